@@ -22,6 +22,8 @@
 
 #include "convert2bed.h"
 
+#ifndef C2B_NO_MAIN
+
 int
 main(int argc, char **argv)
 {
@@ -36,6 +38,7 @@ main(int argc, char **argv)
     /* setup */
     c2b_init_globals();
     c2b_init_command_line_options(argc, argv);
+    c2b_globals.stats->start_seconds = c2b_seconds();
     /* check that stdin is available */
     if ((stats_res = fstat(STDIN_FILENO, &stats)) == -1) {
         int errsv = errno;
@@ -48,11 +51,17 @@ main(int argc, char **argv)
         c2b_print_usage(stderr);
         return ENODATA; /* No message is available on the STREAM head read queue (POSIX.1) */
     }
-    c2b_test_dependencies();
+    if (c2b_globals.pipe->is_size_set) {
+        if (S_ISFIFO(stats.st_mode))
+            c2b_set_pipe_size(STDIN_FILENO);
+        if ((fstat(STDOUT_FILENO, &stats) == 0) && (S_ISFIFO(stats.st_mode)))
+            c2b_set_pipe_size(STDOUT_FILENO);
+    }
     c2b_init_pipeset(&pipes, MAX_PIPES);
 
     /* convert */
     c2b_init_conversion(&pipes);
+    c2b_print_stats();
 
     /* clean-up */
     c2b_delete_pipeset(&pipes);
@@ -64,6 +73,8 @@ main(int argc, char **argv)
     return EXIT_SUCCESS;
 }
 
+#endif
+
 static void
 c2b_init_conversion(c2b_pipeset_t *p)
 {
@@ -145,6 +156,10 @@ c2b_init_rmsk_conversion(c2b_pipeset_t *p)
 static void
 c2b_init_sam_conversion(c2b_pipeset_t *p)
 {
+    if (c2b_globals.fragments->is_enabled) {
+        c2b_init_generic_conversion(p, &c2b_line_convert_sam_to_bed_fragments);
+        return;
+    }
     c2b_init_generic_conversion(p, (!c2b_globals.split_flag ?
                                     &c2b_line_convert_sam_to_bed_unsorted_without_split_operation :
                                     &c2b_line_convert_sam_to_bed_unsorted_with_split_operation));
@@ -163,46 +178,41 @@ c2b_init_wig_conversion(c2b_pipeset_t *p)
 }
 
 static void
-c2b_init_generic_conversion(c2b_pipeset_t *p, void(*to_bed_line_functor)(char *, ssize_t *, char *, ssize_t))
+c2b_init_generic_conversion(c2b_pipeset_t *p, void(*to_bed_line_functor)(c2b_context_t *, c2b_output_t *, char *, ssize_t))
 {
 #ifdef DEBUG
     fprintf(stderr, "--- c2b_init_generic_conversion() - enter ---\n");
 #endif
 
-    pthread_t cat2generic_thread; 
     pthread_t generic2bed_unsorted_thread; 
+    pthread_t generic2bed_sorted_thread;
     pthread_t bed_unsorted2stdout_thread;
-    pthread_t bed_unsorted2bed_sorted_thread;
-    pthread_t bed_sorted2stdout_thread;
-    pthread_t bed_sorted2starch_thread;
-    pthread_t starch2stdout_thread;
-    c2b_pipeline_stage_t cat2generic_stage;
     c2b_pipeline_stage_t generic2bed_unsorted_stage;
+    c2b_pipeline_stage_t generic2bed_sorted_stage;
     c2b_pipeline_stage_t bed_unsorted2stdout_stage;
-    c2b_pipeline_stage_t bed_unsorted2bed_sorted_stage;
-    c2b_pipeline_stage_t bed_sorted2stdout_stage;
-    c2b_pipeline_stage_t bed_sorted2starch_stage;
-    c2b_pipeline_stage_t starch2stdout_stage;
-    char cat2generic_cmd[C2B_MAX_LINE_LENGTH_VALUE];
-    char bed_unsorted2bed_sorted_cmd[C2B_MAX_LINE_LENGTH_VALUE];
-    char bed_sorted2starch_cmd[C2B_MAX_LINE_LENGTH_VALUE];
-    void (*generic2bed_unsorted_line_functor)(char *, ssize_t *, char *, ssize_t) = to_bed_line_functor;
-    int errsv = 0;
+    void (*generic2bed_unsorted_line_functor)(c2b_context_t *, c2b_output_t *, char *, ssize_t) = to_bed_line_functor;
+
+    /* with --coverage, the format's functor is called from c2b_line_convert_to_coverage() */
+
+    if (c2b_globals.coverage->is_enabled) {
+        c2b_globals.coverage->line_functor = to_bed_line_functor;
+        generic2bed_unsorted_line_functor = &c2b_line_convert_to_coverage;
+    }
+
+    /*
+       Text formats are read directly from standard input by the line processing 
+       stage (src == -1), so that pipe set 0 is unused here and no "cat -" helper 
+       process is required to feed the converter. Sorting and Starch compression
+       are done within the line processing stage, which writes sorted BED or a
+       Starch archive to stdout.
+    */
 
     if ((!c2b_globals.sort->is_enabled) && (c2b_globals.output_format_idx == BED_FORMAT)) {
-        cat2generic_stage.pipeset = p;
-        cat2generic_stage.line_functor = NULL;
-        cat2generic_stage.src = -1;
-        cat2generic_stage.dest = 0;
-        cat2generic_stage.description = "Generic data from stdin";
-        cat2generic_stage.pid = 0;
-        cat2generic_stage.status = 0;
-        
         generic2bed_unsorted_stage.pipeset = p;
         generic2bed_unsorted_stage.line_functor = generic2bed_unsorted_line_functor;
-        generic2bed_unsorted_stage.src = 0;
+        generic2bed_unsorted_stage.src = -1;
         generic2bed_unsorted_stage.dest = 1;
-        generic2bed_unsorted_stage.description = "Generic data to unsorted BED";
+        generic2bed_unsorted_stage.description = "Generic data from stdin to unsorted BED";
         generic2bed_unsorted_stage.pid = 0;
         generic2bed_unsorted_stage.status = 0;
 
@@ -214,79 +224,16 @@ c2b_init_generic_conversion(c2b_pipeset_t *p, void(*to_bed_line_functor)(char *,
         bed_unsorted2stdout_stage.pid = 0;
         bed_unsorted2stdout_stage.status = 0;
     }
-    else if (c2b_globals.output_format_idx == BED_FORMAT) {
-        cat2generic_stage.pipeset = p;
-        cat2generic_stage.line_functor = NULL;
-        cat2generic_stage.src = -1;
-        cat2generic_stage.dest = 0;
-        cat2generic_stage.description = "Generic data from stdin"; 
-        cat2generic_stage.pid = 0;
-        cat2generic_stage.status = 0;
-        
-        generic2bed_unsorted_stage.pipeset = p;
-        generic2bed_unsorted_stage.line_functor = generic2bed_unsorted_line_functor;
-        generic2bed_unsorted_stage.src = 0;
-        generic2bed_unsorted_stage.dest = 1;
-        generic2bed_unsorted_stage.description = "Generic data to unsorted BED";
-        generic2bed_unsorted_stage.pid = 0;
-        generic2bed_unsorted_stage.status = 0;
-        
-        bed_unsorted2bed_sorted_stage.pipeset = p;
-        bed_unsorted2bed_sorted_stage.line_functor = NULL;
-        bed_unsorted2bed_sorted_stage.src = 1;
-        bed_unsorted2bed_sorted_stage.dest = 2;
-        bed_unsorted2bed_sorted_stage.description = "Unsorted BED to sorted BED";
-        bed_unsorted2bed_sorted_stage.pid = 0;
-        bed_unsorted2bed_sorted_stage.status = 0;
-
-        bed_sorted2stdout_stage.pipeset = p;
-        bed_sorted2stdout_stage.line_functor = NULL;
-        bed_sorted2stdout_stage.src = 2;
-        bed_sorted2stdout_stage.dest = -1;
-        bed_sorted2stdout_stage.description = "Sorted BED to stdout";
-        bed_sorted2stdout_stage.pid = 0;
-        bed_sorted2stdout_stage.status = 0;
-    }
-    else if (c2b_globals.output_format_idx == STARCH_FORMAT) {
-        cat2generic_stage.pipeset = p;
-        cat2generic_stage.line_functor = NULL;
-        cat2generic_stage.src = -1;
-        cat2generic_stage.dest = 0;
-        cat2generic_stage.description = "Generic data from stdin";
-        cat2generic_stage.pid = 0;
-        cat2generic_stage.status = 0;
-        
-        generic2bed_unsorted_stage.pipeset = p;
-        generic2bed_unsorted_stage.line_functor = generic2bed_unsorted_line_functor;
-        generic2bed_unsorted_stage.src = 0;
-        generic2bed_unsorted_stage.dest = 1;
-        generic2bed_unsorted_stage.description = "Generic data to unsorted BED";
-        generic2bed_unsorted_stage.pid = 0;
-        generic2bed_unsorted_stage.status = 0;
-
-        bed_unsorted2bed_sorted_stage.pipeset = p;
-        bed_unsorted2bed_sorted_stage.line_functor = NULL;
-        bed_unsorted2bed_sorted_stage.src = 1;
-        bed_unsorted2bed_sorted_stage.dest = 2;
-        bed_unsorted2bed_sorted_stage.description = "Unsorted BED to sorted BED";
-        bed_unsorted2bed_sorted_stage.pid = 0;
-        bed_unsorted2bed_sorted_stage.status = 0;
-
-        bed_sorted2starch_stage.pipeset = p;
-        bed_sorted2starch_stage.line_functor = NULL;
-        bed_sorted2starch_stage.src = 2;
-        bed_sorted2starch_stage.dest = 3;
-        bed_sorted2stdout_stage.description = "Sorted BED to Starch";
-        bed_sorted2starch_stage.pid = 0;
-        bed_sorted2starch_stage.status = 0;
-
-        starch2stdout_stage.pipeset = p;
-        starch2stdout_stage.line_functor = NULL;
-        starch2stdout_stage.src = 3;
-        starch2stdout_stage.dest = -1;
-        starch2stdout_stage.description = "Starch to stdout";
-        starch2stdout_stage.pid = 0;
-        starch2stdout_stage.status = 0;
+    else if ((c2b_globals.output_format_idx == BED_FORMAT) || (c2b_globals.output_format_idx == STARCH_FORMAT)) {
+        generic2bed_sorted_stage.pipeset = p;
+        generic2bed_sorted_stage.line_functor = generic2bed_unsorted_line_functor;
+        generic2bed_sorted_stage.src = -1;
+        generic2bed_sorted_stage.dest = -1;
+        generic2bed_sorted_stage.description = (c2b_globals.output_format_idx == STARCH_FORMAT) ? 
+            "Generic data from stdin to Starch" : 
+            "Generic data from stdin to sorted BED";
+        generic2bed_sorted_stage.pid = 0;
+        generic2bed_sorted_stage.status = 0;
     }
     else {
         fprintf(stderr, "Error: Unknown conversion parameter combination\n");
@@ -294,71 +241,6 @@ c2b_init_generic_conversion(c2b_pipeset_t *p, void(*to_bed_line_functor)(char *,
         exit(ENOTSUP); /* Operation not supported (POSIX.1) */
     }
 
-    /*
-       We open pid_t (process) instances to handle data in a specified order. 
-    */
-
-    c2b_cmd_cat_stdin(cat2generic_cmd);
-#ifdef DEBUG
-    fprintf(stderr, "Debug: c2b_cmd_cat_stdin: [%s]\n", cat2generic_cmd);
-#endif
-
-    generic2bed_unsorted_stage.pid = c2b_popen4(cat2generic_cmd,
-                                                p->in[0],
-                                                p->out[0],
-                                                p->err[0],
-                                                POPEN4_FLAG_NONE);
-
-    if (waitpid(generic2bed_unsorted_stage.pid, 
-                &generic2bed_unsorted_stage.status, 
-                WNOHANG | WUNTRACED) == -1) {
-        errsv = errno;
-        fprintf(stderr, "Error: Generic stdin stage waitpid() call failed (%s)\n", (errsv == ECHILD ? "ECHILD" : (errsv == EINTR ? "EINTR" : "EINVAL")));
-        exit(errsv);
-    }
-
-    if (c2b_globals.sort->is_enabled) {
-        c2b_cmd_sort_bed(bed_unsorted2bed_sorted_cmd);
-#ifdef DEBUG
-        fprintf(stderr, "Debug: c2b_cmd_sort_bed: [%s]\n", bed_unsorted2bed_sorted_cmd);
-#endif
-
-        bed_unsorted2bed_sorted_stage.pid = c2b_popen4(bed_unsorted2bed_sorted_cmd,
-                                                       p->in[2],
-                                                       p->out[2],
-                                                       p->err[2],
-                                                       POPEN4_FLAG_NONE);
-
-        if (waitpid(bed_unsorted2bed_sorted_stage.pid, 
-                    &bed_unsorted2bed_sorted_stage.status, 
-                    WNOHANG | WUNTRACED) == -1) {
-            errsv = errno;
-            fprintf(stderr, "Error: Sort stage waitpid() call failed (%s)\n", (errsv == ECHILD ? "ECHILD" : (errsv == EINTR ? "EINTR" : "EINVAL")));
-            exit(errsv);
-        }
-    }
-
-    if (c2b_globals.output_format_idx == STARCH_FORMAT) {
-        c2b_cmd_starch_bed(bed_sorted2starch_cmd);
-#ifdef DEBUG
-        fprintf(stderr, "Debug: c2b_cmd_starch_bed: [%s]\n", bed_sorted2starch_cmd);
-#endif
-
-        bed_sorted2starch_stage.pid = c2b_popen4(bed_sorted2starch_cmd,
-                                                 p->in[3],
-                                                 p->out[3],
-                                                 p->err[3],
-                                                 POPEN4_FLAG_NONE);
-
-        if (waitpid(bed_sorted2starch_stage.pid, 
-                    &bed_sorted2starch_stage.status, 
-                    WNOHANG | WUNTRACED) == -1) {
-            errsv = errno;
-            fprintf(stderr, "Error: Compression stage waitpid() call failed (%s)\n", (errsv == ECHILD ? "ECHILD" : (errsv == EINTR ? "EINTR" : "EINVAL")));
-            exit(errsv);
-        }
-    }
-
 #ifdef DEBUG
     c2b_debug_pipeset(p, MAX_PIPES);
 #endif
@@ -369,10 +251,6 @@ c2b_init_generic_conversion(c2b_pipeset_t *p, void(*to_bed_line_functor)(char *,
     */
 
     if ((!c2b_globals.sort->is_enabled) && (c2b_globals.output_format_idx == BED_FORMAT)) {
-        pthread_create(&cat2generic_thread,
-                       NULL,
-                       c2b_read_bytes_from_stdin,
-                       &cat2generic_stage);
         pthread_create(&generic2bed_unsorted_thread,
                        NULL,
                        c2b_process_intermediate_bytes_by_lines,
@@ -382,64 +260,19 @@ c2b_init_generic_conversion(c2b_pipeset_t *p, void(*to_bed_line_functor)(char *,
                        c2b_write_in_bytes_to_stdout,
                        &bed_unsorted2stdout_stage);
     }
-    else if (c2b_globals.output_format_idx == BED_FORMAT) {
-        pthread_create(&cat2generic_thread,
-                       NULL,
-                       c2b_read_bytes_from_stdin,
-                       &cat2generic_stage);
-        pthread_create(&generic2bed_unsorted_thread,
-                       NULL,
-                       c2b_process_intermediate_bytes_by_lines,
-                       &generic2bed_unsorted_stage);
-        pthread_create(&bed_unsorted2bed_sorted_thread,
-                       NULL,
-                       c2b_write_in_bytes_to_in_process,
-                       &bed_unsorted2bed_sorted_stage);
-        pthread_create(&bed_sorted2stdout_thread,
-                       NULL,
-                       c2b_write_out_bytes_to_stdout,
-                       &bed_sorted2stdout_stage);
-    }
-    else if (c2b_globals.output_format_idx == STARCH_FORMAT) {
-        pthread_create(&cat2generic_thread,
-                       NULL,
-                       c2b_read_bytes_from_stdin,
-                       &cat2generic_stage);
-        pthread_create(&generic2bed_unsorted_thread,
+    else {
+        pthread_create(&generic2bed_sorted_thread,
                        NULL,
                        c2b_process_intermediate_bytes_by_lines,
-                       &generic2bed_unsorted_stage);
-        pthread_create(&bed_unsorted2bed_sorted_thread,
-                       NULL,
-                       c2b_write_in_bytes_to_in_process,
-                       &bed_unsorted2bed_sorted_stage);
-        pthread_create(&bed_sorted2starch_thread,
-                       NULL,
-                       c2b_write_out_bytes_to_in_process,
-                       &bed_sorted2starch_stage);
-        pthread_create(&starch2stdout_thread,
-                       NULL,
-                       c2b_write_out_bytes_to_stdout,
-                       &starch2stdout_stage);
+                       &generic2bed_sorted_stage);
     }
 
     if ((!c2b_globals.sort->is_enabled) && (c2b_globals.output_format_idx == BED_FORMAT)) {
-        pthread_join(cat2generic_thread, (void **) NULL);
         pthread_join(generic2bed_unsorted_thread, (void **) NULL);
         pthread_join(bed_unsorted2stdout_thread, (void **) NULL);
     }
-    else if (c2b_globals.output_format_idx == BED_FORMAT) {
-        pthread_join(cat2generic_thread, (void **) NULL);
-        pthread_join(generic2bed_unsorted_thread, (void **) NULL);
-        pthread_join(bed_unsorted2bed_sorted_thread, (void **) NULL);
-        pthread_join(bed_sorted2stdout_thread, (void **) NULL);
-    }
-    else if (c2b_globals.output_format_idx == STARCH_FORMAT) {
-        pthread_join(cat2generic_thread, (void **) NULL);
-        pthread_join(generic2bed_unsorted_thread, (void **) NULL);
-        pthread_join(bed_unsorted2bed_sorted_thread, (void **) NULL);
-        pthread_join(bed_sorted2starch_thread, (void **) NULL);
-        pthread_join(starch2stdout_thread, (void **) NULL);
+    else {
+        pthread_join(generic2bed_sorted_thread, (void **) NULL);
     }
 
 #ifdef DEBUG
@@ -450,444 +283,25 @@ c2b_init_generic_conversion(c2b_pipeset_t *p, void(*to_bed_line_functor)(char *,
 static void
 c2b_init_bam_conversion(c2b_pipeset_t *p)
 {
-#ifdef DEBUG
-    fprintf(stderr, "--- c2b_init_bam_conversion() - enter ---\n");
-#endif
-
-    pthread_t bam2sam_thread; 
-    pthread_t sam2bed_unsorted_thread; 
-    pthread_t bed_unsorted2stdout_thread;
-    pthread_t bed_unsorted2bed_sorted_thread;
-    pthread_t bed_sorted2stdout_thread;
-    pthread_t bed_sorted2starch_thread;
-    pthread_t starch2stdout_thread;
-    c2b_pipeline_stage_t bam2sam_stage;
-    c2b_pipeline_stage_t sam2bed_unsorted_stage;
-    c2b_pipeline_stage_t bed_unsorted2stdout_stage;
-    c2b_pipeline_stage_t bed_unsorted2bed_sorted_stage;
-    c2b_pipeline_stage_t bed_sorted2stdout_stage;
-    c2b_pipeline_stage_t bed_sorted2starch_stage;
-    c2b_pipeline_stage_t starch2stdout_stage;
-    char bam2sam_cmd[C2B_MAX_LINE_LENGTH_VALUE];
-    char bed_unsorted2bed_sorted_cmd[C2B_MAX_LINE_LENGTH_VALUE];
-    char bed_sorted2starch_cmd[C2B_MAX_LINE_LENGTH_VALUE];
-    void (*sam2bed_unsorted_line_functor)(char *, ssize_t *, char *, ssize_t) = NULL;
-    int errsv = errno;
-
-    sam2bed_unsorted_line_functor = (!c2b_globals.split_flag ?
-                                     &c2b_line_convert_sam_to_bed_unsorted_without_split_operation :
-                                     &c2b_line_convert_sam_to_bed_unsorted_with_split_operation);
-
-    if ((!c2b_globals.sort->is_enabled) && (c2b_globals.output_format_idx == BED_FORMAT)) {
-        bam2sam_stage.pipeset = p;
-        bam2sam_stage.line_functor = NULL;
-        bam2sam_stage.src = -1;
-        bam2sam_stage.dest = 0;
-        bam2sam_stage.description = "BAM data from stdin to SAM";
-        bam2sam_stage.pid = 0;
-        bam2sam_stage.status = 0;
-        
-        sam2bed_unsorted_stage.pipeset = p;
-        sam2bed_unsorted_stage.line_functor = sam2bed_unsorted_line_functor;
-        sam2bed_unsorted_stage.src = 0;
-        sam2bed_unsorted_stage.dest = 1;
-        sam2bed_unsorted_stage.description = "SAM to unsorted BED";
-        sam2bed_unsorted_stage.pid = 0;
-        sam2bed_unsorted_stage.status = 0;
-
-        bed_unsorted2stdout_stage.pipeset = p;
-        bed_unsorted2stdout_stage.line_functor = NULL;
-        bed_unsorted2stdout_stage.src = 1;
-        bed_unsorted2stdout_stage.dest = -1;
-        bed_unsorted2stdout_stage.description = "Unsorted BED to stdout";
-        bed_unsorted2stdout_stage.pid = 0;
-        bed_unsorted2stdout_stage.status = 0;
-    }
-    else if (c2b_globals.output_format_idx == BED_FORMAT) {
-        bam2sam_stage.pipeset = p;
-        bam2sam_stage.line_functor = NULL;
-        bam2sam_stage.src = -1;
-        bam2sam_stage.dest = 0;
-        bam2sam_stage.description = "BAM data from stdin to SAM";
-        bam2sam_stage.pid = 0;
-        bam2sam_stage.status = 0;
-        
-        sam2bed_unsorted_stage.pipeset = p;
-        sam2bed_unsorted_stage.line_functor = sam2bed_unsorted_line_functor;
-        sam2bed_unsorted_stage.src = 0;
-        sam2bed_unsorted_stage.dest = 1;
-        sam2bed_unsorted_stage.description = "SAM to unsorted BED";
-        sam2bed_unsorted_stage.pid = 0;
-        sam2bed_unsorted_stage.status = 0;
-        
-        bed_unsorted2bed_sorted_stage.pipeset = p;
-        bed_unsorted2bed_sorted_stage.line_functor = NULL;
-        bed_unsorted2bed_sorted_stage.src = 1;
-        bed_unsorted2bed_sorted_stage.dest = 2;
-        bed_unsorted2bed_sorted_stage.description = "Unsorted BED to sorted BED";
-        bed_unsorted2bed_sorted_stage.pid = 0;
-        bed_unsorted2bed_sorted_stage.status = 0;
-
-        bed_sorted2stdout_stage.pipeset = p;
-        bed_sorted2stdout_stage.line_functor = NULL;
-        bed_sorted2stdout_stage.src = 2;
-        bed_sorted2stdout_stage.dest = -1;
-        bed_sorted2stdout_stage.description = "Sorted BED to stdout";
-        bed_sorted2stdout_stage.pid = 0;
-        bed_sorted2stdout_stage.status = 0;
-    }
-    else if (c2b_globals.output_format_idx == STARCH_FORMAT) {
-        bam2sam_stage.pipeset = p;
-        bam2sam_stage.line_functor = NULL;
-        bam2sam_stage.src = -1;
-        bam2sam_stage.dest = 0;
-        bam2sam_stage.description = "BAM data from stdin to SAM";
-        bam2sam_stage.pid = 0;
-        bam2sam_stage.status = 0;
-        
-        sam2bed_unsorted_stage.pipeset = p;
-        sam2bed_unsorted_stage.line_functor = sam2bed_unsorted_line_functor;
-        sam2bed_unsorted_stage.src = 0;
-        sam2bed_unsorted_stage.dest = 1;
-        sam2bed_unsorted_stage.description = "SAM to unsorted BED";
-        sam2bed_unsorted_stage.pid = 0;
-        sam2bed_unsorted_stage.status = 0;
-
-        bed_unsorted2bed_sorted_stage.pipeset = p;
-        bed_unsorted2bed_sorted_stage.line_functor = NULL;
-        bed_unsorted2bed_sorted_stage.src = 1;
-        bed_unsorted2bed_sorted_stage.dest = 2;
-        bed_unsorted2bed_sorted_stage.description = "Unsorted BED to sorted BED";
-        bed_unsorted2bed_sorted_stage.pid = 0;
-        bed_unsorted2bed_sorted_stage.status = 0;
-
-        bed_sorted2starch_stage.pipeset = p;
-        bed_sorted2starch_stage.line_functor = NULL;
-        bed_sorted2starch_stage.src = 2;
-        bed_sorted2starch_stage.dest = 3;
-        bed_sorted2starch_stage.description = "Sorted BED to Starch";
-        bed_sorted2starch_stage.pid = 0;
-        bed_sorted2starch_stage.status = 0;
-
-        starch2stdout_stage.pipeset = p;
-        starch2stdout_stage.line_functor = NULL;
-        starch2stdout_stage.src = 3;
-        starch2stdout_stage.dest = -1;
-        starch2stdout_stage.description = "Starch to stdout";
-        starch2stdout_stage.pid = 0;
-        starch2stdout_stage.status = 0;
-    }
-    else {
-        fprintf(stderr, "Error: Unknown BAM conversion parameter combination\n");
-        c2b_print_usage(stderr);
-        exit(ENOTSUP); /* Operation not supported (POSIX.1) */
-    }
-
-    /*
-       We open pid_t (process) instances to handle data in a specified order. 
-    */
-
-    c2b_cmd_bam_to_sam(bam2sam_cmd);
-#ifdef DEBUG
-    fprintf(stderr, "Debug: c2b_cmd_bam_to_sam: [%s]\n", bam2sam_cmd);
-#endif
-
-    bam2sam_stage.pid = c2b_popen4(bam2sam_cmd,
-                                   p->in[0],
-                                   p->out[0],
-                                   p->err[0],
-                                   POPEN4_FLAG_NONE);
-
-    if (waitpid(bam2sam_stage.pid, 
-                &bam2sam_stage.status, 
-                WNOHANG | WUNTRACED) == -1) {
-        errsv = errno;
-        fprintf(stderr, "Error: BAM-to-SAM stage waitpid() call failed (%s)\n", (errsv == ECHILD ? "ECHILD" : (errsv == EINTR ? "EINTR" : "EINVAL")));
-        exit(errsv);
-    }
-
-    if (c2b_globals.sort->is_enabled) {
-        c2b_cmd_sort_bed(bed_unsorted2bed_sorted_cmd);
-#ifdef DEBUG
-        fprintf(stderr, "Debug: c2b_cmd_sort_bed: [%s]\n", bed_unsorted2bed_sorted_cmd);
-#endif
-
-        bed_unsorted2bed_sorted_stage.pid = c2b_popen4(bed_unsorted2bed_sorted_cmd,
-                                                       p->in[2],
-                                                       p->out[2],
-                                                       p->err[2],
-                                                       POPEN4_FLAG_NONE);
-        
-        if (waitpid(bed_unsorted2bed_sorted_stage.pid, 
-                    &bed_unsorted2bed_sorted_stage.status, 
-                    WNOHANG | WUNTRACED) == -1) {
-            errsv = errno;
-            fprintf(stderr, "Error: Sort stage waitpid() call failed (%s)\n", (errsv == ECHILD ? "ECHILD" : (errsv == EINTR ? "EINTR" : "EINVAL")));
-            exit(errsv);
-        }
-    }
-
-    if (c2b_globals.output_format_idx == STARCH_FORMAT) {
-        c2b_cmd_starch_bed(bed_sorted2starch_cmd);
-#ifdef DEBUG
-        fprintf(stderr, "Debug: c2b_cmd_starch_bed: [%s]\n", bed_sorted2starch_cmd);
-#endif
-
-        bed_sorted2starch_stage.pid = c2b_popen4(bed_sorted2starch_cmd,
-                                                 p->in[3],
-                                                 p->out[3],
-                                                 p->err[3],
-                                                 POPEN4_FLAG_NONE);
-
-        if (waitpid(bed_sorted2starch_stage.pid, 
-                    &bed_sorted2starch_stage.status, 
-                    WNOHANG | WUNTRACED) == -1) {
-            errsv = errno;
-            fprintf(stderr, "Error: Compression stage waitpid() call failed (%s)\n", (errsv == ECHILD ? "ECHILD" : (errsv == EINTR ? "EINTR" : "EINVAL")));
-            exit(errsv);
-        }
-    }
-
-#ifdef DEBUG
-    c2b_debug_pipeset(p, MAX_PIPES);
-#endif
-
-    /*
-       Once we have the desired process instances, we create and join
-       threads for their ordered execution.
+    /* 
+       BAM records are decoded from standard input by the line processing stage, 
+       which hands each binary record to the functor in place of a line of text
     */
 
-    if ((!c2b_globals.sort->is_enabled) && (c2b_globals.output_format_idx == BED_FORMAT)) {
-        pthread_create(&bam2sam_thread,
-                       NULL,
-                       c2b_read_bytes_from_stdin,
-                       &bam2sam_stage);
-        pthread_create(&sam2bed_unsorted_thread,
-                       NULL,
-                       c2b_process_intermediate_bytes_by_lines,
-                       &sam2bed_unsorted_stage);
-        pthread_create(&bed_unsorted2stdout_thread,
-                       NULL,
-                       c2b_write_in_bytes_to_stdout,
-                       &bed_unsorted2stdout_stage);
-    }
-    else if (c2b_globals.output_format_idx == BED_FORMAT) {
-        pthread_create(&bam2sam_thread,
-                       NULL,
-                       c2b_read_bytes_from_stdin,
-                       &bam2sam_stage);
-        pthread_create(&sam2bed_unsorted_thread,
-                       NULL,
-                       c2b_process_intermediate_bytes_by_lines,
-                       &sam2bed_unsorted_stage);
-        pthread_create(&bed_unsorted2bed_sorted_thread,
-                       NULL,
-                       c2b_write_in_bytes_to_in_process,
-                       &bed_unsorted2bed_sorted_stage);
-        pthread_create(&bed_sorted2stdout_thread,
-                       NULL,
-                       c2b_write_out_bytes_to_stdout,
-                       &bed_sorted2stdout_stage);
-    }
-    else if (c2b_globals.output_format_idx == STARCH_FORMAT) {
-        pthread_create(&bam2sam_thread,
-                       NULL,
-                       c2b_read_bytes_from_stdin,
-                       &bam2sam_stage);
-        pthread_create(&sam2bed_unsorted_thread,
-                       NULL,
-                       c2b_process_intermediate_bytes_by_lines,
-                       &sam2bed_unsorted_stage);
-        pthread_create(&bed_unsorted2bed_sorted_thread,
-                       NULL,
-                       c2b_write_in_bytes_to_in_process,
-                       &bed_unsorted2bed_sorted_stage);
-        pthread_create(&bed_sorted2starch_thread,
-                       NULL,
-                       c2b_write_out_bytes_to_in_process,
-                       &bed_sorted2starch_stage);
-        pthread_create(&starch2stdout_thread,
-                       NULL,
-                       c2b_write_out_bytes_to_stdout,
-                       &starch2stdout_stage);
-    }
-
-    if ((!c2b_globals.sort->is_enabled) && (c2b_globals.output_format_idx == BED_FORMAT)) {
-        pthread_join(bam2sam_thread, (void **) NULL);
-        pthread_join(sam2bed_unsorted_thread, (void **) NULL);
-        pthread_join(bed_unsorted2stdout_thread, (void **) NULL);
-    }
-    else if (c2b_globals.output_format_idx == BED_FORMAT) {
-        pthread_join(bam2sam_thread, (void **) NULL);
-        pthread_join(sam2bed_unsorted_thread, (void **) NULL);
-        pthread_join(bed_unsorted2bed_sorted_thread, (void **) NULL);
-        pthread_join(bed_sorted2stdout_thread, (void **) NULL);
-    }
-    else if (c2b_globals.output_format_idx == STARCH_FORMAT) {
-        pthread_join(bam2sam_thread, (void **) NULL);
-        pthread_join(sam2bed_unsorted_thread, (void **) NULL);
-        pthread_join(bed_unsorted2bed_sorted_thread, (void **) NULL);
-        pthread_join(bed_sorted2starch_thread, (void **) NULL);
-        pthread_join(starch2stdout_thread, (void **) NULL);
-    }
-
-#ifdef DEBUG
-    fprintf(stderr, "--- c2b_init_bam_conversion() - exit  ---\n");
-#endif
-}
-
-static inline void
-c2b_cmd_cat_stdin(char *cmd)
-{
-    const char *cat_args = " - ";
-    
-    /* /path/to/cat - */
-    memcpy(cmd,
-           c2b_globals.cat->path,
-           strlen(c2b_globals.cat->path) + 1);
-    memcpy(cmd + strlen(c2b_globals.cat->path),
-           cat_args,
-           strlen(cat_args) + 1);
-    cmd[strlen(c2b_globals.cat->path) + strlen(cat_args)] = '\0';
-}
-
-static inline void
-c2b_cmd_bam_to_sam(char *cmd)
-{
-    const char *bam2sam_args = " view -h -";
-
-    /* /path/to/samtools view -h - */
-    memcpy(cmd, 
-           c2b_globals.sam->samtools_path, 
-           strlen(c2b_globals.sam->samtools_path) + 1);
-    memcpy(cmd + strlen(c2b_globals.sam->samtools_path), 
-           bam2sam_args, 
-           strlen(bam2sam_args) + 1);
-    cmd[strlen(c2b_globals.sam->samtools_path) + strlen(bam2sam_args)] = '\0';
-}
-
-static inline void
-c2b_cmd_sort_bed(char *cmd)
-{
-    char sort_bed_args[C2B_MAX_LINE_LENGTH_VALUE];
-    memset(sort_bed_args, 0, C2B_MAX_LINE_LENGTH_VALUE);
-
-    /* /path/to/sort-bed [--max-mem <val>] [--tmpdir <path>] - */
-    if (c2b_globals.sort->max_mem_value) {
-        memcpy(sort_bed_args,
-               sort_bed_max_mem_arg, 
-               strlen(sort_bed_max_mem_arg) + 1);
-        memcpy(sort_bed_args + strlen(sort_bed_args), 
-               c2b_globals.sort->max_mem_value, 
-               strlen(c2b_globals.sort->max_mem_value) + 1);
-        sort_bed_args[strlen(sort_bed_max_mem_arg) + strlen(sort_bed_args)] = '\0';
-    }
-    else {
-        memcpy(sort_bed_args, 
-               sort_bed_max_mem_default_arg, 
-               strlen(sort_bed_max_mem_default_arg) + 1);
-        sort_bed_args[strlen(sort_bed_max_mem_default_arg)] = '\0';
-    }
-    if (c2b_globals.sort->sort_tmpdir_path) {
-        memcpy(sort_bed_args + strlen(sort_bed_args),
-               sort_bed_tmpdir_arg,
-               strlen(sort_bed_tmpdir_arg) + 1);
-        memcpy(sort_bed_args + strlen(sort_bed_args),
-               c2b_globals.sort->sort_tmpdir_path,
-               strlen(c2b_globals.sort->sort_tmpdir_path) + 1);
-        sort_bed_args[strlen(sort_bed_args) + strlen(c2b_globals.sort->sort_tmpdir_path)] = '\0';
-    }
-    memcpy(sort_bed_args + strlen(sort_bed_args),
-           sort_bed_stdin,
-           strlen(sort_bed_stdin) + 1);
-    sort_bed_args[strlen(sort_bed_args) + strlen(sort_bed_stdin)] = '\0';
-
-    /* cmd */
-    memcpy(cmd, 
-           c2b_globals.sort->sort_bed_path, 
-           strlen(c2b_globals.sort->sort_bed_path) + 1);
-    memcpy(cmd + strlen(c2b_globals.sort->sort_bed_path), 
-           sort_bed_args, 
-           strlen(sort_bed_args) + 1);
-    cmd[strlen(c2b_globals.sort->sort_bed_path) + strlen(sort_bed_args)] = '\0';
-}
-
-static inline void
-c2b_cmd_starch_bed(char *cmd) 
-{
-    char starch_args[C2B_MAX_LINE_LENGTH_VALUE];
-    memset(starch_args, 0, C2B_MAX_LINE_LENGTH_VALUE);
-
-    /* /path/to/starch [--bzip2 | --gzip] [--note="xyz..."] - */
-    if (c2b_globals.starch->bzip2) {
-        memcpy(starch_args,
-               starch_bzip2_arg,
-               strlen(starch_bzip2_arg) + 1);
-        starch_args[strlen(starch_bzip2_arg)] = '\0';
-    }
-    else if (c2b_globals.starch->gzip) {
-        memcpy(starch_args,
-               starch_gzip_arg,
-               strlen(starch_gzip_arg) + 1);
-        starch_args[strlen(starch_gzip_arg)] = '\0';
+    if (c2b_globals.fragments->is_enabled) {
+        c2b_init_generic_conversion(p, &c2b_line_convert_bam_to_bed_fragments);
+        return;
     }
-
-#ifdef DEBUG
-    fprintf(stderr, "Debug: c2b_globals.starch->bzip2: [%d]\n", c2b_globals.starch->bzip2);
-    fprintf(stderr, "Debug: c2b_globals.starch->gzip: [%d]\n", c2b_globals.starch->gzip);
-    fprintf(stderr, "Debug: c2b_globals.starch->note: [%s]\n", c2b_globals.starch->note);
-    fprintf(stderr, "Debug: starch_args: [%s]\n", starch_args);
-#endif
-
-    if (c2b_globals.starch->note) {
-        memcpy(starch_args + strlen(starch_args),
-               starch_note_prefix_arg,
-               strlen(starch_note_prefix_arg) + 1);
-        memcpy(starch_args + strlen(starch_args),
-               c2b_globals.starch->note,
-               strlen(c2b_globals.starch->note) + 1);
-        memcpy(starch_args + strlen(starch_args),
-               starch_note_suffix_arg,
-               strlen(starch_note_suffix_arg) + 1);
-        starch_args[strlen(starch_args) + strlen(starch_note_prefix_arg) + strlen(c2b_globals.starch->note) + strlen(starch_note_suffix_arg)] = '\0';
-    }
-    memcpy(starch_args + strlen(starch_args),
-           starch_stdin_arg,
-           strlen(starch_stdin_arg) + 1);
-
-#ifdef DEBUG
-    fprintf(stderr, "Debug: starch_args: [%s]\n", starch_args);
-#endif
-
-    /* cmd */
-    memcpy(cmd, 
-           c2b_globals.starch->path, 
-           strlen(c2b_globals.starch->path) + 1);
-    memcpy(cmd + strlen(c2b_globals.starch->path), 
-           starch_args, 
-           strlen(starch_args) + 1);
-    cmd[strlen(c2b_globals.starch->path) + strlen(starch_args)] = '\0';
+    c2b_init_generic_conversion(p, (!c2b_globals.split_flag ?
+                                    &c2b_line_convert_bam_to_bed_unsorted_without_split_operation :
+                                    &c2b_line_convert_bam_to_bed_unsorted_with_split_operation));
 }
 
 static void
-c2b_line_convert_gtf_to_bed_unsorted(char *dest, ssize_t *dest_size, char *src, ssize_t src_size)
+c2b_line_convert_gtf_to_bed_unsorted(c2b_context_t *ctx, c2b_output_t *dest, char *src, ssize_t src_size)
 {
-    ssize_t gtf_field_offsets[C2B_MAX_FIELD_COUNT_VALUE];
-    int gtf_field_idx = 0;
-    ssize_t current_src_posn = -1;
-
-    while (++current_src_posn < src_size) {
-        if ((src[current_src_posn] == c2b_tab_delim) || (src[current_src_posn] == c2b_line_delim)) {
-            gtf_field_offsets[gtf_field_idx++] = current_src_posn;
-        }
-        if (gtf_field_idx >= C2B_MAX_FIELD_COUNT_VALUE) {
-            fprintf(stderr, "Error: Invalid field count (%d) -- input file may have too many fields\n", gtf_field_idx);
-            c2b_print_usage(stderr);
-            exit(EINVAL); /* Invalid argument (POSIX.1) */
-        }
-    }
-    gtf_field_offsets[gtf_field_idx] = src_size;
-    gtf_field_offsets[gtf_field_idx + 1] = -1;
+    c2b_span_t gtf_fields[C2B_MAX_FIELD_COUNT_VALUE];
+    int gtf_field_idx = c2b_split_fields(ctx, src, src_size, gtf_fields);
 
     /* 
        If number of fields is not in bounds, we may need to exit early
@@ -901,14 +315,7 @@ c2b_line_convert_gtf_to_bed_unsorted(char *dest, ssize_t *dest_size, char *src,
                 }
                 else {
                     /* copy header line to destination stream buffer */
-                    char src_header_line_str[C2B_MAX_LINE_LENGTH_VALUE];
-                    char dest_header_line_str[C2B_MAX_LINE_LENGTH_VALUE];
-                    memcpy(src_header_line_str, src, src_size);
-                    src_header_line_str[src_size] = '\0';
-                    sprintf(dest_header_line_str, "%s\t%u\t%u\t%s\n", c2b_header_chr_name, c2b_globals.header_line_idx, (c2b_globals.header_line_idx + 1), src_header_line_str);
-                    memcpy(dest + *dest_size, dest_header_line_str, strlen(dest_header_line_str));
-                    *dest_size += strlen(dest_header_line_str);
-                    c2b_globals.header_line_idx++;
+                    c2b_line_convert_header_to_bed(ctx, dest, src, src_size);
                     return;
                 }
             }
@@ -923,93 +330,40 @@ c2b_line_convert_gtf_to_bed_unsorted(char *dest, ssize_t *dest_size, char *src,
         }
     }
 
-    /* 0 - seqname */
-    char seqname_str[C2B_MAX_FIELD_LENGTH_VALUE];
-    ssize_t seqname_size = gtf_field_offsets[0];
-    memcpy(seqname_str, src, seqname_size);
-    seqname_str[seqname_size] = '\0';
-
-    /* 1 - source */
-    char source_str[C2B_MAX_FIELD_LENGTH_VALUE];
-    ssize_t source_size = gtf_field_offsets[1] - gtf_field_offsets[0] - 1;
-    memcpy(source_str, src + gtf_field_offsets[0] + 1, source_size);
-    source_str[source_size] = '\0';
-
-    /* 2 - feature */
-    char feature_str[C2B_MAX_FIELD_LENGTH_VALUE];
-    ssize_t feature_size = gtf_field_offsets[2] - gtf_field_offsets[1] - 1;
-    memcpy(feature_str, src + gtf_field_offsets[1] + 1, feature_size);
-    feature_str[feature_size] = '\0';
-
-    /* 3 - start */
-    char start_str[C2B_MAX_FIELD_LENGTH_VALUE];
-    ssize_t start_size = gtf_field_offsets[3] - gtf_field_offsets[2] - 1;
-    memcpy(start_str, src + gtf_field_offsets[2] + 1, start_size);
-    start_str[start_size] = '\0';
-    uint64_t start_val = strtoull(start_str, NULL, 10);
-
-    /* 4 - end */
-    char end_str[C2B_MAX_FIELD_LENGTH_VALUE];
-    ssize_t end_size = gtf_field_offsets[4] - gtf_field_offsets[3] - 1;
-    memcpy(end_str, src + gtf_field_offsets[3] + 1, end_size);
-    end_str[end_size] = '\0';
-    uint64_t end_val = strtoull(end_str, NULL, 10);
-
-    /* 5 - score */
-    char score_str[C2B_MAX_FIELD_LENGTH_VALUE];
-    ssize_t score_size = gtf_field_offsets[5] - gtf_field_offsets[4] - 1;
-    memcpy(score_str, src + gtf_field_offsets[4] + 1, score_size);
-    score_str[score_size] = '\0';
-
-    /* 6 - strand */
-    char strand_str[C2B_MAX_FIELD_LENGTH_VALUE];
-    ssize_t strand_size = gtf_field_offsets[6] - gtf_field_offsets[5] - 1;
-    memcpy(strand_str, src + gtf_field_offsets[5] + 1, strand_size);
-    strand_str[strand_size] = '\0';
-
-    /* 7 - frame */
-    char frame_str[C2B_MAX_FIELD_LENGTH_VALUE];
-    ssize_t frame_size = gtf_field_offsets[7] - gtf_field_offsets[6] - 1;
-    memcpy(frame_str, src + gtf_field_offsets[6] + 1, frame_size);
-    frame_str[frame_size] = '\0';
-
-    /* 8 - attributes */
-    char attributes_str[C2B_MAX_FIELD_LENGTH_VALUE];
-    ssize_t attributes_size = gtf_field_offsets[8] - gtf_field_offsets[7] - 1;
-    memcpy(attributes_str, src + gtf_field_offsets[7] + 1, attributes_size);
-    attributes_str[attributes_size] = '\0';
-
-    /* 9 - comments */
-    char comments_str[C2B_MAX_FIELD_LENGTH_VALUE];
-    ssize_t comments_size = 0;
+    c2b_gtf_t gtf;
+    gtf.seqname = gtf_fields[0];
+    gtf.source = gtf_fields[1];
+    gtf.feature = gtf_fields[2];
+    gtf.start = c2b_span_to_uint64(gtf_fields[3]);
+    gtf.end = c2b_span_to_uint64(gtf_fields[4]);
+    gtf.score = gtf_fields[5];
+    gtf.strand = gtf_fields[6];
+    gtf.frame = gtf_fields[7];
+    gtf.attributes = gtf_fields[8];
+    gtf.comments.s = NULL;
+    gtf.comments.length = 0;
     if (gtf_field_idx == 9) {
-        comments_size = gtf_field_offsets[9] - gtf_field_offsets[8] - 1;
-        memcpy(comments_str, src + gtf_field_offsets[8] + 1, comments_size);
-        comments_str[comments_size] = '\0';
+        gtf.comments = gtf_fields[9];
     }
 
-    c2b_gtf_t gtf;
-    gtf.seqname = seqname_str;
-    gtf.source = source_str;
-    gtf.feature = feature_str;
-    gtf.start = start_val;
-    gtf.end = end_val;
-    gtf.score = score_str;
-    gtf.strand = strand_str;
-    gtf.frame = frame_str;
-    gtf.attributes = attributes_str;
-    gtf.comments = comments_str;
-
     /* 
-       Fix coordinate indexing, and (if needed) add attribute for zero-length record
+       Fix coordinate indexing, and (if needed) add attribute for zero-length record; 
+       only this case needs its own copy of the attributes field
     */
 
+    char attributes_str[C2B_MAX_FIELD_LENGTH_VALUE];
     if (gtf.start == gtf.end) {
         gtf.start -= 1;
-        ssize_t trailing_semicolon_fudge = (attributes_str[strlen(attributes_str) - 1] == ';') ? 1 : 0;
-        memcpy(attributes_str + strlen(attributes_str) - trailing_semicolon_fudge, 
+        ssize_t trailing_semicolon_fudge = ((gtf.attributes.length > 0) && (gtf.attributes.s[gtf.attributes.length - 1] == ';')) ? 1 : 0;
+        ssize_t attributes_size = gtf.attributes.length - trailing_semicolon_fudge;
+        if (attributes_size + (ssize_t) strlen(c2b_gtf_zero_length_insertion_attribute) > C2B_MAX_FIELD_LENGTH_VALUE)
+            c2b_field_overflow("GTF attributes");
+        memcpy(attributes_str, gtf.attributes.s, attributes_size);
+        memcpy(attributes_str + attributes_size, 
                c2b_gtf_zero_length_insertion_attribute, 
-               strlen(c2b_gtf_zero_length_insertion_attribute) + 1);
+               strlen(c2b_gtf_zero_length_insertion_attribute));
+        gtf.attributes.s = attributes_str;
+        gtf.attributes.length = attributes_size + strlen(c2b_gtf_zero_length_insertion_attribute);
     }
     else {
         gtf.start -= 1;
@@ -1019,36 +373,42 @@ c2b_line_convert_gtf_to_bed_unsorted(char *dest, ssize_t *dest_size, char *src,
        Parse ID value out from attributes string
     */
 
-    char *attributes_copy = NULL;
-    attributes_copy = malloc(strlen(attributes_str) + 1);
-    if (!attributes_copy) {
-        fprintf(stderr, "Error: Could not allocate space for GFF attributes copy\n");
-        exit(ENOMEM); /* Not enough space (POSIX.1) */
-    }
-    memcpy(attributes_copy, attributes_str, strlen(attributes_str) + 1);
-    const char *kv_tok;
     const char *gtf_id_prefix = "gene_id ";
-    char *id_str;
-    while((kv_tok = c2b_strsep(&attributes_copy, ";")) != NULL) {
-        id_str = strstr(kv_tok, gtf_id_prefix);
-        if (id_str) {
+    ssize_t gtf_id_prefix_size = strlen(gtf_id_prefix);
+    c2b_span_t kv_tok;
+    char *attributes_end = gtf.attributes.s + gtf.attributes.length;
+    kv_tok.s = gtf.attributes.s;
+    do {
+        char *kv_tok_end = memchr(kv_tok.s, ';', attributes_end - kv_tok.s);
+        if (!kv_tok_end) {
+            kv_tok_end = attributes_end;
+        }
+        kv_tok.length = kv_tok_end - kv_tok.s;
+        if (c2b_span_find(kv_tok, gtf_id_prefix)) {
             /* we remove quotation marks around ID string value */
-            memcpy(c2b_globals.gtf->id, kv_tok + strlen(gtf_id_prefix) + 1, strlen(kv_tok + strlen(gtf_id_prefix)) - 2);
-            c2b_globals.gtf->id[strlen(kv_tok + strlen(gtf_id_prefix)) - 2] = '\0';
+            ssize_t id_size = kv_tok.length - gtf_id_prefix_size - 2;
+            if (id_size < 0) {
+                id_size = 0;
+            }
+            if (id_size >= C2B_MAX_FIELD_LENGTH_VALUE)
+                c2b_field_overflow("GTF gene_id");
+            memcpy(ctx->gtf.id, kv_tok.s + gtf_id_prefix_size + 1, id_size);
+            ctx->gtf.id[id_size] = '\0';
         }
-    }
-    free(attributes_copy), attributes_copy = NULL;
-    gtf.id = c2b_globals.gtf->id;
+        kv_tok.s = kv_tok_end + 1;
+    } while (kv_tok.s <= attributes_end);
+    gtf.id.s = ctx->gtf.id;
+    gtf.id.length = strlen(ctx->gtf.id);
 
     /* 
        Convert GTF struct to BED string and copy it to destination
     */
 
-    c2b_line_convert_gtf_to_bed(gtf, dest, dest_size);
+    c2b_line_convert_gtf_to_bed(gtf, dest);
 }
 
 static inline void
-c2b_line_convert_gtf_to_bed(c2b_gtf_t g, char *dest_line, ssize_t *dest_size)
+c2b_line_convert_gtf_to_bed(c2b_gtf_t g, c2b_output_t *dest)
 {
     /* 
        For GTF-formatted data, we use the mapping provided by BEDOPS convention described at:
@@ -1080,75 +440,37 @@ c2b_line_convert_gtf_to_bed(c2b_gtf_t g, char *dest_line, ssize_t *dest_size)
        comments                  11                     -
     */
 
-    if (strlen(g.comments) == 0) {
-        *dest_size += sprintf(dest_line + *dest_size,
-                              "%s\t"            \
-                              "%" PRIu64 "\t"   \
-                              "%" PRIu64 "\t"   \
-                              "%s\t"            \
-                              "%s\t"            \
-                              "%s\t"            \
-                              "%s\t"            \
-                              "%s\t"            \
-                              "%s\t"            \
-                              "%s\n",
-                              g.seqname,
-                              g.start,
-                              g.end,
-                              g.id,
-                              g.score,
-                              g.strand,
-                              g.source,
-                              g.feature,
-                              g.frame,
-                              g.attributes);
+    char *dest_posn = c2b_reserve_output(dest,
+                                         g.seqname.length + g.id.length + g.score.length + g.strand.length + 
+                                         g.source.length + g.feature.length + g.frame.length + g.attributes.length + 
+                                         g.comments.length + 
+                                         9 + 2 * C2B_MAX_UINT64_FIELD_LENGTH_VALUE);
+
+    dest_posn = c2b_emit_span(dest_posn, g.seqname, c2b_tab_delim);
+    dest_posn = c2b_emit_uint64(dest_posn, g.start, c2b_tab_delim);
+    dest_posn = c2b_emit_uint64(dest_posn, g.end, c2b_tab_delim);
+    dest_posn = c2b_emit_span(dest_posn, g.id, c2b_tab_delim);
+    dest_posn = c2b_emit_span(dest_posn, g.score, c2b_tab_delim);
+    dest_posn = c2b_emit_span(dest_posn, g.strand, c2b_tab_delim);
+    dest_posn = c2b_emit_span(dest_posn, g.source, c2b_tab_delim);
+    dest_posn = c2b_emit_span(dest_posn, g.feature, c2b_tab_delim);
+    dest_posn = c2b_emit_span(dest_posn, g.frame, c2b_tab_delim);
+    if (g.comments.length == 0) {
+        dest_posn = c2b_emit_span(dest_posn, g.attributes, c2b_line_delim);
     }
     else {
-        *dest_size += sprintf(dest_line + *dest_size,
-                              "%s\t"            \
-                              "%" PRIu64 "\t"   \
-                              "%" PRIu64 "\t"   \
-                              "%s\t"            \
-                              "%s\t"            \
-                              "%s\t"            \
-                              "%s\t"            \
-                              "%s\t"            \
-                              "%s\t"            \
-                              "%s\t"            \
-                              "%s\n",
-                              g.seqname,
-                              g.start,
-                              g.end,
-                              g.id,
-                              g.score,
-                              g.strand,
-                              g.source,
-                              g.feature,
-                              g.frame,
-                              g.attributes,
-                              g.comments);
-    }
-}
-
-static void
-c2b_line_convert_gff_to_bed_unsorted(char *dest, ssize_t *dest_size, char *src, ssize_t src_size)
-{
-    ssize_t gff_field_offsets[C2B_MAX_FIELD_COUNT_VALUE];
-    int gff_field_idx = 0;
-    ssize_t current_src_posn = -1;
-
-    while (++current_src_posn < src_size) {
-        if ((src[current_src_posn] == c2b_tab_delim) || (src[current_src_posn] == c2b_line_delim)) {
-            gff_field_offsets[gff_field_idx++] = current_src_posn;
-        }
-        if (gff_field_idx >= C2B_MAX_FIELD_COUNT_VALUE) {
-            fprintf(stderr, "Error: Invalid field count (%d) -- input file may have too many fields\n", gff_field_idx);
-            c2b_print_usage(stderr);
-            exit(EINVAL); /* Invalid argument (POSIX.1) */
-        }
+        dest_posn = c2b_emit_span(dest_posn, g.attributes, c2b_tab_delim);
+        dest_posn = c2b_emit_span(dest_posn, g.comments, c2b_line_delim);
     }
-    gff_field_offsets[gff_field_idx] = src_size;
-    gff_field_offsets[gff_field_idx + 1] = -1;
+
+    dest->size = dest_posn - dest->buf;
+}
+
+static void
+c2b_line_convert_gff_to_bed_unsorted(c2b_context_t *ctx, c2b_output_t *dest, char *src, ssize_t src_size)
+{
+    c2b_span_t gff_fields[C2B_MAX_FIELD_COUNT_VALUE];
+    int gff_field_idx = c2b_split_fields(ctx, src, src_size, gff_fields);
 
     /* 
        If number of fields is not in bounds, we may need to exit early
@@ -1156,33 +478,22 @@ c2b_line_convert_gff_to_bed_unsorted(char *dest, ssize_t *dest_size, char *src,
 
     if (((gff_field_idx + 1) < c2b_gff_field_min) || ((gff_field_idx + 1) > c2b_gff_field_max)) {
         if (gff_field_idx == 0) {
-            char non_interval_str[C2B_MAX_FIELD_LENGTH_VALUE];
-            memcpy(non_interval_str, src, current_src_posn);
-            non_interval_str[current_src_posn] = '\0';
-            char non_int_prefix[C2B_MAX_FIELD_LENGTH_VALUE];
-            strncpy(non_int_prefix, non_interval_str, 2);
-            non_int_prefix[2] = '\0';
+            c2b_span_t non_interval = gff_fields[0];
             /* We compare against either of two standard GFF3 or GVF header pragmas */
-            if ((strcmp(non_interval_str, c2b_gff_header) == 0) || 
-                (strcmp(non_interval_str, c2b_gvf_header) == 0) || 
-                (strcmp(non_int_prefix, c2b_gvf_generic_header) == 0)) {
+            if (c2b_span_equals(non_interval, c2b_gff_header) || 
+                c2b_span_equals(non_interval, c2b_gvf_header) || 
+                ((non_interval.length >= (ssize_t) strlen(c2b_gvf_generic_header)) && 
+                 (memcmp(non_interval.s, c2b_gvf_generic_header, strlen(c2b_gvf_generic_header)) == 0))) {
                 if (!c2b_globals.keep_header_flag) {
                     return;
                 }
                 else {
                     /* copy header line to destination stream buffer */
-                    char src_header_line_str[C2B_MAX_LINE_LENGTH_VALUE];
-                    char dest_header_line_str[C2B_MAX_LINE_LENGTH_VALUE];
-                    memcpy(src_header_line_str, src, src_size);
-                    src_header_line_str[src_size] = '\0';
-                    sprintf(dest_header_line_str, "%s\t%u\t%u\t%s\n", c2b_header_chr_name, c2b_globals.header_line_idx, (c2b_globals.header_line_idx + 1), src_header_line_str);
-                    memcpy(dest + *dest_size, dest_header_line_str, strlen(dest_header_line_str));
-                    *dest_size += strlen(dest_header_line_str);
-                    c2b_globals.header_line_idx++;
+                    c2b_line_convert_header_to_bed(ctx, dest, src, src_size);
                     return;                    
                 }
             }
-            else if (strcmp(non_interval_str, c2b_gff_fasta) == 0) {
+            else if (c2b_span_equals(non_interval, c2b_gff_fasta)) {
                 return;
             }
             else {
@@ -1196,83 +507,35 @@ c2b_line_convert_gff_to_bed_unsorted(char *dest, ssize_t *dest_size, char *src,
         }
     }
 
-    /* 0 - seqid */
-    char seqid_str[C2B_MAX_FIELD_LENGTH_VALUE];
-    ssize_t seqid_size = gff_field_offsets[0];
-    memcpy(seqid_str, src, seqid_size);
-    seqid_str[seqid_size] = '\0';
-
-    /* 1 - source */
-    char source_str[C2B_MAX_FIELD_LENGTH_VALUE];
-    ssize_t source_size = gff_field_offsets[1] - gff_field_offsets[0] - 1;
-    memcpy(source_str, src + gff_field_offsets[0] + 1, source_size);
-    source_str[source_size] = '\0';
-
-    /* 2 - type */
-    char type_str[C2B_MAX_FIELD_LENGTH_VALUE];
-    ssize_t type_size = gff_field_offsets[2] - gff_field_offsets[1] - 1;
-    memcpy(type_str, src + gff_field_offsets[1] + 1, type_size);
-    type_str[type_size] = '\0';
-
-    /* 3 - start */
-    char start_str[C2B_MAX_FIELD_LENGTH_VALUE];
-    ssize_t start_size = gff_field_offsets[3] - gff_field_offsets[2] - 1;
-    memcpy(start_str, src + gff_field_offsets[2] + 1, start_size);
-    start_str[start_size] = '\0';
-    uint64_t start_val = strtoull(start_str, NULL, 10);
-
-    /* 4 - end */
-    char end_str[C2B_MAX_FIELD_LENGTH_VALUE];
-    ssize_t end_size = gff_field_offsets[4] - gff_field_offsets[3] - 1;
-    memcpy(end_str, src + gff_field_offsets[3] + 1, end_size);
-    end_str[end_size] = '\0';
-    uint64_t end_val = strtoull(end_str, NULL, 10);
-
-    /* 5 - score */
-    char score_str[C2B_MAX_FIELD_LENGTH_VALUE];
-    ssize_t score_size = gff_field_offsets[5] - gff_field_offsets[4] - 1;
-    memcpy(score_str, src + gff_field_offsets[4] + 1, score_size);
-    score_str[score_size] = '\0';
-
-    /* 6 - strand */
-    char strand_str[C2B_MAX_FIELD_LENGTH_VALUE];
-    ssize_t strand_size = gff_field_offsets[6] - gff_field_offsets[5] - 1;
-    memcpy(strand_str, src + gff_field_offsets[5] + 1, strand_size);
-    strand_str[strand_size] = '\0';
-
-    /* 7 - phase */
-    char phase_str[C2B_MAX_FIELD_LENGTH_VALUE];
-    ssize_t phase_size = gff_field_offsets[7] - gff_field_offsets[6] - 1;
-    memcpy(phase_str, src + gff_field_offsets[6] + 1, phase_size);
-    phase_str[phase_size] = '\0';
-
-    /* 8 - attributes */
-    char attributes_str[C2B_MAX_FIELD_LENGTH_VALUE];
-    ssize_t attributes_size = gff_field_offsets[8] - gff_field_offsets[7] - 1;
-    memcpy(attributes_str, src + gff_field_offsets[7] + 1, attributes_size);
-    attributes_str[attributes_size] = '\0';
-
     c2b_gff_t gff;
-    gff.seqid = seqid_str;
-    gff.source = source_str;
-    gff.type = type_str;
-    gff.start = start_val;
-    gff.end = end_val;
-    gff.score = score_str;
-    gff.strand = strand_str;
-    gff.phase = phase_str;
-    gff.attributes = attributes_str;
+    gff.seqid = gff_fields[0];
+    gff.source = gff_fields[1];
+    gff.type = gff_fields[2];
+    gff.start = c2b_span_to_uint64(gff_fields[3]);
+    gff.end = c2b_span_to_uint64(gff_fields[4]);
+    gff.score = gff_fields[5];
+    gff.strand = gff_fields[6];
+    gff.phase = gff_fields[7];
+    gff.attributes = gff_fields[8];
 
     /* 
-       Fix coordinate indexing, and (if needed) add attribute for zero-length record
+       Fix coordinate indexing, and (if needed) add attribute for zero-length record; 
+       only this case needs its own copy of the attributes field
     */
 
+    char attributes_str[C2B_MAX_FIELD_LENGTH_VALUE];
     if (gff.start == gff.end) {
         gff.start -= 1;
-        ssize_t trailing_semicolon_fudge = (attributes_str[strlen(attributes_str) - 1] == ';') ? 1 : 0;
-        memcpy(attributes_str + strlen(attributes_str) - trailing_semicolon_fudge,
+        ssize_t trailing_semicolon_fudge = ((gff.attributes.length > 0) && (gff.attributes.s[gff.attributes.length - 1] == ';')) ? 1 : 0;
+        ssize_t attributes_size = gff.attributes.length - trailing_semicolon_fudge;
+        if (attributes_size + (ssize_t) strlen(c2b_gff_zero_length_insertion_attribute) > C2B_MAX_FIELD_LENGTH_VALUE)
+            c2b_field_overflow("GFF attributes");
+        memcpy(attributes_str, gff.attributes.s, attributes_size);
+        memcpy(attributes_str + attributes_size,
                c2b_gff_zero_length_insertion_attribute, 
-               strlen(c2b_gff_zero_length_insertion_attribute) + 1);
+               strlen(c2b_gff_zero_length_insertion_attribute));
+        gff.attributes.s = attributes_str;
+        gff.attributes.length = attributes_size + strlen(c2b_gff_zero_length_insertion_attribute);
     }
     else {
         gff.start -= 1;
@@ -1282,37 +545,36 @@ c2b_line_convert_gff_to_bed_unsorted(char *dest, ssize_t *dest_size, char *src,
        Parse ID value out from attributes string
     */
 
-    char *attributes_copy = NULL;
-    attributes_copy = malloc(strlen(attributes_str) + 1);
-    if (!attributes_copy) {
-        fprintf(stderr, "Error: Could not allocate space for GFF attributes copy\n");
-        exit(ENOMEM); /* Not enough space (POSIX.1) */
-    }
-    memcpy(attributes_copy, attributes_str, strlen(attributes_str) + 1);
-    const char *kv_tok;
     const char *gff_id_prefix = "ID=";
+    ssize_t gff_id_prefix_size = strlen(gff_id_prefix);
     const char *gff_null_id = ".";
-    char *id_str = NULL;
-    memcpy(c2b_globals.gff->id, gff_null_id, strlen(gff_null_id) + 1);
-    while ((kv_tok = c2b_strsep(&attributes_copy, ";")) != NULL) {
-        id_str = strstr(kv_tok, gff_id_prefix);
-        if (id_str) {
-            memcpy(c2b_globals.gff->id, kv_tok + strlen(gff_id_prefix), strlen(kv_tok + strlen(gff_id_prefix)) + 1);
-            c2b_globals.gff->id[strlen(kv_tok + strlen(gff_id_prefix)) + 1] = '\0';
+    c2b_span_t kv_tok;
+    char *attributes_end = gff.attributes.s + gff.attributes.length;
+    gff.id.s = (char *) gff_null_id;
+    gff.id.length = strlen(gff_null_id);
+    kv_tok.s = gff.attributes.s;
+    do {
+        char *kv_tok_end = memchr(kv_tok.s, ';', attributes_end - kv_tok.s);
+        if (!kv_tok_end) {
+            kv_tok_end = attributes_end;
         }
-    }
-    free(attributes_copy), attributes_copy = NULL;
-    gff.id = c2b_globals.gff->id;
+        kv_tok.length = kv_tok_end - kv_tok.s;
+        if (c2b_span_find(kv_tok, gff_id_prefix)) {
+            gff.id.s = kv_tok.s + gff_id_prefix_size;
+            gff.id.length = kv_tok.length - gff_id_prefix_size;
+        }
+        kv_tok.s = kv_tok_end + 1;
+    } while (kv_tok.s <= attributes_end);
 
     /* 
        Convert GFF struct to BED string and copy it to destination
     */
 
-    c2b_line_convert_gff_to_bed(gff, dest, dest_size);
+    c2b_line_convert_gff_to_bed(gff, dest);
 }
 
 static inline void
-c2b_line_convert_gff_to_bed(c2b_gff_t g, char *dest_line, ssize_t *dest_size)
+c2b_line_convert_gff_to_bed(c2b_gff_t g, c2b_output_t *dest)
 {
     /* 
        For GFF- and GVF-formatted data, we use the mapping provided by BEDOPS convention described at:
@@ -1338,48 +600,30 @@ c2b_line_convert_gff_to_bed(c2b_gff_t g, char *dest_line, ssize_t *dest_size)
        attributes                10                     -
     */
 
-    *dest_size += sprintf(dest_line + *dest_size,
-                          "%s\t"                \
-                          "%" PRIu64 "\t"       \
-                          "%" PRIu64 "\t"       \
-                          "%s\t"                \
-                          "%s\t"                \
-                          "%s\t"                \
-                          "%s\t"                \
-                          "%s\t"                \
-                          "%s\t"                \
-                          "%s\n",
-                          g.seqid,
-                          g.start,
-                          g.end,
-                          g.id,
-                          g.score,
-                          g.strand,
-                          g.source,
-                          g.type,
-                          g.phase,
-                          g.attributes);
-}
-
-static void
-c2b_line_convert_psl_to_bed_unsorted(char *dest, ssize_t *dest_size, char *src, ssize_t src_size)
-{
-    ssize_t psl_field_offsets[C2B_MAX_FIELD_COUNT_VALUE];
-    int psl_field_idx = 0;
-    ssize_t current_src_posn = -1;
+    char *dest_posn = c2b_reserve_output(dest,
+                                         g.seqid.length + g.id.length + g.score.length + g.strand.length + 
+                                         g.source.length + g.type.length + g.phase.length + g.attributes.length + 
+                                         8 + 2 * C2B_MAX_UINT64_FIELD_LENGTH_VALUE);
+
+    dest_posn = c2b_emit_span(dest_posn, g.seqid, c2b_tab_delim);
+    dest_posn = c2b_emit_uint64(dest_posn, g.start, c2b_tab_delim);
+    dest_posn = c2b_emit_uint64(dest_posn, g.end, c2b_tab_delim);
+    dest_posn = c2b_emit_span(dest_posn, g.id, c2b_tab_delim);
+    dest_posn = c2b_emit_span(dest_posn, g.score, c2b_tab_delim);
+    dest_posn = c2b_emit_span(dest_posn, g.strand, c2b_tab_delim);
+    dest_posn = c2b_emit_span(dest_posn, g.source, c2b_tab_delim);
+    dest_posn = c2b_emit_span(dest_posn, g.type, c2b_tab_delim);
+    dest_posn = c2b_emit_span(dest_posn, g.phase, c2b_tab_delim);
+    dest_posn = c2b_emit_span(dest_posn, g.attributes, c2b_line_delim);
+
+    dest->size = dest_posn - dest->buf;
+}
 
-    while (++current_src_posn < src_size) {
-        if ((src[current_src_posn] == c2b_tab_delim) || (src[current_src_posn] == c2b_line_delim)) {
-            psl_field_offsets[psl_field_idx++] = current_src_posn;
-        }
-        if (psl_field_idx >= C2B_MAX_FIELD_COUNT_VALUE) {
-            fprintf(stderr, "Error: Invalid field count (%d) -- input file may have too many fields\n", psl_field_idx);
-            c2b_print_usage(stderr);
-            exit(EINVAL); /* Invalid argument (POSIX.1) */
-        }
-    }
-    psl_field_offsets[psl_field_idx] = src_size;
-    psl_field_offsets[psl_field_idx + 1] = -1;
+static void
+c2b_line_convert_psl_to_bed_unsorted(c2b_context_t *ctx, c2b_output_t *dest, char *src, ssize_t src_size)
+{
+    c2b_span_t psl_fields[C2B_MAX_FIELD_COUNT_VALUE];
+    int psl_field_idx = c2b_split_fields(ctx, src, src_size, psl_fields);
 
     /* 
        If number of fields is not in bounds, we may need to exit early
@@ -1387,24 +631,17 @@ c2b_line_convert_psl_to_bed_unsorted(char *dest, ssize_t *dest_size, char *src,
 
     if (((psl_field_idx + 1) < c2b_psl_field_min) || ((psl_field_idx + 1) > c2b_psl_field_max)) {
         if ((psl_field_idx == 0) || (psl_field_idx == 17)) {
-            if ((c2b_globals.psl->is_headered) && (c2b_globals.keep_header_flag) && (c2b_globals.header_line_idx <= 5)) {
+            if ((c2b_globals.psl->is_headered) && (c2b_globals.keep_header_flag) && (ctx->header_line_idx <= 5)) {
                 /* copy header line to destination stream buffer */
-                char src_header_line_str[C2B_MAX_LINE_LENGTH_VALUE];
-                char dest_header_line_str[C2B_MAX_LINE_LENGTH_VALUE];
-                memcpy(src_header_line_str, src, src_size);
-                src_header_line_str[src_size] = '\0';
-                sprintf(dest_header_line_str, "%s\t%u\t%u\t%s\n", c2b_header_chr_name, c2b_globals.header_line_idx, (c2b_globals.header_line_idx + 1), src_header_line_str);
-                memcpy(dest + *dest_size, dest_header_line_str, strlen(dest_header_line_str));
-                *dest_size += strlen(dest_header_line_str);
-                c2b_globals.header_line_idx++;
+                c2b_line_convert_header_to_bed(ctx, dest, src, src_size);
                 return;                    
             }
-            else if ((c2b_globals.psl->is_headered) && (c2b_globals.header_line_idx <= 5)) {
-                c2b_globals.header_line_idx++;
+            else if ((c2b_globals.psl->is_headered) && (ctx->header_line_idx <= 5)) {
+                ctx->header_line_idx++;
                 return;
             }
             else {
-                fprintf(stderr, "Error: Possible corrupt input on line %u -- if PSL input is headered, use the --headered option\n", c2b_globals.header_line_idx);
+                fprintf(stderr, "Error: Possible corrupt input on line %u -- if PSL input is headered, use the --headered option\n", ctx->header_line_idx);
                 c2b_print_usage(stderr);
                 exit(EINVAL); /* Invalid argument (POSIX.1) */
             }
@@ -1416,375 +653,118 @@ c2b_line_convert_psl_to_bed_unsorted(char *dest, ssize_t *dest_size, char *src,
         }
     }
 
-    /* 0 - matches */
-    char matches_str[C2B_MAX_FIELD_LENGTH_VALUE];
-    ssize_t matches_size = psl_field_offsets[0];
-    memcpy(matches_str, src, matches_size);
-    matches_str[matches_size] = '\0';
-    uint64_t matches_val = strtoull(matches_str, NULL, 10);
-
-#ifdef DEBUG
-    fprintf(stderr, "matches_str: [%s]\n", matches_str);
-#endif
+    c2b_psl_t psl;
+    psl.matches = c2b_span_to_uint64(psl_fields[0]);
 
     /* 
        We test if matches is a number or string, as one of the header 
        lines can mimic a genomic element
     */
 
-    if ((matches_val == 0) && (!isdigit(matches_str[0]))) {
-        if ((c2b_globals.psl->is_headered) && (c2b_globals.keep_header_flag) && (c2b_globals.header_line_idx <= 5)) {
+    if ((psl.matches == 0) && ((psl_fields[0].length == 0) || (!isdigit(psl_fields[0].s[0])))) {
+        if ((c2b_globals.psl->is_headered) && (c2b_globals.keep_header_flag) && (ctx->header_line_idx <= 5)) {
             /* copy header line to destination stream buffer */
-            char src_header_line_str[C2B_MAX_LINE_LENGTH_VALUE];
-            char dest_header_line_str[C2B_MAX_LINE_LENGTH_VALUE];
-            memcpy(src_header_line_str, src, src_size);
-            src_header_line_str[src_size] = '\0';
-            sprintf(dest_header_line_str, "%s\t%u\t%u\t%s\n", c2b_header_chr_name, c2b_globals.header_line_idx, (c2b_globals.header_line_idx + 1), src_header_line_str);
-            memcpy(dest + *dest_size, dest_header_line_str, strlen(dest_header_line_str));
-            *dest_size += strlen(dest_header_line_str);
-            c2b_globals.header_line_idx++;
+            c2b_line_convert_header_to_bed(ctx, dest, src, src_size);
         }
         return;
     }
 
-    /* 1 - misMatches */
-    char misMatches_str[C2B_MAX_FIELD_LENGTH_VALUE];
-    ssize_t misMatches_size = psl_field_offsets[1] - psl_field_offsets[0] - 1;
-    memcpy(misMatches_str, src + psl_field_offsets[0] + 1, misMatches_size);
-    misMatches_str[misMatches_size] = '\0';
-    uint64_t misMatches_val = strtoull(misMatches_str, NULL, 10);
-    
-#ifdef DEBUG
-    fprintf(stderr, "misMatches_str: [%s]\n", misMatches_str);
-#endif
-
-    /* 2 - repMatches */
-    char repMatches_str[C2B_MAX_FIELD_LENGTH_VALUE];
-    ssize_t repMatches_size = psl_field_offsets[2] - psl_field_offsets[1] - 1;
-    memcpy(repMatches_str, src + psl_field_offsets[1] + 1, repMatches_size);
-    repMatches_str[repMatches_size] = '\0';
-    uint64_t repMatches_val = strtoull(repMatches_str, NULL, 10);
-
-#ifdef DEBUG
-    fprintf(stderr, "repMatches_str: [%s]\n", repMatches_str);
-#endif
-
-    /* 3 - nCount */
-    char nCount_str[C2B_MAX_FIELD_LENGTH_VALUE];
-    ssize_t nCount_size = psl_field_offsets[3] - psl_field_offsets[2] - 1;
-    memcpy(nCount_str, src + psl_field_offsets[2] + 1, nCount_size);
-    nCount_str[nCount_size] = '\0';
-    uint64_t nCount_val = strtoull(nCount_str, NULL, 10);
-
-#ifdef DEBUG
-    fprintf(stderr, "nCount_str: [%s]\n", nCount_str);
-#endif
-
-    /* 4 - qNumInsert */
-    char qNumInsert_str[C2B_MAX_FIELD_LENGTH_VALUE];
-    ssize_t qNumInsert_size = psl_field_offsets[4] - psl_field_offsets[3] - 1;
-    memcpy(qNumInsert_str, src + psl_field_offsets[3] + 1, qNumInsert_size);
-    qNumInsert_str[qNumInsert_size] = '\0';
-    uint64_t qNumInsert_val = strtoull(qNumInsert_str, NULL, 10);
-
-#ifdef DEBUG
-    fprintf(stderr, "qNumInsert_str: [%s]\n", qNumInsert_str);
-#endif
-
-    /* 5 - qBaseInsert */
-    char qBaseInsert_str[C2B_MAX_FIELD_LENGTH_VALUE];
-    ssize_t qBaseInsert_size = psl_field_offsets[5] - psl_field_offsets[4] - 1;
-    memcpy(qBaseInsert_str, src + psl_field_offsets[4] + 1, qBaseInsert_size);
-    qBaseInsert_str[qBaseInsert_size] = '\0';
-    uint64_t qBaseInsert_val = strtoull(qBaseInsert_str, NULL, 10);
-
-#ifdef DEBUG
-    fprintf(stderr, "qBaseInsert_str: [%s]\n", qBaseInsert_str);
-#endif
-
-    /* 6 - tNumInsert */
-    char tNumInsert_str[C2B_MAX_FIELD_LENGTH_VALUE];
-    ssize_t tNumInsert_size = psl_field_offsets[6] - psl_field_offsets[5] - 1;
-    memcpy(tNumInsert_str, src + psl_field_offsets[5] + 1, tNumInsert_size);
-    tNumInsert_str[tNumInsert_size] = '\0';
-    uint64_t tNumInsert_val = strtoull(tNumInsert_str, NULL, 10);
-
-#ifdef DEBUG
-    fprintf(stderr, "tNumInsert_str: [%s]\n", tNumInsert_str);
-#endif
-
-    /* 7 - tBaseInsert */
-    char tBaseInsert_str[C2B_MAX_FIELD_LENGTH_VALUE];
-    ssize_t tBaseInsert_size = psl_field_offsets[7] - psl_field_offsets[6] - 1;
-    memcpy(tBaseInsert_str, src + psl_field_offsets[6] + 1, tBaseInsert_size);
-    tBaseInsert_str[tBaseInsert_size] = '\0';
-    uint64_t tBaseInsert_val = strtoull(tBaseInsert_str, NULL, 10);
-
-#ifdef DEBUG
-    fprintf(stderr, "tBaseInsert_str: [%s]\n", tBaseInsert_str);
-#endif
-
-    /* 8 - strand */
-    char strand_str[C2B_MAX_FIELD_LENGTH_VALUE];
-    ssize_t strand_size = psl_field_offsets[8] - psl_field_offsets[7] - 1;
-    memcpy(strand_str, src + psl_field_offsets[7] + 1, strand_size);
-    strand_str[strand_size] = '\0';
-
-#ifdef DEBUG
-    fprintf(stderr, "strand_str: [%s]\n", strand_str);
-#endif
-
-    /* 9 - qName */
-    char qName_str[C2B_MAX_FIELD_LENGTH_VALUE];
-    ssize_t qName_size = psl_field_offsets[9] - psl_field_offsets[8] - 1;
-    memcpy(qName_str, src + psl_field_offsets[8] + 1, qName_size);
-    qName_str[qName_size] = '\0';
-
-#ifdef DEBUG
-    fprintf(stderr, "qName_str: [%s]\n", qName_str);
-#endif
-
-    /* 10 - qSize */
-    char qSize_str[C2B_MAX_FIELD_LENGTH_VALUE];
-    ssize_t qSize_size = psl_field_offsets[10] - psl_field_offsets[9] - 1;
-    memcpy(qSize_str, src + psl_field_offsets[9] + 1, qSize_size);
-    qSize_str[qSize_size] = '\0';
-    uint64_t qSize_val = strtoull(qSize_str, NULL, 10);
-
-#ifdef DEBUG
-    fprintf(stderr, "qSize_str: [%s]\n", qSize_str);
-#endif
-
-    /* 11 - qStart */
-    char qStart_str[C2B_MAX_FIELD_LENGTH_VALUE];
-    ssize_t qStart_size = psl_field_offsets[11] - psl_field_offsets[10] - 1;
-    memcpy(qStart_str, src + psl_field_offsets[10] + 1, qStart_size);
-    qStart_str[qStart_size] = '\0';
-    uint64_t qStart_val = strtoull(qStart_str, NULL, 10);
-
-#ifdef DEBUG
-    fprintf(stderr, "qStart_str: [%s]\n", qStart_str);
-#endif
-
-    /* 12 - qEnd */
-    char qEnd_str[C2B_MAX_FIELD_LENGTH_VALUE];
-    ssize_t qEnd_size = psl_field_offsets[12] - psl_field_offsets[11] - 1;
-    memcpy(qEnd_str, src + psl_field_offsets[11] + 1, qEnd_size);
-    qEnd_str[qEnd_size] = '\0';
-    uint64_t qEnd_val = strtoull(qEnd_str, NULL, 10);
-
-#ifdef DEBUG
-    fprintf(stderr, "qEnd_str: [%s]\n", qEnd_str);
-#endif
-
-    /* 13 - tName */
-    char tName_str[C2B_MAX_FIELD_LENGTH_VALUE];
-    ssize_t tName_size = psl_field_offsets[13] - psl_field_offsets[12] - 1;
-    memcpy(tName_str, src + psl_field_offsets[12] + 1, tName_size);
-    tName_str[tName_size] = '\0';
-
-#ifdef DEBUG
-    fprintf(stderr, "tName_str: [%s]\n", tName_str);
-#endif
-
-    /* 14 - tSize */
-    char tSize_str[C2B_MAX_FIELD_LENGTH_VALUE];
-    ssize_t tSize_size = psl_field_offsets[14] - psl_field_offsets[13] - 1;
-    memcpy(tSize_str, src + psl_field_offsets[13] + 1, tSize_size);
-    tSize_str[tSize_size] = '\0';
-    uint64_t tSize_val = strtoull(tSize_str, NULL, 10);
-
-#ifdef DEBUG
-    fprintf(stderr, "tSize_str: [%s]\n", tSize_str);
-#endif
-
-    /* 15 - tStart */
-    char tStart_str[C2B_MAX_FIELD_LENGTH_VALUE];
-    ssize_t tStart_size = psl_field_offsets[15] - psl_field_offsets[14] - 1;
-    memcpy(tStart_str, src + psl_field_offsets[14] + 1, tStart_size);
-    tStart_str[tStart_size] = '\0';
-    uint64_t tStart_val = strtoull(tStart_str, NULL, 10);
-
-#ifdef DEBUG
-    fprintf(stderr, "tStart_str: [%s]\n", tStart_str);
-#endif
-
-    /* 16 - tEnd */
-    char tEnd_str[C2B_MAX_FIELD_LENGTH_VALUE];
-    ssize_t tEnd_size = psl_field_offsets[16] - psl_field_offsets[15] - 1;
-    memcpy(tEnd_str, src + psl_field_offsets[15] + 1, tEnd_size);
-    tEnd_str[tEnd_size] = '\0';
-    uint64_t tEnd_val = strtoull(tEnd_str, NULL, 10);
-
-#ifdef DEBUG
-    fprintf(stderr, "tEnd_str: [%s]\n", tEnd_str);
-#endif
-
-    /* 17 - blockCount */
-    char blockCount_str[C2B_MAX_FIELD_LENGTH_VALUE];
-    ssize_t blockCount_size = psl_field_offsets[17] - psl_field_offsets[16] - 1;
-    memcpy(blockCount_str, src + psl_field_offsets[16] + 1, blockCount_size);
-    blockCount_str[blockCount_size] = '\0';
-    uint64_t blockCount_val = strtoull(blockCount_str, NULL, 10);
-
-#ifdef DEBUG
-    fprintf(stderr, "blockCount_str: [%s]\n", blockCount_str);
-#endif
-
-    /* 18 - blockSizes */
-    char blockSizes_str[C2B_MAX_FIELD_LENGTH_VALUE];
-    ssize_t blockSizes_size = psl_field_offsets[18] - psl_field_offsets[17] - 1;
-    memcpy(blockSizes_str, src + psl_field_offsets[17] + 1, blockSizes_size);
-    blockSizes_str[blockSizes_size] = '\0';
-
-#ifdef DEBUG
-    fprintf(stderr, "blockSizes_str: [%s]\n", blockSizes_str);
-#endif
-
-    /* 19 - qStarts */
-    char qStarts_str[C2B_MAX_FIELD_LENGTH_VALUE];
-    ssize_t qStarts_size = psl_field_offsets[19] - psl_field_offsets[18] - 1;
-    memcpy(qStarts_str, src + psl_field_offsets[18] + 1, qStarts_size);
-    qStarts_str[qStarts_size] = '\0';
-
-#ifdef DEBUG
-    fprintf(stderr, "qStarts_str: [%s]\n", qStarts_str);
-#endif
-
-    /* 20 - tStarts */
-    char tStarts_str[C2B_MAX_FIELD_LENGTH_VALUE];
-    ssize_t tStarts_size = psl_field_offsets[20] - psl_field_offsets[19] - 1;
-    memcpy(tStarts_str, src + psl_field_offsets[19] + 1, tStarts_size);
-    tStarts_str[tStarts_size] = '\0';
-
-#ifdef DEBUG
-    fprintf(stderr, "tStarts_str: [%s]\n", tStarts_str);
-#endif
-
-    c2b_psl_t psl;
-    psl.matches = matches_val;
-    psl.misMatches = misMatches_val;
-    psl.repMatches = repMatches_val;
-    psl.nCount = nCount_val;
-    psl.qNumInsert = qNumInsert_val;
-    psl.qBaseInsert = qBaseInsert_val;
-    psl.tNumInsert = tNumInsert_val;
-    psl.tBaseInsert = tBaseInsert_val;
-    psl.strand = strand_str;
-    psl.qName = qName_str;
-    psl.qSize = qSize_val;
-    psl.qStart = qStart_val;
-    psl.qEnd = qEnd_val;
-    psl.tName = tName_str;
-    psl.tSize = tSize_val;
-    psl.tStart = tStart_val;
-    psl.tEnd = tEnd_val;
-    psl.blockCount = blockCount_val;
-    psl.blockSizes = blockSizes_str;
-    psl.qStarts = qStarts_str;
-    psl.tStarts = tStarts_str;
+    psl.misMatches = c2b_span_to_uint64(psl_fields[1]);
+    psl.repMatches = c2b_span_to_uint64(psl_fields[2]);
+    psl.nCount = c2b_span_to_uint64(psl_fields[3]);
+    psl.qNumInsert = c2b_span_to_uint64(psl_fields[4]);
+    psl.qBaseInsert = c2b_span_to_uint64(psl_fields[5]);
+    psl.tNumInsert = c2b_span_to_uint64(psl_fields[6]);
+    psl.tBaseInsert = c2b_span_to_uint64(psl_fields[7]);
+    psl.strand = psl_fields[8];
+    psl.qName = psl_fields[9];
+    psl.qSize = c2b_span_to_uint64(psl_fields[10]);
+    psl.qStart = c2b_span_to_uint64(psl_fields[11]);
+    psl.qEnd = c2b_span_to_uint64(psl_fields[12]);
+    psl.tName = psl_fields[13];
+    psl.tSize = c2b_span_to_uint64(psl_fields[14]);
+    psl.tStart = c2b_span_to_uint64(psl_fields[15]);
+    psl.tEnd = c2b_span_to_uint64(psl_fields[16]);
+    psl.blockCount = c2b_span_to_uint64(psl_fields[17]);
+    psl.blockSizes = psl_fields[18];
+    psl.qStarts = psl_fields[19];
+    psl.tStarts = psl_fields[20];
 
     /* 
        Convert PSL struct to BED string and copy it to destination
     */
 
-    if ((c2b_globals.split_flag) && (blockCount_val > 1)) {
-        if (c2b_globals.psl->block->max_count < blockCount_val) {
-            fprintf(stderr, "Error: Insufficent PSL block state global size\n");
+    if ((c2b_globals.split_flag) && (psl.blockCount > 1)) {
+        uint64_t block_sizes[C2B_MAX_PSL_BLOCKS];
+        uint64_t block_starts[C2B_MAX_PSL_BLOCKS];
+        if (psl.blockCount > C2B_MAX_PSL_BLOCKS) {
+            fprintf(stderr, "Error: Insufficent PSL block state size\n");
             exit(ENOMEM); /* Not enough space (POSIX.1) */
         }
-        /* parse tStarts_str and blockSizes_str to write per-block elements */
-        c2b_psl_blockSizes_to_ptr(blockSizes_str, blockCount_val);
-        c2b_psl_tStarts_to_ptr(tStarts_str, blockCount_val);
-        for (uint64_t bc_idx = 0; bc_idx < blockCount_val; bc_idx++) {
-            psl.tStart = c2b_globals.psl->block->starts[bc_idx];
-            psl.tEnd = c2b_globals.psl->block->starts[bc_idx] + c2b_globals.psl->block->sizes[bc_idx];
-            c2b_line_convert_psl_to_bed(psl, dest, dest_size);
+        /* parse tStarts and blockSizes to write per-block elements */
+        c2b_psl_blockSizes_to_ptr(psl.blockSizes, psl.blockCount, block_sizes);
+        c2b_psl_tStarts_to_ptr(psl.tStarts, psl.blockCount, block_starts);
+        for (uint64_t bc_idx = 0; bc_idx < psl.blockCount; bc_idx++) {
+            psl.tStart = block_starts[bc_idx];
+            psl.tEnd = block_starts[bc_idx] + block_sizes[bc_idx];
+            c2b_line_convert_psl_to_bed(psl, dest);
         }
     }
     else {
-        c2b_line_convert_psl_to_bed(psl, dest, dest_size);
+        c2b_line_convert_psl_to_bed(psl, dest);
     }
 }
 
 static inline void
-c2b_psl_blockSizes_to_ptr(char *s, uint64_t bc) 
+c2b_psl_blockSizes_to_ptr(c2b_span_t s, uint64_t bc, uint64_t *sizes) 
 {
-    size_t start_bs_offset = 0;
-    size_t end_bs_index = 0;
-    size_t length_bs_offset = 0;
-    uint64_t bc_idx;
-    char bs_arr[C2B_MAX_PSL_BLOCK_SIZES_STRING_LENGTH];
+    char *bs_start = s.s;
+    char *bs_end = s.s + s.length;
     char *bs_ptr = NULL;
-    uint64_t bs_val = 0;
+    c2b_span_t bs_tok;
+    uint64_t bc_idx;
 
     for (bc_idx = 0; bc_idx < bc; bc_idx++) {
-        bs_ptr = strchr(s + start_bs_offset, c2b_psl_blockSizes_delimiter);
-#ifdef DEBUG
-        fprintf(stderr, "s: [%s] | bs_ptr: [%s]\n", s, bs_ptr);
-#endif
+        bs_ptr = memchr(bs_start, c2b_psl_blockSizes_delimiter, bs_end - bs_start);
         if (bs_ptr) {
-            end_bs_index = bs_ptr - s;
-#ifdef DEBUG
-            fprintf(stderr, "start_bs_offset: [%zu] | end_bs_index: [%zu]\n", start_bs_offset, end_bs_index);
-#endif
-            length_bs_offset = end_bs_index - start_bs_offset;
-            if (length_bs_offset > C2B_MAX_PSL_BLOCK_SIZES_STRING_LENGTH) {
+            bs_tok.s = bs_start;
+            bs_tok.length = bs_ptr - bs_start;
+            if (bs_tok.length > C2B_MAX_PSL_BLOCK_SIZES_STRING_LENGTH) {
                 fprintf(stderr, "Error: PSL block size string length too long\n");
                 exit(EINVAL); // Invalid argument (POSIX.1)
             }
-            memcpy(bs_arr, s + start_bs_offset, length_bs_offset);
-            bs_arr[length_bs_offset] = '\0';
-#ifdef DEBUG
-            fprintf(stderr, "bs_arr: [%s]\n", bs_arr);
-#endif
-            bs_val = strtoull(bs_arr, NULL, 10);
-            c2b_globals.psl->block->sizes[bc_idx] = bs_val;
-            start_bs_offset = end_bs_index + 1;
+            sizes[bc_idx] = c2b_span_to_uint64(bs_tok);
+            bs_start = bs_ptr + 1;
         }
     }
 }
 
 static inline void
-c2b_psl_tStarts_to_ptr(char *s, uint64_t bc) 
+c2b_psl_tStarts_to_ptr(c2b_span_t s, uint64_t bc, uint64_t *starts) 
 {
-    size_t start_ts_offset = 0;
-    size_t end_ts_index = 0;
-    size_t length_ts_offset = 0;
-    uint64_t bc_idx;
-    char ts_arr[C2B_MAX_PSL_T_STARTS_STRING_LENGTH];
+    char *ts_start = s.s;
+    char *ts_end = s.s + s.length;
     char *ts_ptr = NULL;
-    uint64_t ts_val = 0;
+    c2b_span_t ts_tok;
+    uint64_t bc_idx;
 
     for (bc_idx = 0; bc_idx < bc; bc_idx++) {
-        ts_ptr = strchr(s + start_ts_offset, c2b_psl_tStarts_delimiter);
-#ifdef DEBUG
-        fprintf(stderr, "s: [%s] | ts_ptr: [%s]\n", s, ts_ptr);
-#endif
+        ts_ptr = memchr(ts_start, c2b_psl_tStarts_delimiter, ts_end - ts_start);
         if (ts_ptr) {
-            end_ts_index = ts_ptr - s;
-#ifdef DEBUG
-            fprintf(stderr, "start_ts_offset: [%zu] | end_ts_index: [%zu]\n", start_ts_offset, end_ts_index);
-#endif
-            length_ts_offset = end_ts_index - start_ts_offset;
-            if (length_ts_offset > C2B_MAX_PSL_T_STARTS_STRING_LENGTH) {
+            ts_tok.s = ts_start;
+            ts_tok.length = ts_ptr - ts_start;
+            if (ts_tok.length > C2B_MAX_PSL_T_STARTS_STRING_LENGTH) {
                 fprintf(stderr, "Error: PSL block start string length too long\n");
                 exit(EINVAL); // Invalid argument (POSIX.1)
             }
-            memcpy(ts_arr, s + start_ts_offset, length_ts_offset);
-            ts_arr[length_ts_offset] = '\0';
-#ifdef DEBUG
-            fprintf(stderr, "ts_arr: [%s]\n", ts_arr);
-#endif
-            ts_val = strtoull(ts_arr, NULL, 10);
-            c2b_globals.psl->block->starts[bc_idx] = ts_val;
-            start_ts_offset = end_ts_index + 1;
+            starts[bc_idx] = c2b_span_to_uint64(ts_tok);
+            ts_start = ts_ptr + 1;
         }
     }
 }
 
 static inline void
-c2b_line_convert_psl_to_bed(c2b_psl_t p, char *dest_line, ssize_t *dest_size)
+c2b_line_convert_psl_to_bed(c2b_psl_t p, c2b_output_t *dest)
 {
     /* 
        For PSL-formatted data, we use the mapping provided by BEDOPS convention described at:
@@ -1821,53 +801,38 @@ c2b_line_convert_psl_to_bed(c2b_psl_t p, char *dest_line, ssize_t *dest_size)
        tStarts                   21                     -
     */
 
-    *dest_size += sprintf(dest_line + *dest_size,
-                          "%s\t"                \
-                          "%" PRIu64 "\t"       \
-                          "%" PRIu64 "\t"       \
-                          "%s\t"                \
-                          "%" PRIu64 "\t"       \
-                          "%s\t"                \
-                          "%" PRIu64 "\t"       \
-                          "%" PRIu64 "\t"       \
-                          "%" PRIu64 "\t"       \
-                          "%" PRIu64 "\t"       \
-                          "%" PRIu64 "\t"       \
-                          "%" PRIu64 "\t"       \
-                          "%" PRIu64 "\t"       \
-                          "%" PRIu64 "\t"       \
-                          "%" PRIu64 "\t"       \
-                          "%" PRIu64 "\t"       \
-                          "%" PRIu64 "\t"       \
-                          "%" PRIu64 "\t"       \
-                          "%s\t"                \
-                          "%s\t"                \
-                          "%s\n",
-                          p.tName,
-                          p.tStart,
-                          p.tEnd,
-                          p.qName,
-                          p.matches,
-                          p.strand,
-                          p.qSize,
-                          p.misMatches,
-                          p.repMatches,
-                          p.nCount,
-                          p.qNumInsert,
-                          p.qBaseInsert,
-                          p.tNumInsert,
-                          p.tBaseInsert,
-                          p.qStart,
-                          p.qEnd,
-                          p.tSize,
-                          p.blockCount,
-                          p.blockSizes,
-                          p.qStarts,
-                          p.tStarts);
-}
-
-static void
-c2b_line_convert_rmsk_to_bed_unsorted(char *dest, ssize_t *dest_size, char *src, ssize_t src_size)
+    char *dest_posn = c2b_reserve_output(dest,
+                                         p.tName.length + p.qName.length + p.strand.length + p.blockSizes.length + 
+                                         p.qStarts.length + p.tStarts.length + 
+                                         6 + 15 * C2B_MAX_UINT64_FIELD_LENGTH_VALUE);
+
+    dest_posn = c2b_emit_span(dest_posn, p.tName, c2b_tab_delim);
+    dest_posn = c2b_emit_uint64(dest_posn, p.tStart, c2b_tab_delim);
+    dest_posn = c2b_emit_uint64(dest_posn, p.tEnd, c2b_tab_delim);
+    dest_posn = c2b_emit_span(dest_posn, p.qName, c2b_tab_delim);
+    dest_posn = c2b_emit_uint64(dest_posn, p.matches, c2b_tab_delim);
+    dest_posn = c2b_emit_span(dest_posn, p.strand, c2b_tab_delim);
+    dest_posn = c2b_emit_uint64(dest_posn, p.qSize, c2b_tab_delim);
+    dest_posn = c2b_emit_uint64(dest_posn, p.misMatches, c2b_tab_delim);
+    dest_posn = c2b_emit_uint64(dest_posn, p.repMatches, c2b_tab_delim);
+    dest_posn = c2b_emit_uint64(dest_posn, p.nCount, c2b_tab_delim);
+    dest_posn = c2b_emit_uint64(dest_posn, p.qNumInsert, c2b_tab_delim);
+    dest_posn = c2b_emit_uint64(dest_posn, p.qBaseInsert, c2b_tab_delim);
+    dest_posn = c2b_emit_uint64(dest_posn, p.tNumInsert, c2b_tab_delim);
+    dest_posn = c2b_emit_uint64(dest_posn, p.tBaseInsert, c2b_tab_delim);
+    dest_posn = c2b_emit_uint64(dest_posn, p.qStart, c2b_tab_delim);
+    dest_posn = c2b_emit_uint64(dest_posn, p.qEnd, c2b_tab_delim);
+    dest_posn = c2b_emit_uint64(dest_posn, p.tSize, c2b_tab_delim);
+    dest_posn = c2b_emit_uint64(dest_posn, p.blockCount, c2b_tab_delim);
+    dest_posn = c2b_emit_span(dest_posn, p.blockSizes, c2b_tab_delim);
+    dest_posn = c2b_emit_span(dest_posn, p.qStarts, c2b_tab_delim);
+    dest_posn = c2b_emit_span(dest_posn, p.tStarts, c2b_line_delim);
+
+    dest->size = dest_posn - dest->buf;
+}
+
+static void
+c2b_line_convert_rmsk_to_bed_unsorted(c2b_context_t *ctx, c2b_output_t *dest, char *src, ssize_t src_size)
 {
     /* 
        RepeatMasker annotation output is space-delimited and can have multiple spaces. We also need to walk
@@ -1880,13 +845,25 @@ c2b_line_convert_rmsk_to_bed_unsorted(char *dest, ssize_t *dest_size, char *src,
     int rmsk_field_end_idx = 0;
     ssize_t current_src_posn = 0;
 
+    /* a blank line, such as the one that ends the header, has no fields to walk */
+
+    if (src_size == 0) {
+        if (ctx->rmsk.line < c2b_rmsk_header_line_count) {
+            ctx->rmsk.line++;
+            if (c2b_globals.keep_header_flag) {
+                c2b_line_convert_header_to_bed(ctx, dest, src, src_size);
+            }
+        }
+        return;
+    }
+
     while (current_src_posn < src_size) {
         /* within bounds */
-        if (((current_src_posn + 1) < src_size) && (c2b_globals.rmsk->line >= c2b_rmsk_header_line_count)) {
+        if (((current_src_posn + 1) < src_size) && (ctx->rmsk.line >= c2b_rmsk_header_line_count)) {
             /* skip over any initial spaces */
-            while (c2b_globals.rmsk->is_start_of_line) {
+            while (ctx->rmsk.is_start_of_line) {
                 if ((src[current_src_posn] != c2b_space_delim) && (src[current_src_posn] != c2b_line_delim)) {
-                    c2b_globals.rmsk->is_start_of_line = kFalse;
+                    ctx->rmsk.is_start_of_line = kFalse;
                     rmsk_field_start_offsets[rmsk_field_start_idx++] = current_src_posn; /* 0th offset is *start* of actual data */
                     break;
                 }
@@ -1899,14 +876,14 @@ c2b_line_convert_rmsk_to_bed_unsorted(char *dest, ssize_t *dest_size, char *src,
             }
             /* if current position is a space delimiter, we keep reading until there are no more spaces */
             if (src[current_src_posn] == c2b_space_delim) {
-                c2b_globals.rmsk->is_start_of_gap = kTrue;
-                if (c2b_globals.rmsk->is_start_of_gap) {
+                ctx->rmsk.is_start_of_gap = kTrue;
+                if (ctx->rmsk.is_start_of_gap) {
                     rmsk_field_end_offsets[rmsk_field_end_idx++] = current_src_posn; /* current offset is end of current field */
                 }
                 /* walk through gap until next field is found */
-                while (c2b_globals.rmsk->is_start_of_gap) {
+                while (ctx->rmsk.is_start_of_gap) {
                     if (src[current_src_posn++] != c2b_space_delim) {
-                        c2b_globals.rmsk->is_start_of_gap = kFalse;
+                        ctx->rmsk.is_start_of_gap = kFalse;
                         rmsk_field_start_offsets[rmsk_field_start_idx++] = current_src_posn - 1; /* current offset is start of next field */
                         if (src[current_src_posn] == c2b_line_delim) {
                             rmsk_field_end_offsets[rmsk_field_end_idx++] = current_src_posn;
@@ -1919,27 +896,20 @@ c2b_line_convert_rmsk_to_bed_unsorted(char *dest, ssize_t *dest_size, char *src,
             /* if current position is a line delimiter, we increment some indices */
             else if (src[current_src_posn] == c2b_line_delim) {
                 rmsk_field_end_offsets[rmsk_field_end_idx++] = current_src_posn;
-                c2b_globals.rmsk->line++;
-                c2b_globals.rmsk->is_start_of_line = kTrue;
-                c2b_globals.rmsk->is_start_of_gap = kFalse;
+                ctx->rmsk.line++;
+                ctx->rmsk.is_start_of_line = kTrue;
+                ctx->rmsk.is_start_of_gap = kFalse;
             }
         }
         else {
             if (src[current_src_posn + 1] == c2b_line_delim) {
                 rmsk_field_end_offsets[rmsk_field_end_idx++] = current_src_posn + 1;
-                c2b_globals.rmsk->line++;
-                c2b_globals.rmsk->is_start_of_line = kTrue;
-                c2b_globals.rmsk->is_start_of_gap = kFalse;
-                if (c2b_globals.rmsk->line <= c2b_rmsk_header_line_count) {
+                ctx->rmsk.line++;
+                ctx->rmsk.is_start_of_line = kTrue;
+                ctx->rmsk.is_start_of_gap = kFalse;
+                if (ctx->rmsk.line <= c2b_rmsk_header_line_count) {
                     if (c2b_globals.keep_header_flag) {
-                        char src_header_line_str[C2B_MAX_LINE_LENGTH_VALUE];
-                        char dest_header_line_str[C2B_MAX_LINE_LENGTH_VALUE];
-                        memcpy(src_header_line_str, src, src_size);
-                        src_header_line_str[src_size] = '\0';
-                        sprintf(dest_header_line_str, "%s\t%u\t%u\t%s\n", c2b_header_chr_name, c2b_globals.header_line_idx, (c2b_globals.header_line_idx + 1), src_header_line_str);
-                        memcpy(dest + *dest_size, dest_header_line_str, strlen(dest_header_line_str));
-                        *dest_size += strlen(dest_header_line_str);
-                        c2b_globals.header_line_idx++;
+                        c2b_line_convert_header_to_bed(ctx, dest, src, src_size);
                     }
                     return;
                 }
@@ -1948,8 +918,8 @@ c2b_line_convert_rmsk_to_bed_unsorted(char *dest, ssize_t *dest_size, char *src,
         current_src_posn++;
     }
 
-    c2b_globals.rmsk->is_start_of_line = kTrue;
-    c2b_globals.rmsk->is_start_of_gap = kFalse;
+    ctx->rmsk.is_start_of_line = kTrue;
+    ctx->rmsk.is_start_of_gap = kFalse;
 
 #ifdef DEBUG
     fprintf(stderr, "rmsk_field_start_idx: %d\n", (int) rmsk_field_start_idx);
@@ -1962,230 +932,45 @@ c2b_line_convert_rmsk_to_bed_unsorted(char *dest, ssize_t *dest_size, char *src,
         exit(EINVAL); // Invalid argument (POSIX.1)
     }
     
-    /*  0 - Smith-Waterman score of the match */
-    char sw_score_str[C2B_MAX_FIELD_LENGTH_VALUE];
-    ssize_t sw_score_start = rmsk_field_start_offsets[0];
-    ssize_t sw_score_end = rmsk_field_end_offsets[0];
-    ssize_t sw_score_size = sw_score_end - sw_score_start;
-    memcpy(sw_score_str, src + sw_score_start, sw_score_size);
-    sw_score_str[sw_score_size] = '\0';
-
-#ifdef DEBUG
-    fprintf(stderr, "sw_score_str [%s]\n", sw_score_str);
-#endif
-
-    /*  1 - Percent, divergence = mismatches / (matches + mismatches) */
-    char perc_div_str[C2B_MAX_FIELD_LENGTH_VALUE];
-    ssize_t perc_div_start = rmsk_field_start_offsets[1];
-    ssize_t perc_div_end = rmsk_field_end_offsets[1];
-    ssize_t perc_div_size = perc_div_end - perc_div_start;
-    memcpy(perc_div_str, src + perc_div_start, perc_div_size);
-    perc_div_str[perc_div_size] = '\0';
-
-#ifdef DEBUG
-    fprintf(stderr, "perc_div_str [%s]\n", perc_div_str);
-#endif
-
-    /*  2 - Percent, bases opposite a gap in the query sequence = deleted bp */
-    char perc_deleted_str[C2B_MAX_FIELD_LENGTH_VALUE];
-    ssize_t perc_deleted_start = rmsk_field_start_offsets[2];
-    ssize_t perc_deleted_end = rmsk_field_end_offsets[2];
-    ssize_t perc_deleted_size = perc_deleted_end - perc_deleted_start;
-    memcpy(perc_deleted_str, src + perc_deleted_start, perc_deleted_size);
-    perc_deleted_str[perc_deleted_size] = '\0';
-
-#ifdef DEBUG
-    fprintf(stderr, "perc_deleted_str [%s]\n", perc_deleted_str);
-#endif
-
-    /*  3 - Percent, bases opposite a gap in the repeat consensus = inserted bp */
-    char perc_inserted_str[C2B_MAX_FIELD_LENGTH_VALUE];
-    ssize_t perc_inserted_start = rmsk_field_start_offsets[3];
-    ssize_t perc_inserted_end = rmsk_field_end_offsets[3];
-    ssize_t perc_inserted_size = perc_inserted_end - perc_inserted_start;
-    memcpy(perc_inserted_str, src + perc_inserted_start, perc_inserted_size);
-    perc_inserted_str[perc_inserted_size] = '\0';
-
-#ifdef DEBUG
-    fprintf(stderr, "perc_inserted_str [%s]\n", perc_inserted_str);
-#endif
-
-    /*  4 - Query sequence */
-    char query_seq_str[C2B_MAX_FIELD_LENGTH_VALUE];
-    ssize_t query_seq_start = rmsk_field_start_offsets[4];
-    ssize_t query_seq_end = rmsk_field_end_offsets[4];
-    ssize_t query_seq_size = query_seq_end - query_seq_start;
-    memcpy(query_seq_str, src + query_seq_start, query_seq_size);
-    query_seq_str[query_seq_size] = '\0';
-
-#ifdef DEBUG
-    fprintf(stderr, "query_seq_str [%s]\n", query_seq_str);
-#endif
-
-    /*  5 - Query start (1-indexed) */
-    char query_start_str[C2B_MAX_FIELD_LENGTH_VALUE];
-    ssize_t query_start_start = rmsk_field_start_offsets[5];
-    ssize_t query_start_end = rmsk_field_end_offsets[5];
-    ssize_t query_start_size = query_start_end - query_start_start;
-    memcpy(query_start_str, src + query_start_start, query_start_size);
-    query_start_str[query_start_size] = '\0';
-    uint64_t query_start_val = strtoull(query_start_str, NULL, 10);
-
-#ifdef DEBUG
-    fprintf(stderr, "query_start_str [%s]\n", query_start_str);
-#endif
-
-    /*  6 - Query end */
-    char query_end_str[C2B_MAX_FIELD_LENGTH_VALUE];
-    ssize_t query_end_start = rmsk_field_start_offsets[6];
-    ssize_t query_end_end = rmsk_field_end_offsets[6];
-    ssize_t query_end_size = query_end_end - query_end_start;
-    memcpy(query_end_str, src + query_end_start, query_end_size);
-    query_end_str[query_end_size] = '\0';
-    uint64_t query_end_val = strtoull(query_end_str, NULL, 10);
-
-#ifdef DEBUG
-    fprintf(stderr, "query_end_str [%s]\n", query_end_str);
-#endif
-
-    /*  7 - Bases in query sequence past the ending position of match */
-    char bases_past_match_str[C2B_MAX_FIELD_LENGTH_VALUE];
-    ssize_t bases_past_match_start = rmsk_field_start_offsets[7];
-    ssize_t bases_past_match_end = rmsk_field_end_offsets[7];
-    ssize_t bases_past_match_size = bases_past_match_end - bases_past_match_start;
-    memcpy(bases_past_match_str, src + bases_past_match_start, bases_past_match_size);
-    bases_past_match_str[bases_past_match_size] = '\0';
-
-#ifdef DEBUG
-    fprintf(stderr, "bases_past_match_str [%s]\n", bases_past_match_str);
-#endif
-
-    /*  8 - Strand match with repeat consensus sequence (+ = forward, C = complement) */
-    char strand_str[C2B_MAX_FIELD_LENGTH_VALUE];
-    ssize_t strand_start = rmsk_field_start_offsets[8];
-    ssize_t strand_end = rmsk_field_end_offsets[8];
-    ssize_t strand_size = strand_end - strand_start;
-    memcpy(strand_str, src + strand_start, strand_size);
-    strand_str[strand_size] = '\0';
-    if (strcmp(strand_str, c2b_rmsk_strand_complement) == 0) {
-        memcpy(strand_str, c2b_rmsk_strand_complement_replacement, strlen(c2b_rmsk_strand_complement_replacement) + 1);
+    c2b_span_t rmsk_fields[C2B_MAX_FIELD_COUNT_VALUE];
+    for (int rmsk_field_idx = 0; rmsk_field_idx < rmsk_field_start_idx; rmsk_field_idx++) {
+        rmsk_fields[rmsk_field_idx].s = src + rmsk_field_start_offsets[rmsk_field_idx];
+        rmsk_fields[rmsk_field_idx].length = rmsk_field_end_offsets[rmsk_field_idx] - rmsk_field_start_offsets[rmsk_field_idx];
     }
 
-#ifdef DEBUG
-    fprintf(stderr, "strand_str [%s]\n", strand_str);
-#endif
-
-    /*  9 - Matching interspersed repeat name */
-    char repeat_name_str[C2B_MAX_FIELD_LENGTH_VALUE];
-    ssize_t repeat_name_start = rmsk_field_start_offsets[9];
-    ssize_t repeat_name_end = rmsk_field_end_offsets[9];
-    ssize_t repeat_name_size = repeat_name_end - repeat_name_start;
-    memcpy(repeat_name_str, src + repeat_name_start, repeat_name_size);
-    repeat_name_str[repeat_name_size] = '\0';
-
-#ifdef DEBUG
-    fprintf(stderr, "repeat_name_str [%s]\n", repeat_name_str);
-#endif
-
-    /* 10 - Repeat class */
-    char repeat_class_str[C2B_MAX_FIELD_LENGTH_VALUE];
-    ssize_t repeat_class_start = rmsk_field_start_offsets[10];
-    ssize_t repeat_class_end = rmsk_field_end_offsets[10];
-    ssize_t repeat_class_size = repeat_class_end - repeat_class_start;
-    memcpy(repeat_class_str, src + repeat_class_start, repeat_class_size);
-    repeat_class_str[repeat_class_size] = '\0';
-
-#ifdef DEBUG
-    fprintf(stderr, "repeat_class_str [%s]\n", repeat_class_str);
-#endif
-
-    /* 11 - Bases in (complement of) the repeat consensus sequence, prior to beginning of the match */
-    char bases_before_match_comp_str[C2B_MAX_FIELD_LENGTH_VALUE];
-    ssize_t bases_before_match_comp_start = rmsk_field_start_offsets[11];
-    ssize_t bases_before_match_comp_end = rmsk_field_end_offsets[11];
-    ssize_t bases_before_match_comp_size = bases_before_match_comp_end - bases_before_match_comp_start;
-    memcpy(bases_before_match_comp_str, src + bases_before_match_comp_start, bases_before_match_comp_size);
-    bases_before_match_comp_str[bases_before_match_comp_size] = '\0';
-
-#ifdef DEBUG
-    fprintf(stderr, "bases_before_match_comp_str [%s]\n", bases_before_match_comp_str);
-#endif
-
-    /* 12 - Match start (in repeat consensus sequence) */
-    char match_start_str[C2B_MAX_FIELD_LENGTH_VALUE];
-    ssize_t match_start_start = rmsk_field_start_offsets[12];
-    ssize_t match_start_end = rmsk_field_end_offsets[12];
-    ssize_t match_start_size = match_start_end - match_start_start;
-    memcpy(match_start_str, src + match_start_start, match_start_size);
-    match_start_str[match_start_size] = '\0';
-
-#ifdef DEBUG
-    fprintf(stderr, "match_start_str [%s]\n", match_start_str);
-#endif
-
-    /* 13 - Match end (in repeat consensus sequence) */
-    char match_end_str[C2B_MAX_FIELD_LENGTH_VALUE];
-    ssize_t match_end_start = rmsk_field_start_offsets[13];
-    ssize_t match_end_end = rmsk_field_end_offsets[13];
-    ssize_t match_end_size = match_end_end - match_end_start;
-    memcpy(match_end_str, src + match_end_start, match_end_size);
-    match_end_str[match_end_size] = '\0';
-
-#ifdef DEBUG
-    fprintf(stderr, "match_end_str [%s]\n", match_end_str);
-#endif
-
-    /* 14 - Identifier for individual insertions */
-    char unique_id_str[C2B_MAX_FIELD_LENGTH_VALUE];
-    ssize_t unique_id_start = rmsk_field_start_offsets[14];
-    ssize_t unique_id_end = rmsk_field_end_offsets[14];
-    ssize_t unique_id_size = unique_id_end - unique_id_start;
-    memcpy(unique_id_str, src + unique_id_start, unique_id_size);
-    unique_id_str[unique_id_size] = '\0';
-
-#ifdef DEBUG
-    fprintf(stderr, "unique_id_str [%s]\n", unique_id_str);
-#endif
+    c2b_rmsk_t rmsk;
+    rmsk.sw_score = rmsk_fields[0];
+    rmsk.perc_div = rmsk_fields[1];
+    rmsk.perc_deleted = rmsk_fields[2];
+    rmsk.perc_inserted = rmsk_fields[3];
+    rmsk.query_seq = rmsk_fields[4];
+    rmsk.query_start = c2b_span_to_uint64(rmsk_fields[5]) - 1;
+    rmsk.query_end = c2b_span_to_uint64(rmsk_fields[6]);
+    rmsk.bases_past_match = rmsk_fields[7];
+    rmsk.strand = rmsk_fields[8];
+    if (c2b_span_equals(rmsk.strand, c2b_rmsk_strand_complement)) {
+        rmsk.strand.s = (char *) c2b_rmsk_strand_complement_replacement;
+        rmsk.strand.length = strlen(c2b_rmsk_strand_complement_replacement);
+    }
+    rmsk.repeat_name = rmsk_fields[9];
+    rmsk.repeat_class = rmsk_fields[10];
+    rmsk.bases_before_match_comp = rmsk_fields[11];
+    rmsk.match_start = rmsk_fields[12];
+    rmsk.match_end = rmsk_fields[13];
+    rmsk.unique_id = rmsk_fields[14];
 
     /* 15 - Higher-scoring match present (optional) */
-    char higher_score_match_str[C2B_MAX_FIELD_LENGTH_VALUE];
-    higher_score_match_str[0] = '\0';
-
+    rmsk.higher_score_match.s = NULL;
+    rmsk.higher_score_match.length = 0;
     if ((rmsk_field_start_idx == c2b_rmsk_field_max) && (rmsk_field_end_idx == c2b_rmsk_field_max)) {
-        ssize_t higher_score_match_start = rmsk_field_start_offsets[15];
-        ssize_t higher_score_match_end = rmsk_field_end_offsets[15];
-        ssize_t higher_score_match_size = higher_score_match_end - higher_score_match_start;
-        memcpy(higher_score_match_str, src + higher_score_match_start, higher_score_match_size);
-        higher_score_match_str[higher_score_match_size] = '\0';
+        rmsk.higher_score_match = rmsk_fields[15];
     }
 
-#ifdef DEBUG
-    fprintf(stderr, "higher_score_match_str [%s]\n", higher_score_match_str);
-#endif
-
-    c2b_rmsk_t rmsk;
-    rmsk.sw_score = sw_score_str;
-    rmsk.perc_div = perc_div_str;
-    rmsk.perc_deleted = perc_deleted_str;
-    rmsk.perc_inserted = perc_inserted_str;
-    rmsk.query_seq = query_seq_str;
-    rmsk.query_start = query_start_val - 1;
-    rmsk.query_end = query_end_val;
-    rmsk.bases_past_match = bases_past_match_str;
-    rmsk.strand = strand_str;
-    rmsk.repeat_name = repeat_name_str;
-    rmsk.repeat_class = repeat_class_str;
-    rmsk.bases_before_match_comp = bases_before_match_comp_str;
-    rmsk.match_start = match_start_str;
-    rmsk.match_end = match_end_str;
-    rmsk.unique_id = unique_id_str;
-    rmsk.higher_score_match = higher_score_match_str;
-
-    c2b_line_convert_rmsk_to_bed(rmsk, dest, dest_size);
+    c2b_line_convert_rmsk_to_bed(rmsk, dest);
 }
 
 static inline void
-c2b_line_convert_rmsk_to_bed(c2b_rmsk_t r, char *dest_line, ssize_t *dest_size)
+c2b_line_convert_rmsk_to_bed(c2b_rmsk_t r, c2b_output_t *dest)
 {
     /* 
        For RepeatMasker annotation-formatted data, we use the mapping provided by BEDOPS
@@ -2218,78 +1003,40 @@ c2b_line_convert_rmsk_to_bed(c2b_rmsk_t r, char *dest_line, ssize_t *dest_size)
        higher_score_match        16                     -       
     */
 
-    if (strlen(r.higher_score_match) == 0) {
-        *dest_size += sprintf(dest_line + *dest_size,
-                              "%s\t"            \
-                              "%" PRIu64 "\t"   \
-                              "%" PRIu64 "\t"   \
-                              "%s\t"            \
-                              "%s\t"            \
-                              "%s\t"            \
-                              "%s\t"            \
-                              "%s\t"            \
-                              "%s\t"            \
-                              "%s\t"            \
-                              "%s\t"            \
-                              "%s\t"            \
-                              "%s\t"            \
-                              "%s\t"            \
-                              "%s\n",
-                              r.query_seq,
-                              r.query_start,
-                              r.query_end,
-                              r.repeat_name,
-                              r.sw_score,
-                              r.strand,
-                              r.perc_div,
-                              r.perc_deleted,
-                              r.perc_inserted,
-                              r.bases_past_match,
-                              r.repeat_class,
-                              r.bases_before_match_comp,
-                              r.match_start,
-                              r.match_end,
-                              r.unique_id);
+    char *dest_posn = c2b_reserve_output(dest,
+                                         r.query_seq.length + r.repeat_name.length + r.sw_score.length + r.strand.length + 
+                                         r.perc_div.length + r.perc_deleted.length + r.perc_inserted.length + r.bases_past_match.length + 
+                                         r.repeat_class.length + r.bases_before_match_comp.length + r.match_start.length + r.match_end.length + 
+                                         r.unique_id.length + r.higher_score_match.length + 
+                                         14 + 2 * C2B_MAX_UINT64_FIELD_LENGTH_VALUE);
+
+    dest_posn = c2b_emit_span(dest_posn, r.query_seq, c2b_tab_delim);
+    dest_posn = c2b_emit_uint64(dest_posn, r.query_start, c2b_tab_delim);
+    dest_posn = c2b_emit_uint64(dest_posn, r.query_end, c2b_tab_delim);
+    dest_posn = c2b_emit_span(dest_posn, r.repeat_name, c2b_tab_delim);
+    dest_posn = c2b_emit_span(dest_posn, r.sw_score, c2b_tab_delim);
+    dest_posn = c2b_emit_span(dest_posn, r.strand, c2b_tab_delim);
+    dest_posn = c2b_emit_span(dest_posn, r.perc_div, c2b_tab_delim);
+    dest_posn = c2b_emit_span(dest_posn, r.perc_deleted, c2b_tab_delim);
+    dest_posn = c2b_emit_span(dest_posn, r.perc_inserted, c2b_tab_delim);
+    dest_posn = c2b_emit_span(dest_posn, r.bases_past_match, c2b_tab_delim);
+    dest_posn = c2b_emit_span(dest_posn, r.repeat_class, c2b_tab_delim);
+    dest_posn = c2b_emit_span(dest_posn, r.bases_before_match_comp, c2b_tab_delim);
+    dest_posn = c2b_emit_span(dest_posn, r.match_start, c2b_tab_delim);
+    dest_posn = c2b_emit_span(dest_posn, r.match_end, c2b_tab_delim);
+    if (r.higher_score_match.length == 0) {
+        dest_posn = c2b_emit_span(dest_posn, r.unique_id, c2b_line_delim);
     }
     else {
-        *dest_size += sprintf(dest_line + *dest_size,
-                              "%s\t"            \
-                              "%" PRIu64 "\t"   \
-                              "%" PRIu64 "\t"   \
-                              "%s\t"            \
-                              "%s\t"            \
-                              "%s\t"            \
-                              "%s\t"            \
-                              "%s\t"            \
-                              "%s\t"            \
-                              "%s\t"            \
-                              "%s\t"            \
-                              "%s\t"            \
-                              "%s\t"            \
-                              "%s\t"            \
-                              "%s\t"            \
-                              "%s\n",
-                              r.query_seq,
-                              r.query_start,
-                              r.query_end,
-                              r.repeat_name,
-                              r.sw_score,
-                              r.strand,
-                              r.perc_div,
-                              r.perc_deleted,
-                              r.perc_inserted,
-                              r.bases_past_match,
-                              r.repeat_class,
-                              r.bases_before_match_comp,
-                              r.match_start,
-                              r.match_end,
-                              r.unique_id,
-                              r.higher_score_match);
-    }
-}
-
-static void
-c2b_line_convert_sam_to_bed_unsorted_without_split_operation(char *dest, ssize_t *dest_size, char *src, ssize_t src_size)
+        dest_posn = c2b_emit_span(dest_posn, r.unique_id, c2b_tab_delim);
+        dest_posn = c2b_emit_span(dest_posn, r.higher_score_match, c2b_line_delim);
+    }
+
+    dest->size = dest_posn - dest->buf;
+}
+
+static void
+c2b_line_convert_sam_to_bed_unsorted_without_split_operation(c2b_context_t *ctx, c2b_output_t *dest, char *src, ssize_t src_size)
 {
     /* 
        Scan the src buffer (all src_size bytes of it) to build a list of tab delimiter 
@@ -2297,9 +1044,8 @@ c2b_line_convert_sam_to_bed_unsorted_without_split_operation(char *dest, ssize_t
        tab-offset list to grab fields in the correct order.
     */
 
-    ssize_t sam_field_offsets[C2B_MAX_FIELD_COUNT_VALUE];
+    c2b_span_t sam_fields[C2B_MAX_FIELD_COUNT_VALUE];
     int sam_field_idx = 0;
-    ssize_t current_src_posn = -1;
     
     /* 
        Find offsets or process header line 
@@ -2312,160 +1058,93 @@ c2b_line_convert_sam_to_bed_unsorted_without_split_operation(char *dest, ssize_t
         }
         else {
             /* copy header line to destination stream buffer */
-            char src_header_line_str[C2B_MAX_LINE_LENGTH_VALUE];
-            char dest_header_line_str[C2B_MAX_LINE_LENGTH_VALUE];
-            memcpy(src_header_line_str, src, src_size);
-            src_header_line_str[src_size] = '\0';
-            sprintf(dest_header_line_str, "%s\t%u\t%u\t%s\n", c2b_header_chr_name, c2b_globals.header_line_idx, (c2b_globals.header_line_idx + 1), src_header_line_str);
-            memcpy(dest + *dest_size, dest_header_line_str, strlen(dest_header_line_str));
-            *dest_size += strlen(dest_header_line_str);
-            c2b_globals.header_line_idx++;
+            c2b_line_convert_header_to_bed(ctx, dest, src, src_size);
             return;
         }
     }
 
-    while (++current_src_posn < src_size) {
-        if ((src[current_src_posn] == c2b_tab_delim) || (src[current_src_posn] == c2b_line_delim)) {
-            sam_field_offsets[sam_field_idx++] = current_src_posn;
-        }
-        if (sam_field_idx >= C2B_MAX_FIELD_COUNT_VALUE) {
-            fprintf(stderr, "Error: Invalid field count (%d) -- input file may have too many fields\n", sam_field_idx);
-            c2b_print_usage(stderr);
-            exit(EINVAL); /* Invalid argument (POSIX.1) */
-        }
-    }
-    sam_field_offsets[sam_field_idx] = src_size;
-    sam_field_offsets[sam_field_idx + 1] = -1;
-
     /* 
-       If no more than one field is read in, then something went wrong
+       Firstly, is read mapped, and does it pass the read filters? If not, we skip over this line
     */
 
-    if (sam_field_idx == 0) {
-        fprintf(stderr, "Error: Invalid field count (%d) -- input file may not match input format\n", sam_field_idx);
-        c2b_print_usage(stderr);
-        exit(EINVAL); /* Invalid argument (POSIX.1) */
-    }
+    int flag_val = 0;
+    sam_field_idx = c2b_sam_split_fields(ctx, src, src_size, sam_fields, &flag_val);
+    if (sam_field_idx < 0)
+        return;
+    boolean is_mapped = (boolean) !(4 & flag_val);
 
     /* 
-       Firstly, is read mapped? If not, and c2b_globals.all_reads_flag is kFalse, we skip over this line
+       Fields are written straight from their spans in the source line, each with the 
+       delimiter that follows it; together they take no more than the line and the 
+       byte after it, or, with --columns, the length of the listed columns
     */
 
-    ssize_t flag_size = sam_field_offsets[1] - sam_field_offsets[0];
-    char flag_src_str[C2B_MAX_FIELD_LENGTH_VALUE];
-    memcpy(flag_src_str, src + sam_field_offsets[0] + 1, flag_size);
-    flag_src_str[flag_size] = '\0';
-    int flag_val = (int) strtol(flag_src_str, NULL, 10);
-    boolean is_mapped = (boolean) !(4 & flag_val);
-    if ((!is_mapped) && (!c2b_globals.all_reads_flag)) 
-        return;
+    c2b_sam_t sam;
+    ssize_t columns_length = 0;
+    if (c2b_globals.columns->is_enabled) {
+        c2b_sam_fields_to_sam(sam_fields, sam_field_idx, &sam);
+        sam.flag = flag_val;
+        sam.strand.s = (0x10 & flag_val) ? "-" : "+";
+        sam.strand.length = 1;
+        columns_length = c2b_sam_bed_tail_length(&sam);
+    }
+
+    char *dest_posn = c2b_reserve_output(dest, 
+                                         src_size + 1 + columns_length + 
+                                         (ssize_t) strlen(c2b_unmapped_read_chr_name) + 1 + 
+                                         2 + 2 * C2B_MAX_UINT64_FIELD_LENGTH_VALUE);
 
     /* Field 1 - RNAME */
     if (is_mapped) {
-        ssize_t rname_size = sam_field_offsets[2] - sam_field_offsets[1];
-        memcpy(dest + *dest_size, src + sam_field_offsets[1] + 1, rname_size);
-        *dest_size += rname_size;
+        memcpy(dest_posn, sam_fields[2].s, sam_fields[2].length + 1);
+        dest_posn += sam_fields[2].length + 1;
     }
     else {
-        char unmapped_read_chr_str[C2B_MAX_FIELD_LENGTH_VALUE];
-        memcpy(unmapped_read_chr_str, c2b_unmapped_read_chr_name, strlen(c2b_unmapped_read_chr_name));
-        unmapped_read_chr_str[strlen(c2b_unmapped_read_chr_name)] = '\t';
-        unmapped_read_chr_str[strlen(c2b_unmapped_read_chr_name) + 1] = '\0';
-        memcpy(dest + *dest_size, unmapped_read_chr_str, strlen(unmapped_read_chr_str));
-        *dest_size += strlen(unmapped_read_chr_str);
+        dest_posn = c2b_emit_str(dest_posn, c2b_unmapped_read_chr_name, c2b_tab_delim);
     }
 
     /* Field 2 - POS - 1 */
-    ssize_t pos_size = sam_field_offsets[3] - sam_field_offsets[2];
-    char pos_src_str[C2B_MAX_FIELD_LENGTH_VALUE];
-    memcpy(pos_src_str, src + sam_field_offsets[2] + 1, pos_size - 1);
-    pos_src_str[pos_size - 1] = '\0';
-    uint64_t pos_val = strtoull(pos_src_str, NULL, 10);
-    char start_str[C2B_MAX_FIELD_LENGTH_VALUE];
-    sprintf(start_str, "%" PRIu64 "\t", (is_mapped) ? pos_val - 1 : 0);
-    memcpy(dest + *dest_size, start_str, strlen(start_str));
-    *dest_size += strlen(start_str);
+    uint64_t pos_val = c2b_span_to_uint64(sam_fields[3]);
+    dest_posn = c2b_emit_uint64(dest_posn, (is_mapped) ? pos_val - 1 : 0, c2b_tab_delim);
 
     /* Field 3 - POS + length(CIGAR) - 1 */
-    ssize_t cigar_size = sam_field_offsets[5] - sam_field_offsets[4];
-    ssize_t cigar_length = 0;
-    char stop_str[C2B_MAX_FIELD_LENGTH_VALUE];
-    char cigar_str[C2B_MAX_FIELD_LENGTH_VALUE];
-    memcpy(cigar_str, src + sam_field_offsets[4] + 1, cigar_size - 1);
-    cigar_str[cigar_size - 1] = '\0';
-    c2b_sam_cigar_str_to_ops(cigar_str);
-    ssize_t block_idx = 0;
-    for (block_idx = 0; block_idx < c2b_globals.sam->cigar->length; ++block_idx) {
-        cigar_length += c2b_globals.sam->cigar->ops[block_idx].bases;
-    }
-    sprintf(stop_str, "%" PRIu64 "\t", (is_mapped) ? pos_val + cigar_length - 1 : 1);
-    memcpy(dest + *dest_size, stop_str, strlen(stop_str));
-    *dest_size += strlen(stop_str);
+    uint64_t cigar_length = c2b_sam_cigar_str_to_bases(sam_fields[5]);
+    dest_posn = c2b_emit_uint64(dest_posn, (is_mapped) ? pos_val + cigar_length - 1 : 1, c2b_tab_delim);
 
     /* Field 4 - QNAME */
-    ssize_t qname_size = sam_field_offsets[0] + 1;
-    memcpy(dest + *dest_size, src, qname_size);
-    *dest_size += qname_size;
+    memcpy(dest_posn, sam_fields[0].s, sam_fields[0].length + 1);
+    dest_posn += sam_fields[0].length + 1;
+
+    /* Fields 5+ - with --columns, MAPQ, 16 & FLAG and the listed columns */
+    if (c2b_globals.columns->is_enabled) {
+        dest_posn = c2b_emit_sam_bed_tail(dest_posn, &sam);
+        dest->size = dest_posn - dest->buf;
+        return;
+    }
 
     /* Field 5 - MAPQ */
-    ssize_t mapq_size = sam_field_offsets[4] - sam_field_offsets[3];
-    memcpy(dest + *dest_size, src + sam_field_offsets[3] + 1, mapq_size);
-    *dest_size += mapq_size;
+    memcpy(dest_posn, sam_fields[4].s, sam_fields[4].length + 1);
+    dest_posn += sam_fields[4].length + 1;
 
     /* Field 6 - 16 & FLAG */
     int strand_val = 0x10 & flag_val;
-    char strand_str[C2B_MAX_STRAND_LENGTH_VALUE];
-    sprintf(strand_str, "%c\t", (strand_val == 0x10) ? '-' : '+');
-    memcpy(dest + *dest_size, strand_str, strlen(strand_str));
-    *dest_size += strlen(strand_str);
+    *dest_posn++ = (strand_val == 0x10) ? '-' : '+';
+    *dest_posn++ = c2b_tab_delim;
 
     /* Field 7 - FLAG */
-    memcpy(dest + *dest_size, src + sam_field_offsets[0] + 1, flag_size);
-    *dest_size += flag_size;
-
-    /* Field 8 - CIGAR */
-    memcpy(dest + *dest_size, src + sam_field_offsets[4] + 1, cigar_size);
-    *dest_size += cigar_size;
-
-    /* Field 9 - RNEXT */
-    ssize_t rnext_size = sam_field_offsets[6] - sam_field_offsets[5];
-    memcpy(dest + *dest_size, src + sam_field_offsets[5] + 1, rnext_size);
-    *dest_size += rnext_size;
-
-    /* Field 10 - PNEXT */
-    ssize_t pnext_size = sam_field_offsets[7] - sam_field_offsets[6];
-    memcpy(dest + *dest_size, src + sam_field_offsets[6] + 1, pnext_size);
-    *dest_size += pnext_size;
-
-    /* Field 11 - TLEN */
-    ssize_t tlen_size = sam_field_offsets[8] - sam_field_offsets[7];
-    memcpy(dest + *dest_size, src + sam_field_offsets[7] + 1, tlen_size);
-    *dest_size += tlen_size;
-
-    /* Field 12 - SEQ */
-    ssize_t seq_size = sam_field_offsets[9] - sam_field_offsets[8];
-    memcpy(dest + *dest_size, src + sam_field_offsets[8] + 1, seq_size);
-    *dest_size += seq_size;
-
-    /* Field 13 - QUAL */
-    ssize_t qual_size = sam_field_offsets[10] - sam_field_offsets[9];
-    memcpy(dest + *dest_size, src + sam_field_offsets[9] + 1, qual_size);
-    *dest_size += qual_size;
-
-    /* Field 14+ - Optional fields */
-    if (sam_field_offsets[11] == -1)
-        return;
+    memcpy(dest_posn, sam_fields[1].s, sam_fields[1].length + 1);
+    dest_posn += sam_fields[1].length + 1;
 
-    int field_idx;
-    for (field_idx = 11; field_idx <= sam_field_idx; field_idx++) {
-        ssize_t opt_size = sam_field_offsets[field_idx] - sam_field_offsets[field_idx - 1];
-        memcpy(dest + *dest_size, src + sam_field_offsets[field_idx - 1] + 1, opt_size);
-        *dest_size += opt_size;
-    }
+    /* Fields 8 to 13 - CIGAR, RNEXT, PNEXT, TLEN, SEQ and QUAL, and fields 14+ - Optional fields */
+    ssize_t rest_size = sam_fields[sam_field_idx].s + sam_fields[sam_field_idx].length + 1 - sam_fields[5].s;
+    memcpy(dest_posn, sam_fields[5].s, rest_size);
+    dest_posn += rest_size;
+
+    dest->size = dest_posn - dest->buf;
 }
 
 static void
-c2b_line_convert_sam_to_bed_unsorted_with_split_operation(char *dest, ssize_t *dest_size, char *src, ssize_t src_size)
+c2b_line_convert_sam_to_bed_unsorted_with_split_operation(c2b_context_t *ctx, c2b_output_t *dest, char *src, ssize_t src_size)
 {
     /* 
        This functor is slightly more complex than c2b_line_convert_sam_to_bed_unsorted_without_split_operation() 
@@ -2473,9 +1152,8 @@ c2b_line_convert_sam_to_bed_unsorted_with_split_operation(char *dest, ssize_t *d
        parse it for operation key-value pairs to loop through later on
     */
 
-    ssize_t sam_field_offsets[C2B_MAX_FIELD_COUNT_VALUE];
+    c2b_span_t sam_fields[C2B_MAX_FIELD_COUNT_VALUE];
     int sam_field_idx = 0;
-    ssize_t current_src_posn = -1;
 
     /* 
        Find offsets or process header line 
@@ -2488,210 +1166,101 @@ c2b_line_convert_sam_to_bed_unsorted_with_split_operation(char *dest, ssize_t *d
         }
         else {
             /* copy header line to destination stream buffer */
-            char src_header_line_str[C2B_MAX_LINE_LENGTH_VALUE];
-            char dest_header_line_str[C2B_MAX_LINE_LENGTH_VALUE];
-            memcpy(src_header_line_str, src, src_size);
-            src_header_line_str[src_size] = '\0';
-            sprintf(dest_header_line_str, "%s\t%u\t%u\t%s\n", c2b_header_chr_name, c2b_globals.header_line_idx, (c2b_globals.header_line_idx + 1), src_header_line_str);
-            memcpy(dest + *dest_size, dest_header_line_str, strlen(dest_header_line_str));
-            *dest_size += strlen(dest_header_line_str);
-            c2b_globals.header_line_idx++;
+            c2b_line_convert_header_to_bed(ctx, dest, src, src_size);
             return;
         }
     }
 
-    while (++current_src_posn < src_size) {
-        if ((src[current_src_posn] == c2b_tab_delim) || (src[current_src_posn] == c2b_line_delim)) {
-            sam_field_offsets[sam_field_idx++] = current_src_posn;
-        }
-        if (sam_field_idx >= C2B_MAX_FIELD_COUNT_VALUE) {
-            fprintf(stderr, "Error: Invalid field count (%d) -- input file may have too many fields\n", sam_field_idx);
-            c2b_print_usage(stderr);
-            exit(EINVAL); /* Invalid argument (POSIX.1) */
-        }
-    }
-    sam_field_offsets[sam_field_idx] = src_size;
-    sam_field_offsets[sam_field_idx + 1] = -1;
-
     /* 
-       If no more than one field is read in, then something went wrong
+       Firstly, is the read mapped, and does it pass the read filters? If not, we skip over this line
     */
 
-    if (sam_field_idx == 0) {
-        fprintf(stderr, "Error: Invalid field count (%d) -- input file may not match input format\n", sam_field_idx);
-        c2b_print_usage(stderr);
-        exit(EINVAL); /* Invalid argument (POSIX.1) */
-    }
+    int flag_val = 0;
+    sam_field_idx = c2b_sam_split_fields(ctx, src, src_size, sam_fields, &flag_val);
+    if (sam_field_idx < 0)
+        return;
+    boolean is_mapped = (boolean) !(4 & flag_val);
 
     /* 
        Translate CIGAR string to operations
     */
 
-    ssize_t cigar_size = sam_field_offsets[5] - sam_field_offsets[4];
-    char cigar_str[C2B_MAX_FIELD_LENGTH_VALUE];
-    memcpy(cigar_str, src + sam_field_offsets[4] + 1, cigar_size - 1);
-    cigar_str[cigar_size - 1] = '\0';
-    c2b_sam_cigar_str_to_ops(cigar_str);
+    c2b_cigar_t cigar;
+    c2b_init_cigar(&cigar);
+    c2b_sam_cigar_str_to_ops(sam_fields[5], &cigar);
 #ifdef DEBUG
-    c2b_sam_debug_cigar_ops(c2b_globals.sam->cigar);
+    c2b_sam_debug_cigar_ops(&cigar);
 #endif
-    ssize_t cigar_length = 0;
-    ssize_t op_idx = 0;
-    for (op_idx = 0; op_idx < c2b_globals.sam->cigar->length; ++op_idx) {
-        cigar_length += c2b_globals.sam->cigar->ops[op_idx].bases;
-    }
-
-    /* 
-       Firstly, is the read mapped? If not, and c2b_globals.all_reads_flag is kFalse, we skip over this line
-    */
-
-    ssize_t flag_size = sam_field_offsets[1] - sam_field_offsets[0];
-    char flag_src_str[C2B_MAX_FIELD_LENGTH_VALUE];
-    memcpy(flag_src_str, src + sam_field_offsets[0] + 1, flag_size);
-    flag_src_str[flag_size] = '\0';
-    int flag_val = (int) strtol(flag_src_str, NULL, 10);
-    boolean is_mapped = (boolean) !(4 & flag_val);
-    if ((!is_mapped) && (!c2b_globals.all_reads_flag)) 
-        return;    
 
     /* 
        Secondly, we need to retrieve RNAME, POS, QNAME parameters
     */
 
-    /* RNAME */
-    char rname_str[C2B_MAX_FIELD_LENGTH_VALUE];
+    c2b_sam_t sam;
+
+    /* RNAME -- unmapped reads keep the tab that follows the placeholder chromosome name */
+    char unmapped_read_chr_str[C2B_MAX_FIELD_LENGTH_VALUE];
     if (is_mapped) {
-        ssize_t rname_size = sam_field_offsets[2] - sam_field_offsets[1] - 1;
-        memcpy(rname_str, src + sam_field_offsets[1] + 1, rname_size);
-        rname_str[rname_size] = '\0';
+        sam.rname = sam_fields[2];
     }
     else {
-        char unmapped_read_chr_str[C2B_MAX_FIELD_LENGTH_VALUE];
-        memcpy(unmapped_read_chr_str, c2b_unmapped_read_chr_name, strlen(c2b_unmapped_read_chr_name));
-        unmapped_read_chr_str[strlen(c2b_unmapped_read_chr_name)] = '\t';
-        unmapped_read_chr_str[strlen(c2b_unmapped_read_chr_name) + 1] = '\0';
-        memcpy(rname_str, unmapped_read_chr_str, strlen(unmapped_read_chr_str));
-        rname_str[strlen(unmapped_read_chr_str)] = '\0';
+        sam.rname.s = unmapped_read_chr_str;
+        sam.rname.length = sprintf(unmapped_read_chr_str, "%s\t", c2b_unmapped_read_chr_name);
     }
 
     /* POS */
-    ssize_t pos_size = sam_field_offsets[3] - sam_field_offsets[2];
-    char pos_src_str[C2B_MAX_FIELD_LENGTH_VALUE];
-    memcpy(pos_src_str, src + sam_field_offsets[2] + 1, pos_size - 1);
-    pos_src_str[pos_size - 1] = '\0';
-    uint64_t pos_val = strtoull(pos_src_str, NULL, 10);
+    uint64_t pos_val = c2b_span_to_uint64(sam_fields[3]);
     uint64_t start_val = pos_val - 1; /* remember, start = POS - 1 */
-    uint64_t stop_val = start_val + cigar_length;
-
-    /* QNAME */
-    char qname_str[C2B_MAX_FIELD_LENGTH_VALUE];
-    ssize_t qname_size = sam_field_offsets[0];
-    memcpy(qname_str, src, qname_size);
-    qname_str[qname_size] = '\0';
+    uint64_t stop_val = start_val + cigar.bases;
 
     /* 16 & FLAG */
     int strand_val = 0x10 & flag_val;
-    char strand_str[C2B_MAX_STRAND_LENGTH_VALUE];
-    sprintf(strand_str, "%c", (strand_val == 0x10) ? '-' : '+');
-    
-    /* MAPQ */
-    char mapq_str[C2B_MAX_FIELD_LENGTH_VALUE];
-    ssize_t mapq_size = sam_field_offsets[4] - sam_field_offsets[3] - 1;
-    memcpy(mapq_str, src + sam_field_offsets[3] + 1, mapq_size);
-    mapq_str[mapq_size] = '\0';
-    
-    /* RNEXT */
-    char rnext_str[C2B_MAX_FIELD_LENGTH_VALUE];
-    ssize_t rnext_size = sam_field_offsets[6] - sam_field_offsets[5] - 1;
-    memcpy(rnext_str, src + sam_field_offsets[5] + 1, rnext_size);
-    rnext_str[rnext_size] = '\0';
-
-    /* PNEXT */
-    char pnext_str[C2B_MAX_FIELD_LENGTH_VALUE];
-    ssize_t pnext_size = sam_field_offsets[7] - sam_field_offsets[6] - 1;
-    memcpy(pnext_str, src + sam_field_offsets[6] + 1, pnext_size);
-    pnext_str[pnext_size] = '\0';
-
-    /* TLEN */
-    char tlen_str[C2B_MAX_FIELD_LENGTH_VALUE];
-    ssize_t tlen_size = sam_field_offsets[8] - sam_field_offsets[7] - 1;
-    memcpy(tlen_str, src + sam_field_offsets[7] + 1, tlen_size);
-    tlen_str[tlen_size] = '\0';
-
-    /* SEQ */
-    char seq_str[C2B_MAX_FIELD_LENGTH_VALUE];
-    ssize_t seq_size = sam_field_offsets[9] - sam_field_offsets[8] - 1;
-    memcpy(seq_str, src + sam_field_offsets[8] + 1, seq_size);
-    seq_str[seq_size] = '\0';
-
-    /* QUAL */
-    char qual_str[C2B_MAX_FIELD_LENGTH_VALUE];
-    ssize_t qual_size = sam_field_offsets[10] - sam_field_offsets[9] - 1;
-    memcpy(qual_str, src + sam_field_offsets[9] + 1, qual_size);
-    qual_str[qual_size] = '\0';
+    sam.strand.s = (strand_val == 0x10) ? "-" : "+";
+    sam.strand.length = 1;
 
-    /* Optional fields */
-    char opt_str[C2B_MAX_FIELD_LENGTH_VALUE];
-    memset(opt_str, 0, strlen(opt_str));
-    if (sam_field_offsets[11] != -1) {
-        for (int field_idx = 11; field_idx <= sam_field_idx; field_idx++) {
-            ssize_t opt_size = sam_field_offsets[field_idx] - sam_field_offsets[field_idx - 1] - (field_idx == sam_field_idx ? 1 : 0);
-            memcpy(opt_str + strlen(opt_str), src + sam_field_offsets[field_idx - 1] + 1, opt_size);
-	    opt_str[strlen(opt_str) + opt_size] = '\0';
-        }
-    }
+    sam.start = start_val;
+    sam.stop = start_val;
+    sam.flag = flag_val;
+    c2b_sam_fields_to_sam(sam_fields, sam_field_idx, &sam);
+
+    c2b_line_convert_sam_split_ops_to_bed(sam, &cigar, stop_val, dest);
+    c2b_delete_cigar(&cigar);
+}
 
+static inline void
+c2b_line_convert_sam_split_ops_to_bed(c2b_sam_t sam, c2b_cigar_t *cigar, uint64_t stop_val, c2b_output_t *dest)
+{
     /* 
        Loop through operations and process a line of input based on each operation and its associated value
     */
 
+    ssize_t op_idx;
     ssize_t block_idx;
-    char previous_op = default_cigar_op_operation;
-    char modified_qname_str[C2B_MAX_FIELD_LENGTH_VALUE];
+    unsigned char op_class = 0;
+    unsigned char previous_op_class = C2B_CIGAR_OP_SKIPPED;
+    ssize_t tail_length = c2b_sam_bed_tail_length(&sam);
+    ssize_t tail_offset = -1;
 
-    c2b_sam_t sam;
-    sam.rname = rname_str;
-    sam.start = start_val;
-    sam.stop = start_val;
-    sam.qname = qname_str;
-    sam.flag = flag_val;
-    sam.strand = strand_str;
-    sam.mapq = mapq_str;
-    sam.cigar = cigar_str;
-    sam.rnext = rnext_str;
-    sam.pnext = pnext_str;
-    sam.tlen = tlen_str;
-    sam.seq = seq_str;
-    sam.qual = qual_str;
-    sam.opt = opt_str;
-
-    for (op_idx = 0, block_idx = 1; op_idx < c2b_globals.sam->cigar->length; ++op_idx) {
-        char current_op = c2b_globals.sam->cigar->ops[op_idx].operation;
-        unsigned int bases = c2b_globals.sam->cigar->ops[op_idx].bases;
-        switch (current_op) 
-            {
-            case 'M':
-                sam.stop += bases;
-                if ((previous_op == default_cigar_op_operation) || (previous_op == 'D') || (previous_op == 'N')) {
-                    sprintf(modified_qname_str, "%s/%zu", qname_str, block_idx++);
-                    sam.qname = modified_qname_str;
-                    c2b_line_convert_sam_to_bed(sam, dest, dest_size);
-                    sam.start = stop_val;
-                }
-                break;
-            case 'N':
-            case 'D':
-                sam.stop += bases;
-                sam.start = sam.stop;
-            case 'H':
-            case 'I':
-            case 'P':
-            case 'S':
-                break;
-            default:
-                break;
+    /* 
+       A block is written at an aligned operation that opens the CIGAR string, or that 
+       follows a deletion or skipped region; other operations only set previous_op_class
+    */
+
+    for (op_idx = 0, block_idx = 1; op_idx < cigar->length; ++op_idx) {
+        unsigned int bases = cigar->ops[op_idx].bases;
+        op_class = c2b_cigar_op_classes[(unsigned char) cigar->ops[op_idx].operation];
+        if (op_class & C2B_CIGAR_OP_ALIGNED) {
+            sam.stop += bases;
+            if (previous_op_class & C2B_CIGAR_OP_SKIPPED) {
+                c2b_line_convert_sam_block_to_bed(&sam, (size_t) block_idx++, &tail_length, &tail_offset, dest);
+                sam.start = stop_val;
             }
-        previous_op = current_op;
+        }
+        else if (op_class & C2B_CIGAR_OP_SKIPPED) {
+            sam.stop += bases;
+            sam.start = sam.stop;
+        }
+        previous_op_class = op_class;
     }
 
     /* 
@@ -2701,73 +1270,170 @@ c2b_line_convert_sam_to_bed_unsorted_with_split_operation(char *dest, ssize_t *d
     */
 
     if (block_idx == 1) {
-        c2b_line_convert_sam_to_bed(sam, dest, dest_size);
+        c2b_line_convert_sam_block_to_bed(&sam, 0, &tail_length, &tail_offset, dest);
     }
 }
 
 static inline void
-c2b_sam_cigar_str_to_ops(char *s)
-{
-    size_t s_idx;
-    size_t s_len = strlen(s);
-    size_t bases_idx = 0;
-    boolean bases_flag = kTrue;
-    boolean operation_flag = kFalse;
-    char curr_bases_field[C2B_MAX_OPERATION_FIELD_LENGTH_VALUE];
-    char curr_char = default_cigar_op_operation;
-    unsigned int curr_bases = 0;
-    ssize_t op_idx = 0;
-
-    for (s_idx = 0; s_idx < s_len; ++s_idx) {
-        curr_char = s[s_idx];
-        if (isdigit(curr_char)) {
-            if (operation_flag) {
-                c2b_globals.sam->cigar->ops[op_idx].bases = curr_bases;
-                op_idx++;
-                operation_flag = kFalse;
-                bases_flag = kTrue;
-            }
-            curr_bases_field[bases_idx++] = curr_char;
-            curr_bases_field[bases_idx] = '\0';
-        }
-        else {
-            if (bases_flag) {
-                curr_bases = atoi(curr_bases_field);
-                bases_flag = kFalse;
-                operation_flag = kTrue;
-                bases_idx = 0;
-                memset(curr_bases_field, 0, strlen(curr_bases_field));
-            }
-            c2b_globals.sam->cigar->ops[op_idx].operation = curr_char;
-            if (curr_char == '*') {
-                break;
-            }
-        }
+c2b_line_convert_sam_block_to_bed(c2b_sam_t *s, size_t block_idx, ssize_t *tail_length, ssize_t *tail_offset, c2b_output_t *dest)
+{
+    /*
+       Writes one block of a split read, with block_idx appended to its QNAME (or left off,
+       if zero). The columns that follow QNAME are the same for every block of a read, so 
+       they are formatted once, into the first block, and copied from there into the blocks
+       that follow. If the output buffer was flushed in between, they are formatted again.
+       The tail_length passed in for the first block is an upper bound; it is set to the 
+       length actually written.
+    */
+
+    char *dest_posn = c2b_reserve_output(dest,
+                                         s->rname.length + s->qname.length + *tail_length + 
+                                         3 + 3 * C2B_MAX_UINT64_FIELD_LENGTH_VALUE);
+
+    dest_posn = c2b_emit_span(dest_posn, s->rname, c2b_tab_delim);
+    dest_posn = c2b_emit_uint64(dest_posn, s->start, c2b_tab_delim);
+    dest_posn = c2b_emit_uint64(dest_posn, s->stop, c2b_tab_delim);
+    if (block_idx > 0) {
+        dest_posn = c2b_emit_span(dest_posn, s->qname, '/');
+        dest_posn = c2b_emit_uint64(dest_posn, (uint64_t) block_idx, c2b_tab_delim);
+    }
+    else {
+        dest_posn = c2b_emit_span(dest_posn, s->qname, c2b_tab_delim);
+    }
+
+    if ((*tail_offset >= 0) && (*tail_offset + *tail_length <= dest->size)) {
+        memcpy(dest_posn, dest->buf + *tail_offset, *tail_length);
+        dest_posn += *tail_length;
+    }
+    else {
+        *tail_offset = dest_posn - dest->buf;
+        dest_posn = c2b_emit_sam_bed_tail(dest_posn, s);
+        *tail_length = dest_posn - (dest->buf + *tail_offset);
     }
-    c2b_globals.sam->cigar->ops[op_idx].bases = curr_bases;
-    c2b_globals.sam->cigar->length = op_idx + 1;
+
+    dest->size = dest_posn - dest->buf;
 }
 
 static void
-c2b_sam_init_cigar_ops(c2b_cigar_t **c, const ssize_t size)
+c2b_init_cigar_op_classes()
 {
-    *c = malloc(sizeof(c2b_cigar_t));
-    if (!*c) {
-        fprintf(stderr, "Error: Could not allocate space for CIGAR struct pointer\n");
-        c2b_print_usage(stderr);
-        exit(ENOMEM); /* Not enough space (POSIX.1) */
+    const char *op = NULL;
+
+    memset(c2b_cigar_op_classes, 0, sizeof(c2b_cigar_op_classes));
+    for (op = c2b_bam_cigar_ops; *op != '\0'; op++) {
+        c2b_cigar_op_classes[(unsigned char) *op] = C2B_CIGAR_OP_VALID;
+    }
+    c2b_cigar_op_classes['M'] |= C2B_CIGAR_OP_ALIGNED;
+    c2b_cigar_op_classes['='] |= C2B_CIGAR_OP_ALIGNED;
+    c2b_cigar_op_classes['X'] |= C2B_CIGAR_OP_ALIGNED;
+    c2b_cigar_op_classes['D'] |= C2B_CIGAR_OP_SKIPPED;
+    c2b_cigar_op_classes['N'] |= C2B_CIGAR_OP_SKIPPED;
+}
+
+static inline void
+c2b_init_cigar(c2b_cigar_t *c)
+{
+    c->ops = c->inline_ops;
+    c->size = C2B_MAX_OPERATIONS_VALUE;
+    c->length = 0;
+    c->bases = 0;
+}
+
+static inline void
+c2b_delete_cigar(c2b_cigar_t *c)
+{
+    if (c->ops != c->inline_ops)
+        free(c->ops);
+    c->ops = c->inline_ops;
+    c->size = C2B_MAX_OPERATIONS_VALUE;
+    c->length = 0;
+}
+
+static void
+c2b_grow_cigar(c2b_cigar_t *c, ssize_t min_size)
+{
+    c2b_cigar_op_t *ops = NULL;
+    ssize_t size = c->size;
+
+    while (size < min_size) {
+        size *= 2;
+    }
+    if (c->ops == c->inline_ops) {
+        ops = malloc(size * sizeof(c2b_cigar_op_t));
+        if (ops)
+            memcpy(ops, c->inline_ops, c->length * sizeof(c2b_cigar_op_t));
+    }
+    else {
+        ops = realloc(c->ops, size * sizeof(c2b_cigar_op_t));
     }
-    (*c)->ops = malloc(size * sizeof(c2b_cigar_op_t));
-    if (!(*c)->ops) {
-        fprintf(stderr, "Error: Could not allocate space for CIGAR struct operation pointer\n");
+    if (!ops) {
+        fprintf(stderr, "Error: Could not allocate space for %zd CIGAR operations\n", size);
         c2b_print_usage(stderr);
         exit(ENOMEM); /* Not enough space (POSIX.1) */
     }
-    (*c)->size = size;
-    (*c)->length = 0;
-    for (ssize_t idx = 0; idx < size; idx++) {
-        (*c)->ops[idx].bases = default_cigar_op_bases;
-        (*c)->ops[idx].operation = default_cigar_op_operation;
+    c->ops = ops;
+    c->size = size;
+}
+
+static inline uint64_t
+c2b_sam_cigar_str_to_bases(c2b_span_t s)
+{
+    const char *posn = s.s;
+    const char *end = s.s + s.length;
+    unsigned int digit = 0;
+    unsigned int bases = 0;
+    uint64_t total_bases = 0;
+
+    /* 
+       Sums the bases of every operation, without keeping the operations; any character 
+       that is not a digit ends an operation, and '*' (no CIGAR) ends the string
+    */
+
+    for (; posn < end; posn++) {
+        digit = (unsigned int) (*posn - '0');
+        if (digit < 10) {
+            bases = bases * 10 + digit;
+            continue;
+        }
+        if (*posn == '*')
+            break;
+        total_bases += bases;
+        bases = 0;
+    }
+
+    return total_bases;
+}
+
+static inline void
+c2b_sam_cigar_str_to_ops(c2b_span_t s, c2b_cigar_t *c)
+{
+    const char *posn = s.s;
+    const char *end = s.s + s.length;
+    unsigned int digit = 0;
+    unsigned int bases = 0;
+
+    /* 
+       As with c2b_sam_cigar_str_to_bases(), in one pass over the field; each operation 
+       is appended to c, which grows should the inline operations fill
+    */
+
+    c->length = 0;
+    c->bases = 0;
+    for (; posn < end; posn++) {
+        digit = (unsigned int) (*posn - '0');
+        if (digit < 10) {
+            bases = bases * 10 + digit;
+            continue;
+        }
+        if (*posn == '*')
+            break;
+        if (c->length == c->size)
+            c2b_grow_cigar(c, c->length + 1);
+        c->ops[c->length].bases = bases;
+        c->ops[c->length].operation = *posn;
+        c->length++;
+        c->bases += bases;
+        bases = 0;
     }
 }
 
@@ -2791,17 +1457,8 @@ c2b_sam_debug_cigar_ops(c2b_cigar_t *c)
     }
 }
 
-static void
-c2b_sam_delete_cigar_ops(c2b_cigar_t *c)
-{
-    if (c) {
-        free(c->ops), c->ops = NULL, c->length = 0, c->size = 0;
-        free(c), c = NULL;
-    }
-}
-
 static inline void
-c2b_line_convert_sam_to_bed(c2b_sam_t s, char *dest_line, ssize_t *dest_size)
+c2b_line_convert_sam_to_bed(c2b_sam_t s, c2b_output_t *dest)
 {
     /*
        For SAM-formatted data, we use the mapping provided by BEDOPS convention described at: 
@@ -2838,730 +1495,5743 @@ c2b_line_convert_sam_to_bed(c2b_sam_t s, char *dest_line, ssize_t *dest_size)
        Alignment fields          14+                    -
     */
 
-    if (strlen(s.opt)) {
-        *dest_size += sprintf(dest_line + *dest_size,
-                              "%s\t"            \
-                              "%" PRIu64 "\t"   \
-                              "%" PRIu64 "\t"   \
-                              "%s\t"            \
-                              "%s\t"            \
-                              "%s\t"            \
-                              "%d\t"            \
-                              "%s\t"            \
-                              "%s\t"            \
-                              "%s\t"            \
-                              "%s\t"            \
-                              "%s\t"            \
-                              "%s\t"            \
-                              "%s\n",
-                              s.rname,
-                              s.start,
-                              s.stop,
-                              s.qname,
-                              s.mapq,
-                              s.strand,
-                              s.flag,
-                              s.cigar,
-                              s.rnext,
-                              s.pnext,
-                              s.tlen,
-                              s.seq,
-                              s.qual,
-                              s.opt);
-    } 
-    else {
-        *dest_size += sprintf(dest_line + *dest_size,
-                              "%s\t"            \
-                              "%" PRIu64 "\t"   \
-                              "%" PRIu64 "\t"   \
-                              "%s\t"            \
-                              "%s\t"            \
-                              "%s\t"            \
-                              "%d\t"            \
-                              "%s\t"            \
-                              "%s\t"            \
-                              "%s\t"            \
-                              "%s\t"            \
-                              "%s\t"            \
-                              "%s\n",
-                              s.rname,
-                              s.start,
-                              s.stop,
-                              s.qname,
-                              s.mapq,
-                              s.strand,
-                              s.flag,
-                              s.cigar,
-                              s.rnext,
-                              s.pnext,
-                              s.tlen,
-                              s.seq,
-                              s.qual);
-    }
-}
-
-static void
-c2b_line_convert_vcf_to_bed_unsorted(char *dest, ssize_t *dest_size, char *src, ssize_t src_size)
-{
-    ssize_t vcf_field_offsets[C2B_MAX_FIELD_COUNT_VALUE];
-    int vcf_field_idx = 0;
-    ssize_t current_src_posn = -1;
+    char *dest_posn = c2b_reserve_output(dest,
+                                         s.rname.length + s.qname.length + c2b_sam_bed_tail_length(&s) + 
+                                         3 + 2 * C2B_MAX_UINT64_FIELD_LENGTH_VALUE);
 
-    while (++current_src_posn < src_size) {
-        if ((src[current_src_posn] == c2b_tab_delim) || (src[current_src_posn] == c2b_line_delim)) {
-            vcf_field_offsets[vcf_field_idx++] = current_src_posn;
-        }
-        if (vcf_field_idx >= C2B_MAX_FIELD_COUNT_VALUE) {
-            fprintf(stderr, "Error: Invalid field count (%d) -- input file may have too many fields\n", vcf_field_idx);
-            c2b_print_usage(stderr);
-            exit(EINVAL); /* Invalid argument (POSIX.1) */
+    dest_posn = c2b_emit_span(dest_posn, s.rname, c2b_tab_delim);
+    dest_posn = c2b_emit_uint64(dest_posn, s.start, c2b_tab_delim);
+    dest_posn = c2b_emit_uint64(dest_posn, s.stop, c2b_tab_delim);
+    dest_posn = c2b_emit_span(dest_posn, s.qname, c2b_tab_delim);
+    dest_posn = c2b_emit_sam_bed_tail(dest_posn, &s);
+
+    dest->size = dest_posn - dest->buf;
+}
+
+static inline ssize_t
+c2b_sam_bed_tail_length(c2b_sam_t *s)
+{
+    /* an upper bound on the length of the columns after QNAME, as c2b_emit_sam_bed_tail() writes them */
+
+    ssize_t length = s->mapq.length + s->strand.length + 2;
+    int column_idx = 0;
+
+    if (!c2b_globals.columns->is_enabled)
+        return length + s->cigar.length + s->rnext.length + s->pnext.length + s->tlen.length + 
+               s->seq.length + s->qual.length + s->opt.length + 7 + C2B_MAX_UINT64_FIELD_LENGTH_VALUE;
+
+    for (column_idx = 0; column_idx < c2b_globals.columns->num_columns; column_idx++) {
+        switch (c2b_globals.columns->columns[column_idx].type) {
+            case C2B_SAM_FLAG_COLUMN:  length += C2B_MAX_UINT64_FIELD_LENGTH_VALUE; break;
+            case C2B_SAM_CIGAR_COLUMN: length += s->cigar.length + 1; break;
+            case C2B_SAM_RNEXT_COLUMN: length += s->rnext.length + 1; break;
+            case C2B_SAM_PNEXT_COLUMN: length += s->pnext.length + 1; break;
+            case C2B_SAM_TLEN_COLUMN:  length += s->tlen.length + 1; break;
+            case C2B_SAM_SEQ_COLUMN:   length += s->seq.length + 1; break;
+            case C2B_SAM_QUAL_COLUMN:  length += s->qual.length + 1; break;
+            case C2B_SAM_OPT_COLUMN:   length += s->opt.length + 2; break;
+            case C2B_SAM_TAG_COLUMN:   length += s->opt.length + 2; break;
         }
     }
-    vcf_field_offsets[vcf_field_idx] = src_size;
-    vcf_field_offsets[vcf_field_idx + 1] = -1;
 
+    return length;
+}
+
+static inline char *
+c2b_emit_sam_bed_tail(char *dest_posn, c2b_sam_t *s)
+{
     /* 
-       If number of fields in not in bounds, we may need to exit early
+       Writes the columns after QNAME -- score and strand, then the remaining SAM fields, or 
+       the --columns list -- and ends the line
     */
-    
-    char src_header_line_str[C2B_MAX_LINE_LENGTH_VALUE];
-    char dest_header_line_str[C2B_MAX_LINE_LENGTH_VALUE];
 
-    if ((vcf_field_idx + 1) < c2b_vcf_field_min) {
-        /* Legal header cases: line starts with "##" or "#" */
-        if ((vcf_field_idx == 0) && (src[0] == c2b_vcf_header_prefix)) { 
-            if (c2b_globals.keep_header_flag) { 
-                /* copy header line to destination stream buffer */
-                memcpy(src_header_line_str, src, src_size);
-                src_header_line_str[src_size] = '\0';
-                sprintf(dest_header_line_str, "%s\t%u\t%u\t%s\n", c2b_header_chr_name, c2b_globals.header_line_idx, (c2b_globals.header_line_idx + 1), src_header_line_str);
-                memcpy(dest + *dest_size, dest_header_line_str, strlen(dest_header_line_str));
-                *dest_size += strlen(dest_header_line_str);
-                c2b_globals.header_line_idx++;
-                return;
-            }
-            else {
-                return;
+    c2b_sam_column_t *column = NULL;
+    c2b_span_t value;
+    int column_idx = 0;
+    int num_columns = c2b_globals.columns->num_columns;
+
+    dest_posn = c2b_emit_span(dest_posn, s->mapq, c2b_tab_delim);
+
+    if (c2b_globals.columns->is_enabled) {
+        dest_posn = c2b_emit_span(dest_posn, s->strand, (num_columns > 0) ? c2b_tab_delim : c2b_line_delim);
+        for (column_idx = 0; column_idx < num_columns; column_idx++) {
+            char delim = (column_idx + 1 < num_columns) ? c2b_tab_delim : c2b_line_delim;
+            column = &c2b_globals.columns->columns[column_idx];
+            switch (column->type) {
+                case C2B_SAM_FLAG_COLUMN:  dest_posn = c2b_emit_int64(dest_posn, s->flag, delim); break;
+                case C2B_SAM_CIGAR_COLUMN: dest_posn = c2b_emit_span(dest_posn, s->cigar, delim); break;
+                case C2B_SAM_RNEXT_COLUMN: dest_posn = c2b_emit_span(dest_posn, s->rnext, delim); break;
+                case C2B_SAM_PNEXT_COLUMN: dest_posn = c2b_emit_span(dest_posn, s->pnext, delim); break;
+                case C2B_SAM_TLEN_COLUMN:  dest_posn = c2b_emit_span(dest_posn, s->tlen, delim); break;
+                case C2B_SAM_SEQ_COLUMN:   dest_posn = c2b_emit_span(dest_posn, s->seq, delim); break;
+                case C2B_SAM_QUAL_COLUMN:  dest_posn = c2b_emit_span(dest_posn, s->qual, delim); break;
+                case C2B_SAM_OPT_COLUMN:   dest_posn = (s->opt.length) ? c2b_emit_span(dest_posn, s->opt, delim) : c2b_emit_str(dest_posn, ".", delim); break;
+                case C2B_SAM_TAG_COLUMN:
+                    value = c2b_sam_find_tag(s->opt, column->tag);
+                    dest_posn = (value.s) ? c2b_emit_span(dest_posn, value, delim) : c2b_emit_str(dest_posn, ".", delim);
+                    break;
             }
         }
-        else if (vcf_field_idx == 0) {
-            fprintf(stderr, "Error: Invalid field count (%d) -- input file may not match input format\n", vcf_field_idx);
-            c2b_print_usage(stderr);
-            exit(EINVAL); /* Invalid argument (POSIX.1) */
-        }
+        return dest_posn;
     }
 
-    /* 0 - CHROM */
-    char chrom_str[C2B_MAX_FIELD_LENGTH_VALUE];
-    ssize_t chrom_size = vcf_field_offsets[0];
-    memcpy(chrom_str, src, chrom_size);
-    chrom_str[chrom_size] = '\0';
-
-    if ((chrom_str[0] == c2b_vcf_header_prefix) && (c2b_globals.keep_header_flag)) {
-        memcpy(src_header_line_str, src, src_size);
-        src_header_line_str[src_size] = '\0';
-        sprintf(dest_header_line_str, "%s\t%u\t%u\t%s\n", c2b_header_chr_name, c2b_globals.header_line_idx, (c2b_globals.header_line_idx + 1), src_header_line_str);
-        memcpy(dest + *dest_size, dest_header_line_str, strlen(dest_header_line_str));
-        *dest_size += strlen(dest_header_line_str);
-        c2b_globals.header_line_idx++;
-        return;
+    dest_posn = c2b_emit_span(dest_posn, s->strand, c2b_tab_delim);
+    dest_posn = c2b_emit_int64(dest_posn, s->flag, c2b_tab_delim);
+    dest_posn = c2b_emit_span(dest_posn, s->cigar, c2b_tab_delim);
+    dest_posn = c2b_emit_span(dest_posn, s->rnext, c2b_tab_delim);
+    dest_posn = c2b_emit_span(dest_posn, s->pnext, c2b_tab_delim);
+    dest_posn = c2b_emit_span(dest_posn, s->tlen, c2b_tab_delim);
+    dest_posn = c2b_emit_span(dest_posn, s->seq, c2b_tab_delim);
+    if (s->opt.length) {
+        dest_posn = c2b_emit_span(dest_posn, s->qual, c2b_tab_delim);
+        dest_posn = c2b_emit_span(dest_posn, s->opt, c2b_line_delim);
     }
-    else if (chrom_str[0] == c2b_vcf_header_prefix) {
-        return;
+    else {
+        dest_posn = c2b_emit_span(dest_posn, s->qual, c2b_line_delim);
     }
 
-    /* 1 - POS */
-    char pos_str[C2B_MAX_FIELD_LENGTH_VALUE];
-    ssize_t pos_size = vcf_field_offsets[1] - vcf_field_offsets[0] - 1;
-    memcpy(pos_str, src + vcf_field_offsets[0] + 1, pos_size);
-    pos_str[pos_size] = '\0';
-    uint64_t pos_val = strtoull(pos_str, NULL, 10);
-    uint64_t start_val = pos_val - 1;
-    uint64_t end_val = pos_val; /* note that this value may change below, depending on options */
+    return dest_posn;
+}
 
-    /* 2 - ID */
-    char id_str[C2B_MAX_FIELD_LENGTH_VALUE];
-    ssize_t id_size = vcf_field_offsets[2] - vcf_field_offsets[1] - 1;
-    memcpy(id_str, src + vcf_field_offsets[1] + 1, id_size);
-    id_str[id_size] = '\0';
-
-    /* 3 - REF */
-    char ref_str[C2B_MAX_FIELD_LENGTH_VALUE];
-    ssize_t ref_size = vcf_field_offsets[3] - vcf_field_offsets[2] - 1;
-    memcpy(ref_str, src + vcf_field_offsets[2] + 1, ref_size);
-    ref_str[ref_size] = '\0';
-
-    /* 4 - ALT */
-    char alt_str[C2B_MAX_FIELD_LENGTH_VALUE];
-    ssize_t alt_size = vcf_field_offsets[4] - vcf_field_offsets[3] - 1;
-    memcpy(alt_str, src + vcf_field_offsets[3] + 1, alt_size);
-    alt_str[alt_size] = '\0';
-
-    /* 5 - QUAL */
-    char qual_str[C2B_MAX_FIELD_LENGTH_VALUE];
-    ssize_t qual_size = vcf_field_offsets[5] - vcf_field_offsets[4] - 1;
-    memcpy(qual_str, src + vcf_field_offsets[4] + 1, qual_size);
-    qual_str[qual_size] = '\0';
-
-    /* 6 - FILTER */
-    char filter_str[C2B_MAX_FIELD_LENGTH_VALUE];
-    ssize_t filter_size = vcf_field_offsets[6] - vcf_field_offsets[5] - 1;
-    memcpy(filter_str, src + vcf_field_offsets[5] + 1, filter_size);
-    filter_str[filter_size] = '\0';
-
-    /* 7 - INFO */
-    char info_str[C2B_MAX_FIELD_LENGTH_VALUE];
-    ssize_t info_size = vcf_field_offsets[7] - vcf_field_offsets[6] - 1;
-    memcpy(info_str, src + vcf_field_offsets[6] + 1, info_size);
-    info_str[info_size] = '\0';
-
-    char format_str[C2B_MAX_FIELD_LENGTH_VALUE];
-    char samples_str[C2B_MAX_FIELD_LENGTH_VALUE];
-
-    format_str[0] = '\0'; /* initialize to zero-length string */
+static inline void
+c2b_sam_fields_to_sam(c2b_span_t *fields, int field_idx, c2b_sam_t *s)
+{
+    /* 
+       Fields past field_idx were not split out of the line, as with a --columns list 
+       that does not need them, and are left empty; FLAG, strand, RNAME and the 
+       coordinates are set by the caller
+    */
 
-    if (vcf_field_idx >= 8) {
-        /* 8 - FORMAT */
-        ssize_t format_size = vcf_field_offsets[8] - vcf_field_offsets[7] - 1;
-        memcpy(format_str, src + vcf_field_offsets[7] + 1, format_size);
-        format_str[format_size] = '\0';
+    c2b_span_t empty = { NULL, 0 };
 
-        /* 9 - Samples */
-        ssize_t samples_size = vcf_field_offsets[vcf_field_idx] - vcf_field_offsets[8] - 1;
-        memcpy(samples_str, src + vcf_field_offsets[8] + 1, samples_size);
-        samples_str[samples_size] = '\0';
+    s->qname = fields[0];
+    s->mapq = fields[4];
+    s->cigar = fields[5];
+    s->rnext = (field_idx >= 6) ? fields[6] : empty;
+    s->pnext = (field_idx >= 7) ? fields[7] : empty;
+    s->tlen = (field_idx >= 8) ? fields[8] : empty;
+    s->seq = (field_idx >= 9) ? fields[9] : empty;
+    s->qual = (field_idx >= 10) ? fields[10] : empty;
+
+    /* Optional fields -- the remainder of the line, tabs included */
+    s->opt = empty;
+    if (field_idx > 10) {
+        s->opt.s = fields[11].s;
+        s->opt.length = fields[field_idx].s + fields[field_idx].length - fields[11].s;
     }
+}
 
-    c2b_vcf_t vcf;
-    vcf.chrom = chrom_str;
-    vcf.pos = pos_val;
-    vcf.start = start_val;
-    vcf.end = end_val;
-    vcf.id = id_str;
-    vcf.ref = ref_str;
-    vcf.alt = alt_str;
-    vcf.qual = qual_str;
-    vcf.filter = filter_str;
-    vcf.info = info_str;
-    vcf.format = format_str;
-    vcf.samples = samples_str;
+static inline c2b_span_t
+c2b_sam_find_tag(c2b_span_t opt, const char *tag)
+{
+    /* returns the VALUE of the first TAG:TYPE:VALUE field in opt that matches tag, or a NULL span */
+
+    char *posn = opt.s;
+    char *opt_end = opt.s + opt.length;
+    char *field_end = NULL;
+    c2b_span_t value = { NULL, 0 };
+
+    while (posn + 5 <= opt_end) {
+        field_end = memchr(posn, c2b_tab_delim, (size_t) (opt_end - posn));
+        if (!field_end)
+            field_end = opt_end;
+        if ((posn[0] == tag[0]) && (posn[1] == tag[1]) && (posn[2] == ':') && (field_end - posn >= 5)) {
+            value.s = posn + 5;
+            value.length = field_end - value.s;
+            return value;
+        }
+        posn = field_end + 1;
+    }
 
-    if ((!c2b_globals.vcf->do_not_split) && (memchr(alt_str, c2b_vcf_alt_allele_delim, strlen(alt_str)))) {
+    return value;
+}
 
-        /* loop through each allele */
+static inline int
+c2b_sam_split_fields(c2b_context_t *ctx, char *src, ssize_t src_size, c2b_span_t *fields, int *flag_val)
+{
+    /* 
+       QNAME through MAPQ are split out of the line first, so that a read that is dropped 
+       on its FLAG or MAPQ costs no more than that. The remaining fields, up to the last 
+       one needed, are then split out of the rest of the line, and the tag predicates, if 
+       any, are tested. Returns the index of the last field, as c2b_split_leading_fields() 
+       does, or -1 if the read is dropped.
+    */
 
-        char *alt_alleles_copy = NULL;
-        alt_alleles_copy = malloc(strlen(alt_str) + 1);
-        if (!alt_alleles_copy) {
-            fprintf(stderr, "Error: Could not allocate space for VCF alt alleles copy\n");
-            exit(ENOMEM); /* Not enough space (POSIX.1) */
-        }
-        memcpy(alt_alleles_copy, alt_str, strlen(alt_str) + 1);
-        const char *allele_tok;
-        while ((allele_tok = c2b_strsep(&alt_alleles_copy, ",")) != NULL) {
-            vcf.alt = (char *) allele_tok; /* discard const */
-            if ((c2b_globals.vcf->filter_count == 1) && (!c2b_globals.vcf->only_insertions)) {
-                vcf.end = start_val + abs(ref_size - strlen(vcf.alt)) + 1;
-            }
-            if ( (c2b_globals.vcf->filter_count == 0) ||
-                 ((c2b_globals.vcf->only_snvs) && (c2b_vcf_record_is_snv(ref_str, vcf.alt))) ||
-                 ((c2b_globals.vcf->only_insertions) && (c2b_vcf_record_is_insertion(ref_str, vcf.alt))) ||
-                 ((c2b_globals.vcf->only_deletions) && (c2b_vcf_record_is_deletion(ref_str, vcf.alt))) ) 
-                {
-                    c2b_line_convert_vcf_to_bed(vcf, dest, dest_size);
-                }
-        }
-        free(alt_alleles_copy), alt_alleles_copy = NULL;
+    int field_idx = c2b_split_leading_fields(ctx, src, src_size, fields, 5);
+    unsigned int mapq_val = 0;
+    c2b_span_t opt = { NULL, 0 };
+
+    /* 
+       If no more than one field is read in, then something went wrong
+    */
+
+    if (field_idx == 0) {
+        fprintf(stderr, "Error: Invalid field count (%d) -- input file may not match input format\n", field_idx);
+        c2b_print_usage(stderr);
+        exit(EINVAL); /* Invalid argument (POSIX.1) */
     }
-    else {
 
-        /* just print the one allele */
+    *flag_val = (int) c2b_span_to_uint64(fields[1]);
+    if ((c2b_globals.filter->min_mapq > 0) && (field_idx >= 4))
+        mapq_val = (unsigned int) c2b_span_to_uint64(fields[4]);
+    if (c2b_read_is_dropped(ctx, *flag_val, mapq_val))
+        return -1;
 
-        if ((c2b_globals.vcf->filter_count == 1) && (!c2b_globals.vcf->only_insertions)) {
-            vcf.end = start_val + abs(ref_size - strlen(alt_str)) + 1;
-        }
-        if ( (c2b_globals.vcf->filter_count == 0) ||
-             ((c2b_globals.vcf->only_snvs) && (c2b_vcf_record_is_snv(ref_str, alt_str))) ||
-             ((c2b_globals.vcf->only_insertions) && (c2b_vcf_record_is_insertion(ref_str, alt_str))) ||
-             ((c2b_globals.vcf->only_deletions) && (c2b_vcf_record_is_deletion(ref_str, alt_str))) ) 
-            {
-                c2b_line_convert_vcf_to_bed(vcf, dest, dest_size);
-            }
+    if (field_idx == 5)
+        field_idx += c2b_split_leading_fields(ctx, fields[5].s, fields[5].length, fields + 5, c2b_globals.columns->max_field_idx - 5);
+
+    if ((c2b_globals.filter->num_tag_filters > 0) && (field_idx > 10)) {
+        opt.s = fields[11].s;
+        opt.length = fields[field_idx].s + fields[field_idx].length - fields[11].s;
     }
+    if (c2b_read_tags_are_dropped(ctx, opt))
+        return -1;
+
+    return field_idx;
 }
 
 static inline boolean
-c2b_vcf_allele_is_id(char *s)
+c2b_read_is_dropped(c2b_context_t *ctx, int flag_val, unsigned int mapq_val)
 {
-    return ((s[0] == c2b_vcf_id_prefix) && (s[strlen(s)-1] == c2b_vcf_id_suffix)) ? kTrue : kFalse;
+    c2b_filter_params_t *filter = c2b_globals.filter;
+
+    if ((4 & flag_val) && (!c2b_globals.all_reads_flag)) {
+        ctx->counts.unmapped_reads++;
+        return kTrue;
+    }
+
+    if ((filter->is_enabled) && 
+        (((flag_val & filter->required_flags) != filter->required_flags) || 
+         (flag_val & filter->excluded_flags) || 
+         (mapq_val < filter->min_mapq))) {
+        ctx->counts.filtered_reads++;
+        return kTrue;
+    }
+
+    return kFalse;
 }
 
 static inline boolean
-c2b_vcf_record_is_snv(char *ref, char *alt) 
+c2b_read_tags_are_dropped(c2b_context_t *ctx, c2b_span_t opt)
 {
-    return ((!c2b_vcf_allele_is_id(alt)) && (((int) strlen(ref) - (int) strlen(alt)) == 0)) ? kTrue : kFalse;
+    c2b_filter_params_t *filter = c2b_globals.filter;
+    int filter_idx = 0;
+
+    for (filter_idx = 0; filter_idx < filter->num_tag_filters; filter_idx++) {
+        if (!c2b_tag_filter_matches(&filter->tag_filters[filter_idx], c2b_sam_find_tag(opt, filter->tag_filters[filter_idx].tag))) {
+            ctx->counts.filtered_reads++;
+            return kTrue;
+        }
+    }
+
+    return kFalse;
 }
 
 static inline boolean
-c2b_vcf_record_is_insertion(char *ref, char *alt) 
+c2b_tag_filter_matches(const c2b_tag_filter_t *f, c2b_span_t value)
 {
-    return ((!c2b_vcf_allele_is_id(alt)) && (((int) strlen(ref) - (int) strlen(alt)) < 0)) ? kTrue : kFalse;
+    double number = 0.0;
+    int comparison = 0;
+
+    if (f->op == C2B_TAG_PRESENT)
+        return (value.s != NULL) ? kTrue : kFalse;
+    if (f->op == C2B_TAG_ABSENT)
+        return (value.s == NULL) ? kTrue : kFalse;
+    if (!value.s)
+        return kFalse;
+
+    if ((f->is_numeric) && (c2b_span_to_double(value, &number)))
+        comparison = (number < f->number) ? -1 : ((number > f->number) ? 1 : 0);
+    else if ((f->op == C2B_TAG_EQ) || (f->op == C2B_TAG_NE))
+        comparison = ((value.length == f->value_length) && (memcmp(value.s, f->value, (size_t) value.length) == 0)) ? 0 : 1;
+    else
+        return kFalse;
+
+    switch (f->op) {
+        case C2B_TAG_EQ: return (comparison == 0) ? kTrue : kFalse;
+        case C2B_TAG_NE: return (comparison != 0) ? kTrue : kFalse;
+        case C2B_TAG_LT: return (comparison < 0) ? kTrue : kFalse;
+        case C2B_TAG_LE: return (comparison <= 0) ? kTrue : kFalse;
+        case C2B_TAG_GT: return (comparison > 0) ? kTrue : kFalse;
+        case C2B_TAG_GE: return (comparison >= 0) ? kTrue : kFalse;
+        default: break;
+    }
+
+    return kFalse;
 }
 
 static inline boolean
-c2b_vcf_record_is_deletion(char *ref, char *alt) 
+c2b_bam_record_is_dropped(c2b_context_t *ctx, char *src, ssize_t src_size)
 {
-    return ((!c2b_vcf_allele_is_id(alt)) && (((int) strlen(ref) - (int) strlen(alt)) > 0)) ? kTrue : kFalse;
+    /* FLAG and MAPQ are read from the fixed-length core of the record, before anything is decoded */
+
+    const unsigned char *record = (const unsigned char *) src;
+
+    if (src_size < C2B_BAM_RECORD_CORE_LENGTH) {
+        /* reported by c2b_bam_record_to_sam() */
+        return kFalse;
+    }
+
+    return c2b_read_is_dropped(ctx, (int) c2b_bam_le16(record + 14), record[9]);
 }
 
-static inline void
-c2b_line_convert_vcf_to_bed(c2b_vcf_t v, char *dest_line, ssize_t *dest_size) 
+static void
+c2b_line_convert_bam_to_bed_unsorted_without_split_operation(c2b_context_t *ctx, c2b_output_t *dest, char *src, ssize_t src_size)
 {
     /* 
-       For VCF v4.2-formatted data, we use the mapping provided by BEDOPS convention described at:
+       Here, src holds one binary BAM record, less its leading length field. We decode it 
+       to SAM fields and write the same BED columns as the SAM functor would for the line 
+       that samtools prints for this record.
+    */
 
-       http://bedops.readthedocs.org/en/latest/content/reference/file-management/conversion/vcf2bed.html
+    c2b_bam_record_t record;
+    c2b_cigar_t cigar;
+    c2b_sam_t sam;
 
-       VCF field                 BED column index       BED field
-       -------------------------------------------------------------------------
-       CHROM                     1                      chromosome
-       POS - 1                   2                      start
-       POS (*)                   3                      stop
-       ID                        4                      id
-       QUAL                      5                      score
+    if (c2b_bam_record_is_dropped(ctx, src, src_size))
+        return;
 
-      * : When using --deletions, the stop value of the BED output is determined by the length difference 
-          between ALT and REF alleles. Use of --insertions or --snvs yields a one-base BED element.
+    c2b_init_cigar(&cigar);
+    c2b_init_bam_record(&record);
+    c2b_bam_record_to_sam(ctx, src, src_size, &record, &sam, &cigar);
+    if (c2b_read_tags_are_dropped(ctx, sam.opt)) {
+        c2b_delete_cigar(&cigar);
+        c2b_delete_bam_record(&record);
+        return;
+    }
 
-       The remaining VCF columns are mapped as-is, in same order, to adjacent BED columns:
+    boolean is_mapped = (boolean) !(4 & sam.flag);
 
-       VCF field                 BED column index       BED field
-       -------------------------------------------------------------------------
-       REF                       6                      -
-       ALT                       7                      -
-       FILTER                    8                      -
-       INFO                      9                      -
+    if (is_mapped) {
+        sam.rname = c2b_span_from_str(((record.ref_id >= 0) && (record.ref_id < ctx->bam.num_refs)) ? ctx->bam.ref_names[record.ref_id] : "*");
+        sam.start = (uint64_t) (int64_t) record.pos;
+        sam.stop = (uint64_t) (int64_t) record.pos + cigar.bases;
+    }
+    else {
+        sam.rname = c2b_span_from_str((char *) c2b_unmapped_read_chr_name);
+        sam.start = 0;
+        sam.stop = 1;
+    }
 
-       If present in the VCF v4 input, the following columns are also mapped:
+    c2b_line_convert_sam_to_bed(sam, dest);
+    c2b_delete_cigar(&cigar);
+    c2b_delete_bam_record(&record);
+}
 
-       VCF field                 BED column index       BED field
-       -------------------------------------------------------------------------
-       FORMAT                    10                     -
-       Sample 1                  11                     -
-       Sample 2                  12                     -
-       ...
-    */
+static void
+c2b_line_convert_bam_to_bed_unsorted_with_split_operation(c2b_context_t *ctx, c2b_output_t *dest, char *src, ssize_t src_size)
+{
+    c2b_bam_record_t record;
+    c2b_cigar_t cigar;
+    c2b_sam_t sam;
+    char rname_str[C2B_MAX_FIELD_LENGTH_VALUE];
+
+    if (c2b_bam_record_is_dropped(ctx, src, src_size))
+        return;
+
+    c2b_init_cigar(&cigar);
+    c2b_init_bam_record(&record);
+    c2b_bam_record_to_sam(ctx, src, src_size, &record, &sam, &cigar);
+#ifdef DEBUG
+    c2b_sam_debug_cigar_ops(&cigar);
+#endif
+    if (c2b_read_tags_are_dropped(ctx, sam.opt)) {
+        c2b_delete_cigar(&cigar);
+        c2b_delete_bam_record(&record);
+        return;
+    }
+
+    boolean is_mapped = (boolean) !(4 & sam.flag);
+
+    /* as with SAM input, unmapped reads keep the tab that follows the placeholder chromosome name */
 
-    if (strlen(v.format) > 0) {
-        *dest_size += sprintf(dest_line + *dest_size,
-                              "%s\t"            \
-                              "%" PRIu64 "\t"   \
-                              "%" PRIu64 "\t"   \
-                              "%s\t"            \
-                              "%s\t"            \
-                              "%s\t"            \
-                              "%s\t"            \
-                              "%s\t"            \
-                              "%s\t"            \
-                              "%s\t"            \
-                              "%s\n",
-                              v.chrom,
-                              v.start,
-                              v.end,
-                              v.id,
-                              v.qual,
-                              v.ref,
-                              v.alt,
-                              v.filter,
-                              v.info,
-                              v.format,
-                              v.samples);
+    if (is_mapped) {
+        sam.rname = c2b_span_from_str(((record.ref_id >= 0) && (record.ref_id < ctx->bam.num_refs)) ? ctx->bam.ref_names[record.ref_id] : "*");
     }
     else {
-        *dest_size += sprintf(dest_line + *dest_size,
-                              "%s\t"            \
-                              "%" PRIu64 "\t"   \
-                              "%" PRIu64 "\t"   \
-                              "%s\t"            \
-                              "%s\t"            \
-                              "%s\t"            \
-                              "%s\t"            \
-                              "%s\t"            \
-                              "%s\n",
-                              v.chrom,
-                              v.start,
-                              v.end,
-                              v.id,
-                              v.qual,
-                              v.ref,
-                              v.alt,
-                              v.filter,
-                              v.info);
-    }
-}
-
-static void
-c2b_line_convert_wig_to_bed_unsorted(char *dest, ssize_t *dest_size, char *src, ssize_t src_size)
-{
-    char src_line_str[C2B_MAX_LINE_LENGTH_VALUE];
-    char dest_line_str[C2B_MAX_LINE_LENGTH_VALUE];
+        sam.rname.s = rname_str;
+        sam.rname.length = sprintf(rname_str, "%s\t", c2b_unmapped_read_chr_name);
+    }
+    sam.start = (uint64_t) (int64_t) record.pos;
+    sam.stop = sam.start;
+
+    c2b_line_convert_sam_split_ops_to_bed(sam, &cigar, sam.start + cigar.bases, dest);
+    c2b_delete_cigar(&cigar);
+    c2b_delete_bam_record(&record);
+}
 
+static void
+c2b_line_convert_sam_to_bed_fragments(c2b_context_t *ctx, c2b_output_t *dest, char *src, ssize_t src_size)
+{
     /* 
-       Initialize and increment parameters
+       Fields are split out up to TLEN. A read that is one of a proper pair's primary
+       alignments is handed to the table of pending mates, which writes the fragment
+       once both mates are in; other reads are counted and skipped.
     */
 
-    c2b_globals.wig->line++;
-    if (c2b_globals.wig->basename) {
-        sprintf(c2b_globals.wig->id,
-                "%s.%u",
-                c2b_globals.wig->basename,
-                c2b_globals.wig->section);
+    c2b_span_t sam_fields[C2B_MAX_FIELD_COUNT_VALUE];
+    int sam_field_idx = 0;
+    int flag_val = 0;
+    boolean is_mate_on_same_ref = kFalse;
+    c2b_fragment_mate_t mate;
+
+    if (src[0] == c2b_sam_header_prefix) {
+        if (c2b_globals.keep_header_flag)
+            c2b_line_convert_header_to_bed(ctx, dest, src, src_size);
+        return;
     }
 
-    /* 
-       Legal header cases: line starts with '#' 
-    */
-    
-    if (src[0] == c2b_wig_header_prefix) { 
-        if (c2b_globals.wig->start_write) {
-            c2b_globals.wig->start_write = kFalse;
-            sprintf(c2b_globals.wig->id, 
-                    "%s.%u",
-                    c2b_globals.wig->basename, 
-                    ++c2b_globals.wig->section);
-        }
-        if (c2b_globals.keep_header_flag) { 
-            /* copy header line to destination stream buffer */
-            memcpy(src_line_str, src, src_size);
-            src_line_str[src_size] = '\0';
-            if (!c2b_globals.wig->basename) {
-                sprintf(dest_line_str, 
-                        "%s\t%u\t%u\t%s\n", 
-                        c2b_header_chr_name, 
-                        c2b_globals.header_line_idx, 
-                        c2b_globals.header_line_idx + 1, 
-                        src_line_str);
-            }
-            else {
-                sprintf(dest_line_str, 
-                        "%s\t%u\t%u\t%s\t%s\n", 
-                        c2b_header_chr_name, 
-                        c2b_globals.header_line_idx, 
-                        c2b_globals.header_line_idx + 1, 
-                        c2b_globals.wig->id,
-                        src_line_str);
-            }
-            memcpy(dest + *dest_size, dest_line_str, strlen(dest_line_str));
-            *dest_size += strlen(dest_line_str);
-            c2b_globals.header_line_idx++;
-            return;
-        }
-        else {
-            return;
+    sam_field_idx = c2b_sam_split_fields(ctx, src, src_size, sam_fields, &flag_val);
+    if (sam_field_idx < 0)
+        return;
+
+    if (sam_field_idx >= 9) {
+        is_mate_on_same_ref = (c2b_span_equals(sam_fields[6], "=") || 
+                               ((sam_fields[6].length == sam_fields[2].length) && (memcmp(sam_fields[6].s, sam_fields[2].s, sam_fields[2].length) == 0)));
+    }
+    if ((sam_field_idx < 9) || (!c2b_read_is_fragment_mate(flag_val, is_mate_on_same_ref, !c2b_span_equals(sam_fields[8], "0")))) {
+        ctx->counts.unpaired_reads++;
+        return;
+    }
+
+    mate.flag = (uint16_t) flag_val;
+    mate.mapq = (uint8_t) c2b_span_to_uint64(sam_fields[4]);
+    mate.start = c2b_span_to_uint64(sam_fields[3]) - 1;
+    mate.stop = mate.start + c2b_sam_cigar_str_to_bases(sam_fields[5]);
+    mate.mate_start = c2b_span_to_uint64(sam_fields[7]) - 1;
+    c2b_add_fragment_mate(ctx, dest, sam_fields[2], sam_fields[0], &mate);
+}
+
+static void
+c2b_line_convert_bam_to_bed_fragments(c2b_context_t *ctx, c2b_output_t *dest, char *src, ssize_t src_size)
+{
+    /* the mate's reference, position and TLEN are read from the fixed-length core of the record */
+
+    const unsigned char *core = (const unsigned char *) src;
+    c2b_bam_record_t record;
+    c2b_cigar_t cigar;
+    c2b_sam_t sam;
+    c2b_fragment_mate_t mate;
+
+    if (c2b_bam_record_is_dropped(ctx, src, src_size))
+        return;
+
+    c2b_init_cigar(&cigar);
+    c2b_init_bam_record(&record);
+    c2b_bam_record_to_sam(ctx, src, src_size, &record, &sam, &cigar);
+    if (c2b_read_tags_are_dropped(ctx, sam.opt)) {
+        c2b_delete_cigar(&cigar);
+        c2b_delete_bam_record(&record);
+        return;
+    }
+
+    if ((record.ref_id < 0) || 
+        (record.ref_id >= ctx->bam.num_refs) || 
+        (!c2b_read_is_fragment_mate(sam.flag, ((int32_t) c2b_bam_le32(core + 20) == record.ref_id), (c2b_bam_le32(core + 28) != 0)))) {
+        ctx->counts.unpaired_reads++;
+        c2b_delete_cigar(&cigar);
+        c2b_delete_bam_record(&record);
+        return;
+    }
+
+    mate.flag = (uint16_t) sam.flag;
+    mate.mapq = core[9];
+    mate.start = (uint64_t) (int64_t) record.pos;
+    mate.stop = mate.start + cigar.bases;
+    mate.mate_start = (uint64_t) (int64_t) (int32_t) c2b_bam_le32(core + 24);
+    c2b_add_fragment_mate(ctx, dest, c2b_span_from_str(ctx->bam.ref_names[record.ref_id]), sam.qname, &mate);
+    c2b_delete_cigar(&cigar);
+    c2b_delete_bam_record(&record);
+}
+
+static inline boolean
+c2b_read_is_fragment_mate(int flag_val, boolean is_mate_on_same_ref, boolean has_tlen)
+{
+    /* paired and properly aligned (0x3), with neither read nor mate unmapped (0xc), nor secondary or supplementary (0x900) */
+
+    return (((flag_val & 0x3) == 0x3) && (!(flag_val & 0x90c)) && (is_mate_on_same_ref) && (has_tlen)) ? kTrue : kFalse;
+}
+
+static void
+c2b_add_fragment_mate(c2b_context_t *ctx, c2b_output_t *dest, c2b_span_t rname, c2b_span_t qname, c2b_fragment_mate_t *m)
+{
+    ssize_t qname_idx = 0;
+
+    if (!ctx->fragments)
+        ctx->fragments = c2b_new_fragment_state();
+
+    if (qname.length > C2B_MAX_QNAME_LENGTH_VALUE) {
+        fprintf(stderr, "Error: QNAME is longer than %d characters -- input file may not match input format\n", C2B_MAX_QNAME_LENGTH_VALUE);
+        c2b_print_usage(stderr);
+        exit(EINVAL); /* Invalid argument (POSIX.1) */
+    }
+
+    /* 64-bit FNV-1a */
+    m->hash = UINT64_C(14695981039346656037);
+    for (qname_idx = 0; qname_idx < qname.length; qname_idx++)
+        m->hash = (m->hash ^ (unsigned char) qname.s[qname_idx]) * UINT64_C(1099511628211);
+    memcpy(m->qname, qname.s, qname.length);
+    m->qname_length = (uint8_t) qname.length;
+    m->chrom = c2b_fragment_chrom_id(ctx->fragments, rname.s, (size_t) rname.length);
+
+    c2b_pair_fragment_mate(ctx->fragments, &ctx->fragments->table, m, dest);
+}
+
+static c2b_fragment_state_t *
+c2b_new_fragment_state()
+{
+    c2b_fragment_state_t *f = NULL;
+
+    f = malloc(sizeof(c2b_fragment_state_t));
+    if (!f) {
+        fprintf(stderr, "Error: Could not allocate space for fragment state\n");
+        c2b_print_usage(stderr);
+        exit(ENOMEM); /* Not enough space (POSIX.1) */
+    }
+    c2b_init_fragment_table(&f->table, 0);
+    f->chrom_names = NULL;
+    f->chrom_lengths = NULL;
+    f->num_chroms = 0;
+    f->chroms_capacity = 0;
+    f->chrom_slots = NULL;
+    f->chrom_slots_capacity = 0;
+    f->last_chrom = 0;
+
+    return f;
+}
+
+static void
+c2b_delete_fragment_state(c2b_fragment_state_t *f)
+{
+    uint32_t c = 0;
+
+    c2b_delete_fragment_table(&f->table);
+    for (c = 0; c < f->num_chroms; c++)
+        free(f->chrom_names[c]);
+    free(f->chrom_names);
+    free(f->chrom_lengths);
+    free(f->chrom_slots);
+    free(f);
+}
+
+static uint32_t
+c2b_fragment_chrom_id(c2b_fragment_state_t *f, char *name, size_t length)
+{
+    char **names = NULL;
+    size_t *lengths = NULL;
+    uint32_t *slots = NULL;
+    uint32_t mask = 0;
+    uint32_t idx = 0;
+    uint32_t c = 0;
+    uint32_t hash = 2166136261U;
+    size_t n;
+
+    /* as in c2b_sort_chrom_id(), reads tend to arrive in runs on one chromosome */
+
+    if ((f->num_chroms > 0) && 
+        (f->chrom_lengths[f->last_chrom] == length) && 
+        (memcmp(f->chrom_names[f->last_chrom], name, length) == 0))
+        return f->last_chrom;
+
+    if (2 * (f->num_chroms + 1) > f->chrom_slots_capacity) {
+        f->chrom_slots_capacity = (f->chrom_slots_capacity == 0) ? 64 : (2 * f->chrom_slots_capacity);
+        slots = calloc(f->chrom_slots_capacity, sizeof(uint32_t));
+        if (!slots) {
+            fprintf(stderr, "Error: Could not allocate space for fragment chromosome table\n");
+            c2b_print_usage(stderr);
+            exit(ENOMEM); /* Not enough space (POSIX.1) */
+        }
+        mask = f->chrom_slots_capacity - 1;
+        for (c = 0; c < f->num_chroms; c++) {
+            hash = 2166136261U;
+            for (n = 0; n < f->chrom_lengths[c]; n++)
+                hash = (hash ^ (unsigned char) f->chrom_names[c][n]) * 16777619U;
+            idx = hash & mask;
+            while (slots[idx])
+                idx = (idx + 1) & mask;
+            slots[idx] = c + 1;
+        }
+        free(f->chrom_slots);
+        f->chrom_slots = slots;
+    }
+
+    mask = f->chrom_slots_capacity - 1;
+    hash = 2166136261U;
+    for (n = 0; n < length; n++)
+        hash = (hash ^ (unsigned char) name[n]) * 16777619U;
+    idx = hash & mask;
+    while (f->chrom_slots[idx]) {
+        c = f->chrom_slots[idx] - 1;
+        if ((f->chrom_lengths[c] == length) && (memcmp(f->chrom_names[c], name, length) == 0)) {
+            f->last_chrom = c;
+            return c;
+        }
+        idx = (idx + 1) & mask;
+    }
+
+    if (f->num_chroms == f->chroms_capacity) {
+        f->chroms_capacity = (f->chroms_capacity == 0) ? 64 : (2 * f->chroms_capacity);
+        names = realloc(f->chrom_names, f->chroms_capacity * sizeof(char *));
+        lengths = (names) ? realloc(f->chrom_lengths, f->chroms_capacity * sizeof(size_t)) : NULL;
+        if ((!names) || (!lengths)) {
+            fprintf(stderr, "Error: Could not allocate space for fragment chromosome names\n");
+            c2b_print_usage(stderr);
+            exit(ENOMEM); /* Not enough space (POSIX.1) */
+        }
+        f->chrom_names = names;
+        f->chrom_lengths = lengths;
+    }
+    f->chrom_names[f->num_chroms] = malloc(length + 1);
+    if (!f->chrom_names[f->num_chroms]) {
+        fprintf(stderr, "Error: Could not allocate space for fragment chromosome name\n");
+        c2b_print_usage(stderr);
+        exit(ENOMEM); /* Not enough space (POSIX.1) */
+    }
+    memcpy(f->chrom_names[f->num_chroms], name, length);
+    f->chrom_names[f->num_chroms][length] = '\0';
+    f->chrom_lengths[f->num_chroms] = length;
+    f->chrom_slots[idx] = f->num_chroms + 1;
+    f->last_chrom = f->num_chroms++;
+
+    return f->last_chrom;
+}
+
+static void
+c2b_init_fragment_table(c2b_fragment_table_t *t, unsigned int depth)
+{
+    int partition_idx = 0;
+
+    t->mates = NULL;
+    t->num_mates = 0;
+    t->capacity = 0;
+    t->depth = depth;
+    for (partition_idx = 0; partition_idx < C2B_FRAGMENT_PARTITIONS_VALUE; partition_idx++)
+        t->spill_fds[partition_idx] = -1;
+    t->is_spilled = kFalse;
+}
+
+static void
+c2b_delete_fragment_table(c2b_fragment_table_t *t)
+{
+    int partition_idx = 0;
+
+    if (t->mates)
+        free(t->mates), t->mates = NULL;
+    t->num_mates = 0;
+    t->capacity = 0;
+    for (partition_idx = 0; partition_idx < C2B_FRAGMENT_PARTITIONS_VALUE; partition_idx++) {
+        if (t->spill_fds[partition_idx] != -1)
+            close(t->spill_fds[partition_idx]), t->spill_fds[partition_idx] = -1;
+    }
+}
+
+static void
+c2b_pair_fragment_mate(c2b_fragment_state_t *f, c2b_fragment_table_t *t, const c2b_fragment_mate_t *m, c2b_output_t *dest)
+{
+    c2b_fragment_mate_t *slot = NULL;
+    size_t mask = 0;
+    size_t idx = 0;
+    size_t capacity = 0;
+
+    /* 
+       Slots are indexed on the high half of the hash, as the low half picks the 
+       partition. A slot is empty if its FLAG is zero; a stored mate has 0x3 set.
+    */
+
+    if (t->capacity > 0) {
+        mask = t->capacity - 1;
+        for (idx = (size_t) (m->hash >> 32) & mask; t->mates[idx].flag != 0; idx = (idx + 1) & mask) {
+            slot = &t->mates[idx];
+            if ((slot->hash == m->hash) && 
+                (slot->qname_length == m->qname_length) && 
+                (slot->chrom == m->chrom) && 
+                (slot->start == m->mate_start) && 
+                (slot->mate_start == m->start) && 
+                (((slot->flag ^ m->flag) & 0xc0) == 0xc0) && 
+                (memcmp(slot->qname, m->qname, m->qname_length) == 0)) {
+                c2b_emit_fragment(f, slot, m, dest);
+                c2b_remove_fragment_mate(t, idx);
+                return;
+            }
+        }
+    }
+
+    /* the table is grown at half load, or spilled, if growing it would take it past --fragments-max-mem */
+
+    if (2 * (t->num_mates + 1) > t->capacity) {
+        capacity = (t->capacity == 0) ? 1024 : (2 * t->capacity);
+        if ((t->capacity > 0) && 
+            (t->depth < C2B_MAX_FRAGMENT_DEPTH_VALUE) && 
+            ((uint64_t) capacity * sizeof(c2b_fragment_mate_t) > c2b_globals.fragments->max_mem))
+            c2b_spill_fragment_table(t);
+        else
+            c2b_grow_fragment_table(t, capacity);
+    }
+
+    mask = t->capacity - 1;
+    for (idx = (size_t) (m->hash >> 32) & mask; t->mates[idx].flag != 0; idx = (idx + 1) & mask)
+        ;
+    memcpy(&t->mates[idx], m, offsetof(c2b_fragment_mate_t, qname) + m->qname_length);
+    t->num_mates++;
+}
+
+static void
+c2b_remove_fragment_mate(c2b_fragment_table_t *t, size_t idx)
+{
+    size_t mask = t->capacity - 1;
+    size_t next_idx = idx;
+    size_t home_idx = 0;
+
+    /* 
+       Later mates in the same run of slots are shifted back into the hole, unless 
+       their home slot lies cyclically after it, so that no probe stops early
+    */
+
+    for (;;) {
+        next_idx = (next_idx + 1) & mask;
+        if (t->mates[next_idx].flag == 0)
+            break;
+        home_idx = (size_t) (t->mates[next_idx].hash >> 32) & mask;
+        if (((next_idx > idx) && ((home_idx <= idx) || (home_idx > next_idx))) || 
+            ((next_idx < idx) && ((home_idx <= idx) && (home_idx > next_idx)))) {
+            memcpy(&t->mates[idx], &t->mates[next_idx], offsetof(c2b_fragment_mate_t, qname) + t->mates[next_idx].qname_length);
+            idx = next_idx;
+        }
+    }
+    t->mates[idx].flag = 0;
+    t->num_mates--;
+}
+
+static void
+c2b_grow_fragment_table(c2b_fragment_table_t *t, size_t capacity)
+{
+    c2b_fragment_mate_t *mates = NULL;
+    size_t mask = capacity - 1;
+    size_t old_idx = 0;
+    size_t idx = 0;
+
+    mates = calloc(capacity, sizeof(c2b_fragment_mate_t));
+    if (!mates) {
+        fprintf(stderr, "Error: Could not allocate space for fragment mate table\n");
+        c2b_print_usage(stderr);
+        exit(ENOMEM); /* Not enough space (POSIX.1) */
+    }
+    for (old_idx = 0; old_idx < t->capacity; old_idx++) {
+        if (t->mates[old_idx].flag == 0)
+            continue;
+        for (idx = (size_t) (t->mates[old_idx].hash >> 32) & mask; mates[idx].flag != 0; idx = (idx + 1) & mask)
+            ;
+        memcpy(&mates[idx], &t->mates[old_idx], offsetof(c2b_fragment_mate_t, qname) + t->mates[old_idx].qname_length);
+    }
+    free(t->mates);
+    t->mates = mates;
+    t->capacity = capacity;
+}
+
+static void
+c2b_spill_fragment_table(c2b_fragment_table_t *t)
+{
+    char *buffers = NULL;
+    size_t buffer_sizes[C2B_FRAGMENT_PARTITIONS_VALUE] = { 0 };
+    size_t buffer_capacity = C2B_MAX_LINE_LENGTH_VALUE * 2;
+    size_t record_length = 0;
+    size_t idx = 0;
+    int partition_idx = 0;
+    c2b_fragment_mate_t *m = NULL;
+
+    /* 
+       Mates are written out in one pass, through a buffer per partition, as their 
+       fixed-length fields followed by QNAME
+    */
+
+    buffers = malloc(buffer_capacity * C2B_FRAGMENT_PARTITIONS_VALUE);
+    if (!buffers) {
+        fprintf(stderr, "Error: Could not allocate space for fragment spill buffers\n");
+        c2b_print_usage(stderr);
+        exit(ENOMEM); /* Not enough space (POSIX.1) */
+    }
+
+    for (idx = 0; idx < t->capacity; idx++) {
+        m = &t->mates[idx];
+        if (m->flag == 0)
+            continue;
+        partition_idx = (int) ((m->hash >> (4 * t->depth)) & (C2B_FRAGMENT_PARTITIONS_VALUE - 1));
+        record_length = offsetof(c2b_fragment_mate_t, qname) + m->qname_length;
+        if (buffer_sizes[partition_idx] + record_length > buffer_capacity) {
+            c2b_write_fragment_partition(t, partition_idx, buffers + partition_idx * buffer_capacity, buffer_sizes[partition_idx]);
+            buffer_sizes[partition_idx] = 0;
+        }
+        memcpy(buffers + partition_idx * buffer_capacity + buffer_sizes[partition_idx], m, record_length);
+        buffer_sizes[partition_idx] += record_length;
+        m->flag = 0;
+    }
+    for (partition_idx = 0; partition_idx < C2B_FRAGMENT_PARTITIONS_VALUE; partition_idx++) {
+        if (buffer_sizes[partition_idx] > 0)
+            c2b_write_fragment_partition(t, partition_idx, buffers + partition_idx * buffer_capacity, buffer_sizes[partition_idx]);
+    }
+    free(buffers);
+
+    t->num_mates = 0;
+    t->is_spilled = kTrue;
+}
+
+static void
+c2b_write_fragment_partition(c2b_fragment_table_t *t, int partition_idx, char *buffer, size_t size)
+{
+    ssize_t bytes_written = 0;
+    int errsv = 0;
+
+    if (t->spill_fds[partition_idx] == -1)
+        t->spill_fds[partition_idx] = c2b_open_tmp_file("fragment spill");
+
+    while (size > 0) {
+        bytes_written = write(t->spill_fds[partition_idx], buffer, size);
+        if (bytes_written == -1) {
+            errsv = errno;
+            if (errsv == EINTR)
+                continue;
+            fprintf(stderr, "Error: Could not write fragment spill file (%s)\n", strerror(errsv));
+            exit(errsv);
+        }
+        buffer += bytes_written;
+        size -= (size_t) bytes_written;
+    }
+}
+
+static void
+c2b_pair_fragment_partition(c2b_context_t *ctx, int fd, unsigned int depth, c2b_output_t *dest)
+{
+    c2b_fragment_table_t t;
+    c2b_fragment_mate_t m;
+    char *buffer = NULL;
+    size_t buffer_capacity = C2B_MAX_LINE_LENGTH_VALUE * 2;
+    size_t buffer_start = 0;
+    size_t buffer_end = 0;
+    size_t header_length = offsetof(c2b_fragment_mate_t, qname);
+    ssize_t bytes_read = 0;
+    int errsv = 0;
+
+    buffer = malloc(buffer_capacity);
+    if (!buffer) {
+        fprintf(stderr, "Error: Could not allocate space for fragment partition buffer\n");
+        c2b_print_usage(stderr);
+        exit(ENOMEM); /* Not enough space (POSIX.1) */
+    }
+
+    c2b_init_fragment_table(&t, depth);
+    if (lseek(fd, 0, SEEK_SET) == -1) {
+        errsv = errno;
+        fprintf(stderr, "Error: Could not rewind fragment spill file (%s)\n", strerror(errsv));
+        exit(errsv);
+    }
+
+    for (;;) {
+        if ((buffer_end - buffer_start < header_length) || 
+            (buffer_end - buffer_start < header_length + (unsigned char) buffer[buffer_start + offsetof(c2b_fragment_mate_t, qname_length)])) {
+            memmove(buffer, buffer + buffer_start, buffer_end - buffer_start);
+            buffer_end -= buffer_start;
+            buffer_start = 0;
+            bytes_read = read(fd, buffer + buffer_end, buffer_capacity - buffer_end);
+            if (bytes_read == -1) {
+                errsv = errno;
+                if (errsv == EINTR)
+                    continue;
+                fprintf(stderr, "Error: Could not read fragment spill file (%s)\n", strerror(errsv));
+                exit(errsv);
+            }
+            if (bytes_read == 0)
+                break;
+            buffer_end += (size_t) bytes_read;
+            continue;
+        }
+        memcpy(&m, buffer + buffer_start, header_length);
+        memcpy(m.qname, buffer + buffer_start + header_length, m.qname_length);
+        buffer_start += header_length + m.qname_length;
+        c2b_pair_fragment_mate(ctx->fragments, &t, &m, dest);
+    }
+    free(buffer);
+
+    c2b_finish_fragment_table(ctx, &t, dest);
+    c2b_delete_fragment_table(&t);
+}
+
+static void
+c2b_finish_fragment_table(c2b_context_t *ctx, c2b_fragment_table_t *t, c2b_output_t *dest)
+{
+    int partition_idx = 0;
+
+    if (!t->is_spilled) {
+        ctx->counts.orphan_reads += t->num_mates;
+        return;
+    }
+
+    /* the table is released before its partitions are paired, each in a table of its own */
+
+    c2b_spill_fragment_table(t);
+    free(t->mates), t->mates = NULL;
+    t->capacity = 0;
+    for (partition_idx = 0; partition_idx < C2B_FRAGMENT_PARTITIONS_VALUE; partition_idx++) {
+        if (t->spill_fds[partition_idx] == -1)
+            continue;
+        c2b_pair_fragment_partition(ctx, t->spill_fds[partition_idx], t->depth + 1, dest);
+        close(t->spill_fds[partition_idx]), t->spill_fds[partition_idx] = -1;
+    }
+}
+
+static void
+c2b_finish_fragments(c2b_context_t *ctx, c2b_output_t *dest)
+{
+    /* called at the end of the context's input, to pair spilled mates and count orphans */
+
+    if (!ctx->fragments)
+        return;
+
+    c2b_finish_fragment_table(ctx, &ctx->fragments->table, dest);
+    c2b_delete_fragment_state(ctx->fragments), ctx->fragments = NULL;
+}
+
+static inline void
+c2b_emit_fragment(c2b_fragment_state_t *f, const c2b_fragment_mate_t *a, const c2b_fragment_mate_t *b, c2b_output_t *dest)
+{
+    const c2b_fragment_mate_t *first = (a->flag & 0x40) ? a : b;
+    char *dest_posn = c2b_reserve_output(dest, 
+                                         (ssize_t) f->chrom_lengths[a->chrom] + a->qname_length + 
+                                         8 + 3 * C2B_MAX_UINT64_FIELD_LENGTH_VALUE);
+    c2b_span_t qname = { (char *) a->qname, a->qname_length };
+
+    /* chromosome, leftmost start, rightmost stop, QNAME, the lower MAPQ and the strand of the first segment */
+
+    dest_posn = c2b_emit_str(dest_posn, f->chrom_names[a->chrom], c2b_tab_delim);
+    dest_posn = c2b_emit_uint64(dest_posn, (a->start < b->start) ? a->start : b->start, c2b_tab_delim);
+    dest_posn = c2b_emit_uint64(dest_posn, (a->stop > b->stop) ? a->stop : b->stop, c2b_tab_delim);
+    dest_posn = c2b_emit_span(dest_posn, qname, c2b_tab_delim);
+    dest_posn = c2b_emit_uint64(dest_posn, (a->mapq < b->mapq) ? a->mapq : b->mapq, c2b_tab_delim);
+    *dest_posn++ = (first->flag & 0x10) ? '-' : '+';
+    *dest_posn++ = c2b_line_delim;
+
+    dest->size = dest_posn - dest->buf;
+}
+
+static void
+c2b_line_convert_to_coverage(c2b_context_t *ctx, c2b_output_t *dest, char *src, ssize_t src_size)
+{
+    /* 
+       The format's functor writes its lines to scratch. Elements are read back from 
+       these lines and summed into runs of coverage, which alone are written to dest.
+    */
+
+    c2b_coverage_state_t *c = NULL;
+    char *line_start = NULL;
+    char *line_end = NULL;
+    char *chrom_end = NULL;
+    char *field_end = NULL;
+    char *scratch_end = NULL;
+    uint64_t start = 0;
+    uint64_t stop = 0;
+    uint64_t watermark = UINT64_MAX;
+    int pass = 0;
+
+    if (!ctx->coverage)
+        ctx->coverage = c2b_new_coverage_state();
+    c = ctx->coverage;
+
+    c->scratch.size = 0;
+    (*c2b_globals.coverage->line_functor)(ctx, &c->scratch, src, src_size);
+    scratch_end = c->scratch.buf + c->scratch.size;
+
+    /* the first pass finds the lowest start of the call's elements, the second adds them */
+
+    for (pass = 0; pass < 2; pass++) {
+        line_start = c->scratch.buf;
+        while ((line_end = memchr(line_start, c2b_line_delim, (size_t) (scratch_end - line_start))) != NULL) {
+            chrom_end = memchr(line_start, c2b_tab_delim, (size_t) (line_end - line_start));
+            if (!chrom_end) {
+                fprintf(stderr, "Error: Converted BED line has no start or stop coordinate; cannot take coverage\n");
+                c2b_print_usage(stderr);
+                exit(EINVAL); /* Invalid argument (POSIX.1) */
+            }
+            field_end = c2b_parse_sort_coordinate(chrom_end + 1, line_end, &start);
+            if (field_end == line_end) {
+                fprintf(stderr, "Error: Converted BED line has no stop coordinate; cannot take coverage\n");
+                c2b_print_usage(stderr);
+                exit(EINVAL); /* Invalid argument (POSIX.1) */
+            }
+            c2b_parse_sort_coordinate(field_end + 1, line_end, &stop);
+            if (pass == 0) {
+                if (start < watermark)
+                    watermark = start;
+            }
+            else {
+                c2b_add_coverage_element(c, dest, line_start, (size_t) (chrom_end - line_start), start, stop, watermark);
+            }
+            line_start = line_end + 1;
+        }
+    }
+}
+
+static c2b_coverage_state_t *
+c2b_new_coverage_state()
+{
+    c2b_coverage_state_t *c = NULL;
+
+    c = malloc(sizeof(c2b_coverage_state_t));
+    if (!c) {
+        fprintf(stderr, "Error: Could not allocate space for coverage state\n");
+        c2b_print_usage(stderr);
+        exit(ENOMEM); /* Not enough space (POSIX.1) */
+    }
+    c->chrom = NULL;
+    c->chrom_length = 0;
+    c->chrom_capacity = 0;
+    c->has_chrom = kFalse;
+    c->done_chroms = NULL;
+    c->num_done_chroms = 0;
+    c->done_chroms_capacity = 0;
+    c->watermark = 0;
+    c->events = NULL;
+    c->num_events = 0;
+    c->events_capacity = 0;
+    c->run_start = 0;
+    c->depth = 0;
+    c2b_init_output(&c->scratch, -1, NULL);
+
+    return c;
+}
+
+static void
+c2b_delete_coverage_state(c2b_coverage_state_t *c)
+{
+    size_t chrom_idx = 0;
+
+    for (chrom_idx = 0; chrom_idx < c->num_done_chroms; chrom_idx++)
+        free(c->done_chroms[chrom_idx]);
+    free(c->done_chroms);
+    free(c->chrom);
+    free(c->events);
+    c2b_delete_output(&c->scratch);
+    free(c);
+}
+
+static void
+c2b_add_coverage_element(c2b_coverage_state_t *c, c2b_output_t *dest, char *chrom, size_t chrom_length, uint64_t start, uint64_t stop, uint64_t watermark)
+{
+    if ((!c->has_chrom) || (c->chrom_length != chrom_length) || (memcmp(c->chrom, chrom, chrom_length) != 0))
+        c2b_begin_coverage_chrom(c, dest, chrom, chrom_length);
+
+    if (watermark < c->watermark) {
+        fprintf(stderr, "Error: Input is not sorted by coordinate ([%s:%" PRIu64 "] follows [%s:%" PRIu64 "]); --coverage requires sorted input\n", c->chrom, watermark, c->chrom, c->watermark);
+        c2b_print_usage(stderr);
+        exit(EINVAL); /* Invalid argument (POSIX.1) */
+    }
+    c->watermark = watermark;
+
+    /* no later element starts below the watermark, so the events below it are final */
+
+    c2b_sweep_coverage_events(c, dest, watermark);
+    if (stop <= start)
+        return;
+    c2b_push_coverage_event(c, (start << 1) | 1);
+    c2b_push_coverage_event(c, stop << 1);
+}
+
+static void
+c2b_begin_coverage_chrom(c2b_coverage_state_t *c, c2b_output_t *dest, char *chrom, size_t chrom_length)
+{
+    char **done_chroms = NULL;
+    char *name = NULL;
+    size_t chrom_idx = 0;
+
+    /* the previous chromosome is swept to its end, and is not expected again */
+
+    if (c->has_chrom) {
+        c2b_sweep_coverage_events(c, dest, UINT64_MAX);
+        if (c->num_done_chroms == c->done_chroms_capacity) {
+            c->done_chroms_capacity = (c->done_chroms_capacity == 0) ? 64 : (2 * c->done_chroms_capacity);
+            done_chroms = realloc(c->done_chroms, c->done_chroms_capacity * sizeof(char *));
+            if (!done_chroms) {
+                fprintf(stderr, "Error: Could not allocate space for coverage chromosome names\n");
+                c2b_print_usage(stderr);
+                exit(ENOMEM); /* Not enough space (POSIX.1) */
+            }
+            c->done_chroms = done_chroms;
+        }
+        c->done_chroms[c->num_done_chroms++] = c->chrom;
+        c->chrom = NULL;
+        c->chrom_capacity = 0;
+    }
+
+    for (chrom_idx = 0; chrom_idx < c->num_done_chroms; chrom_idx++) {
+        if ((strlen(c->done_chroms[chrom_idx]) == chrom_length) && (memcmp(c->done_chroms[chrom_idx], chrom, chrom_length) == 0)) {
+            fprintf(stderr, "Error: Input is not sorted by coordinate ([%s] follows another chromosome again); --coverage requires sorted input\n", c->done_chroms[chrom_idx]);
+            c2b_print_usage(stderr);
+            exit(EINVAL); /* Invalid argument (POSIX.1) */
+        }
+    }
+
+    if (chrom_length + 1 > c->chrom_capacity) {
+        name = realloc(c->chrom, chrom_length + 1);
+        if (!name) {
+            fprintf(stderr, "Error: Could not allocate space for coverage chromosome name\n");
+            c2b_print_usage(stderr);
+            exit(ENOMEM); /* Not enough space (POSIX.1) */
+        }
+        c->chrom = name;
+        c->chrom_capacity = chrom_length + 1;
+    }
+    memcpy(c->chrom, chrom, chrom_length);
+    c->chrom[chrom_length] = '\0';
+    c->chrom_length = chrom_length;
+    c->has_chrom = kTrue;
+    c->watermark = 0;
+    c->run_start = 0;
+    c->depth = 0;
+}
+
+static void
+c2b_push_coverage_event(c2b_coverage_state_t *c, uint64_t event)
+{
+    uint64_t *events = NULL;
+    size_t idx = c->num_events;
+    size_t parent_idx = 0;
+
+    if (c->num_events == c->events_capacity) {
+        c->events_capacity = (c->events_capacity == 0) ? 1024 : (2 * c->events_capacity);
+        events = realloc(c->events, c->events_capacity * sizeof(uint64_t));
+        if (!events) {
+            fprintf(stderr, "Error: Could not allocate space for coverage events\n");
+            c2b_print_usage(stderr);
+            exit(ENOMEM); /* Not enough space (POSIX.1) */
+        }
+        c->events = events;
+    }
+
+    while (idx > 0) {
+        parent_idx = (idx - 1) / 2;
+        if (c->events[parent_idx] <= event)
+            break;
+        c->events[idx] = c->events[parent_idx];
+        idx = parent_idx;
+    }
+    c->events[idx] = event;
+    c->num_events++;
+}
+
+static uint64_t
+c2b_pop_coverage_event(c2b_coverage_state_t *c)
+{
+    uint64_t event = c->events[0];
+    uint64_t last = c->events[--c->num_events];
+    size_t idx = 0;
+    size_t child_idx = 0;
+
+    while ((child_idx = 2 * idx + 1) < c->num_events) {
+        if ((child_idx + 1 < c->num_events) && (c->events[child_idx + 1] < c->events[child_idx]))
+            child_idx++;
+        if (last <= c->events[child_idx])
+            break;
+        c->events[idx] = c->events[child_idx];
+        idx = child_idx;
+    }
+    if (c->num_events > 0)
+        c->events[idx] = last;
+
+    return event;
+}
+
+static void
+c2b_sweep_coverage_events(c2b_coverage_state_t *c, c2b_output_t *dest, uint64_t limit)
+{
+    uint64_t posn = 0;
+    uint64_t depth = 0;
+
+    /* the events at one position are taken together, so that a run ends only where depth changes */
+
+    while ((c->num_events > 0) && ((c->events[0] >> 1) < limit)) {
+        posn = c->events[0] >> 1;
+        depth = c->depth;
+        while ((c->num_events > 0) && ((c->events[0] >> 1) == posn)) {
+            if (c2b_pop_coverage_event(c) & 1)
+                depth++;
+            else
+                depth--;
+        }
+        if (depth == c->depth)
+            continue;
+        if (c->depth > 0)
+            c2b_emit_coverage_run(c, dest, posn);
+        c->run_start = posn;
+        c->depth = depth;
+    }
+}
+
+static inline void
+c2b_emit_coverage_run(c2b_coverage_state_t *c, c2b_output_t *dest, uint64_t stop)
+{
+    char *dest_posn = c2b_reserve_output(dest, (ssize_t) c->chrom_length + 6 + 3 * C2B_MAX_UINT64_FIELD_LENGTH_VALUE);
+
+    /* bedGraph, or BED with an empty name and the depth as score */
+
+    memcpy(dest_posn, c->chrom, c->chrom_length);
+    dest_posn += c->chrom_length;
+    *dest_posn++ = c2b_tab_delim;
+    dest_posn = c2b_emit_uint64(dest_posn, c->run_start, c2b_tab_delim);
+    dest_posn = c2b_emit_uint64(dest_posn, stop, c2b_tab_delim);
+    if (!c2b_globals.coverage->is_bedgraph) {
+        *dest_posn++ = '.';
+        *dest_posn++ = c2b_tab_delim;
+    }
+    dest_posn = c2b_emit_uint64(dest_posn, c->depth, c2b_line_delim);
+
+    dest->size = dest_posn - dest->buf;
+}
+
+static void
+c2b_finish_coverage(c2b_context_t *ctx, c2b_output_t *dest)
+{
+    /* called at the end of the context's input, to sweep the last chromosome */
+
+    if (!ctx->coverage)
+        return;
+
+    if (ctx->coverage->has_chrom)
+        c2b_sweep_coverage_events(ctx->coverage, dest, UINT64_MAX);
+    c2b_delete_coverage_state(ctx->coverage), ctx->coverage = NULL;
+}
+
+static inline void
+c2b_init_bam_record(c2b_bam_record_t *r)
+{
+    r->cigar.s = r->cigar.inline_s, r->cigar.capacity = C2B_MAX_FIELD_LENGTH_VALUE;
+    r->seq.s = r->seq.inline_s, r->seq.capacity = C2B_MAX_FIELD_LENGTH_VALUE;
+    r->qual.s = r->qual.inline_s, r->qual.capacity = C2B_MAX_FIELD_LENGTH_VALUE;
+    r->opt.s = r->opt.inline_s, r->opt.capacity = C2B_MAX_FIELD_LENGTH_VALUE;
+}
+
+static inline void
+c2b_delete_bam_record(c2b_bam_record_t *r)
+{
+    if (r->cigar.s != r->cigar.inline_s)
+        free(r->cigar.s);
+    if (r->seq.s != r->seq.inline_s)
+        free(r->seq.s);
+    if (r->qual.s != r->qual.inline_s)
+        free(r->qual.s);
+    if (r->opt.s != r->opt.inline_s)
+        free(r->opt.s);
+    c2b_init_bam_record(r);
+}
+
+static char *
+c2b_reserve_bam_field(c2b_bam_field_t *f, size_t length)
+{
+    /* makes room for at least length characters, keeping those already written */
+
+    char *s = NULL;
+    size_t capacity = f->capacity;
+
+    if (length <= f->capacity)
+        return f->s;
+
+    while (capacity < length)
+        capacity *= 2;
+    if (f->s == f->inline_s) {
+        s = malloc(capacity);
+        if (s)
+            memcpy(s, f->inline_s, f->capacity);
+    }
+    else {
+        s = realloc(f->s, capacity);
+    }
+    if (!s) {
+        fprintf(stderr, "Error: Could not allocate space for BAM record field\n");
+        c2b_print_usage(stderr);
+        exit(ENOMEM); /* Not enough space (POSIX.1) */
+    }
+    f->s = s;
+    f->capacity = capacity;
+
+    return f->s;
+}
+
+static void
+c2b_bam_record_to_sam(c2b_context_t *ctx, char *src, ssize_t src_size, c2b_bam_record_t *r, c2b_sam_t *sam, c2b_cigar_t *cigar)
+{
+    const unsigned char *record = (const unsigned char *) src;
+    const unsigned char *record_end = record + src_size;
+    const unsigned char *cigar_src = NULL;
+    const unsigned char *seq_src = NULL;
+    const unsigned char *qual_src = NULL;
+    uint8_t l_read_name = 0;
+    uint16_t n_cigar_op = 0;
+    int32_t l_seq = 0;
+    int32_t next_ref_id = 0;
+    int32_t next_pos = 0;
+    uint32_t op = 0;
+    size_t cigar_str_length = 0;
+    int32_t idx = 0;
+    boolean is_projected = c2b_globals.columns->is_enabled;
+    boolean needs_cigar = (!is_projected) || (c2b_globals.columns->needs_cigar);
+    boolean needs_seq = (!is_projected) || (c2b_globals.columns->needs_seq);
+    boolean needs_qual = (!is_projected) || (c2b_globals.columns->needs_qual);
+    boolean needs_opt = (!is_projected) || (c2b_globals.columns->needs_opt);
+
+    /*
+       The fixed-length core of the record is followed by the NUL-terminated read name, 
+       the CIGAR operations, the 4-bit encoded sequence, the qualities and the tags. With
+       --columns, the CIGAR string, SEQ, QUAL and tags are only decoded if listed.
+    */
+
+    if (src_size < C2B_BAM_RECORD_CORE_LENGTH) {
+        fprintf(stderr, "Error: BAM record is shorter than its fixed-length fields -- input may be corrupt\n");
+        c2b_print_usage(stderr);
+        exit(EINVAL); /* Invalid argument (POSIX.1) */
+    }
+    r->ref_id = (int32_t) c2b_bam_le32(record);
+    r->pos = (int32_t) c2b_bam_le32(record + 4);
+    l_read_name = record[8];
+    c2b_emit_uint64(r->mapq, record[9], '\0');
+    n_cigar_op = c2b_bam_le16(record + 12);
+    sam->flag = (int) c2b_bam_le16(record + 14);
+    l_seq = (int32_t) c2b_bam_le32(record + 16);
+    next_ref_id = (int32_t) c2b_bam_le32(record + 20);
+    next_pos = (int32_t) c2b_bam_le32(record + 24);
+    c2b_emit_int64(r->tlen, (int32_t) c2b_bam_le32(record + 28), '\0');
+
+    cigar_src = record + C2B_BAM_RECORD_CORE_LENGTH + l_read_name;
+    seq_src = cigar_src + 4 * (size_t) n_cigar_op;
+    qual_src = seq_src + ((size_t) l_seq + 1) / 2;
+    if ((l_read_name == 0) || (l_seq < 0) || (qual_src + l_seq > record_end) || (record[C2B_BAM_RECORD_CORE_LENGTH + l_read_name - 1] != '\0')) {
+        fprintf(stderr, "Error: BAM record fields overrun the record -- input may be corrupt\n");
+        c2b_print_usage(stderr);
+        exit(EINVAL); /* Invalid argument (POSIX.1) */
+    }
+
+    /* QNAME */
+    sam->qname.s = (char *) record + C2B_BAM_RECORD_CORE_LENGTH;
+
+    /* CIGAR -- as with SAM input, the length of every operation counts toward the stop position */
+    if (n_cigar_op > cigar->size)
+        c2b_grow_cigar(cigar, n_cigar_op);
+    cigar->bases = 0;
+    cigar->length = n_cigar_op;
+    for (idx = 0; idx < n_cigar_op; idx++) {
+        op = c2b_bam_le32(cigar_src + 4 * idx);
+        if ((op & 0xf) >= strlen(c2b_bam_cigar_ops)) {
+            fprintf(stderr, "Error: BAM record has an invalid CIGAR operation (%u)\n", op & 0xf);
+            c2b_print_usage(stderr);
+            exit(EINVAL); /* Invalid argument (POSIX.1) */
+        }
+        cigar->ops[idx].bases = op >> 4;
+        cigar->ops[idx].operation = c2b_bam_cigar_ops[op & 0xf];
+        cigar->bases += cigar->ops[idx].bases;
+        if (!needs_cigar)
+            continue;
+        c2b_reserve_bam_field(&r->cigar, cigar_str_length + C2B_MAX_OPERATION_FIELD_LENGTH_VALUE);
+        cigar_str_length = c2b_emit_uint64(r->cigar.s + cigar_str_length, cigar->ops[idx].bases, cigar->ops[idx].operation) - r->cigar.s;
+    }
+    r->cigar.s[cigar_str_length] = '\0';
+    if ((n_cigar_op == 0) && (needs_cigar))
+        strcpy(r->cigar.s, "*");
+
+    /* RNEXT and PNEXT */
+    if (next_ref_id < 0)
+        r->rnext = "*";
+    else if (next_ref_id == r->ref_id)
+        r->rnext = "=";
+    else if (next_ref_id < ctx->bam.num_refs)
+        r->rnext = ctx->bam.ref_names[next_ref_id];
+    else {
+        fprintf(stderr, "Error: BAM record mate reference ID (%d) is not in the header\n", next_ref_id);
+        c2b_print_usage(stderr);
+        exit(EINVAL); /* Invalid argument (POSIX.1) */
+    }
+    c2b_emit_int64(r->pnext, (int64_t) next_pos + 1, '\0');
+
+    /* SEQ and QUAL */
+    r->seq.s[0] = '\0';
+    r->qual.s[0] = '\0';
+    if (l_seq == 0) {
+        if (needs_seq)
+            strcpy(r->seq.s, "*");
+        if (needs_qual)
+            strcpy(r->qual.s, "*");
+    }
+    else {
+        if (needs_seq) {
+            c2b_reserve_bam_field(&r->seq, (size_t) l_seq + 1);
+            for (idx = 0; idx < l_seq; idx++) {
+                r->seq.s[idx] = c2b_bam_seq_bases[(seq_src[idx / 2] >> ((idx % 2) ? 0 : 4)) & 0xf];
+            }
+            r->seq.s[l_seq] = '\0';
+        }
+        if ((needs_qual) && (qual_src[0] == 0xff)) {
+            strcpy(r->qual.s, "*");
+        }
+        else if (needs_qual) {
+            c2b_reserve_bam_field(&r->qual, (size_t) l_seq + 1);
+            for (idx = 0; idx < l_seq; idx++) {
+                r->qual.s[idx] = (char) (qual_src[idx] + 33);
+            }
+            r->qual.s[l_seq] = '\0';
+        }
+    }
+
+    /* Optional fields */
+    r->opt.s[0] = '\0';
+    if (needs_opt)
+        c2b_bam_tags_to_str(qual_src + l_seq, record_end, &r->opt);
+
+    sprintf(r->strand, "%c", (0x10 & sam->flag) ? '-' : '+');
+    sam->qname.length = l_read_name - 1;
+    sam->strand = c2b_span_from_str(r->strand);
+    sam->mapq = c2b_span_from_str(r->mapq);
+    sam->cigar = c2b_span_from_str(r->cigar.s);
+    sam->rnext = c2b_span_from_str(r->rnext);
+    sam->pnext = c2b_span_from_str(r->pnext);
+    sam->tlen = c2b_span_from_str(r->tlen);
+    sam->seq = c2b_span_from_str(r->seq.s);
+    sam->qual = c2b_span_from_str(r->qual.s);
+    sam->opt = c2b_span_from_str(r->opt.s);
+}
+
+static void
+c2b_bam_tags_to_str(const unsigned char *tags, const unsigned char *tags_end, c2b_bam_field_t *dest)
+{
+    /*
+       Tags are written as samtools prints them: TAG:TYPE:VALUE, separated by tabs, 
+       with all integer types shown as 'i' and numeric arrays as B:<subtype>,v1,v2...
+       Room is made in dest before each tag, string value and array element is written.
+    */
+
+    size_t dest_length = 0;
+    size_t value_length = 0;
+    const unsigned char *value_end = NULL;
+    unsigned char type = 0;
+    unsigned char subtype = 0;
+    uint32_t count = 0;
+    uint32_t idx = 0;
+    size_t element_size = 0;
+    uint32_t element = 0;
+    float f = 0.0f;
+    char *s = dest->s;
+
+    s[0] = '\0';
+
+    while (tags < tags_end) {
+        if (tags + 3 > tags_end) {
+            fprintf(stderr, "Error: BAM record has a truncated tag -- input may be corrupt\n");
+            c2b_print_usage(stderr);
+            exit(EINVAL); /* Invalid argument (POSIX.1) */
+        }
+        s = c2b_reserve_bam_field(dest, dest_length + 2 * C2B_MAX_OPERATION_FIELD_LENGTH_VALUE);
+        type = tags[2];
+        dest_length += sprintf(s + dest_length, "%s%c%c:%c:", (dest_length > 0) ? "\t" : "", tags[0], tags[1], ((type == 'c') || (type == 'C') || (type == 's') || (type == 'S') || (type == 'I')) ? 'i' : type);
+        tags += 3;
+        switch (type) {
+            case 'A':
+            case 'c':
+            case 'C':
+                element_size = 1;
+                break;
+            case 's':
+            case 'S':
+                element_size = 2;
+                break;
+            case 'i':
+            case 'I':
+            case 'f':
+                element_size = 4;
+                break;
+            case 'Z':
+            case 'H':
+                value_end = memchr(tags, '\0', (size_t) (tags_end - tags));
+                if (!value_end) {
+                    fprintf(stderr, "Error: BAM record has an unterminated string tag -- input may be corrupt\n");
+                    c2b_print_usage(stderr);
+                    exit(EINVAL); /* Invalid argument (POSIX.1) */
+                }
+                value_length = (size_t) (value_end - tags);
+                s = c2b_reserve_bam_field(dest, dest_length + value_length + 1);
+                memcpy(s + dest_length, tags, value_length);
+                dest_length += value_length;
+                s[dest_length] = '\0';
+                tags = value_end + 1;
+                continue;
+            case 'B':
+                if (tags + 5 > tags_end) {
+                    fprintf(stderr, "Error: BAM record has a truncated tag -- input may be corrupt\n");
+                    c2b_print_usage(stderr);
+                    exit(EINVAL); /* Invalid argument (POSIX.1) */
+                }
+                subtype = tags[0];
+                count = c2b_bam_le32(tags + 1);
+                tags += 5;
+                element_size = ((subtype == 'c') || (subtype == 'C')) ? 1 : (((subtype == 's') || (subtype == 'S')) ? 2 : 4);
+                if (((subtype != 'c') && (subtype != 'C') && (subtype != 's') && (subtype != 'S') && (subtype != 'i') && (subtype != 'I') && (subtype != 'f')) || ((size_t) (tags_end - tags) / element_size < count)) {
+                    fprintf(stderr, "Error: BAM record has a malformed array tag -- input may be corrupt\n");
+                    c2b_print_usage(stderr);
+                    exit(EINVAL); /* Invalid argument (POSIX.1) */
+                }
+                s[dest_length++] = (char) subtype;
+                for (idx = 0; idx < count; idx++, tags += element_size) {
+                    s = c2b_reserve_bam_field(dest, dest_length + C2B_MAX_OPERATION_FIELD_LENGTH_VALUE);
+                    element = (element_size == 1) ? tags[0] : ((element_size == 2) ? c2b_bam_le16(tags) : c2b_bam_le32(tags));
+                    switch (subtype) {
+                        case 'c': dest_length += sprintf(s + dest_length, ",%d", (int8_t) element); break;
+                        case 's': dest_length += sprintf(s + dest_length, ",%d", (int16_t) element); break;
+                        case 'i': dest_length += sprintf(s + dest_length, ",%d", (int32_t) element); break;
+                        case 'f': memcpy(&f, &element, sizeof(f)); dest_length += sprintf(s + dest_length, ",%g", f); break;
+                        default:  dest_length += sprintf(s + dest_length, ",%u", element); break;
+                    }
+                }
+                s[dest_length] = '\0';
+                continue;
+            default:
+                fprintf(stderr, "Error: BAM record has a tag of unknown type (%c) -- input may be corrupt\n", type);
+                c2b_print_usage(stderr);
+                exit(EINVAL); /* Invalid argument (POSIX.1) */
+        }
+        if (tags + element_size > tags_end) {
+            fprintf(stderr, "Error: BAM record has a truncated tag -- input may be corrupt\n");
+            c2b_print_usage(stderr);
+            exit(EINVAL); /* Invalid argument (POSIX.1) */
+        }
+        element = (element_size == 1) ? tags[0] : ((element_size == 2) ? c2b_bam_le16(tags) : c2b_bam_le32(tags));
+        switch (type) {
+            case 'A': dest_length += sprintf(s + dest_length, "%c", (char) element); break;
+            case 'c': dest_length += sprintf(s + dest_length, "%d", (int8_t) element); break;
+            case 's': dest_length += sprintf(s + dest_length, "%d", (int16_t) element); break;
+            case 'i': dest_length += sprintf(s + dest_length, "%d", (int32_t) element); break;
+            case 'f': memcpy(&f, &element, sizeof(f)); dest_length += sprintf(s + dest_length, "%g", f); break;
+            default:  dest_length += sprintf(s + dest_length, "%u", element); break;
+        }
+        tags += element_size;
+    }
+}
+
+static inline uint16_t
+c2b_bam_le16(const unsigned char *p)
+{
+    return (uint16_t) (p[0] | (p[1] << 8));
+}
+
+static inline uint32_t
+c2b_bam_le32(const unsigned char *p)
+{
+    return (uint32_t) p[0] | ((uint32_t) p[1] << 8) | ((uint32_t) p[2] << 16) | ((uint32_t) p[3] << 24);
+}
+
+static void
+c2b_field_overflow(const char *name)
+{
+    fprintf(stderr, "Error: %s field is longer than %d characters\n", name, C2B_MAX_FIELD_LENGTH_VALUE);
+    c2b_print_usage(stderr);
+    exit(EINVAL); /* Invalid argument (POSIX.1) */
+}
+
+
+static void
+c2b_line_convert_vcf_to_bed_unsorted(c2b_context_t *ctx, c2b_output_t *dest, char *src, ssize_t src_size)
+{
+    c2b_span_t vcf_fields[C2B_MAX_FIELD_COUNT_VALUE];
+    int vcf_field_idx = c2b_split_leading_fields(ctx, src, src_size, vcf_fields, 9);
+
+    /* 
+       If number of fields in not in bounds, we may need to exit early
+    */
+    
+    if ((vcf_field_idx + 1) < c2b_vcf_field_min) {
+        /* Legal header cases: line starts with "##" or "#" */
+        if ((vcf_field_idx == 0) && (src[0] == c2b_vcf_header_prefix)) { 
+            if (c2b_globals.keep_header_flag) { 
+                /* copy header line to destination stream buffer */
+                c2b_line_convert_header_to_bed(ctx, dest, src, src_size);
+                return;
+            }
+            else {
+                return;
+            }
+        }
+        else if (vcf_field_idx == 0) {
+            fprintf(stderr, "Error: Invalid field count (%d) -- input file may not match input format\n", vcf_field_idx);
+            c2b_print_usage(stderr);
+            exit(EINVAL); /* Invalid argument (POSIX.1) */
+        }
+    }
+
+    /* 0 - CHROM */
+    c2b_span_t chrom = vcf_fields[0];
+    boolean is_header = ((chrom.length > 0) && (chrom.s[0] == c2b_vcf_header_prefix)) ? kTrue : kFalse;
+    if ((is_header) && (c2b_globals.keep_header_flag)) {
+        c2b_line_convert_header_to_bed(ctx, dest, src, src_size);
+        return;
+    }
+    else if (is_header) {
+        return;
+    }
+
+    /* 1 - POS */
+    uint64_t pos_val = c2b_span_to_uint64(vcf_fields[1]);
+    uint64_t start_val = pos_val - 1;
+    uint64_t end_val = pos_val; /* note that this value may change below, depending on options */
+
+    c2b_vcf_t vcf;
+    vcf.chrom = chrom;
+    vcf.pos = pos_val;
+    vcf.start = start_val;
+    vcf.end = end_val;
+    vcf.id = vcf_fields[2];
+    vcf.ref = vcf_fields[3];
+    vcf.alt = vcf_fields[4];
+    vcf.qual = vcf_fields[5];
+    vcf.filter = vcf_fields[6];
+    vcf.info = vcf_fields[7];
+    vcf.format.s = NULL;
+    vcf.format.length = 0;
+    vcf.samples.s = NULL;
+    vcf.samples.length = 0;
+    if (vcf_field_idx >= 8) {
+        /* 8 - FORMAT */
+        vcf.format = vcf_fields[8];
+        /* 9 - Samples -- the remainder of the line, tabs included */
+        if (vcf_field_idx >= 9) {
+            vcf.samples.s = vcf_fields[9].s;
+            vcf.samples.length = vcf_fields[vcf_field_idx].s + vcf_fields[vcf_field_idx].length - vcf_fields[9].s;
+        }
+    }
+
+    c2b_span_t alt = vcf.alt;
+    char *alt_end = alt.s + alt.length;
+    char *allele_end = NULL;
+    if ((!c2b_globals.vcf->do_not_split) && (memchr(alt.s, c2b_vcf_alt_allele_delim, alt.length))) {
+        /* loop through each allele */
+        vcf.alt.s = alt.s;
+        do {
+            allele_end = memchr(vcf.alt.s, c2b_vcf_alt_allele_delim, alt_end - vcf.alt.s);
+            if (!allele_end) {
+                allele_end = alt_end;
+            }
+            vcf.alt.length = allele_end - vcf.alt.s;
+            if ((c2b_globals.vcf->filter_count == 1) && (!c2b_globals.vcf->only_insertions)) {
+                vcf.end = start_val + abs((int) (vcf.ref.length - vcf.alt.length)) + 1;
+            }
+            if ( (c2b_globals.vcf->filter_count == 0) ||
+                 ((c2b_globals.vcf->only_snvs) && (c2b_vcf_record_is_snv(vcf.ref, vcf.alt))) ||
+                 ((c2b_globals.vcf->only_insertions) && (c2b_vcf_record_is_insertion(vcf.ref, vcf.alt))) ||
+                 ((c2b_globals.vcf->only_deletions) && (c2b_vcf_record_is_deletion(vcf.ref, vcf.alt))) ) 
+                {
+                    c2b_line_convert_vcf_to_bed(vcf, dest);
+                }
+            else
+                ctx->counts.filtered_alleles++;
+            vcf.alt.s = allele_end + 1;
+        } while (vcf.alt.s <= alt_end);
+    }
+    else {
+        /* just print the one allele */
+        if ((c2b_globals.vcf->filter_count == 1) && (!c2b_globals.vcf->only_insertions)) {
+            vcf.end = start_val + abs((int) (vcf.ref.length - alt.length)) + 1;
+        }
+        if ( (c2b_globals.vcf->filter_count == 0) ||
+             ((c2b_globals.vcf->only_snvs) && (c2b_vcf_record_is_snv(vcf.ref, alt))) ||
+             ((c2b_globals.vcf->only_insertions) && (c2b_vcf_record_is_insertion(vcf.ref, alt))) ||
+             ((c2b_globals.vcf->only_deletions) && (c2b_vcf_record_is_deletion(vcf.ref, alt))) ) 
+            {
+                c2b_line_convert_vcf_to_bed(vcf, dest);
+            }
+        else
+            ctx->counts.filtered_alleles++;
+    }
+}
+
+static inline boolean
+c2b_vcf_allele_is_id(c2b_span_t s)
+{
+    return ((s.length > 0) && (s.s[0] == c2b_vcf_id_prefix) && (s.s[s.length - 1] == c2b_vcf_id_suffix)) ? kTrue : kFalse;
+}
+
+static inline boolean
+c2b_vcf_record_is_snv(c2b_span_t ref, c2b_span_t alt) 
+{
+    return ((!c2b_vcf_allele_is_id(alt)) && (((int) ref.length - (int) alt.length) == 0)) ? kTrue : kFalse;
+}
+
+static inline boolean
+c2b_vcf_record_is_insertion(c2b_span_t ref, c2b_span_t alt) 
+{
+    return ((!c2b_vcf_allele_is_id(alt)) && (((int) ref.length - (int) alt.length) < 0)) ? kTrue : kFalse;
+}
+
+static inline boolean
+c2b_vcf_record_is_deletion(c2b_span_t ref, c2b_span_t alt) 
+{
+    return ((!c2b_vcf_allele_is_id(alt)) && (((int) ref.length - (int) alt.length) > 0)) ? kTrue : kFalse;
+}
+
+static inline void
+c2b_line_convert_vcf_to_bed(c2b_vcf_t v, c2b_output_t *dest) 
+{
+    /* 
+       For VCF v4.2-formatted data, we use the mapping provided by BEDOPS convention described at:
+
+       http://bedops.readthedocs.org/en/latest/content/reference/file-management/conversion/vcf2bed.html
+
+       VCF field                 BED column index       BED field
+       -------------------------------------------------------------------------
+       CHROM                     1                      chromosome
+       POS - 1                   2                      start
+       POS (*)                   3                      stop
+       ID                        4                      id
+       QUAL                      5                      score
+
+      * : When using --deletions, the stop value of the BED output is determined by the length difference 
+          between ALT and REF alleles. Use of --insertions or --snvs yields a one-base BED element.
+
+       The remaining VCF columns are mapped as-is, in same order, to adjacent BED columns:
+
+       VCF field                 BED column index       BED field
+       -------------------------------------------------------------------------
+       REF                       6                      -
+       ALT                       7                      -
+       FILTER                    8                      -
+       INFO                      9                      -
+
+       If present in the VCF v4 input, the following columns are also mapped:
+
+       VCF field                 BED column index       BED field
+       -------------------------------------------------------------------------
+       FORMAT                    10                     -
+       Sample 1                  11                     -
+       Sample 2                  12                     -
+       ...
+    */
+
+    char *dest_posn = c2b_reserve_output(dest,
+                                         v.chrom.length + v.id.length + v.qual.length + v.ref.length + 
+                                         v.alt.length + v.filter.length + v.info.length + v.format.length + 
+                                         v.samples.length + 
+                                         9 + 2 * C2B_MAX_UINT64_FIELD_LENGTH_VALUE);
+
+    dest_posn = c2b_emit_span(dest_posn, v.chrom, c2b_tab_delim);
+    dest_posn = c2b_emit_uint64(dest_posn, v.start, c2b_tab_delim);
+    dest_posn = c2b_emit_uint64(dest_posn, v.end, c2b_tab_delim);
+    dest_posn = c2b_emit_span(dest_posn, v.id, c2b_tab_delim);
+    dest_posn = c2b_emit_span(dest_posn, v.qual, c2b_tab_delim);
+    dest_posn = c2b_emit_span(dest_posn, v.ref, c2b_tab_delim);
+    dest_posn = c2b_emit_span(dest_posn, v.alt, c2b_tab_delim);
+    dest_posn = c2b_emit_span(dest_posn, v.filter, c2b_tab_delim);
+    if (v.format.length > 0) {
+        dest_posn = c2b_emit_span(dest_posn, v.info, c2b_tab_delim);
+        dest_posn = c2b_emit_span(dest_posn, v.format, c2b_tab_delim);
+        dest_posn = c2b_emit_span(dest_posn, v.samples, c2b_line_delim);
+    }
+    else {
+        dest_posn = c2b_emit_span(dest_posn, v.info, c2b_line_delim);
+    }
+
+    dest->size = dest_posn - dest->buf;
+}
+
+static void
+c2b_line_convert_wig_to_bed_unsorted(c2b_context_t *ctx, c2b_output_t *dest, char *src, ssize_t src_size)
+{
+    char src_line_buffer[C2B_MAX_LINE_LENGTH_VALUE];
+    char *src_line_str = src_line_buffer;
+    ssize_t dest_line_capacity = src_size + C2B_MAX_LINE_LENGTH_VALUE;
+    int dest_line_size = 0;
+
+    /* 
+       Initialize and increment parameters
+    */
+
+    ctx->wig.line++;
+
+    /* 
+       Step headers and data lines are scanned from a string copy of the line, which 
+       is made on the heap if the line is too long for the stack. Converted lines are 
+       printed into the output buffer, with room for the line and its ID and coordinates.
+    */
+
+    if (src_size >= C2B_MAX_LINE_LENGTH_VALUE) {
+        src_line_str = malloc(src_size + 1);
+        if (!src_line_str) {
+            fprintf(stderr, "Error: Could not allocate space for WIG line %u\n", ctx->wig.line);
+            c2b_print_usage(stderr);
+            exit(ENOMEM); /* Not enough space (POSIX.1) */
+        }
+    }
+    if (c2b_globals.wig->basename) {
+        sprintf(ctx->wig.id,
+                "%s.%u",
+                c2b_globals.wig->basename,
+                ctx->wig.section);
+    }
+
+    /* 
+       Legal header cases: line starts with '#' 
+    */
+    
+    if (src[0] == c2b_wig_header_prefix) { 
+        if (ctx->wig.start_write) {
+            ctx->wig.start_write = kFalse;
+            sprintf(ctx->wig.id, 
+                    "%s.%u",
+                    c2b_globals.wig->basename, 
+                    ++ctx->wig.section);
+        }
+        if (c2b_globals.keep_header_flag) { 
+            /* copy header line to destination stream buffer */
+            if (!c2b_globals.wig->basename) {
+                dest_line_size = sprintf(c2b_reserve_output(dest, dest_line_capacity), 
+                                         "%s\t%u\t%u\t%.*s\n", 
+                                         c2b_header_chr_name, 
+                                         ctx->header_line_idx, 
+                                         ctx->header_line_idx + 1, 
+                                         (int) src_size,
+                                         src);
+            }
+            else {
+                dest_line_size = sprintf(c2b_reserve_output(dest, dest_line_capacity), 
+                                         "%s\t%u\t%u\t%s\t%.*s\n", 
+                                         c2b_header_chr_name, 
+                                         ctx->header_line_idx, 
+                                         ctx->header_line_idx + 1, 
+                                         ctx->wig.id,
+                                         (int) src_size,
+                                         src);
+            }
+            dest->size += dest_line_size;
+            ctx->header_line_idx++;
+        }
+    }
+    else if ((strncmp(src, c2b_wig_track_prefix, strlen(c2b_wig_track_prefix)) == 0) || 
+             (strncmp(src, c2b_wig_browser_prefix, strlen(c2b_wig_browser_prefix)) == 0)) {
+        if (ctx->wig.start_write) {
+            ctx->wig.start_write = kFalse;
+            sprintf(ctx->wig.id,
+                    "%s.%u",
+                    c2b_globals.wig->basename,
+                    ++ctx->wig.section);
+        }
+        if (c2b_globals.keep_header_flag) { 
+            /* copy header line to destination stream buffer */
+            if (!c2b_globals.wig->basename) {
+                dest_line_size = sprintf(c2b_reserve_output(dest, dest_line_capacity), 
+                                         "%s\t%u\t%u\t%.*s\n", 
+                                         c2b_header_chr_name, 
+                                         ctx->header_line_idx, 
+                                         ctx->header_line_idx + 1, 
+                                         (int) src_size,
+                                         src);
+            }
+            else {
+                dest_line_size = sprintf(c2b_reserve_output(dest, dest_line_capacity), 
+                                         "%s\t%u\t%u\t%s\t%.*s\n", 
+                                         c2b_header_chr_name, 
+                                         ctx->header_line_idx, 
+                                         ctx->header_line_idx + 1, 
+                                         ctx->wig.id,
+                                         (int) src_size,
+                                         src);
+            }
+            dest->size += dest_line_size;
+            ctx->header_line_idx++;
+        }
+    }
+    else if (strncmp(src, c2b_wig_variable_step_prefix, strlen(c2b_wig_variable_step_prefix)) == 0) {
+        memcpy(src_line_str, src, src_size);
+        src_line_str[src_size] = '\0';
+        int variable_step_fields = sscanf(src_line_str, 
+                                          "variableStep chrom=%s span=%" SCNu64 "\n", 
+                                          ctx->wig.chr, 
+                                          &(ctx->wig.span));
+        if (variable_step_fields < 1) {
+            fprintf(stderr, "Error: Invalid variableStep header on line %u\n", ctx->wig.line);
+            exit(EINVAL); /* Invalid argument (POSIX.1) */
+        }
+        if (variable_step_fields == 1)
+            ctx->wig.span = 1;
+        ctx->wig.is_fixed_step = kFalse;
+        if (ctx->wig.start_write) {
+            ctx->wig.start_write = kFalse;
+            sprintf(ctx->wig.id,
+                    "%s.%u",
+                    c2b_globals.wig->basename,
+                    ++ctx->wig.section);
+        }
+        if (c2b_globals.keep_header_flag) { 
+            /* copy header line to destination stream buffer */
+            if (!c2b_globals.wig->basename) {
+                dest_line_size = sprintf(c2b_reserve_output(dest, dest_line_capacity), 
+                                         "%s\t%u\t%u\t%s\n", 
+                                         c2b_header_chr_name, 
+                                         ctx->header_line_idx, 
+                                         ctx->header_line_idx + 1, 
+                                         src_line_str);
+            }
+            else {
+                dest_line_size = sprintf(c2b_reserve_output(dest, dest_line_capacity), 
+                                         "%s\t%u\t%u\t%s\t%s\n", 
+                                         c2b_header_chr_name, 
+                                         ctx->header_line_idx, 
+                                         ctx->header_line_idx + 1, 
+                                         ctx->wig.id,
+                                         src_line_str);
+            }
+            dest->size += dest_line_size;
+            ctx->header_line_idx++;
+        }
+    }
+    else if (strncmp(src, c2b_wig_fixed_step_prefix, strlen(c2b_wig_fixed_step_prefix)) == 0) {
+        memcpy(src_line_str, src, src_size);
+        src_line_str[src_size] = '\0';
+        int fixed_step_fields = sscanf(src_line_str, 
+                                       "fixedStep chrom=%s start=%" SCNu64 " step=%" SCNu64 " span=%" SCNu64 "\n", 
+                                       ctx->wig.chr, 
+                                       &(ctx->wig.start_pos), 
+                                       &(ctx->wig.step), 
+                                       &(ctx->wig.span));
+        if (fixed_step_fields < 3) {
+            fprintf(stderr, "Error: Invalid fixedStep header on line %u\n", ctx->wig.line);
+            exit(EINVAL); /* Invalid argument (POSIX.1) */
+        }
+        if (fixed_step_fields == 3) {
+            ctx->wig.span = 1;
+        }
+        ctx->wig.is_fixed_step = kTrue;
+        if (c2b_globals.keep_header_flag) { 
+            /* copy header line to destination stream buffer */
+            if (!c2b_globals.wig->basename) {
+                dest_line_size = sprintf(c2b_reserve_output(dest, dest_line_capacity), 
+                                         "%s\t%u\t%u\t%s\n", 
+                                         c2b_header_chr_name, 
+                                         ctx->header_line_idx, 
+                                         ctx->header_line_idx + 1, 
+                                         src_line_str);
+            }
+            else {
+                dest_line_size = sprintf(c2b_reserve_output(dest, dest_line_capacity), 
+                                         "%s\t%u\t%u\t%s\t%s\n", 
+                                         c2b_header_chr_name, 
+                                         ctx->header_line_idx, 
+                                         ctx->header_line_idx + 1, 
+                                         ctx->wig.id,
+                                         src_line_str);
+            }
+            dest->size += dest_line_size;
+            ctx->header_line_idx++;
+        }
+    }
+    else if (strncmp(src, c2b_wig_chr_prefix, strlen(c2b_wig_chr_prefix)) == 0) {
+        memcpy(src_line_str, src, src_size);
+        src_line_str[src_size] = '\0';
+        int bed_fields = sscanf(src_line_str, 
+                                "%s\t%" SCNu64 "\t%" SCNu64 "\t%lf\n", 
+                                ctx->wig.chr,
+                                &(ctx->wig.start_pos), 
+                                &(ctx->wig.end_pos), 
+                                &(ctx->wig.score));
+        if (bed_fields != 4) {
+            fprintf(stderr, "Error: Invalid WIG line %u\n", ctx->wig.line);
+            exit(EINVAL); /* Invalid argument (POSIX.1) */
+        }
+        ctx->wig.pos_lines++;
+        if ((ctx->wig.start_pos == 0) && (!c2b_globals.zero_indexed_flag)) {
+            fprintf(stderr, "Error: WIG data contains 0-indexed element at line %u\n", ctx->wig.line);
+            fprintf(stderr, "       Consider adding --zero-indexed (-x) option to convert zero-indexed WIG data\n");
+            exit(EINVAL); /* Invalid argument (POSIX.1) */
+        }
+        if (!c2b_globals.wig->basename) {
+            dest_line_size = sprintf(c2b_reserve_output(dest, dest_line_capacity),
+                                     "%s\t"                      \
+                                     "%" PRIu64 "\t"             \
+                                     "%" PRIu64 "\t"             \
+                                     "id-%d\t"                   \
+                                     "%lf\n",
+                                     ctx->wig.chr,
+                                     ctx->wig.start_pos - c2b_globals.wig->start_shift,
+                                     ctx->wig.end_pos - c2b_globals.wig->end_shift,
+                                     ctx->wig.pos_lines,
+                                     ctx->wig.score);
+        }
+        else {
+            dest_line_size = sprintf(c2b_reserve_output(dest, dest_line_capacity),
+                                     "%s\t"                      \
+                                     "%" PRIu64 "\t"             \
+                                     "%" PRIu64 "\t"             \
+                                     "%s-%d\t"                   \
+                                     "%lf\n",
+                                     ctx->wig.chr,
+                                     ctx->wig.start_pos - c2b_globals.wig->start_shift,
+                                     ctx->wig.end_pos - c2b_globals.wig->end_shift,
+                                     ctx->wig.id,
+                                     ctx->wig.pos_lines,
+                                     ctx->wig.score);
+        }
+        ctx->wig.start_write = kTrue;
+        dest->size += dest_line_size;
+    }
+    else {
+        memcpy(src_line_str, src, src_size);
+        src_line_str[src_size] = '\0';
+
+        if (ctx->wig.is_fixed_step) {
+
+            int fixed_step_column_fields = sscanf(src_line_str, "%lf\n", &(ctx->wig.score));
+            if (fixed_step_column_fields != 1) {
+                fprintf(stderr, "Error: Invalid WIG line %u\n", ctx->wig.line);
+                exit(EINVAL); /* Invalid argument (POSIX.1) */
+            }
+            ctx->wig.pos_lines++;
+            if ((ctx->wig.start_pos == 0) && (!c2b_globals.zero_indexed_flag)) {
+                fprintf(stderr, "Error: WIG data contains 0-indexed element at line %u\n", ctx->wig.line);
+                fprintf(stderr, "       Consider adding --zero-indexed (-x) option to convert zero-indexed WIG data\n");
+                exit(EINVAL); /* Invalid argument (POSIX.1) */
+            }
+            if (!c2b_globals.wig->basename) {
+                dest_line_size = sprintf(c2b_reserve_output(dest, dest_line_capacity),
+                                         "%s\t"                  \
+                                         "%" PRIu64 "\t"         \
+                                         "%" PRIu64 "\t"         \
+                                         "id-%d\t"               \
+                                         "%lf\n",
+                                         ctx->wig.chr,
+                                         ctx->wig.start_pos - c2b_globals.wig->start_shift,
+                                         ctx->wig.start_pos + ctx->wig.span - c2b_globals.wig->end_shift,
+                                         ctx->wig.pos_lines,
+                                         ctx->wig.score);
+            }
+            else {
+                dest_line_size = sprintf(c2b_reserve_output(dest, dest_line_capacity),
+                                         "%s\t"                  \
+                                         "%" PRIu64 "\t"         \
+                                         "%" PRIu64 "\t"         \
+                                         "%s-%d\t"               \
+                                         "%lf\n",
+                                         ctx->wig.chr,
+                                         ctx->wig.start_pos - c2b_globals.wig->start_shift,
+                                         ctx->wig.start_pos + ctx->wig.span - c2b_globals.wig->end_shift,
+                                         ctx->wig.id,
+                                         ctx->wig.pos_lines,
+                                         ctx->wig.score);
+            }            
+            ctx->wig.start_pos += ctx->wig.step;
+            ctx->wig.start_write = kTrue;
+            dest->size += dest_line_size;
+        }
+        else {
+            int variable_step_column_fields = sscanf(src_line_str, 
+                                                     "%" SCNu64 "\t%lf\n", 
+                                                     &(ctx->wig.start_pos), 
+                                                     &(ctx->wig.score));
+            if (variable_step_column_fields != 2) {
+                fprintf(stderr, "Error: Invalid WIG line %u\n", ctx->wig.line);
+                exit(EINVAL); /* Invalid argument (POSIX.1) */
+            }
+            ctx->wig.pos_lines++;
+            if ((ctx->wig.start_pos == 0) && (!c2b_globals.zero_indexed_flag)) {
+                fprintf(stderr, "Error: WIG data contains 0-indexed element at line %u\n", ctx->wig.line);
+                fprintf(stderr, "       Consider adding --zero-indexed (-x) option to convert zero-indexed WIG data\n");
+                exit(EINVAL); /* Invalid argument (POSIX.1) */
+            }
+            if (!c2b_globals.wig->basename) {
+                dest_line_size = sprintf(c2b_reserve_output(dest, dest_line_capacity),
+                                         "%s\t"                  \
+                                         "%" PRIu64 "\t"         \
+                                         "%" PRIu64 "\t"         \
+                                         "id-%d\t"               \
+                                         "%lf\n",
+                                         ctx->wig.chr,
+                                         ctx->wig.start_pos - c2b_globals.wig->start_shift,
+                                         ctx->wig.start_pos + ctx->wig.span - c2b_globals.wig->end_shift,
+                                         ctx->wig.pos_lines,
+                                         ctx->wig.score);
+            }
+            else {
+                dest_line_size = sprintf(c2b_reserve_output(dest, dest_line_capacity),
+                                         "%s\t"                  \
+                                         "%" PRIu64 "\t"         \
+                                         "%" PRIu64 "\t"         \
+                                         "%s-%d\t"               \
+                                         "%lf\n",
+                                         ctx->wig.chr,
+                                         ctx->wig.start_pos - c2b_globals.wig->start_shift,
+                                         ctx->wig.start_pos + ctx->wig.span - c2b_globals.wig->end_shift,
+                                         ctx->wig.id,
+                                         ctx->wig.pos_lines,
+                                         ctx->wig.score);
+            }            
+            ctx->wig.start_pos += ctx->wig.step;
+            ctx->wig.start_write = kTrue;
+            dest->size += dest_line_size;
+        }
+    }
+
+    if (src_line_str != src_line_buffer)
+        free(src_line_str);
+}
+
+static void *
+c2b_process_intermediate_bytes_by_lines(void *arg)
+{
+    c2b_pipeline_stage_t *stage = (c2b_pipeline_stage_t *) arg;
+    c2b_pipeset_t *pipes = stage->pipeset;
+    char *src_buffer = NULL;
+    ssize_t src_buffer_size = C2B_MAX_LINE_LENGTH_VALUE;
+    ssize_t grown_buffer_size = 0;
+    ssize_t src_bytes_read = 0;
+    ssize_t remainder_length = 0;
+    ssize_t remainder_offset = 0;
+    ssize_t start_offset = 0;
+    ssize_t end_offset = 0;
+    c2b_output_t output;
+    void (*line_functor)(c2b_context_t *, c2b_output_t *, char *, ssize_t) = stage->line_functor;
+    c2b_context_t context;
+    c2b_delim_index_t delims;
+    c2b_sorter_t sorter;
+    c2b_sorter_t *dest_sorter = NULL;
+    c2b_starch_writer_t starch_writer;
+    int src_fd = (stage->src == (unsigned int) -1) ? STDIN_FILENO : pipes->out[stage->src][PIPE_READ];
+    int dest_fd = (stage->dest == (unsigned int) -1) ? STDOUT_FILENO : pipes->in[stage->dest][PIPE_WRITE];
+    int exit_status = 0;
+    double stage_wall_start = c2b_seconds();
+    double stage_cpu_start = c2b_process_cpu_seconds();
+
+#ifdef DEBUG
+    fprintf(stderr, "\t-> c2b_process_intermediate_bytes_by_lines | reading from fd  (%02d) | writing to fd  (%02d)\n", src_fd, dest_fd);
+#endif
+
+    /* 
+       We read from the src out pipe (or directly from stdin, for text formats), 
+       then write to the dest in pipe 
+    */
+    
+    src_buffer = c2b_resize_line_buffer(NULL, 0, src_buffer_size);
+
+    c2b_init_context(&context);
+    c2b_init_delim_index(&delims);
+
+    /* when sorting in process, converted lines go to the sorter rather than downstream */
+
+    if (c2b_globals.sort->is_enabled) {
+        c2b_init_sorter(&sorter);
+        dest_sorter = &sorter;
+        if (c2b_globals.output_format_idx == STARCH_FORMAT) {
+            c2b_init_starch_writer(&starch_writer, dest_fd);
+            dest_sorter->starch = &starch_writer;
+            /* what the writer takes comes out of the sorter's budget, before runs are spilled or merged */
+            dest_sorter->max_memory = (dest_sorter->max_memory > starch_writer.memory) ? (dest_sorter->max_memory - starch_writer.memory) : 0;
+        }
+    }
+    c2b_init_output(&output, dest_fd, dest_sorter);
+
+    /*
+       BAM input is made of binary records, which are decoded by their own reader.
+       With more than one thread, conversion is handed off to a pool of chunk workers,
+       except with --fragments or --coverage, as the mates of a pair, or the elements
+       that make up a run, may fall in different chunks.
+       Otherwise, if stdin is a regular file, we map it and hand out lines in place. 
+       Failing both, we fall through to the read() loop below.
+    */
+
+    if (c2b_globals.input_format_idx == BAM_FORMAT) {
+        c2b_process_bam_records(stage, src_fd, &output, &context);
+    }
+    else if ((c2b_globals.threads > 1) && (!c2b_globals.fragments->is_enabled) && (!c2b_globals.coverage->is_enabled)) {
+        c2b_process_intermediate_bytes_by_chunks(stage, src_fd, dest_fd, dest_sorter);
+    }
+    else if ((stage->src == (unsigned int) -1) && (c2b_process_mapped_bytes_by_lines(stage, src_fd, &output, &context))) {
+        src_bytes_read = 0;
+    }
+    else while ((src_bytes_read = c2b_timed_read(&c2b_globals.pipe->convert_stats,
+                                                src_fd,
+                                  src_buffer + remainder_length,
+                                  src_buffer_size - remainder_length)) > 0) {
+
+        /* 
+           So here's what src_buffer looks like initially; basically, some stuff separated by
+           newlines. The src_buffer will probably not terminate with a newline. So we first 
+           build the delimiter index over the buffer, and take the last newline bit in it to
+           find the remainder_offset index value:
+           
+           src_buffer  [  .  .  .  \n  .  .  .  \n  .  .  .  \n  .  .  .  .  .  .  ]
+           index        0 1 2 ...                            ^                    ^
+                                                             |                    |
+                                                             |   src_bytes_read --
+                                                             | 
+                                         remainder_offset --- 
+
+           In other words, everything at and after index [remainder_offset + 1] to index
+           [src_bytes_read - 1] is a remainder byte ("R"):
+
+           src_buffer  [  .  .  .  \n  .  .  .  \n  .  .  .  \n R R R R R ]
+           
+           Assuming this failed:
+
+           If remainder_offset is -1 and we have read src_buffer_size bytes, then we know there 
+           are no newlines anywhere in the src_buffer, which therefore holds the start of a line 
+           longer than src_buffer_size. We double src_buffer_size (see c2b_grow_line_capacity(), 
+           which rejects lines longer than --max-line-length) and read the rest of the line into
+           the grown buffer, converting nothing this time around.
+           
+           Asumming this worked:
+           
+           We can now parse byte indices {[0 .. remainder_offset]} into lines, which are fed one
+           by one to the line_functor. This functor parses out tab offsets and writes out a 
+           reordered string based on the rules for the format (see BEDOPS docs for reordering 
+           table).
+           
+           Finally, we write bytes from index [remainder_offset + 1] to [src_bytes_read - 1] 
+           back to src_buffer. We are writing remainder_length bytes:
+           
+           new_remainder_length = current_src_bytes_read + old_remainder_length - new_remainder_offset
+           
+           Note that we can leave the rest of the buffer untouched:
+           
+           src_buffer  [ R R R R R \n  .  .  .  \n  .  .  .  \n  .  .  .  ]
+           
+           On the subsequent read, we want to read() into src_buffer at position remainder_length
+           and read up to, at most, (src_buffer_size - remainder_length) bytes:
+           
+           read(byte_source, 
+                src_buffer + remainder_length,
+                src_buffer_size - remainder_length)
+
+           Second and subsequent reads should reduce the maximum number of src_bytes_read from 
+           src_buffer_size to something smaller.
+        */
+
+        c2b_index_delims(&delims, src_buffer, src_bytes_read + remainder_length);
+        context.delims = &delims;
+
+        remainder_offset = c2b_last_delim(delims.line_bits, src_bytes_read + remainder_length);
+        if (remainder_offset != -1)
+            remainder_offset++;
+
+        if (remainder_offset == -1) {
+            if (src_bytes_read + remainder_length == src_buffer_size) {
+                grown_buffer_size = c2b_grow_line_capacity(src_buffer_size);
+                src_buffer = c2b_resize_line_buffer(src_buffer, src_buffer_size, grown_buffer_size);
+                src_buffer_size = grown_buffer_size;
+            }
+            remainder_offset = 0;
+        }
+
+        /* 
+           We next want to process bytes from index [0] to index [remainder_offset - 1] for all
+           lines contained within. We basically build a buffer containing all translated 
+           lines to write downstream.
+        */
+
+        start_offset = 0;
+        while ((end_offset = c2b_next_delim(delims.line_bits, start_offset, remainder_offset)) != -1) {
+            /* for a given line from src, the functor appends its translated bytes to output */
+            (*line_functor)(&context, &output, src_buffer + start_offset, end_offset - start_offset);
+            context.counts.lines++;
+            start_offset = end_offset + 1;
+        }
+        
+        /* 
+           Once output holds at least its watermark of translated bytes, we write() it to 
+           the in-pipe of the destination stage (or hand it to the sorter)
+        */
+        
+        if (output.size >= output.watermark)
+            c2b_flush_output(&output);
+
+        remainder_length = src_bytes_read + remainder_length - remainder_offset;
+        memmove(src_buffer, src_buffer + remainder_offset, remainder_length);
+    }
+
+    c2b_finish_fragments(&context, &output);
+    c2b_finish_coverage(&context, &output);
+    c2b_flush_output(&output);
+    c2b_delete_output(&output);
+
+    c2b_add_record_counts(&context.counts);
+    c2b_globals.stats->convert.wall_seconds = c2b_seconds() - stage_wall_start;
+    c2b_globals.stats->convert.cpu_seconds = c2b_process_cpu_seconds() - stage_cpu_start;
+
+    if (dest_sorter) {
+        stage_wall_start = c2b_seconds();
+        stage_cpu_start = c2b_process_cpu_seconds();
+        c2b_sort_records(dest_sorter);
+        c2b_write_sorted_records(dest_sorter, dest_fd);
+        if (dest_sorter->starch) {
+            c2b_finish_starch_writer(dest_sorter->starch);
+            c2b_delete_starch_writer(dest_sorter->starch);
+        }
+        c2b_globals.stats->sorted_records = (uint64_t) dest_sorter->total_records;
+        c2b_globals.stats->sort.wall_seconds = c2b_seconds() - stage_wall_start;
+        c2b_globals.stats->sort.cpu_seconds = c2b_process_cpu_seconds() - stage_cpu_start;
+        c2b_delete_sorter(dest_sorter);
+    }
+
+    if (dest_fd != STDOUT_FILENO)
+        close(dest_fd);
+
+    if (src_buffer) 
+        free(src_buffer), src_buffer = NULL;
+
+    c2b_delete_delim_index(&delims);
+
+    /* there is no upstream child process to reap when reading stdin directly */
+    if ((stage->pid > 0) && (WIFEXITED(stage->status) || WIFSIGNALED(stage->status))) {
+        waitpid(stage->pid, &stage->status, WUNTRACED);
+        exit_status = WEXITSTATUS(stage->status);
+        if (exit_status != 0) 
+            fprintf(stderr, 
+                    "Error: Stage [%s] failed -- exit status [%d | %d]\n", 
+                    stage->description,
+                    stage->status, 
+                    exit_status);
+    }
+
+    pthread_exit(NULL);
+}
+
+static boolean
+c2b_process_mapped_bytes_by_lines(c2b_pipeline_stage_t *stage, int src_fd, c2b_output_t *dest, c2b_context_t *ctx)
+{
+    char *map = NULL;
+    size_t map_size = 0;
+    char *line_start = NULL;
+    char *map_end = NULL;
+    ssize_t window_limit = C2B_MAX_LINE_LENGTH_VALUE;
+    ssize_t window_size = 0;
+    ssize_t window_offset = 0;
+    ssize_t line_end_offset = 0;
+    c2b_delim_index_t delims;
+    void (*line_functor)(c2b_context_t *, c2b_output_t *, char *, ssize_t) = stage->line_functor;
+
+    if (!c2b_map_input(src_fd, &map, &map_size, &line_start))
+        return kFalse;
+
+    /* 
+       Lines are passed to the functor as spans of the mapping, with no copy into 
+       an intermediate source buffer. As with the read() path, only newline-terminated
+       lines are converted. 
+
+       The mapping is indexed one window of up to window_limit bytes at a time, starting 
+       at the first unconverted line. Translated lines are flushed downstream after a window 
+       once dest holds at least its watermark. A full window without a newline holds the 
+       start of a line longer than window_limit, so the limit is doubled and the window 
+       indexed again, up to --max-line-length.
+    */
+
+    c2b_init_delim_index(&delims);
+    ctx->delims = &delims;
+
+    map_end = map + map_size;
+    while (line_start < map_end) {
+        window_size = ((map_end - line_start) < window_limit) ? (map_end - line_start) : window_limit;
+        c2b_index_delims(&delims, line_start, window_size);
+        window_offset = 0;
+        while ((line_end_offset = c2b_next_delim(delims.line_bits, window_offset, window_size)) != -1) {
+            (*line_functor)(ctx, dest, line_start + window_offset, line_end_offset - window_offset);
+            ctx->counts.lines++;
+            window_offset = line_end_offset + 1;
+        }
+        if (window_offset == 0) {
+            if (window_size == window_limit) {
+                window_limit = c2b_grow_line_capacity(window_limit);
+                continue;
+            }
+            break;
+        }
+        line_start += window_offset;
+        if (dest->size >= dest->watermark)
+            c2b_flush_output(dest);
+    }
+
+    ctx->delims = NULL;
+    c2b_delete_delim_index(&delims);
+
+    munmap(map, map_size);
+
+    return kTrue;
+}
+
+static inline void
+c2b_write_converted_bytes(int dest_fd, c2b_sorter_t *sorter, char *buffer, ssize_t size)
+{
+    char *line_end = buffer;
+    char *buffer_end = buffer + size;
+
+    /* converted bytes leave the convert stage from one thread at a time, so no lock is taken */
+
+    if (c2b_globals.stats->is_enabled) {
+        c2b_globals.stats->bytes_out += (uint64_t) size;
+        while ((line_end = memchr(line_end, c2b_line_delim, buffer_end - line_end)) != NULL) {
+            c2b_globals.stats->lines_out++;
+            line_end++;
+        }
+    }
+
+    if (sorter) {
+        c2b_add_sort_records(sorter, buffer, size);
+        return;
+    }
+
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wunused-result"
+    c2b_timed_write(&c2b_globals.pipe->convert_stats, dest_fd, buffer, size);
+#pragma GCC diagnostic pop
+}
+
+static boolean
+c2b_map_input(int fd, char **map, size_t *map_size, char **start)
+{
+    struct stat fd_stats;
+    off_t fd_offset = 0;
+    off_t map_offset = 0;
+    long page_size = sysconf(_SC_PAGESIZE);
+
+    /* 
+       We map from the current offset of fd, so that input which has been 
+       partially consumed before convert2bed was started is handled as with read()
+    */
+
+    if ((fstat(fd, &fd_stats) == -1) || (!S_ISREG(fd_stats.st_mode)) || (page_size <= 0))
+        return kFalse;
+    if (((fd_offset = lseek(fd, 0, SEEK_CUR)) == -1) || (fd_offset >= fd_stats.st_size))
+        return kFalse;
+
+    map_offset = fd_offset - (fd_offset % page_size);
+    *map_size = (size_t) (fd_stats.st_size - map_offset);
+    *map = mmap(NULL, *map_size, PROT_READ, MAP_PRIVATE, fd, map_offset);
+    if (*map == MAP_FAILED) {
+        *map = NULL;
+        return kFalse;
+    }
+    posix_madvise(*map, *map_size, POSIX_MADV_SEQUENTIAL);
+    *start = *map + (fd_offset - map_offset);
+
+    /* mapped input is not waited on, but is counted as read */
+    c2b_globals.pipe->convert_stats.bytes_read += (uint64_t) (fd_stats.st_size - fd_offset);
+
+#ifdef DEBUG
+    fprintf(stderr, "\t-> c2b_map_input | mapped fd (%02d) | [%zu] bytes from offset [%lld]\n", fd, *map_size, (long long) map_offset);
+#endif
+
+    return kTrue;
+}
+
+static void
+c2b_process_bam_records(c2b_pipeline_stage_t *stage, int src_fd, c2b_output_t *dest, c2b_context_t *ctx)
+{
+    c2b_bgzf_t bgzf;
+    char *record = NULL;
+    size_t record_capacity = 0;
+    size_t record_length = 0;
+    uint64_t header_end = 0;
+    int32_t n;
+    void (*line_functor)(c2b_context_t *, c2b_output_t *, char *, ssize_t) = stage->line_functor;
+
+#ifdef DEBUG
+    fprintf(stderr, "\t-> c2b_process_bam_records | reading from fd  (%02d) | writing to fd  (%02d)\n", src_fd, dest->fd);
+#endif
+
+    /* 
+       Each record is read whole into a buffer of its own and handed to the functor. 
+       Translated records are flushed downstream once dest holds at least its watermark.
+    */
+
+    c2b_init_bgzf(&bgzf, src_fd);
+    if ((c2b_globals.threads > 1) && (!c2b_globals.bam->index_path))
+        c2b_init_bgzf_ring(&bgzf, c2b_globals.threads);
+    c2b_read_bam_header(&bgzf, ctx, dest);
+
+    /* with an index, records are read region by region, and the header is all we take from here */
+
+    if (c2b_globals.bam->index_path) {
+        c2b_check_bgzf_eof_marker(src_fd);
+        c2b_flush_output(dest);
+        if (!c2b_tell_bgzf(&bgzf, &header_end))
+            header_end = (uint64_t) bgzf.offset << 16;
+        c2b_process_bam_regions(stage, src_fd, ctx, header_end, dest->fd, dest->sorter);
+    }
+    else while (c2b_read_bam_record(&bgzf, &record, &record_capacity, &record_length)) {
+        (*line_functor)(ctx, dest, record, (ssize_t) record_length);
+        ctx->counts.lines++;
+        if (dest->size >= dest->watermark)
+            c2b_flush_output(dest);
+    }
+    c2b_flush_output(dest);
+
+    for (n = 0; n < ctx->bam.num_refs; n++) {
+        free(ctx->bam.ref_names[n]), ctx->bam.ref_names[n] = NULL;
+    }
+    if (ctx->bam.ref_names)
+        free(ctx->bam.ref_names), ctx->bam.ref_names = NULL;
+    ctx->bam.num_refs = 0;
+    if (record)
+        free(record), record = NULL;
+    c2b_delete_bgzf(&bgzf);
+}
+
+static boolean
+c2b_read_bam_record(c2b_bgzf_t *b, char **record, size_t *record_capacity, size_t *record_length)
+{
+    unsigned char length_bytes[4];
+
+    /* reads one record, less its length field, into a buffer that grows as needed */
+
+    if (!c2b_read_bgzf(b, length_bytes, sizeof(length_bytes)))
+        return kFalse;
+    *record_length = c2b_bam_le32(length_bytes);
+    if (*record_length > *record_capacity) {
+        *record_capacity = (*record_length > 2 * *record_capacity) ? *record_length : 2 * *record_capacity;
+        free(*record);
+        *record = malloc(*record_capacity);
+        if (!*record) {
+            fprintf(stderr, "Error: Could not allocate space for BAM record\n");
+            c2b_print_usage(stderr);
+            exit(ENOMEM); /* Not enough space (POSIX.1) */
+        }
+    }
+    if (!c2b_read_bgzf(b, *record, *record_length)) {
+        fprintf(stderr, "Error: BAM input ends within a record -- input may be truncated\n");
+        c2b_print_usage(stderr);
+        exit(EINVAL); /* Invalid argument (POSIX.1) */
+    }
+    return kTrue;
+}
+
+static void
+c2b_read_bam_header(c2b_bgzf_t *b, c2b_context_t *ctx, c2b_output_t *dest)
+{
+    unsigned char magic[4];
+    unsigned char length_bytes[4];
+    char *text = NULL;
+    char *line = NULL;
+    char *line_end = NULL;
+    char *text_end = NULL;
+    char sq_line[C2B_MAX_LINE_LENGTH_VALUE];
+    uint32_t text_length = 0;
+    uint32_t name_length = 0;
+    int32_t n;
+
+    if ((!c2b_read_bgzf(b, magic, sizeof(magic))) || (memcmp(magic, c2b_bam_magic, sizeof(magic)) != 0)) {
+        fprintf(stderr, "Error: Input does not start with the BAM magic string -- check input format\n");
+        c2b_print_usage(stderr);
+        exit(EINVAL); /* Invalid argument (POSIX.1) */
+    }
+
+    /* header text, which is passed through, line by line, when --keep-header is set */
+
+    if (!c2b_read_bgzf(b, length_bytes, sizeof(length_bytes)))
+        goto truncated;
+    text_length = c2b_bam_le32(length_bytes);
+    text = malloc((size_t) text_length + 1);
+    if (!text) {
+        fprintf(stderr, "Error: Could not allocate space for BAM header text\n");
+        c2b_print_usage(stderr);
+        exit(ENOMEM); /* Not enough space (POSIX.1) */
+    }
+    if ((text_length > 0) && (!c2b_read_bgzf(b, text, text_length)))
+        goto truncated;
+    text[text_length] = '\0';
+    text_end = text + strlen(text);
+
+    if (c2b_globals.keep_header_flag) {
+        for (line = text; line < text_end; line = line_end + 1) {
+            line_end = memchr(line, '\n', (size_t) (text_end - line));
+            if (!line_end)
+                line_end = text_end;
+            if ((line_end - line) >= C2B_MAX_LINE_LENGTH_VALUE) {
+                fprintf(stderr, "Error: BAM header line is longer than %d characters\n", C2B_MAX_LINE_LENGTH_VALUE);
+                c2b_print_usage(stderr);
+                exit(EINVAL); /* Invalid argument (POSIX.1) */
+            }
+            if (line_end > line)
+                c2b_line_convert_sam_to_bed_unsorted_without_split_operation(ctx, dest, line, line_end - line);
+        }
+    }
+
+    /* reference sequence names, which records refer to by index */
+
+    if (!c2b_read_bgzf(b, length_bytes, sizeof(length_bytes)))
+        goto truncated;
+    ctx->bam.num_refs = (int32_t) c2b_bam_le32(length_bytes);
+    if (ctx->bam.num_refs < 0) {
+        fprintf(stderr, "Error: BAM header has a negative reference count -- input may be corrupt\n");
+        c2b_print_usage(stderr);
+        exit(EINVAL); /* Invalid argument (POSIX.1) */
+    }
+    ctx->bam.ref_names = calloc((size_t) ctx->bam.num_refs + 1, sizeof(char *));
+    if (!ctx->bam.ref_names) {
+        fprintf(stderr, "Error: Could not allocate space for BAM reference names\n");
+        c2b_print_usage(stderr);
+        exit(ENOMEM); /* Not enough space (POSIX.1) */
+    }
+    for (n = 0; n < ctx->bam.num_refs; n++) {
+        if (!c2b_read_bgzf(b, length_bytes, sizeof(length_bytes)))
+            goto truncated;
+        name_length = c2b_bam_le32(length_bytes);
+        if ((name_length == 0) || (name_length >= C2B_MAX_FIELD_LENGTH_VALUE)) {
+            fprintf(stderr, "Error: BAM header has a reference name of invalid length (%u)\n", name_length);
+            c2b_print_usage(stderr);
+            exit(EINVAL); /* Invalid argument (POSIX.1) */
+        }
+        ctx->bam.ref_names[n] = malloc(name_length);
+        if (!ctx->bam.ref_names[n]) {
+            fprintf(stderr, "Error: Could not allocate space for BAM reference name\n");
+            c2b_print_usage(stderr);
+            exit(ENOMEM); /* Not enough space (POSIX.1) */
+        }
+        if ((!c2b_read_bgzf(b, ctx->bam.ref_names[n], name_length)) || (!c2b_read_bgzf(b, length_bytes, sizeof(length_bytes))))
+            goto truncated;
+        ctx->bam.ref_names[n][name_length - 1] = '\0';
+
+        /* with no header text, samtools prints a @SQ line for each reference */
+
+        if ((text_length == 0) && (c2b_globals.keep_header_flag)) {
+            sprintf(sq_line, "@SQ\tSN:%s\tLN:%u", ctx->bam.ref_names[n], c2b_bam_le32(length_bytes));
+            c2b_line_convert_sam_to_bed_unsorted_without_split_operation(ctx, dest, sq_line, (ssize_t) strlen(sq_line));
+        }
+    }
+
+    free(text), text = NULL;
+    return;
+
+ truncated:
+    fprintf(stderr, "Error: BAM input ends within its header -- input may be truncated\n");
+    c2b_print_usage(stderr);
+    exit(EINVAL); /* Invalid argument (POSIX.1) */
+}
+
+static void
+c2b_process_bam_regions(c2b_pipeline_stage_t *stage, int src_fd, c2b_context_t *ctx, uint64_t header_end, int dest_fd, c2b_sorter_t *sorter)
+{
+    c2b_bam_region_queue_t queue;
+    c2b_bam_region_t *region = NULL;
+    pthread_t *worker_threads = NULL;
+    unsigned int num_workers = 0;
+    unsigned int worker_idx = 0;
+    char *write_buffer = NULL;
+    size_t write_capacity = 0;
+    size_t write_size = 0;
+    char *swap_buffer = NULL;
+    size_t swap_capacity = 0;
+    size_t region_idx = 0;
+    struct stat src_stat;
+
+#ifdef DEBUG
+    fprintf(stderr, "\t-> c2b_process_bam_regions | reading from fd  (%02d) | writing to fd  (%02d) | threads [%u]\n", src_fd, dest_fd, c2b_globals.threads);
+#endif
+
+    if ((fstat(src_fd, &src_stat) == -1) || (!S_ISREG(src_stat.st_mode))) {
+        fprintf(stderr, "Error: BAM input must be a regular file redirected to standard input when --bai is used\n");
+        c2b_print_usage(stderr);
+        exit(EINVAL); /* Invalid argument (POSIX.1) */
+    }
+
+    c2b_init_bam_regions(&queue, ctx, header_end);
+    queue.src_fd = src_fd;
+    queue.line_functor = stage->line_functor;
+    if (queue.num == 0) {
+        c2b_delete_bam_regions(&queue);
+        return;
+    }
+
+    num_workers = (queue.num < c2b_globals.threads) ? (unsigned int) queue.num : c2b_globals.threads;
+    worker_threads = malloc(num_workers * sizeof(pthread_t));
+    if (!worker_threads) {
+        fprintf(stderr, "Error: Could not allocate space for worker thread handles\n");
+        c2b_print_usage(stderr);
+        exit(ENOMEM); /* Not enough space (POSIX.1) */
+    }
+    for (worker_idx = 0; worker_idx < num_workers; worker_idx++) {
+        pthread_create(&worker_threads[worker_idx], NULL, c2b_convert_bam_regions, &queue);
+    }
+
+    /* 
+       Pending bytes of the region being written are swapped out for an empty buffer,
+       so that its worker can go on converting while we write
+    */
+
+    for (region_idx = 0; region_idx < queue.num; region_idx++) {
+        region = &queue.regions[region_idx];
+        for (;;) {
+            pthread_mutex_lock(&queue.lock);
+            while ((region->pending_size == 0) && (!region->is_done)) {
+                pthread_cond_wait(&queue.changed, &queue.lock);
+            }
+            if (region->pending_size == 0) {
+                pthread_mutex_unlock(&queue.lock);
+                break;
+            }
+            swap_buffer = region->pending;
+            swap_capacity = region->pending_capacity;
+            write_size = region->pending_size;
+            region->pending = write_buffer;
+            region->pending_capacity = write_capacity;
+            region->pending_size = 0;
+            write_buffer = swap_buffer;
+            write_capacity = swap_capacity;
+            pthread_cond_broadcast(&queue.changed);
+            pthread_mutex_unlock(&queue.lock);
+
+            c2b_write_converted_bytes(dest_fd, sorter, write_buffer, (ssize_t) write_size);
+        }
+        free(region->pending), region->pending = NULL;
+        region->pending_capacity = 0;
+    }
+
+    for (worker_idx = 0; worker_idx < num_workers; worker_idx++) {
+        pthread_join(worker_threads[worker_idx], (void **) NULL);
+    }
+
+    if (write_buffer)
+        free(write_buffer), write_buffer = NULL;
+    free(worker_threads), worker_threads = NULL;
+    c2b_delete_bam_regions(&queue);
+}
+
+static void
+c2b_init_bam_regions(c2b_bam_region_queue_t *q, c2b_context_t *ctx, uint64_t header_end)
+{
+    FILE *index_stream = NULL;
+    unsigned char *index = NULL;
+    unsigned char *p = NULL;
+    unsigned char *index_end = NULL;
+    size_t index_size = 0;
+    size_t index_capacity = 0;
+    size_t bytes_read = 0;
+    uint64_t *ref_begins = NULL;
+    uint64_t *ref_ends = NULL;
+    boolean *is_listed = NULL;
+    uint64_t tail_begin = header_end;
+    uint64_t chunk_begin = 0;
+    uint64_t chunk_end = 0;
+    int32_t num_refs = 0;
+    int32_t num_bins = 0;
+    int32_t num_chunks = 0;
+    int32_t num_intervals = 0;
+    int32_t ref_idx = 0;
+    int32_t bin_idx = 0;
+    int32_t chunk_idx = 0;
+    uint32_t bin = 0;
+    char *regions = NULL;
+    char *regions_ptr = NULL;
+    char *name = NULL;
+    size_t region_idx = 0;
+
+    /* the index is small next to its BAM file, so we read it whole */
+
+    index_stream = fopen(c2b_globals.bam->index_path, "rb");
+    if (!index_stream) {
+        fprintf(stderr, "Error: Could not open BAM index [%s] (%s)\n", c2b_globals.bam->index_path, strerror(errno));
+        c2b_print_usage(stderr);
+        exit(EINVAL); /* Invalid argument (POSIX.1) */
+    }
+    do {
+        if (index_size == index_capacity) {
+            index_capacity = (index_capacity == 0) ? C2B_BGZF_SOURCE_BUFFER_SIZE : 2 * index_capacity;
+            p = realloc(index, index_capacity);
+            if (!p) {
+                fprintf(stderr, "Error: Could not allocate space for BAM index\n");
+                c2b_print_usage(stderr);
+                exit(ENOMEM); /* Not enough space (POSIX.1) */
+            }
+            index = p;
+        }
+        bytes_read = fread(index + index_size, 1, index_capacity - index_size, index_stream);
+        index_size += bytes_read;
+    } while (bytes_read > 0);
+    fclose(index_stream);
+    p = index;
+    index_end = index + index_size;
+
+    if ((index_size < 8) || (memcmp(p, c2b_bai_magic, 4) != 0)) {
+        fprintf(stderr, "Error: [%s] does not start with the BAI magic string -- check index format\n", c2b_globals.bam->index_path);
+        c2b_print_usage(stderr);
+        exit(EINVAL); /* Invalid argument (POSIX.1) */
+    }
+    num_refs = (int32_t) c2b_bam_le32(p + 4);
+    p += 8;
+    if (num_refs != ctx->bam.num_refs) {
+        fprintf(stderr, "Error: BAM index has %d reference sequences, but BAM header has %d -- check that index matches input\n", num_refs, ctx->bam.num_refs);
+        c2b_print_usage(stderr);
+        exit(EINVAL); /* Invalid argument (POSIX.1) */
+    }
+
+    ref_begins = malloc(((size_t) num_refs + 1) * sizeof(uint64_t));
+    ref_ends = malloc(((size_t) num_refs + 1) * sizeof(uint64_t));
+    if ((!ref_begins) || (!ref_ends)) {
+        fprintf(stderr, "Error: Could not allocate space for BAM index offsets\n");
+        c2b_print_usage(stderr);
+        exit(ENOMEM); /* Not enough space (POSIX.1) */
+    }
+
+    /* 
+       A reference's records lie between the least start and the greatest end of the 
+       chunks in its bins. The pseudo-bin holds counts, not chunks, and is skipped.
+    */
+
+    for (ref_idx = 0; ref_idx < num_refs; ref_idx++) {
+        ref_begins[ref_idx] = UINT64_MAX;
+        ref_ends[ref_idx] = 0;
+        if (index_end - p < 4)
+            goto truncated;
+        num_bins = (int32_t) c2b_bam_le32(p);
+        p += 4;
+        for (bin_idx = 0; bin_idx < num_bins; bin_idx++) {
+            if (index_end - p < 8)
+                goto truncated;
+            bin = c2b_bam_le32(p);
+            num_chunks = (int32_t) c2b_bam_le32(p + 4);
+            p += 8;
+            if ((num_chunks < 0) || ((size_t) (index_end - p) < (size_t) num_chunks * 16))
+                goto truncated;
+            for (chunk_idx = 0; (bin != C2B_BAI_PSEUDO_BIN) && (chunk_idx < num_chunks); chunk_idx++) {
+                chunk_begin = (uint64_t) c2b_bam_le32(p + 16 * chunk_idx) | ((uint64_t) c2b_bam_le32(p + 16 * chunk_idx + 4) << 32);
+                chunk_end = (uint64_t) c2b_bam_le32(p + 16 * chunk_idx + 8) | ((uint64_t) c2b_bam_le32(p + 16 * chunk_idx + 12) << 32);
+                if (chunk_begin < ref_begins[ref_idx])
+                    ref_begins[ref_idx] = chunk_begin;
+                if (chunk_end > ref_ends[ref_idx])
+                    ref_ends[ref_idx] = chunk_end;
+            }
+            p += (size_t) num_chunks * 16;
+        }
+        if (index_end - p < 4)
+            goto truncated;
+        num_intervals = (int32_t) c2b_bam_le32(p);
+        p += 4;
+        if ((num_intervals < 0) || ((size_t) (index_end - p) < (size_t) num_intervals * 8))
+            goto truncated;
+        p += (size_t) num_intervals * 8;
+        if (ref_ends[ref_idx] > tail_begin)
+            tail_begin = ref_ends[ref_idx];
+    }
+    free(index), index = NULL;
+
+    q->regions = malloc(((size_t) num_refs + 1) * sizeof(c2b_bam_region_t));
+    if (!q->regions) {
+        fprintf(stderr, "Error: Could not allocate space for BAM regions\n");
+        c2b_print_usage(stderr);
+        exit(ENOMEM); /* Not enough space (POSIX.1) */
+    }
+    q->num = 0;
+
+    /* regions are listed in --regions order, or else in the order of the BAM header */
+
+    if (c2b_globals.bam->regions) {
+        regions = malloc(strlen(c2b_globals.bam->regions) + 1);
+        if (!regions) {
+            fprintf(stderr, "Error: Could not allocate space for regions argument copy\n");
+            c2b_print_usage(stderr);
+            exit(ENOMEM); /* Not enough space (POSIX.1) */
+        }
+        memcpy(regions, c2b_globals.bam->regions, strlen(c2b_globals.bam->regions) + 1);
+        is_listed = calloc((size_t) num_refs + 1, sizeof(boolean));
+        if (!is_listed) {
+            fprintf(stderr, "Error: Could not allocate space for regions list\n");
+            c2b_print_usage(stderr);
+            exit(ENOMEM); /* Not enough space (POSIX.1) */
+        }
+        regions_ptr = regions;
+        while ((name = c2b_strsep(&regions_ptr, ",")) != NULL) {
+            if (*name == '\0')
+                continue;
+            for (ref_idx = 0; ref_idx < num_refs; ref_idx++) {
+                if (strcmp(name, ctx->bam.ref_names[ref_idx]) == 0)
+                    break;
+            }
+            if (ref_idx == num_refs) {
+                fprintf(stderr, "Error: Region [%s] is not a reference sequence in the BAM header\n", name);
+                c2b_print_usage(stderr);
+                exit(EINVAL); /* Invalid argument (POSIX.1) */
+            }
+            if (is_listed[ref_idx]) {
+                fprintf(stderr, "Error: Region [%s] is listed more than once\n", name);
+                c2b_print_usage(stderr);
+                exit(EINVAL); /* Invalid argument (POSIX.1) */
+            }
+            if (ref_begins[ref_idx] < ref_ends[ref_idx]) {
+                q->regions[q->num].ref_id = ref_idx;
+                q->regions[q->num].begin = ref_begins[ref_idx];
+                q->regions[q->num].end = ref_ends[ref_idx];
+                q->num++;
+            }
+            is_listed[ref_idx] = kTrue;
+        }
+        free(is_listed), is_listed = NULL;
+        free(regions), regions = NULL;
+    }
+    else {
+        for (ref_idx = 0; ref_idx < num_refs; ref_idx++) {
+            if (ref_begins[ref_idx] < ref_ends[ref_idx]) {
+                q->regions[q->num].ref_id = ref_idx;
+                q->regions[q->num].begin = ref_begins[ref_idx];
+                q->regions[q->num].end = ref_ends[ref_idx];
+                q->num++;
+            }
+        }
+        if (c2b_globals.all_reads_flag) {
+            q->regions[q->num].ref_id = -1;
+            q->regions[q->num].begin = tail_begin;
+            q->regions[q->num].end = UINT64_MAX;
+            q->num++;
+        }
+    }
+
+    for (region_idx = 0; region_idx < q->num; region_idx++) {
+        q->regions[region_idx].pending = NULL;
+        q->regions[region_idx].pending_size = 0;
+        q->regions[region_idx].pending_capacity = 0;
+        q->regions[region_idx].is_done = kFalse;
+    }
+    q->next_convert = 0;
+    q->src_fd = -1;
+    q->context = ctx;
+    q->line_functor = NULL;
+    pthread_mutex_init(&q->lock, NULL);
+    pthread_cond_init(&q->changed, NULL);
+
+    free(ref_begins), ref_begins = NULL;
+    free(ref_ends), ref_ends = NULL;
+    return;
+
+ truncated:
+    fprintf(stderr, "Error: BAM index [%s] ends early -- index may be truncated\n", c2b_globals.bam->index_path);
+    c2b_print_usage(stderr);
+    exit(EINVAL); /* Invalid argument (POSIX.1) */
+}
+
+static void
+c2b_delete_bam_regions(c2b_bam_region_queue_t *q)
+{
+    size_t n;
+
+    for (n = 0; n < q->num; n++) {
+        if (q->regions[n].pending)
+            free(q->regions[n].pending), q->regions[n].pending = NULL;
+    }
+    free(q->regions), q->regions = NULL;
+    q->num = 0;
+    pthread_mutex_destroy(&q->lock);
+    pthread_cond_destroy(&q->changed);
+}
+
+static void *
+c2b_convert_bam_regions(void *arg)
+{
+    c2b_bam_region_queue_t *q = (c2b_bam_region_queue_t *) arg;
+    c2b_bam_region_t *region = NULL;
+    c2b_context_t context;
+    c2b_bgzf_t bgzf;
+    c2b_output_t dest;
+    char *record = NULL;
+    size_t record_capacity = 0;
+    size_t record_length = 0;
+    uint64_t voffset = 0;
+
+    c2b_init_output(&dest, -1, NULL);
+    memcpy(&context, q->context, sizeof(c2b_context_t));
+    memset(&context.counts, 0, sizeof(c2b_record_counts_t));
+    context.fragments = NULL;
+    context.coverage = NULL;
+    c2b_init_bgzf(&bgzf, q->src_fd);
+    bgzf.is_positioned = kTrue;
+
+    for (;;) {
+        pthread_mutex_lock(&q->lock);
+        if (q->next_convert == q->num) {
+            pthread_mutex_unlock(&q->lock);
+            break;
+        }
+        region = &q->regions[q->next_convert++];
+        pthread_mutex_unlock(&q->lock);
+
+        /* records of other references are skipped, should the index bounds take any in */
+
+        c2b_seek_bgzf(&bgzf, region->begin);
+        while ((c2b_tell_bgzf(&bgzf, &voffset)) && (voffset < region->end)) {
+            if (!c2b_read_bam_record(&bgzf, &record, &record_capacity, &record_length))
+                break;
+            if ((record_length >= 4) && ((int32_t) c2b_bam_le32((unsigned char *) record) != region->ref_id))
+                continue;
+            (*q->line_functor)(&context, &dest, record, (ssize_t) record_length);
+            context.counts.lines++;
+            if (dest.size >= dest.watermark) {
+                c2b_append_bam_region_bytes(q, region, dest.buf, (size_t) dest.size);
+                dest.size = 0;
+            }
+        }
+        /* proper pairs share a reference, so mates are paired, and runs swept, within the region */
+        c2b_finish_fragments(&context, &dest);
+        c2b_finish_coverage(&context, &dest);
+        c2b_append_bam_region_bytes(q, region, dest.buf, (size_t) dest.size);
+        dest.size = 0;
+
+        pthread_mutex_lock(&q->lock);
+        region->is_done = kTrue;
+        pthread_cond_broadcast(&q->changed);
+        pthread_mutex_unlock(&q->lock);
+    }
+
+    c2b_add_record_counts(&context.counts);
+    if (record)
+        free(record), record = NULL;
+    c2b_delete_output(&dest);
+    c2b_delete_bgzf(&bgzf);
+    pthread_exit(NULL);
+}
+
+static void
+c2b_append_bam_region_bytes(c2b_bam_region_queue_t *q, c2b_bam_region_t *region, char *src, size_t src_size)
+{
+    char *pending = NULL;
+    size_t capacity = 0;
+
+    if (src_size == 0)
+        return;
+
+    /* 
+       Regions are claimed in order, so the region being written always has a worker,
+       and the stage empties its pending bytes whenever that worker waits here
+    */
+
+    pthread_mutex_lock(&q->lock);
+    while (region->pending_size >= C2B_BAM_REGION_MAX_PENDING) {
+        pthread_cond_wait(&q->changed, &q->lock);
+    }
+    if (region->pending_size + src_size > region->pending_capacity) {
+        capacity = (region->pending_capacity == 0) ? src_size : region->pending_capacity;
+        while (capacity < region->pending_size + src_size)
+            capacity *= 2;
+        pending = realloc(region->pending, capacity);
+        if (!pending) {
+            fprintf(stderr, "Error: Could not allocate space for converted region bytes\n");
+            c2b_print_usage(stderr);
+            exit(ENOMEM); /* Not enough space (POSIX.1) */
+        }
+        region->pending = pending;
+        region->pending_capacity = capacity;
+    }
+    memcpy(region->pending + region->pending_size, src, src_size);
+    region->pending_size += src_size;
+    pthread_cond_broadcast(&q->changed);
+    pthread_mutex_unlock(&q->lock);
+}
+
+static void
+c2b_init_bgzf(c2b_bgzf_t *b, int fd)
+{
+    b->fd = fd;
+    b->offset = 0;
+    b->block_coffset = 0;
+    b->is_positioned = kFalse;
+    b->is_at_eof_marker = kFalse;
+    b->src = malloc(C2B_BGZF_SOURCE_BUFFER_SIZE);
+    b->src_start = 0;
+    b->src_end = 0;
+    b->src_capacity = C2B_BGZF_SOURCE_BUFFER_SIZE;
+    b->block = malloc(C2B_BGZF_MAX_BLOCK_SIZE);
+    b->block_size = 0;
+    b->block_offset = 0;
+    if ((!b->src) || (!b->block)) {
+        fprintf(stderr, "Error: Could not allocate space for BGZF buffers\n");
+        c2b_print_usage(stderr);
+        exit(ENOMEM); /* Not enough space (POSIX.1) */
+    }
+    b->ring = NULL;
+    memset(&b->z, 0, sizeof(b->z));
+    if (inflateInit2(&b->z, -MAX_WBITS) != Z_OK) {
+        fprintf(stderr, "Error: Could not initialize BGZF block decompression\n");
+        exit(ENOMEM); /* Not enough space (POSIX.1) */
+    }
+}
+
+static void
+c2b_delete_bgzf(c2b_bgzf_t *b)
+{
+    if (b->ring)
+        c2b_delete_bgzf_ring(b);
+    inflateEnd(&b->z);
+    free(b->src), b->src = NULL;
+    free(b->block), b->block = NULL;
+}
+
+static boolean
+c2b_fill_bgzf_source(c2b_bgzf_t *b, size_t size)
+{
+    ssize_t bytes_read = 0;
+    int errsv = 0;
+
+    /* returns kFalse if input ends before size bytes are buffered */
+
+    if (b->src_end - b->src_start >= size)
+        return kTrue;
+    if (b->src_start > 0) {
+        memmove(b->src, b->src + b->src_start, b->src_end - b->src_start);
+        b->src_end -= b->src_start;
+        b->src_start = 0;
+    }
+    while (b->src_end < size) {
+        if (b->is_positioned)
+            bytes_read = pread(b->fd, b->src + b->src_end, b->src_capacity - b->src_end, b->offset);
+        else
+            bytes_read = c2b_timed_read(&c2b_globals.pipe->convert_stats, b->fd, b->src + b->src_end, b->src_capacity - b->src_end);
+        if (bytes_read == -1) {
+            errsv = errno;
+            if (errsv == EINTR)
+                continue;
+            fprintf(stderr, "Error: Could not read BAM input (%s)\n", strerror(errsv));
+            exit(errsv);
+        }
+        if (bytes_read == 0)
+            return kFalse;
+        b->src_end += (size_t) bytes_read;
+        b->offset += bytes_read;
+    }
+    return kTrue;
+}
+
+static void
+c2b_check_bgzf_eof_marker(int fd)
+{
+    struct stat fd_stat;
+    unsigned char marker[C2B_BGZF_EOF_MARKER_LENGTH];
+
+    /* indexed input is read by region, and not to its end, so the marker is read from the end of the file */
+
+    if ((fstat(fd, &fd_stat) == -1) || (fd_stat.st_size < C2B_BGZF_EOF_MARKER_LENGTH))
+        return;
+    if ((pread(fd, marker, C2B_BGZF_EOF_MARKER_LENGTH, fd_stat.st_size - C2B_BGZF_EOF_MARKER_LENGTH) != C2B_BGZF_EOF_MARKER_LENGTH) || 
+        (memcmp(marker, c2b_bgzf_eof_marker, C2B_BGZF_EOF_MARKER_LENGTH) != 0))
+        c2b_warn_bgzf_eof_marker();
+}
+
+static void
+c2b_warn_bgzf_eof_marker()
+{
+    fprintf(stderr, "Warning: BAM input has no BGZF end-of-file marker -- input may be truncated\n");
+}
+
+static boolean
+c2b_scan_bgzf_block(c2b_bgzf_t *b, unsigned char **data, size_t *data_size, uint32_t *crc, uint32_t *isize)
+{
+    unsigned char *header = NULL;
+    size_t extra_length = 0;
+    size_t block_length = 0;
+    size_t offset = 0;
+    size_t subfield_length = 0;
+
+    /* 
+       Finds the next block from its header and points data at its compressed bytes, 
+       which stay valid until the next call. Returns kFalse at the end of input, which 
+       must fall on a block boundary, and should follow the end-of-file marker.
+    */
+
+    if (!c2b_fill_bgzf_source(b, C2B_BGZF_HEADER_LENGTH)) {
+        if (b->src_end != b->src_start)
+            goto truncated;
+        if ((!b->is_at_eof_marker) && (!b->is_positioned)) {
+            c2b_warn_bgzf_eof_marker();
+            b->is_at_eof_marker = kTrue; /* warns once */
+        }
+        return kFalse;
+    }
+    header = b->src + b->src_start;
+    if ((header[0] != 31) || (header[1] != 139) || (header[2] != 8) || (!(header[3] & 4))) {
+        fprintf(stderr, "Error: Input is not BGZF-compressed -- check input format\n");
+        c2b_print_usage(stderr);
+        exit(EINVAL); /* Invalid argument (POSIX.1) */
+    }
+    extra_length = c2b_bam_le16(header + 10);
+    if (!c2b_fill_bgzf_source(b, 12 + extra_length))
+        goto truncated;
+    header = b->src + b->src_start;
+
+    /* the "BC" subfield of the gzip extra field holds the block length, less one */
+
+    for (offset = 12; offset + 4 <= 12 + extra_length; offset += 4 + subfield_length) {
+        subfield_length = c2b_bam_le16(header + offset + 2);
+        if ((header[offset] == 'B') && (header[offset + 1] == 'C') && (subfield_length == 2)) {
+            block_length = (size_t) c2b_bam_le16(header + offset + 4) + 1;
+            break;
+        }
+    }
+    if (block_length < 12 + extra_length + C2B_BGZF_FOOTER_LENGTH) {
+        fprintf(stderr, "Error: BGZF block has no valid size subfield -- input may be corrupt\n");
+        c2b_print_usage(stderr);
+        exit(EINVAL); /* Invalid argument (POSIX.1) */
+    }
+    if (!c2b_fill_bgzf_source(b, block_length))
+        goto truncated;
+    header = b->src + b->src_start;
+
+    *crc = c2b_bam_le32(header + block_length - 8);
+    *isize = c2b_bam_le32(header + block_length - 4);
+    if (*isize > C2B_BGZF_MAX_BLOCK_SIZE) {
+        fprintf(stderr, "Error: BGZF block is larger than %d bytes -- input may be corrupt\n", C2B_BGZF_MAX_BLOCK_SIZE);
+        c2b_print_usage(stderr);
+        exit(EINVAL); /* Invalid argument (POSIX.1) */
+    }
+    b->is_at_eof_marker = ((block_length == C2B_BGZF_EOF_MARKER_LENGTH) && (memcmp(header, c2b_bgzf_eof_marker, C2B_BGZF_EOF_MARKER_LENGTH) == 0)) ? kTrue : kFalse;
+    *data = header + 12 + extra_length;
+    *data_size = block_length - 12 - extra_length - C2B_BGZF_FOOTER_LENGTH;
+    b->block_coffset = b->offset - (off_t) (b->src_end - b->src_start);
+    b->src_start += block_length;
+    return kTrue;
+
+ truncated:
+    fprintf(stderr, "Error: BAM input ends within a BGZF block -- input may be truncated\n");
+    c2b_print_usage(stderr);
+    exit(EINVAL); /* Invalid argument (POSIX.1) */
+}
+
+static void
+c2b_inflate_bgzf_data(z_stream *z, const unsigned char *data, size_t data_size, uint32_t crc, uint32_t isize, unsigned char *block)
+{
+    inflateReset(z);
+    z->next_in = (Bytef *) data;
+    z->avail_in = (uInt) data_size;
+    z->next_out = block;
+    z->avail_out = C2B_BGZF_MAX_BLOCK_SIZE;
+    if ((inflate(z, Z_FINISH) != Z_STREAM_END) || (z->total_out != isize) || (crc32(crc32(0L, Z_NULL, 0), block, isize) != crc)) {
+        fprintf(stderr, "Error: Could not decompress BGZF block -- input may be corrupt\n");
+        c2b_print_usage(stderr);
+        exit(EINVAL); /* Invalid argument (POSIX.1) */
+    }
+}
+
+static boolean
+c2b_inflate_bgzf_block(c2b_bgzf_t *b)
+{
+    unsigned char *data = NULL;
+    size_t data_size = 0;
+    uint32_t crc = 0;
+    uint32_t isize = 0;
+
+    if (b->ring)
+        return c2b_read_bgzf_ring_block(b);
+
+    if (!c2b_scan_bgzf_block(b, &data, &data_size, &crc, &isize))
+        return kFalse;
+    c2b_inflate_bgzf_data(&b->z, data, data_size, crc, isize, b->block);
+    b->block_size = isize;
+    b->block_offset = 0;
+    return kTrue;
+}
+
+static void
+c2b_init_bgzf_ring(c2b_bgzf_t *b, unsigned int num_workers)
+{
+    c2b_bgzf_ring_t *ring = NULL;
+    size_t n;
+    unsigned int worker_idx = 0;
+
+    ring = malloc(sizeof(c2b_bgzf_ring_t));
+    if (!ring) {
+        fprintf(stderr, "Error: Could not allocate space for BGZF block ring\n");
+        c2b_print_usage(stderr);
+        exit(ENOMEM); /* Not enough space (POSIX.1) */
+    }
+    ring->num = C2B_BGZF_BLOCKS_PER_THREAD * num_workers;
+    ring->slots = malloc(ring->num * sizeof(c2b_bgzf_slot_t));
+    ring->worker_threads = malloc(num_workers * sizeof(pthread_t));
+    if ((!ring->slots) || (!ring->worker_threads)) {
+        fprintf(stderr, "Error: Could not allocate space for BGZF block ring\n");
+        c2b_print_usage(stderr);
+        exit(ENOMEM); /* Not enough space (POSIX.1) */
+    }
+    for (n = 0; n < ring->num; n++) {
+        ring->slots[n].src = malloc(C2B_BGZF_MAX_BLOCK_SIZE);
+        ring->slots[n].block = malloc(C2B_BGZF_MAX_BLOCK_SIZE);
+        if ((!ring->slots[n].src) || (!ring->slots[n].block)) {
+            fprintf(stderr, "Error: Could not allocate space for BGZF block ring buffers\n");
+            c2b_print_usage(stderr);
+            exit(ENOMEM); /* Not enough space (POSIX.1) */
+        }
+        ring->slots[n].src_size = 0;
+        ring->slots[n].crc = 0;
+        ring->slots[n].isize = 0;
+        ring->slots[n].state = C2B_BGZF_SLOT_EMPTY;
+    }
+    ring->next_fill = 0;
+    ring->next_inflate = 0;
+    ring->next_read = 0;
+    ring->is_done = kFalse;
+    ring->num_workers = num_workers;
+    pthread_mutex_init(&ring->lock, NULL);
+    pthread_cond_init(&ring->changed, NULL);
+    b->ring = ring;
+
+    pthread_create(&ring->reader_thread, NULL, c2b_scan_bgzf_blocks, b);
+    for (worker_idx = 0; worker_idx < num_workers; worker_idx++) {
+        pthread_create(&ring->worker_threads[worker_idx], NULL, c2b_inflate_bgzf_blocks, ring);
+    }
+}
+
+static void
+c2b_delete_bgzf_ring(c2b_bgzf_t *b)
+{
+    c2b_bgzf_ring_t *ring = b->ring;
+    size_t n;
+    unsigned int worker_idx = 0;
+
+    pthread_join(ring->reader_thread, NULL);
+    for (worker_idx = 0; worker_idx < ring->num_workers; worker_idx++) {
+        pthread_join(ring->worker_threads[worker_idx], NULL);
+    }
+    for (n = 0; n < ring->num; n++) {
+        free(ring->slots[n].src), ring->slots[n].src = NULL;
+        free(ring->slots[n].block), ring->slots[n].block = NULL;
+    }
+    pthread_mutex_destroy(&ring->lock);
+    pthread_cond_destroy(&ring->changed);
+    free(ring->worker_threads), ring->worker_threads = NULL;
+    free(ring->slots), ring->slots = NULL;
+    free(ring), b->ring = NULL;
+}
+
+static void *
+c2b_scan_bgzf_blocks(void *arg)
+{
+    c2b_bgzf_t *b = (c2b_bgzf_t *) arg;
+    c2b_bgzf_ring_t *ring = b->ring;
+    c2b_bgzf_slot_t *slot = NULL;
+    unsigned char *data = NULL;
+    size_t data_size = 0;
+    uint32_t crc = 0;
+    uint32_t isize = 0;
+
+    while (c2b_scan_bgzf_block(b, &data, &data_size, &crc, &isize)) {
+        pthread_mutex_lock(&ring->lock);
+        slot = &ring->slots[ring->next_fill % ring->num];
+        while (slot->state != C2B_BGZF_SLOT_EMPTY) {
+            pthread_cond_wait(&ring->changed, &ring->lock);
+        }
+        pthread_mutex_unlock(&ring->lock);
+
+        memcpy(slot->src, data, data_size);
+        slot->src_size = data_size;
+        slot->crc = crc;
+        slot->isize = isize;
+
+        pthread_mutex_lock(&ring->lock);
+        slot->state = C2B_BGZF_SLOT_FILLED;
+        ring->next_fill++;
+        pthread_cond_broadcast(&ring->changed);
+        pthread_mutex_unlock(&ring->lock);
+    }
+
+    pthread_mutex_lock(&ring->lock);
+    ring->is_done = kTrue;
+    pthread_cond_broadcast(&ring->changed);
+    pthread_mutex_unlock(&ring->lock);
+
+    pthread_exit(NULL);
+}
+
+static void *
+c2b_inflate_bgzf_blocks(void *arg)
+{
+    c2b_bgzf_ring_t *ring = (c2b_bgzf_ring_t *) arg;
+    c2b_bgzf_slot_t *slot = NULL;
+    z_stream z;
+
+    memset(&z, 0, sizeof(z));
+    if (inflateInit2(&z, -MAX_WBITS) != Z_OK) {
+        fprintf(stderr, "Error: Could not initialize BGZF block decompression\n");
+        exit(ENOMEM); /* Not enough space (POSIX.1) */
+    }
+
+    for (;;) {
+        pthread_mutex_lock(&ring->lock);
+        while ((ring->next_inflate == ring->next_fill) && (!ring->is_done)) {
+            pthread_cond_wait(&ring->changed, &ring->lock);
+        }
+        if (ring->next_inflate == ring->next_fill) {
+            pthread_mutex_unlock(&ring->lock);
+            break;
+        }
+        slot = &ring->slots[ring->next_inflate++ % ring->num];
+        pthread_mutex_unlock(&ring->lock);
+
+        c2b_inflate_bgzf_data(&z, slot->src, slot->src_size, slot->crc, slot->isize, slot->block);
+
+        pthread_mutex_lock(&ring->lock);
+        slot->state = C2B_BGZF_SLOT_INFLATED;
+        pthread_cond_broadcast(&ring->changed);
+        pthread_mutex_unlock(&ring->lock);
+    }
+
+    inflateEnd(&z);
+    pthread_exit(NULL);
+}
+
+static boolean
+c2b_read_bgzf_ring_block(c2b_bgzf_t *b)
+{
+    c2b_bgzf_ring_t *ring = b->ring;
+    c2b_bgzf_slot_t *slot = NULL;
+    unsigned char *block = NULL;
+
+    /* the next block in input order is swapped out of its slot, which is then free to refill */
+
+    pthread_mutex_lock(&ring->lock);
+    slot = &ring->slots[ring->next_read % ring->num];
+    while ((slot->state != C2B_BGZF_SLOT_INFLATED) && (!((ring->is_done) && (ring->next_read == ring->next_fill)))) {
+        pthread_cond_wait(&ring->changed, &ring->lock);
+    }
+    if (slot->state != C2B_BGZF_SLOT_INFLATED) {
+        pthread_mutex_unlock(&ring->lock);
+        return kFalse;
+    }
+    block = b->block;
+    b->block = slot->block;
+    slot->block = block;
+    b->block_size = slot->isize;
+    b->block_offset = 0;
+    slot->state = C2B_BGZF_SLOT_EMPTY;
+    ring->next_read++;
+    pthread_cond_broadcast(&ring->changed);
+    pthread_mutex_unlock(&ring->lock);
+
+    return kTrue;
+}
+
+static void
+c2b_seek_bgzf(c2b_bgzf_t *b, uint64_t voffset)
+{
+    /* 
+       A virtual offset is the file offset of a block in its upper 48 bits and an offset
+       into the inflated block in its lower 16 bits
+    */
+
+    b->offset = (off_t) (voffset >> 16);
+    b->src_start = 0;
+    b->src_end = 0;
+    b->block_size = 0;
+    b->block_offset = 0;
+    if (!c2b_inflate_bgzf_block(b)) {
+        if ((voffset & 0xffff) == 0)
+            return;
+        b->block_size = 0;
+    }
+    if ((voffset & 0xffff) > b->block_size) {
+        fprintf(stderr, "Error: BAM index points past the end of a BGZF block -- check that index matches input\n");
+        c2b_print_usage(stderr);
+        exit(EINVAL); /* Invalid argument (POSIX.1) */
+    }
+    b->block_offset = (size_t) (voffset & 0xffff);
+}
+
+static boolean
+c2b_tell_bgzf(c2b_bgzf_t *b, uint64_t *voffset)
+{
+    /* 
+       Gives the virtual offset of the next byte to read, moving on to the next block 
+       if the current one is used up. Returns kFalse at the end of input.
+    */
+
+    while (b->block_offset == b->block_size) {
+        if (!c2b_inflate_bgzf_block(b))
+            return kFalse;
+    }
+    *voffset = ((uint64_t) b->block_coffset << 16) | (uint64_t) b->block_offset;
+    return kTrue;
+}
+
+static boolean
+c2b_read_bgzf(c2b_bgzf_t *b, void *dest, size_t size)
+{
+    unsigned char *d = (unsigned char *) dest;
+    size_t available = 0;
+    size_t copied = 0;
+
+    /* 
+       Copies size bytes, across block boundaries as needed. Returns kFalse if the 
+       input ends first, and no bytes are copied if it ends before the first.
+    */
+
+    while (copied < size) {
+        if (b->block_offset == b->block_size) {
+            if (!c2b_inflate_bgzf_block(b))
+                return kFalse;
+            continue;
+        }
+        available = b->block_size - b->block_offset;
+        if (available > size - copied)
+            available = size - copied;
+        memcpy(d + copied, b->block + b->block_offset, available);
+        b->block_offset += available;
+        copied += available;
+    }
+    return kTrue;
+}
+
+static void
+c2b_init_context(c2b_context_t *ctx)
+{
+    ctx->header_line_idx = 0U;
+
+    memset(ctx->gtf.id, 0, C2B_MAX_FIELD_LENGTH_VALUE);
+
+    ctx->rmsk.line = 0U;
+    ctx->rmsk.is_start_of_line = kTrue;
+    ctx->rmsk.is_start_of_gap = kFalse;
+
+    ctx->wig.section = 1;
+    ctx->wig.line = 0;
+    ctx->wig.pos_lines = 0;
+    ctx->wig.span = 0;
+    ctx->wig.step = 0;
+    ctx->wig.start_pos = 0;
+    ctx->wig.end_pos = 0;
+    ctx->wig.score = 0.0f;
+    memset(ctx->wig.chr, 0, C2B_MAX_CHROMOSOME_LENGTH);
+    memset(ctx->wig.id, 0, C2B_MAX_FIELD_LENGTH_VALUE);
+    ctx->wig.is_fixed_step = kFalse;
+    ctx->wig.start_write = kFalse;
+
+    ctx->bam.ref_names = NULL;
+    ctx->bam.num_refs = 0;
+
+    ctx->delims = NULL;
+    ctx->fragments = NULL;
+    ctx->coverage = NULL;
+
+    memset(&ctx->counts, 0, sizeof(c2b_record_counts_t));
+}
+
+static void
+c2b_advance_context(c2b_context_t *ctx, void (*line_functor)(c2b_context_t *, c2b_output_t *, char *, ssize_t), c2b_output_t *scratch, char *src, ssize_t src_size)
+{
+    /*
+       Moves ctx from the state before the first line of src to the state after its last 
+       line, as if every line had been converted. Output from any functor calls made here 
+       goes to scratch and is discarded; the chunk itself is converted later by a worker.
+    */
+
+    switch (c2b_globals.input_format_idx)
+        {
+        case BAM_FORMAT:
+        case SAM_FORMAT:
+            if (c2b_globals.keep_header_flag)
+                c2b_advance_context_over_headers(ctx, line_functor, scratch, src, src_size, c2b_sam_header_prefix);
+            break;
+        case GFF_FORMAT:
+        case GVF_FORMAT:
+            if (c2b_globals.keep_header_flag)
+                c2b_advance_context_over_headers(ctx, line_functor, scratch, src, src_size, c2b_gff_header[0]);
+            break;
+        case VCF_FORMAT:
+            if (c2b_globals.keep_header_flag)
+                c2b_advance_context_over_headers(ctx, line_functor, scratch, src, src_size, c2b_vcf_header_prefix);
+            break;
+        case GTF_FORMAT:
+            if (c2b_globals.keep_header_flag)
+                c2b_advance_context_over_headers(ctx, line_functor, scratch, src, src_size, c2b_gtf_comment);
+            c2b_advance_gtf_context(ctx, line_functor, scratch, src, src_size);
+            break;
+        case PSL_FORMAT:
+            c2b_advance_psl_context(ctx, line_functor, scratch, src, src_size);
+            break;
+        case RMSK_FORMAT:
+            c2b_advance_rmsk_context(ctx, line_functor, scratch, src, src_size);
+            break;
+        case WIG_FORMAT:
+            c2b_advance_wig_context(ctx, line_functor, scratch, src, src_size);
+            break;
+        default:
+            break;
+        }
+}
+
+static void
+c2b_advance_context_over_headers(c2b_context_t *ctx, void (*line_functor)(c2b_context_t *, c2b_output_t *, char *, ssize_t), c2b_output_t *scratch, char *src, ssize_t src_size, const char prefix)
+{
+    char *line_start = src;
+    char *line_end = NULL;
+    char *src_end = src + src_size;
+
+    /* only a line that starts with the header prefix can advance the header line index */
+
+    while ((line_end = memchr(line_start, c2b_line_delim, (size_t) (src_end - line_start))) != NULL) {
+        if (line_start[0] == prefix) {
+            scratch->size = 0;
+            (*line_functor)(ctx, scratch, line_start, line_end - line_start);
+        }
+        line_start = line_end + 1;
+    }
+}
+
+static void
+c2b_advance_gtf_context(c2b_context_t *ctx, void (*line_functor)(c2b_context_t *, c2b_output_t *, char *, ssize_t), c2b_output_t *scratch, char *src, ssize_t src_size)
+{
+    char id_str[C2B_MAX_FIELD_LENGTH_VALUE];
+    char *line_start = NULL;
+    char *line_end = src + src_size - 1;
+    unsigned int header_line_idx = ctx->header_line_idx;
+
+    /*
+       The ID carried into the next chunk is the one set by the last line in this chunk 
+       that has a gene_id attribute. We walk lines backwards from the end and convert each 
+       until one sets the ID, which we detect by first writing a newline into it -- a 
+       value that no attribute can produce. The header line index is put back afterwards,
+       as it has already been advanced over this chunk.
+    */
+
+    memcpy(id_str, ctx->gtf.id, C2B_MAX_FIELD_LENGTH_VALUE);
+    while (line_end > src) {
+        line_start = line_end;
+        while ((line_start > src) && (*(line_start - 1) != c2b_line_delim))
+            line_start--;
+        ctx->gtf.id[0] = c2b_line_delim;
+        scratch->size = 0;
+        (*line_functor)(ctx, scratch, line_start, line_end - line_start);
+        ctx->header_line_idx = header_line_idx;
+        if (ctx->gtf.id[0] != c2b_line_delim)
+            return;
+        line_end = line_start - 1;
+    }
+    memcpy(ctx->gtf.id, id_str, C2B_MAX_FIELD_LENGTH_VALUE);
+}
+
+static void
+c2b_advance_psl_context(c2b_context_t *ctx, void (*line_functor)(c2b_context_t *, c2b_output_t *, char *, ssize_t), c2b_output_t *scratch, char *src, ssize_t src_size)
+{
+    char *line_start = src;
+    char *line_end = NULL;
+    char *src_end = src + src_size;
+    char *tab = NULL;
+    int field_count = 0;
+
+    /*
+       PSL header lines are counted only while the header line index is at most 5. A
+       line which starts with a digit and has the expected number of fields is a record 
+       and leaves the index alone, so we only need to convert the other lines.
+    */
+
+    while ((ctx->header_line_idx <= 5) && ((line_end = memchr(line_start, c2b_line_delim, (size_t) (src_end - line_start))) != NULL)) {
+        field_count = 1;
+        tab = line_start;
+        while ((tab = memchr(tab, c2b_tab_delim, (size_t) (line_end - tab))) != NULL) {
+            field_count++;
+            tab++;
+        }
+        if ((!isdigit(line_start[0])) || (field_count < c2b_psl_field_min) || (field_count > c2b_psl_field_max)) {
+            scratch->size = 0;
+            (*line_functor)(ctx, scratch, line_start, line_end - line_start);
+        }
+        line_start = line_end + 1;
+    }
+}
+
+static void
+c2b_advance_rmsk_context(c2b_context_t *ctx, void (*line_functor)(c2b_context_t *, c2b_output_t *, char *, ssize_t), c2b_output_t *scratch, char *src, ssize_t src_size)
+{
+    char *line_start = src;
+    char *line_end = NULL;
+    char *src_end = src + src_size;
+
+    /* the RepeatMasker context stops changing once the header lines have been read */
+
+    while ((ctx->rmsk.line < c2b_rmsk_header_line_count) && ((line_end = memchr(line_start, c2b_line_delim, (size_t) (src_end - line_start))) != NULL)) {
+        scratch->size = 0;
+        (*line_functor)(ctx, scratch, line_start, line_end - line_start);
+        line_start = line_end + 1;
+    }
+}
+
+static void
+c2b_advance_wig_context(c2b_context_t *ctx, void (*line_functor)(c2b_context_t *, c2b_output_t *, char *, ssize_t), c2b_output_t *scratch, char *src, ssize_t src_size)
+{
+    char *line_start = src;
+    char *line_end = NULL;
+    char *src_end = src + src_size;
+    char *chr_line_start = NULL;
+    ssize_t chr_line_size = 0;
+    uint32_t chr_line = 0;
+    uint32_t chr_pos_lines = 0;
+    uint32_t line = 0;
+    uint32_t pos_lines = 0;
+    uint64_t steps_since_chr_line = 0;
+    boolean is_eof = kFalse;
+
+    /*
+       Header, track, browser, variableStep and fixedStep lines are converted, as these
+       start new sections. For data lines we only count the line and, in a fixedStep 
+       section, step the start position. 
+
+       A BED-like "chr" line resets the chromosome and start position, which would mean
+       parsing every such line; instead, we hold on to the last one and convert it just 
+       before the next section header or the end of the chunk, then replay any fixedStep 
+       data lines that followed it.
+    */
+
+    while (!is_eof) {
+        line_end = memchr(line_start, c2b_line_delim, (size_t) (src_end - line_start));
+        is_eof = (line_end == NULL) ? kTrue : kFalse;
+        if ((!is_eof) && (strncmp(line_start, c2b_wig_chr_prefix, strlen(c2b_wig_chr_prefix)) == 0)) {
+            ctx->wig.line++;
+            ctx->wig.pos_lines++;
+            ctx->wig.start_write = kTrue;
+            chr_line_start = line_start;
+            chr_line_size = line_end - line_start;
+            chr_line = ctx->wig.line;
+            chr_pos_lines = ctx->wig.pos_lines;
+            steps_since_chr_line = 0;
+        }
+        else if ((!is_eof) &&
+                 (line_start[0] != c2b_wig_header_prefix) &&
+                 (strncmp(line_start, c2b_wig_track_prefix, strlen(c2b_wig_track_prefix)) != 0) &&
+                 (strncmp(line_start, c2b_wig_browser_prefix, strlen(c2b_wig_browser_prefix)) != 0) &&
+                 (strncmp(line_start, c2b_wig_variable_step_prefix, strlen(c2b_wig_variable_step_prefix)) != 0) &&
+                 (strncmp(line_start, c2b_wig_fixed_step_prefix, strlen(c2b_wig_fixed_step_prefix)) != 0)) {
+            ctx->wig.line++;
+            ctx->wig.pos_lines++;
+            ctx->wig.start_write = kTrue;
+            if (ctx->wig.is_fixed_step) {
+                ctx->wig.start_pos += ctx->wig.step;
+                steps_since_chr_line++;
+            }
+        }
+        else {
+            if (chr_line_start) {
+                line = ctx->wig.line;
+                pos_lines = ctx->wig.pos_lines;
+                ctx->wig.line = chr_line - 1;
+                ctx->wig.pos_lines = chr_pos_lines - 1;
+                scratch->size = 0;
+                (*line_functor)(ctx, scratch, chr_line_start, chr_line_size);
+                ctx->wig.line = line;
+                ctx->wig.pos_lines = pos_lines;
+                if (ctx->wig.is_fixed_step)
+                    ctx->wig.start_pos += ctx->wig.step * steps_since_chr_line;
+                chr_line_start = NULL;
+            }
+            if (!is_eof) {
+                scratch->size = 0;
+                (*line_functor)(ctx, scratch, line_start, line_end - line_start);
+            }
+        }
+        if (!is_eof)
+            line_start = line_end + 1;
+    }
+}
+
+static void
+c2b_process_intermediate_bytes_by_chunks(c2b_pipeline_stage_t *stage, int src_fd, int dest_fd, c2b_sorter_t *sorter)
+{
+    c2b_chunk_queue_t queue;
+    c2b_chunk_t *chunk = NULL;
+    pthread_t *worker_threads = NULL;
+    pthread_t writer_thread;
+    unsigned int worker_idx = 0;
+    char *map = NULL;
+    size_t map_size = 0;
+    char *map_start = NULL;
+    char *map_end = NULL;
+    boolean is_mapped = kFalse;
+    boolean is_eof = kFalse;
+    char *carry_buffer = NULL;
+    ssize_t carry_length = 0;
+    ssize_t chunk_limit = C2B_MAX_LINE_LENGTH_VALUE;
+    ssize_t grown_chunk_limit = 0;
+    ssize_t chunk_length = 0;
+    ssize_t bytes_read = 0;
+    ssize_t remainder_offset = 0;
+    c2b_context_t *context = NULL;
+    c2b_output_t scratch;
+
+#ifdef DEBUG
+    fprintf(stderr, "\t-> c2b_process_intermediate_bytes_by_chunks | reading from fd  (%02d) | writing to fd  (%02d) | threads [%u]\n", src_fd, dest_fd, c2b_globals.threads);
+#endif
+
+    c2b_init_chunk_queue(&queue, stage, C2B_CHUNKS_PER_THREAD * c2b_globals.threads);
+    queue.dest_fd = dest_fd;
+    queue.sorter = sorter;
+
+    worker_threads = malloc(c2b_globals.threads * sizeof(pthread_t));
+    if (!worker_threads) {
+        fprintf(stderr, "Error: Could not allocate space for worker thread handles\n");
+        c2b_print_usage(stderr);
+        exit(ENOMEM); /* Not enough space (POSIX.1) */
+    }
+    for (worker_idx = 0; worker_idx < c2b_globals.threads; worker_idx++) {
+        pthread_create(&worker_threads[worker_idx], NULL, c2b_convert_chunks, &queue);
+    }
+    pthread_create(&writer_thread, NULL, c2b_write_chunks, &queue);
+
+    context = malloc(sizeof(c2b_context_t));
+    if (!context) {
+        fprintf(stderr, "Error: Could not allocate space for chunk conversion context\n");
+        c2b_print_usage(stderr);
+        exit(ENOMEM); /* Not enough space (POSIX.1) */
+    }
+    c2b_init_context(context);
+    c2b_init_output(&scratch, -1, NULL);
+
+    /*
+       If stdin is a regular file, chunks are spans of the mapping; otherwise, each chunk 
+       owns a read buffer, and the partial line at the end of one read is carried over to
+       the start of the next chunk
+    */
+
+    if (stage->src == (unsigned int) -1)
+        is_mapped = c2b_map_input(src_fd, &map, &map_size, &map_start);
+    if (is_mapped) {
+        map_end = map + map_size;
+    }
+    else {
+        carry_buffer = c2b_resize_line_buffer(NULL, 0, chunk_limit);
+    }
+
+    while (!is_eof) {
+        pthread_mutex_lock(&queue.lock);
+        chunk = &queue.chunks[queue.next_fill % queue.num];
+        while (chunk->state != C2B_CHUNK_EMPTY) {
+            pthread_cond_wait(&queue.changed, &queue.lock);
+        }
+        pthread_mutex_unlock(&queue.lock);
+
+        /* 
+           Only whole lines go into the chunk; as with the single-threaded path, a final 
+           line without a trailing newline is not converted. A full chunk without a newline
+           holds the start of a line longer than chunk_limit, which is doubled until the 
+           line fits, and stays that size for the chunks that follow.
+        */
+
+        chunk_length = -1;
+        for (;;) {
+            if (is_mapped) {
+                chunk_length = ((map_end - map_start) < chunk_limit) ? (map_end - map_start) : chunk_limit;
+                is_eof = (map_start + chunk_length == map_end) ? kTrue : kFalse;
+                chunk->src = map_start;
+            }
+            else {
+                if (chunk->src_capacity < chunk_limit) {
+                    chunk->src_buffer = c2b_resize_line_buffer(chunk->src_buffer, chunk->src_capacity, chunk_limit);
+                    chunk->src_capacity = chunk_limit;
+                }
+                if (chunk_length == -1) {
+                    memcpy(chunk->src_buffer, carry_buffer, carry_length);
+                    chunk_length = carry_length;
+                }
+                while ((chunk_length < chunk_limit) && 
+                       ((bytes_read = c2b_timed_read(&c2b_globals.pipe->convert_stats, src_fd, chunk->src_buffer + chunk_length, chunk_limit - chunk_length)) > 0)) {
+                    chunk_length += bytes_read;
+                }
+                is_eof = (chunk_length < chunk_limit) ? kTrue : kFalse;
+                chunk->src = chunk->src_buffer;
+            }
+            c2b_memrchr_offset(&remainder_offset, chunk->src, chunk_limit, chunk_length, c2b_line_delim);
+            if ((remainder_offset != -1) || (chunk_length < chunk_limit))
+                break;
+            grown_chunk_limit = c2b_grow_line_capacity(chunk_limit);
+            if (!is_mapped)
+                carry_buffer = c2b_resize_line_buffer(carry_buffer, chunk_limit, grown_chunk_limit);
+            chunk_limit = grown_chunk_limit;
+        }
+        if (remainder_offset == -1)
+            break;
+        chunk->src_size = remainder_offset;
+        if (is_mapped) {
+            map_start += remainder_offset;
+            is_eof = (map_start == map_end) ? kTrue : kFalse;
+        }
+        else {
+            carry_length = chunk_length - remainder_offset;
+            memcpy(carry_buffer, chunk->src + remainder_offset, carry_length);
+        }
+
+        /* the chunk is converted from the context left by all earlier chunks */
+
+        memcpy(&chunk->context, context, sizeof(c2b_context_t));
+        c2b_advance_context(context, queue.line_functor, &scratch, chunk->src, chunk->src_size);
+
+        pthread_mutex_lock(&queue.lock);
+        chunk->state = C2B_CHUNK_FILLED;
+        queue.next_fill++;
+        pthread_cond_broadcast(&queue.changed);
+        pthread_mutex_unlock(&queue.lock);
+    }
+
+    pthread_mutex_lock(&queue.lock);
+    queue.is_done = kTrue;
+    pthread_cond_broadcast(&queue.changed);
+    pthread_mutex_unlock(&queue.lock);
+
+    for (worker_idx = 0; worker_idx < c2b_globals.threads; worker_idx++) {
+        pthread_join(worker_threads[worker_idx], (void **) NULL);
+    }
+    pthread_join(writer_thread, (void **) NULL);
+
+    if (is_mapped)
+        munmap(map, map_size);
+    if (carry_buffer)
+        free(carry_buffer), carry_buffer = NULL;
+    c2b_delete_output(&scratch);
+    free(context), context = NULL;
+    free(worker_threads), worker_threads = NULL;
+    c2b_delete_chunk_queue(&queue);
+}
+
+static void
+c2b_init_chunk_queue(c2b_chunk_queue_t *q, c2b_pipeline_stage_t *stage, const size_t num)
+{
+    size_t n;
+
+    q->chunks = malloc(num * sizeof(c2b_chunk_t));
+    if (!q->chunks) {
+        fprintf(stderr, "Error: Could not allocate space for chunk queue\n");
+        c2b_print_usage(stderr);
+        exit(ENOMEM); /* Not enough space (POSIX.1) */
+    }
+    for (n = 0; n < num; n++) {
+        q->chunks[n].src = NULL;
+        q->chunks[n].src_size = 0;
+        q->chunks[n].src_buffer = NULL;
+        q->chunks[n].src_capacity = 0;
+        c2b_init_output(&q->chunks[n].dest, -1, NULL);
+        q->chunks[n].state = C2B_CHUNK_EMPTY;
+        c2b_init_delim_index(&q->chunks[n].delims);
+    }
+    q->num = num;
+    q->next_fill = 0;
+    q->next_convert = 0;
+    q->next_write = 0;
+    q->is_done = kFalse;
+    q->line_functor = stage->line_functor;
+    q->dest_fd = -1;
+    q->sorter = NULL;
+    pthread_mutex_init(&q->lock, NULL);
+    pthread_cond_init(&q->changed, NULL);
+}
+
+static void
+c2b_delete_chunk_queue(c2b_chunk_queue_t *q)
+{
+    size_t n;
+
+    for (n = 0; n < q->num; n++) {
+        free(q->chunks[n].src_buffer), q->chunks[n].src_buffer = NULL;
+        c2b_delete_output(&q->chunks[n].dest);
+        c2b_delete_delim_index(&q->chunks[n].delims);
+    }
+    free(q->chunks), q->chunks = NULL;
+    q->num = 0;
+    pthread_mutex_destroy(&q->lock);
+    pthread_cond_destroy(&q->changed);
+}
+
+static void *
+c2b_convert_chunks(void *arg)
+{
+    c2b_chunk_queue_t *q = (c2b_chunk_queue_t *) arg;
+    c2b_chunk_t *chunk = NULL;
+    c2b_record_counts_t counts;
+    ssize_t line_offset = 0;
+    ssize_t line_end_offset = 0;
+
+    memset(&counts, 0, sizeof(c2b_record_counts_t));
+
+    for (;;) {
+        pthread_mutex_lock(&q->lock);
+        while ((q->next_convert == q->next_fill) && (!q->is_done)) {
+            pthread_cond_wait(&q->changed, &q->lock);
+        }
+        if (q->next_convert == q->next_fill) {
+            pthread_mutex_unlock(&q->lock);
+            break;
+        }
+        chunk = &q->chunks[q->next_convert++ % q->num];
+        pthread_mutex_unlock(&q->lock);
+
+        chunk->dest.size = 0;
+        c2b_index_delims(&chunk->delims, chunk->src, chunk->src_size);
+        chunk->context.delims = &chunk->delims;
+        memset(&chunk->context.counts, 0, sizeof(c2b_record_counts_t));
+        line_offset = 0;
+        while ((line_end_offset = c2b_next_delim(chunk->delims.line_bits, line_offset, chunk->src_size)) != -1) {
+            (*q->line_functor)(&chunk->context, &chunk->dest, chunk->src + line_offset, line_end_offset - line_offset);
+            chunk->context.counts.lines++;
+            line_offset = line_end_offset + 1;
+        }
+        counts.lines += chunk->context.counts.lines;
+        counts.unmapped_reads += chunk->context.counts.unmapped_reads;
+        counts.filtered_reads += chunk->context.counts.filtered_reads;
+        counts.filtered_alleles += chunk->context.counts.filtered_alleles;
+        counts.unpaired_reads += chunk->context.counts.unpaired_reads;
+        counts.orphan_reads += chunk->context.counts.orphan_reads;
+
+        pthread_mutex_lock(&q->lock);
+        chunk->state = C2B_CHUNK_CONVERTED;
+        pthread_cond_broadcast(&q->changed);
+        pthread_mutex_unlock(&q->lock);
+    }
+
+    c2b_add_record_counts(&counts);
+    pthread_exit(NULL);
+}
+
+static void *
+c2b_write_chunks(void *arg)
+{
+    c2b_chunk_queue_t *q = (c2b_chunk_queue_t *) arg;
+    c2b_chunk_t *chunk = NULL;
+
+    for (;;) {
+        pthread_mutex_lock(&q->lock);
+        chunk = &q->chunks[q->next_write % q->num];
+        while ((chunk->state != C2B_CHUNK_CONVERTED) && !((q->is_done) && (q->next_write == q->next_fill))) {
+            pthread_cond_wait(&q->changed, &q->lock);
+        }
+        if (chunk->state != C2B_CHUNK_CONVERTED) {
+            pthread_mutex_unlock(&q->lock);
+            break;
+        }
+        pthread_mutex_unlock(&q->lock);
+
+        c2b_write_converted_bytes(q->dest_fd, q->sorter, chunk->dest.buf, chunk->dest.size);
+
+        pthread_mutex_lock(&q->lock);
+        chunk->state = C2B_CHUNK_EMPTY;
+        q->next_write++;
+        pthread_cond_broadcast(&q->changed);
+        pthread_mutex_unlock(&q->lock);
+    }
+
+    pthread_exit(NULL);
+}
+
+static void
+c2b_init_sorter(c2b_sorter_t *s)
+{
+    s->records = NULL;
+    s->num_records = 0;
+    s->records_capacity = 0;
+    s->blocks = NULL;
+    s->num_blocks = 0;
+    s->blocks_capacity = 0;
+    s->block_size = 0;
+    s->block_capacity = 0;
+    s->chroms = NULL;
+    s->num_chroms = 0;
+    s->chroms_capacity = 0;
+    s->chrom_slots = NULL;
+    s->chrom_slots_capacity = 0;
+    s->last_chrom = 0;
+    s->chroms_by_rank = NULL;
+    s->memory = C2B_SORT_IO_BUFFER_SIZE;
+    s->max_memory = c2b_globals.sort->max_mem;
+    s->peak_memory = 0;
+    s->total_records = 0;
+    s->run_fd = -1;
+    s->run_file_size = 0;
+    s->runs = NULL;
+    s->num_runs = 0;
+    s->runs_capacity = 0;
+    s->starch = NULL;
+}
+
+static void
+c2b_delete_sorter(c2b_sorter_t *s)
+{
+    size_t n;
+    uint32_t c;
+
+    for (n = 0; n < s->num_blocks; n++) {
+        free(s->blocks[n]), s->blocks[n] = NULL;
+    }
+    for (c = 0; c < s->num_chroms; c++) {
+        free(s->chroms[c].name), s->chroms[c].name = NULL;
+    }
+    if (s->blocks)
+        free(s->blocks), s->blocks = NULL;
+    if (s->records)
+        free(s->records), s->records = NULL;
+    if (s->chroms)
+        free(s->chroms), s->chroms = NULL;
+    if (s->chrom_slots)
+        free(s->chrom_slots), s->chrom_slots = NULL;
+    if (s->chroms_by_rank)
+        free(s->chroms_by_rank), s->chroms_by_rank = NULL;
+    if (s->runs)
+        free(s->runs), s->runs = NULL;
+    if (s->run_fd != -1)
+        close(s->run_fd), s->run_fd = -1;
+    s->num_blocks = 0;
+    s->num_records = 0;
+    s->num_chroms = 0;
+    s->num_runs = 0;
+    s->memory = 0;
+}
+
+static void
+c2b_add_sort_block(c2b_sorter_t *s, size_t size)
+{
+    char **blocks = NULL;
+    size_t default_size = C2B_SORT_BLOCK_SIZE;
+    size_t block_capacity = 0;
+
+    /* blocks are kept small enough that several fit in the memory budget */
+
+    if (s->max_memory / 4 < default_size)
+        default_size = (size_t) (s->max_memory / 4);
+    block_capacity = (size > default_size) ? size : default_size;
+
+    /* the records held are spilled first, if the new block would take us past the budget */
+
+    if (s->memory + block_capacity > s->max_memory)
+        c2b_spill_sort_records(s);
+
+    if (s->num_blocks == s->blocks_capacity) {
+        s->blocks_capacity = (s->blocks_capacity == 0) ? 16 : (2 * s->blocks_capacity);
+        blocks = realloc(s->blocks, s->blocks_capacity * sizeof(char *));
+        if (!blocks) {
+            fprintf(stderr, "Error: Could not allocate space for sort block list\n");
+            c2b_print_usage(stderr);
+            exit(ENOMEM); /* Not enough space (POSIX.1) */
+        }
+        s->blocks = blocks;
+    }
+    s->block_capacity = block_capacity;
+    s->blocks[s->num_blocks] = malloc(s->block_capacity);
+    if (!s->blocks[s->num_blocks]) {
+        fprintf(stderr, "Error: Could not allocate space for sort block\n");
+        c2b_print_usage(stderr);
+        exit(ENOMEM); /* Not enough space (POSIX.1) */
+    }
+    s->num_blocks++;
+    s->block_size = 0;
+    s->memory += s->block_capacity;
+}
+
+static void
+c2b_add_sort_records(c2b_sorter_t *s, char *src, ssize_t src_size)
+{
+    char *block = NULL;
+    char *line_start = NULL;
+    char *line_end = NULL;
+    char *block_end = NULL;
+    char *field_end = NULL;
+    c2b_sort_record_t *records = NULL;
+    c2b_sort_record_t *record = NULL;
+    size_t records_capacity = 0;
+    size_t total_records = s->total_records;
+
+    if (src_size <= 0)
+        return;
+
+    /* converted text is copied once, into the current block, and records point into it */
+
+    if ((s->num_blocks == 0) || (s->block_capacity - s->block_size < (size_t) src_size))
+        c2b_add_sort_block(s, (size_t) src_size);
+    block = s->blocks[s->num_blocks - 1] + s->block_size;
+    memcpy(block, src, src_size);
+    s->block_size += src_size;
+
+    line_start = block;
+    block_end = block + src_size;
+    while ((line_end = memchr(line_start, c2b_line_delim, (size_t) (block_end - line_start))) != NULL) {
+        if (s->num_records == s->records_capacity) {
+            records_capacity = (s->records_capacity == 0) ? 65536 : (2 * s->records_capacity);
+            records = realloc(s->records, records_capacity * sizeof(c2b_sort_record_t));
+            if (!records) {
+                fprintf(stderr, "Error: Could not allocate space for sort records\n");
+                c2b_print_usage(stderr);
+                exit(ENOMEM); /* Not enough space (POSIX.1) */
+            }
+            s->memory += 2 * (records_capacity - s->records_capacity) * sizeof(c2b_sort_record_t);
+            s->records = records;
+            s->records_capacity = records_capacity;
+        }
+        record = &s->records[s->num_records++];
+        record->line = line_start;
+        record->length = (uint32_t) (line_end - line_start + 1);
+        field_end = memchr(line_start, c2b_tab_delim, (size_t) (line_end - line_start));
+        if (!field_end) {
+            fprintf(stderr, "Error: Converted BED line has no start or stop coordinate; cannot sort\n");
+            c2b_print_usage(stderr);
+            exit(EINVAL); /* Invalid argument (POSIX.1) */
+        }
+        record->chrom = c2b_sort_chrom_id(s, line_start, (size_t) (field_end - line_start));
+        field_end = c2b_parse_sort_coordinate(field_end + 1, line_end, &record->start);
+        if (field_end == line_end) {
+            fprintf(stderr, "Error: Converted BED line has no stop coordinate; cannot sort\n");
+            c2b_print_usage(stderr);
+            exit(EINVAL); /* Invalid argument (POSIX.1) */
+        }
+        c2b_parse_sort_coordinate(field_end + 1, line_end, &record->stop);
+        line_start = line_end + 1;
+        s->total_records++;
+    }
+
+    if (s->memory > s->peak_memory)
+        s->peak_memory = s->memory;
+
+    /* we also spill if another buffer of as many lines would double the index past the budget */
+
+    if ((s->memory > s->max_memory) || 
+        ((s->num_records + (s->total_records - total_records) > s->records_capacity) && 
+         (s->memory + 2 * s->records_capacity * sizeof(c2b_sort_record_t) > s->max_memory)))
+        c2b_spill_sort_records(s);
+}
+
+static inline char *
+c2b_parse_sort_coordinate(char *s, char *end, uint64_t *val)
+{
+    char *p = s;
+    uint64_t v = 0;
+
+    while ((p < end) && (*p >= '0') && (*p <= '9')) {
+        v = (v * 10) + (uint64_t) (*p++ - '0');
+    }
+    if ((p == s) || ((p < end) && (*p != c2b_tab_delim))) {
+        fprintf(stderr, "Error: Converted BED line has an invalid coordinate; cannot sort\n");
+        c2b_print_usage(stderr);
+        exit(EINVAL); /* Invalid argument (POSIX.1) */
+    }
+    *val = v;
+
+    return p;
+}
+
+static uint32_t
+c2b_sort_chrom_id(c2b_sorter_t *s, char *name, size_t length)
+{
+    c2b_sort_chrom_t *chroms = NULL;
+    c2b_sort_chrom_t *chrom = NULL;
+    uint32_t *slots = NULL;
+    uint32_t mask = 0;
+    uint32_t idx = 0;
+    uint32_t c = 0;
+    uint32_t hash = 2166136261U;
+    size_t n;
+
+    /* converted lines tend to arrive in runs on one chromosome */
+
+    if ((s->num_chroms > 0) && 
+        (s->chroms[s->last_chrom].length == length) && 
+        (memcmp(s->chroms[s->last_chrom].name, name, length) == 0))
+        return s->last_chrom;
+
+    /* otherwise, we look the name up in an open-addressed (FNV-1a) hash table, grown at half load */
+
+    if (2 * (s->num_chroms + 1) > s->chrom_slots_capacity) {
+        s->chrom_slots_capacity = (s->chrom_slots_capacity == 0) ? 64 : (2 * s->chrom_slots_capacity);
+        slots = calloc(s->chrom_slots_capacity, sizeof(uint32_t));
+        if (!slots) {
+            fprintf(stderr, "Error: Could not allocate space for sort chromosome table\n");
+            c2b_print_usage(stderr);
+            exit(ENOMEM); /* Not enough space (POSIX.1) */
+        }
+        mask = s->chrom_slots_capacity - 1;
+        for (c = 0; c < s->num_chroms; c++) {
+            hash = 2166136261U;
+            for (n = 0; n < s->chroms[c].length; n++)
+                hash = (hash ^ (unsigned char) s->chroms[c].name[n]) * 16777619U;
+            idx = hash & mask;
+            while (slots[idx])
+                idx = (idx + 1) & mask;
+            slots[idx] = c + 1;
+        }
+        if (s->chrom_slots)
+            free(s->chrom_slots);
+        s->chrom_slots = slots;
+    }
+
+    mask = s->chrom_slots_capacity - 1;
+    hash = 2166136261U;
+    for (n = 0; n < length; n++)
+        hash = (hash ^ (unsigned char) name[n]) * 16777619U;
+    idx = hash & mask;
+    while (s->chrom_slots[idx]) {
+        chrom = &s->chroms[s->chrom_slots[idx] - 1];
+        if ((chrom->length == length) && (memcmp(chrom->name, name, length) == 0)) {
+            s->last_chrom = s->chrom_slots[idx] - 1;
+            return s->last_chrom;
+        }
+        idx = (idx + 1) & mask;
+    }
+
+    if (s->num_chroms == s->chroms_capacity) {
+        s->chroms_capacity = (s->chroms_capacity == 0) ? 64 : (2 * s->chroms_capacity);
+        chroms = realloc(s->chroms, s->chroms_capacity * sizeof(c2b_sort_chrom_t));
+        if (!chroms) {
+            fprintf(stderr, "Error: Could not allocate space for sort chromosome names\n");
+            c2b_print_usage(stderr);
+            exit(ENOMEM); /* Not enough space (POSIX.1) */
+        }
+        s->chroms = chroms;
+    }
+    chrom = &s->chroms[s->num_chroms];
+    chrom->name = malloc(length + 1);
+    if (!chrom->name) {
+        fprintf(stderr, "Error: Could not allocate space for sort chromosome name\n");
+        c2b_print_usage(stderr);
+        exit(ENOMEM); /* Not enough space (POSIX.1) */
+    }
+    memcpy(chrom->name, name, length);
+    chrom->name[length] = '\0';
+    chrom->length = length;
+    chrom->rank = 0;
+    s->chrom_slots[idx] = s->num_chroms + 1;
+    s->last_chrom = s->num_chroms++;
+
+    return s->last_chrom;
+}
+
+static int
+c2b_compare_sort_chroms(const void *a, const void *b)
+{
+    return strcmp((*(c2b_sort_chrom_t * const *) a)->name, (*(c2b_sort_chrom_t * const *) b)->name);
+}
+
+static inline int
+c2b_compare_sort_records(const c2b_sort_record_t *a, const c2b_sort_record_t *b)
+{
+    uint32_t length = 0;
+    int result = 0;
+
+    if (a->chrom != b->chrom)
+        return (a->chrom < b->chrom) ? -1 : 1;
+    if (a->start != b->start)
+        return (a->start < b->start) ? -1 : 1;
+    if (a->stop != b->stop)
+        return (a->stop < b->stop) ? -1 : 1;
+
+    /* records with equal keys are ordered on their text, less the newline */
+
+    length = (a->length < b->length) ? a->length : b->length;
+    if ((result = memcmp(a->line, b->line, length - 1)) != 0)
+        return result;
+    return (a->length < b->length) ? -1 : ((a->length > b->length) ? 1 : 0);
+}
+
+static void
+c2b_merge_sort_records(c2b_sort_record_t *records, c2b_sort_record_t *buffer, size_t num)
+{
+    c2b_sort_record_t record;
+    size_t half = num / 2;
+    size_t i;
+    size_t j;
+
+    if (num <= C2B_SORT_INSERTION_THRESHOLD) {
+        for (i = 1; i < num; i++) {
+            record = records[i];
+            for (j = i; (j > 0) && (c2b_compare_sort_records(&record, &records[j - 1]) < 0); j--)
+                records[j] = records[j - 1];
+            records[j] = record;
+        }
+        return;
+    }
+
+    c2b_merge_sort_records(records, buffer, half);
+    c2b_merge_sort_records(records + half, buffer + half, num - half);
+    c2b_merge_sort_runs(records, buffer, 0, half, num);
+}
+
+static void
+c2b_merge_sort_runs(c2b_sort_record_t *records, c2b_sort_record_t *buffer, size_t start, size_t middle, size_t end)
+{
+    size_t i = start;
+    size_t j = middle;
+    size_t k = start;
+
+    /* nothing to do if the runs are already in order, as with input that was sorted to begin with */
+
+    if ((middle == start) || (middle == end) || (c2b_compare_sort_records(&records[middle - 1], &records[middle]) <= 0))
+        return;
+
+    while ((i < middle) && (j < end)) {
+        if (c2b_compare_sort_records(&records[j], &records[i]) < 0)
+            buffer[k++] = records[j++];
+        else
+            buffer[k++] = records[i++];
+    }
+    while (i < middle)
+        buffer[k++] = records[i++];
+    while (j < end)
+        buffer[k++] = records[j++];
+    memcpy(records + start, buffer + start, (end - start) * sizeof(c2b_sort_record_t));
+}
+
+static void *
+c2b_sort_slice(void *arg)
+{
+    c2b_sort_task_t *task = (c2b_sort_task_t *) arg;
+
+    c2b_merge_sort_records(task->records + task->start, task->buffer + task->start, task->end - task->start);
+
+    pthread_exit(NULL);
+}
+
+static void *
+c2b_merge_slices(void *arg)
+{
+    c2b_sort_task_t *task = (c2b_sort_task_t *) arg;
+
+    c2b_merge_sort_runs(task->records, task->buffer, task->start, task->middle, task->end);
+
+    pthread_exit(NULL);
+}
+
+static void
+c2b_rank_sort_chroms(c2b_sorter_t *s)
+{
+    c2b_sort_chrom_t **chroms_by_rank = NULL;
+    uint32_t c;
+
+    /* rank chromosome names lexicographically; ranks are redone as names are added */
+
+    chroms_by_rank = realloc(s->chroms_by_rank, (s->num_chroms + 1) * sizeof(c2b_sort_chrom_t *));
+    if (!chroms_by_rank) {
+        fprintf(stderr, "Error: Could not allocate space for sort chromosome order\n");
+        c2b_print_usage(stderr);
+        exit(ENOMEM); /* Not enough space (POSIX.1) */
+    }
+    s->chroms_by_rank = chroms_by_rank;
+    for (c = 0; c < s->num_chroms; c++)
+        s->chroms_by_rank[c] = &s->chroms[c];
+    qsort(s->chroms_by_rank, s->num_chroms, sizeof(c2b_sort_chrom_t *), c2b_compare_sort_chroms);
+    for (c = 0; c < s->num_chroms; c++)
+        s->chroms_by_rank[c]->rank = c;
+}
+
+static void
+c2b_sort_records(c2b_sorter_t *s)
+{
+    c2b_sort_record_t *buffer = NULL;
+    c2b_sort_task_t *tasks = NULL;
+    pthread_t *sort_threads = NULL;
+    size_t *bounds = NULL;
+    size_t num_slices = c2b_globals.threads;
+    size_t num_tasks = 0;
+    size_t n;
+
+#ifdef DEBUG
+    fprintf(stderr, "\t-> c2b_sort_records | records [%zu] | chromosomes [%u] | blocks [%zu]\n", s->num_records, s->num_chroms, s->num_blocks);
+#endif
+
+    c2b_rank_sort_chroms(s);
+
+    if (s->num_records == 0)
+        return;
+
+    /* key each record on its chromosome's rank */
+
+    for (n = 0; n < s->num_records; n++)
+        s->records[n].chrom = s->chroms[s->records[n].chrom].rank;
+
+    /* each slice should be large enough to be worth a thread */
+
+    if (num_slices > s->num_records / C2B_SORT_MIN_RECORDS_PER_THREAD)
+        num_slices = s->num_records / C2B_SORT_MIN_RECORDS_PER_THREAD;
+    if (num_slices < 1)
+        num_slices = 1;
+
+    buffer = malloc(s->num_records * sizeof(c2b_sort_record_t));
+    tasks = malloc(num_slices * sizeof(c2b_sort_task_t));
+    sort_threads = malloc(num_slices * sizeof(pthread_t));
+    bounds = malloc((num_slices + 1) * sizeof(size_t));
+    if ((!buffer) || (!tasks) || (!sort_threads) || (!bounds)) {
+        fprintf(stderr, "Error: Could not allocate space for sort buffers\n");
+        c2b_print_usage(stderr);
+        exit(ENOMEM); /* Not enough space (POSIX.1) */
+    }
+
+    for (n = 0; n <= num_slices; n++)
+        bounds[n] = (s->num_records / num_slices) * n + ((n == num_slices) ? (s->num_records % num_slices) : 0);
+
+    if (num_slices == 1) {
+        c2b_merge_sort_records(s->records, buffer, s->num_records);
+    }
+    else {
+        for (n = 0; n < num_slices; n++) {
+            tasks[n].records = s->records;
+            tasks[n].buffer = buffer;
+            tasks[n].start = bounds[n];
+            tasks[n].middle = bounds[n];
+            tasks[n].end = bounds[n + 1];
+            pthread_create(&sort_threads[n], NULL, c2b_sort_slice, &tasks[n]);
+        }
+        for (n = 0; n < num_slices; n++)
+            pthread_join(sort_threads[n], (void **) NULL);
+
+        /* merge neighbouring runs in pairs, each pair on its own thread, until one run is left */
+
+        while (num_slices > 1) {
+            num_tasks = 0;
+            for (n = 0; n + 1 < num_slices; n += 2) {
+                tasks[num_tasks].records = s->records;
+                tasks[num_tasks].buffer = buffer;
+                tasks[num_tasks].start = bounds[n];
+                tasks[num_tasks].middle = bounds[n + 1];
+                tasks[num_tasks].end = bounds[n + 2];
+                pthread_create(&sort_threads[num_tasks], NULL, c2b_merge_slices, &tasks[num_tasks]);
+                num_tasks++;
+            }
+            for (n = 0; n < num_tasks; n++)
+                pthread_join(sort_threads[n], (void **) NULL);
+            for (n = 0; n <= num_slices; n += 2)
+                bounds[n / 2] = bounds[n];
+            if (num_slices % 2)
+                bounds[(num_slices + 1) / 2] = bounds[num_slices];
+            num_slices = (num_slices + 1) / 2;
+        }
+    }
+
+    free(bounds), bounds = NULL;
+    free(sort_threads), sort_threads = NULL;
+    free(tasks), tasks = NULL;
+    free(buffer), buffer = NULL;
+}
+
+static void
+c2b_write_sorted_records(c2b_sorter_t *s, int dest_fd)
+{
+    char *dest_buffer = NULL;
+    size_t dest_buffer_size = C2B_SORT_IO_BUFFER_SIZE;
+    size_t dest_bytes_written = 0;
+    c2b_sort_record_t *record = NULL;
+    c2b_sort_chrom_t *chrom = NULL;
+    double merge_start = c2b_seconds();
+    size_t n;
+
+    if (s->num_runs > 0) {
+        c2b_merge_sorted_runs(s, dest_fd);
+    }
+    else {
+        dest_buffer = malloc(dest_buffer_size);
+        if (!dest_buffer) {
+            fprintf(stderr, "Error: Could not allocate space for sorted output buffer\n");
+            c2b_print_usage(stderr);
+            exit(ENOMEM); /* Not enough space (POSIX.1) */
+        }
+        for (n = 0; n < s->num_records; n++) {
+            record = &s->records[n];
+            if (s->starch) {
+                chrom = s->chroms_by_rank[record->chrom];
+                c2b_add_starch_record(s->starch, chrom, record->start, record->stop, record->line + chrom->length, record->length - (uint32_t) chrom->length);
+                continue;
+            }
+            if (dest_bytes_written + record->length > dest_buffer_size) {
+                c2b_write_sort_bytes(dest_fd, dest_buffer, dest_bytes_written);
+                dest_bytes_written = 0;
+            }
+            memcpy(dest_buffer + dest_bytes_written, record->line, record->length);
+            dest_bytes_written += record->length;
+        }
+        c2b_write_sort_bytes(dest_fd, dest_buffer, dest_bytes_written);
+        free(dest_buffer), dest_buffer = NULL;
+    }
+
+    if (c2b_globals.stats->is_enabled)
+        c2b_keep_sort_stats(s, c2b_seconds() - merge_start);
+}
+
+static void
+c2b_keep_sort_stats(c2b_sorter_t *s, double write_seconds)
+{
+    c2b_stats_params_t *st = c2b_globals.stats;
+
+    /* runs are copied out, as the sorter is deleted before the report is written */
+
+    if (s->num_runs > 0) {
+        st->sort_runs = malloc(s->num_runs * sizeof(c2b_sort_run_t));
+        if (!st->sort_runs) {
+            fprintf(stderr, "Error: Could not allocate space for sort run stats\n");
+            c2b_print_usage(stderr);
+            exit(ENOMEM); /* Not enough space (POSIX.1) */
+        }
+        memcpy(st->sort_runs, s->runs, s->num_runs * sizeof(c2b_sort_run_t));
+    }
+    st->num_sort_runs = s->num_runs;
+    st->sort_run_file_size = s->run_file_size;
+    st->sort_max_memory = s->max_memory;
+    st->sort_peak_memory = s->peak_memory;
+    st->sort_write_seconds = write_seconds;
+}
+
+static inline double
+c2b_seconds()
+{
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    return (double) now.tv_sec + (double) now.tv_nsec / 1e9;
+}
+
+static void
+c2b_write_sort_bytes(int fd, char *buffer, size_t size)
+{
+    ssize_t bytes_written = 0;
+    int errsv = 0;
+
+    /* run files are written to disk, so only writes to standard output count as pipe waits */
+
+    while (size > 0) {
+        bytes_written = c2b_timed_write((fd == STDOUT_FILENO) ? &c2b_globals.pipe->sort_stats : NULL, fd, buffer, size);
+        if (bytes_written == -1) {
+            errsv = errno;
+            if (errsv == EINTR)
+                continue;
+            fprintf(stderr, "Error: Could not write sorted data (%s)\n", strerror(errsv));
+            exit(errsv);
+        }
+        buffer += bytes_written;
+        size -= (size_t) bytes_written;
+    }
+}
+
+static void
+c2b_open_sort_run_file(c2b_sorter_t *s)
+{
+    s->run_fd = c2b_open_tmp_file("sort run");
+}
+
+static int
+c2b_open_tmp_file(const char *description)
+{
+    const char *tmpdir = c2b_globals.sort->sort_tmpdir_path;
+    char *path = NULL;
+    int fd = -1;
+    int errsv = 0;
+
+    if (!tmpdir)
+        tmpdir = getenv("TMPDIR");
+    if ((!tmpdir) || (strlen(tmpdir) == 0))
+        tmpdir = "/tmp";
+
+    path = malloc(strlen(tmpdir) + strlen(c2b_sort_run_file_template) + 2);
+    if (!path) {
+        fprintf(stderr, "Error: Could not allocate space for %s file path\n", description);
+        c2b_print_usage(stderr);
+        exit(ENOMEM); /* Not enough space (POSIX.1) */
+    }
+    sprintf(path, "%s/%s", tmpdir, c2b_sort_run_file_template);
+
+    /* the file is unlinked at once, so that it goes away however we exit */
+
+    fd = mkstemp(path);
+    if (fd == -1) {
+        errsv = errno;
+        fprintf(stderr, "Error: Could not create %s file in [%s] (%s)\n", description, tmpdir, strerror(errsv));
+        c2b_print_usage(stderr);
+        exit(errsv);
+    }
+    unlink(path);
+    free(path), path = NULL;
+
+    return fd;
+}
+
+static void
+c2b_spill_sort_records(c2b_sorter_t *s)
+{
+    char *run_buffer = NULL;
+    size_t run_buffer_size = C2B_SORT_IO_BUFFER_SIZE;
+    size_t run_bytes_written = 0;
+    c2b_sort_record_t *record = NULL;
+    c2b_sort_run_record_t header;
+    c2b_sort_run_t *runs = NULL;
+    c2b_sort_run_t *run = NULL;
+    c2b_sort_chrom_t *chrom = NULL;
+    double sort_start = 0;
+    double write_start = 0;
+    size_t n;
+
+    if (s->num_records == 0)
+        return;
+
+    if (s->num_runs == s->runs_capacity) {
+        s->runs_capacity = (s->runs_capacity == 0) ? 16 : (2 * s->runs_capacity);
+        runs = realloc(s->runs, s->runs_capacity * sizeof(c2b_sort_run_t));
+        if (!runs) {
+            fprintf(stderr, "Error: Could not allocate space for sort run list\n");
+            c2b_print_usage(stderr);
+            exit(ENOMEM); /* Not enough space (POSIX.1) */
+        }
+        s->runs = runs;
+    }
+    if (s->run_fd == -1)
+        c2b_open_sort_run_file(s);
+
+    run = &s->runs[s->num_runs++];
+    run->offset = s->run_file_size;
+    run->num_records = s->num_records;
+    run->memory = s->memory;
+
+    sort_start = c2b_seconds();
+    c2b_sort_records(s);
+    write_start = c2b_seconds();
+    run->sort_seconds = write_start - sort_start;
+
+    run_buffer = malloc(run_buffer_size);
+    if (!run_buffer) {
+        fprintf(stderr, "Error: Could not allocate space for sort run buffer\n");
+        c2b_print_usage(stderr);
+        exit(ENOMEM); /* Not enough space (POSIX.1) */
+    }
+
+    /* records are written by chromosome id, as ranks change when names are added */
+
+    for (n = 0; n < s->num_records; n++) {
+        record = &s->records[n];
+        chrom = s->chroms_by_rank[record->chrom];
+        header.chrom = (uint32_t) (chrom - s->chroms);
+        header.length = record->length - (uint32_t) chrom->length;
+        header.start = record->start;
+        header.stop = record->stop;
+        if (run_bytes_written + sizeof(header) + header.length > run_buffer_size) {
+            c2b_write_sort_bytes(s->run_fd, run_buffer, run_bytes_written);
+            run_bytes_written = 0;
+        }
+        if (sizeof(header) + header.length > run_buffer_size) {
+            c2b_write_sort_bytes(s->run_fd, (char *) &header, sizeof(header));
+            c2b_write_sort_bytes(s->run_fd, record->line + chrom->length, header.length);
+        }
+        else {
+            memcpy(run_buffer + run_bytes_written, &header, sizeof(header));
+            memcpy(run_buffer + run_bytes_written + sizeof(header), record->line + chrom->length, header.length);
+            run_bytes_written += sizeof(header) + header.length;
+        }
+        s->run_file_size += sizeof(header) + header.length;
+    }
+    c2b_write_sort_bytes(s->run_fd, run_buffer, run_bytes_written);
+    free(run_buffer), run_buffer = NULL;
+
+    run->size = s->run_file_size - run->offset;
+    run->write_seconds = c2b_seconds() - write_start;
+
+    /* release the text blocks; the record index is kept for the next run */
+
+    for (n = 0; n < s->num_blocks; n++) {
+        free(s->blocks[n]), s->blocks[n] = NULL;
+    }
+    s->num_blocks = 0;
+    s->block_size = 0;
+    s->block_capacity = 0;
+    s->num_records = 0;
+    s->memory = C2B_SORT_IO_BUFFER_SIZE + 2 * s->records_capacity * sizeof(c2b_sort_record_t);
+}
+
+static boolean
+c2b_fill_sort_source(c2b_sorter_t *s, c2b_sort_source_t *src, size_t size)
+{
+    char *buffer = NULL;
+    off_t run_end = src->run->offset + src->run->size;
+    size_t buffered = src->buffer_end - src->buffer_start;
+    size_t request = 0;
+    ssize_t bytes_read = 0;
+    int errsv = 0;
+
+    if (buffered >= size)
+        return kTrue;
+
+    /* keep what is left of the buffer, growing it if one record will not fit */
+
+    memmove(src->buffer, src->buffer + src->buffer_start, buffered);
+    src->buffer_start = 0;
+    src->buffer_end = buffered;
+    if (size > src->buffer_capacity) {
+        buffer = realloc(src->buffer, size);
+        if (!buffer) {
+            fprintf(stderr, "Error: Could not allocate space for sort run buffer\n");
+            c2b_print_usage(stderr);
+            exit(ENOMEM); /* Not enough space (POSIX.1) */
         }
-    }
-    else if ((strncmp(src, c2b_wig_track_prefix, strlen(c2b_wig_track_prefix)) == 0) || 
-             (strncmp(src, c2b_wig_browser_prefix, strlen(c2b_wig_browser_prefix)) == 0)) {
-        if (c2b_globals.wig->start_write) {
-            c2b_globals.wig->start_write = kFalse;
-            sprintf(c2b_globals.wig->id,
-                    "%s.%u",
-                    c2b_globals.wig->basename,
-                    ++c2b_globals.wig->section);
+        src->buffer = buffer;
+        src->buffer_capacity = size;
+    }
+
+    while ((src->buffer_end < size) && (src->offset < run_end)) {
+        request = src->buffer_capacity - src->buffer_end;
+        if ((off_t) request > run_end - src->offset)
+            request = (size_t) (run_end - src->offset);
+        bytes_read = pread(s->run_fd, src->buffer + src->buffer_end, request, src->offset);
+        if (bytes_read <= 0) {
+            errsv = (bytes_read == 0) ? EIO : errno;
+            if (errsv == EINTR)
+                continue;
+            fprintf(stderr, "Error: Could not read sort run file (%s)\n", strerror(errsv));
+            exit(errsv);
         }
-        if (c2b_globals.keep_header_flag) { 
-            /* copy header line to destination stream buffer */
-            memcpy(src_line_str, src, src_size);
-            src_line_str[src_size] = '\0';
-            if (!c2b_globals.wig->basename) {
-                sprintf(dest_line_str, 
-                        "%s\t%u\t%u\t%s\n", 
-                        c2b_header_chr_name, 
-                        c2b_globals.header_line_idx, 
-                        c2b_globals.header_line_idx + 1, 
-                        src_line_str);
-            }
-            else {
-                sprintf(dest_line_str, 
-                        "%s\t%u\t%u\t%s\t%s\n", 
-                        c2b_header_chr_name, 
-                        c2b_globals.header_line_idx, 
-                        c2b_globals.header_line_idx + 1, 
-                        c2b_globals.wig->id,
-                        src_line_str);
-            }
-            memcpy(dest + *dest_size, dest_line_str, strlen(dest_line_str));
-            *dest_size += strlen(dest_line_str);
-            c2b_globals.header_line_idx++;
+        src->buffer_end += (size_t) bytes_read;
+        src->offset += bytes_read;
+    }
+
+    return (src->buffer_end >= size) ? kTrue : kFalse;
+}
+
+static void
+c2b_next_sort_source_record(c2b_sorter_t *s, c2b_sort_source_t *src)
+{
+    c2b_sort_record_t *record = NULL;
+    c2b_sort_run_record_t header;
+    size_t name_length = 0;
+
+    if (!src->run) {
+        if (src->index == s->num_records) {
+            src->is_exhausted = kTrue;
             return;
         }
-        else {
-            return;
-        }        
+        record = &s->records[src->index++];
+        name_length = s->chroms_by_rank[record->chrom]->length;
+        src->chrom = record->chrom;
+        src->start = record->start;
+        src->stop = record->stop;
+        src->rest = record->line + name_length;
+        src->rest_length = record->length - (uint32_t) name_length;
+        return;
     }
-    else if (strncmp(src, c2b_wig_variable_step_prefix, strlen(c2b_wig_variable_step_prefix)) == 0) {
-        memcpy(src_line_str, src, src_size);
-        src_line_str[src_size] = '\0';
-        int variable_step_fields = sscanf(src_line_str, 
-                                          "variableStep chrom=%s span=%" SCNu64 "\n", 
-                                          c2b_globals.wig->chr, 
-                                          &(c2b_globals.wig->span));
-        if (variable_step_fields < 1) {
-            fprintf(stderr, "Error: Invalid variableStep header on line %u\n", c2b_globals.wig->line);
-            exit(EINVAL); /* Invalid argument (POSIX.1) */
+
+    if (!c2b_fill_sort_source(s, src, sizeof(header))) {
+        if (src->buffer_end != src->buffer_start) {
+            fprintf(stderr, "Error: Sort run file is truncated\n");
+            exit(EIO); /* I/O error (POSIX.1) */
         }
-        if (variable_step_fields == 1)
-            c2b_globals.wig->span = 1;
-        c2b_globals.wig->is_fixed_step = kFalse;
-        if (c2b_globals.wig->start_write) {
-            c2b_globals.wig->start_write = kFalse;
-            sprintf(c2b_globals.wig->id,
-                    "%s.%u",
-                    c2b_globals.wig->basename,
-                    ++c2b_globals.wig->section);
+        src->is_exhausted = kTrue;
+        return;
+    }
+    memcpy(&header, src->buffer + src->buffer_start, sizeof(header));
+    if (!c2b_fill_sort_source(s, src, sizeof(header) + header.length)) {
+        fprintf(stderr, "Error: Sort run file is truncated\n");
+        exit(EIO); /* I/O error (POSIX.1) */
+    }
+    src->chrom = s->chroms[header.chrom].rank;
+    src->start = header.start;
+    src->stop = header.stop;
+    src->rest = src->buffer + src->buffer_start + sizeof(header);
+    src->rest_length = header.length;
+    src->buffer_start += sizeof(header) + header.length;
+}
+
+static inline boolean
+c2b_sort_source_precedes(c2b_sort_source_t *sources, size_t num_sources, size_t a, size_t b)
+{
+    c2b_sort_source_t *x = NULL;
+    c2b_sort_source_t *y = NULL;
+    uint32_t length = 0;
+    int result = 0;
+
+    /* index num_sources stands for a source that precedes all others, and fills the tree at start */
+
+    if (a == num_sources)
+        return kTrue;
+    if (b == num_sources)
+        return kFalse;
+    x = &sources[a];
+    y = &sources[b];
+    if (x->is_exhausted)
+        return kFalse;
+    if (y->is_exhausted)
+        return kTrue;
+
+    /* the order is that of c2b_compare_sort_records(), with the text compared after the chromosome name */
+
+    if (x->chrom != y->chrom)
+        return (x->chrom < y->chrom) ? kTrue : kFalse;
+    if (x->start != y->start)
+        return (x->start < y->start) ? kTrue : kFalse;
+    if (x->stop != y->stop)
+        return (x->stop < y->stop) ? kTrue : kFalse;
+    length = (x->rest_length < y->rest_length) ? x->rest_length : y->rest_length;
+    if ((result = memcmp(x->rest, y->rest, length - 1)) != 0)
+        return (result < 0) ? kTrue : kFalse;
+    if (x->rest_length != y->rest_length)
+        return (x->rest_length < y->rest_length) ? kTrue : kFalse;
+    return (a < b) ? kTrue : kFalse;
+}
+
+static void
+c2b_adjust_sort_loser_tree(c2b_sort_source_t *sources, size_t *tree, size_t num_sources, size_t idx)
+{
+    size_t winner = idx;
+    size_t loser = 0;
+    size_t node = (idx + num_sources) / 2;
+
+    /* walk from the source's leaf to the root, leaving the loser of each match at its node */
+
+    while (node > 0) {
+        if (c2b_sort_source_precedes(sources, num_sources, tree[node], winner)) {
+            loser = winner;
+            winner = tree[node];
+            tree[node] = loser;
         }
-        if (c2b_globals.keep_header_flag) { 
-            /* copy header line to destination stream buffer */
-            if (!c2b_globals.wig->basename) {
-                sprintf(dest_line_str, 
-                        "%s\t%u\t%u\t%s\n", 
-                        c2b_header_chr_name, 
-                        c2b_globals.header_line_idx, 
-                        c2b_globals.header_line_idx + 1, 
-                        src_line_str);
+        node /= 2;
+    }
+    tree[0] = winner;
+}
+
+static void
+c2b_merge_sorted_runs(c2b_sorter_t *s, int dest_fd)
+{
+    c2b_sort_source_t *sources = NULL;
+    c2b_sort_source_t *src = NULL;
+    c2b_sort_chrom_t *chrom = NULL;
+    size_t *tree = NULL;
+    size_t num_sources = s->num_runs + 1;
+    size_t buffer_capacity = 0;
+    char *dest_buffer = NULL;
+    size_t dest_buffer_size = C2B_SORT_IO_BUFFER_SIZE;
+    size_t dest_bytes_written = 0;
+    size_t n;
+
+    /* what memory the in-memory records leave is divided among the run buffers */
+
+    buffer_capacity = (s->max_memory > s->memory) ? (size_t) ((s->max_memory - s->memory) / s->num_runs) : 0;
+    if (buffer_capacity < C2B_SORT_MIN_RUN_BUFFER_SIZE)
+        buffer_capacity = C2B_SORT_MIN_RUN_BUFFER_SIZE;
+    if (buffer_capacity > C2B_SORT_BLOCK_SIZE)
+        buffer_capacity = C2B_SORT_BLOCK_SIZE;
+
+    sources = malloc(num_sources * sizeof(c2b_sort_source_t));
+    tree = malloc(num_sources * sizeof(size_t));
+    dest_buffer = malloc(dest_buffer_size);
+    if ((!sources) || (!tree) || (!dest_buffer)) {
+        fprintf(stderr, "Error: Could not allocate space for sort merge\n");
+        c2b_print_usage(stderr);
+        exit(ENOMEM); /* Not enough space (POSIX.1) */
+    }
+
+    /* one source per run, and a last source for the records still in memory */
+
+    for (n = 0; n < num_sources; n++) {
+        src = &sources[n];
+        src->is_exhausted = kFalse;
+        src->run = (n < s->num_runs) ? &s->runs[n] : NULL;
+        src->offset = (src->run) ? src->run->offset : 0;
+        src->buffer = NULL;
+        src->buffer_capacity = 0;
+        src->buffer_start = 0;
+        src->buffer_end = 0;
+        src->index = 0;
+        if (src->run) {
+            src->buffer = malloc(buffer_capacity);
+            if (!src->buffer) {
+                fprintf(stderr, "Error: Could not allocate space for sort run buffer\n");
+                c2b_print_usage(stderr);
+                exit(ENOMEM); /* Not enough space (POSIX.1) */
             }
-            else {
-                sprintf(dest_line_str, 
-                        "%s\t%u\t%u\t%s\t%s\n", 
-                        c2b_header_chr_name, 
-                        c2b_globals.header_line_idx, 
-                        c2b_globals.header_line_idx + 1, 
-                        c2b_globals.wig->id,
-                        src_line_str);
+            src->buffer_capacity = buffer_capacity;
+        }
+        c2b_next_sort_source_record(s, src);
+        tree[n] = num_sources;
+    }
+    for (n = num_sources; n > 0; n--)
+        c2b_adjust_sort_loser_tree(sources, tree, num_sources, n - 1);
+
+    while (!sources[tree[0]].is_exhausted) {
+        src = &sources[tree[0]];
+        chrom = s->chroms_by_rank[src->chrom];
+        if (s->starch) {
+            c2b_add_starch_record(s->starch, chrom, src->start, src->stop, src->rest, src->rest_length);
+            c2b_next_sort_source_record(s, src);
+            c2b_adjust_sort_loser_tree(sources, tree, num_sources, tree[0]);
+            continue;
+        }
+        if (dest_bytes_written + chrom->length + src->rest_length > dest_buffer_size) {
+            c2b_write_sort_bytes(dest_fd, dest_buffer, dest_bytes_written);
+            dest_bytes_written = 0;
+        }
+        if (chrom->length + src->rest_length > dest_buffer_size) {
+            c2b_write_sort_bytes(dest_fd, chrom->name, chrom->length);
+            c2b_write_sort_bytes(dest_fd, src->rest, src->rest_length);
+        }
+        else {
+            memcpy(dest_buffer + dest_bytes_written, chrom->name, chrom->length);
+            memcpy(dest_buffer + dest_bytes_written + chrom->length, src->rest, src->rest_length);
+            dest_bytes_written += chrom->length + src->rest_length;
+        }
+        c2b_next_sort_source_record(s, src);
+        c2b_adjust_sort_loser_tree(sources, tree, num_sources, tree[0]);
+    }
+    c2b_write_sort_bytes(dest_fd, dest_buffer, dest_bytes_written);
+
+    for (n = 0; n < num_sources; n++) {
+        if (sources[n].buffer)
+            free(sources[n].buffer), sources[n].buffer = NULL;
+    }
+    free(dest_buffer), dest_buffer = NULL;
+    free(tree), tree = NULL;
+    free(sources), sources = NULL;
+}
+
+static uint64_t
+c2b_parse_max_mem(const char *value)
+{
+    char *value_end = NULL;
+    uint64_t multiplier = 1;
+    unsigned long long val = 0;
+
+    /* values may carry a K, M, G or T suffix, as with sort-bed */
+
+    errno = 0;
+    val = strtoull(value, &value_end, 10);
+    if ((errno == 0) && (value_end != value) && (*value_end != '\0') && (*(value_end + 1) == '\0')) {
+        switch (toupper((unsigned char) *value_end)) 
+            {
+            case 'K':
+                multiplier = 1024ULL;
+                value_end++;
+                break;
+            case 'M':
+                multiplier = 1024ULL * 1024ULL;
+                value_end++;
+                break;
+            case 'G':
+                multiplier = 1024ULL * 1024ULL * 1024ULL;
+                value_end++;
+                break;
+            case 'T':
+                multiplier = 1024ULL * 1024ULL * 1024ULL * 1024ULL;
+                value_end++;
+                break;
+            default:
+                break;
             }
-            memcpy(dest + *dest_size, dest_line_str, strlen(dest_line_str));
-            *dest_size += strlen(dest_line_str);
-            c2b_globals.header_line_idx++;
-            return;
+    }
+    if ((errno != 0) || (value_end == value) || (*value_end != '\0') || (val == 0) || (val > UINT64_MAX / multiplier)) {
+        fprintf(stderr, "Error: Memory value must be a positive integer, optionally followed by K, M, G or T\n");
+        c2b_print_usage(stderr);
+        exit(EINVAL); /* Invalid argument (POSIX.1) */
+    }
+
+    return (uint64_t) val * multiplier;
+}
+
+static void
+c2b_init_starch_writer(c2b_starch_writer_t *w, int dest_fd)
+{
+    uint64_t max_memory = c2b_globals.sort->max_mem / 2;
+    uint64_t fixed_memory = 0;
+
+    w->dest_fd = dest_fd;
+    w->streams = NULL;
+    w->num_streams = 0;
+    w->streams_capacity = 0;
+    w->num_written = 0;
+    w->current_chrom = NULL;
+    w->chunk = NULL;
+    w->chunk_size = 0;
+    w->chunk_capacity = 0;
+    w->last_start = 0;
+    w->last_stop = 0;
+    w->last_length = 0;
+    w->coverage_stop = 0;
+    w->num_threads = c2b_globals.starch->threads;
+    w->max_queued_chunks = C2B_STARCH_MAX_QUEUED_CHUNKS;
+
+    /* queues are shortened, and then fewer streams compressed at once, until the fixed costs fit */
+
+    fixed_memory = C2B_STARCH_CHUNK_SIZE + w->num_threads * c2b_starch_stream_memory(w->max_queued_chunks);
+    while ((fixed_memory > max_memory) && ((w->max_queued_chunks > 1) || (w->num_threads > 1))) {
+        if (w->max_queued_chunks > 1)
+            w->max_queued_chunks--;
+        else
+            w->num_threads--;
+        fixed_memory = C2B_STARCH_CHUNK_SIZE + w->num_threads * c2b_starch_stream_memory(w->max_queued_chunks);
+    }
+    if (w->num_threads < c2b_globals.starch->threads) {
+        fprintf(stderr, "Warning: Lowered --starch-threads from %u to %u, to fit in half of --max-mem\n", c2b_globals.starch->threads, w->num_threads);
+    }
+
+    /* held bytes get a quarter of --max-mem, or what the fixed costs leave of half */
+
+    w->held_memory = 0;
+    w->max_held_memory = c2b_globals.sort->max_mem / 4;
+    if (fixed_memory + w->max_held_memory > max_memory)
+        w->max_held_memory = (max_memory > fixed_memory) ? (max_memory - fixed_memory) : 0;
+    w->memory = fixed_memory + w->max_held_memory;
+    pthread_mutex_init(&w->lock, NULL);
+    if (gethostname(w->hostname, sizeof(w->hostname)) == -1)
+        strcpy(w->hostname, "localhost");
+    w->hostname[sizeof(w->hostname) - 1] = '\0';
+
+    c2b_write_sort_bytes(w->dest_fd, (char *) c2b_starch_magic, sizeof(c2b_starch_magic));
+    w->archive_size = sizeof(c2b_starch_magic);
+}
+
+static uint64_t
+c2b_starch_stream_memory(size_t max_queued_chunks)
+{
+    uint64_t state_size = (c2b_globals.starch->gzip) ? C2B_STARCH_GZIP_STATE_SIZE : C2B_STARCH_BZIP2_STATE_SIZE;
+
+    /* a stream's queued chunks, the chunk being compressed and its output block, and the compressor */
+
+    return (uint64_t) (max_queued_chunks + 2) * C2B_STARCH_CHUNK_SIZE + state_size;
+}
+
+static void
+c2b_delete_starch_writer(c2b_starch_writer_t *w)
+{
+    size_t n;
+
+    for (n = 0; n < w->num_streams; n++) {
+        pthread_mutex_destroy(&w->streams[n]->lock);
+        pthread_cond_destroy(&w->streams[n]->changed);
+        if (w->streams[n]->held)
+            free(w->streams[n]->held), w->streams[n]->held = NULL;
+        if (w->streams[n]->spill_fd != -1)
+            close(w->streams[n]->spill_fd), w->streams[n]->spill_fd = -1;
+        free(w->streams[n]->chrom), w->streams[n]->chrom = NULL;
+        free(w->streams[n]), w->streams[n] = NULL;
+    }
+    if (w->streams)
+        free(w->streams), w->streams = NULL;
+    if (w->chunk)
+        free(w->chunk), w->chunk = NULL;
+    pthread_mutex_destroy(&w->lock);
+}
+
+static void
+c2b_add_starch_record(c2b_starch_writer_t *w, c2b_sort_chrom_t *chrom, uint64_t start, uint64_t stop, char *rest, uint32_t rest_length)
+{
+    c2b_starch_stream_t *stream = NULL;
+    char *remainder = NULL;
+    char *rest_end = rest + rest_length;
+    size_t remainder_length = 0;
+    size_t needed = 0;
+    uint64_t length = stop - start;
+
+    if (chrom != w->current_chrom) {
+        if (w->current_chrom)
+            c2b_end_starch_stream(w);
+        c2b_begin_starch_stream(w, chrom);
+    }
+    stream = w->streams[w->num_streams - 1];
+
+    /* rest is "\tstart\tstop[\tremainder]\n" -- only the remainder is kept as-is */
+
+    if ((rest_length > 0) && (*(rest_end - 1) == '\n'))
+        rest_end--;
+    remainder = memchr(rest + 1, '\t', (size_t) (rest_end - rest - 1));
+    if (remainder)
+        remainder = memchr(remainder + 1, '\t', (size_t) (rest_end - remainder - 1));
+    if (remainder)
+        remainder_length = (size_t) (rest_end - remainder);
+
+    needed = 2 * C2B_MAX_OPERATION_FIELD_LENGTH_VALUE + remainder_length + 3;
+    if (w->chunk_size + needed > w->chunk_capacity) {
+        if (w->chunk_size > 0)
+            c2b_queue_starch_chunk(w);
+        w->chunk_capacity = (needed > C2B_STARCH_CHUNK_SIZE) ? needed : C2B_STARCH_CHUNK_SIZE;
+        w->chunk = malloc(w->chunk_capacity);
+        if (!w->chunk) {
+            fprintf(stderr, "Error: Could not allocate space for Starch chunk\n");
+            c2b_print_usage(stderr);
+            exit(ENOMEM); /* Not enough space (POSIX.1) */
+        }
+    }
+
+    if ((stream->line_count == 0) || (length != w->last_length)) {
+        w->chunk_size += sprintf(w->chunk + w->chunk_size, "p%" PRIu64 "\n", length);
+        w->last_length = length;
+    }
+    w->chunk_size += sprintf(w->chunk + w->chunk_size, "%" PRId64, (int64_t) start - (int64_t) w->last_stop);
+    if (remainder_length > 0) {
+        memcpy(w->chunk + w->chunk_size, remainder, remainder_length);
+        w->chunk_size += remainder_length;
+    }
+    w->chunk[w->chunk_size++] = '\n';
+
+    if (stream->line_count > 0) {
+        if ((start == w->last_start) && (stop == w->last_stop))
+            stream->duplicate_exists = kTrue;
+        if ((w->last_start < start) && (w->last_stop > stop))
+            stream->nested_exists = kTrue;
+    }
+    if (stop > w->coverage_stop) {
+        stream->unique_bases += stop - ((start > w->coverage_stop) ? start : w->coverage_stop);
+        w->coverage_stop = stop;
+    }
+    stream->non_unique_bases += length;
+    stream->line_count++;
+    w->last_start = start;
+    w->last_stop = stop;
+}
+
+static void
+c2b_begin_starch_stream(c2b_starch_writer_t *w, c2b_sort_chrom_t *chrom)
+{
+    c2b_starch_stream_t *stream = NULL;
+    c2b_starch_stream_t **streams = NULL;
+    int errsv = 0;
+
+    /* with this stream, at most --starch-threads streams are compressed at once */
+
+    c2b_write_starch_streams(w, w->num_threads - 1);
+
+    if (w->num_streams == w->streams_capacity) {
+        w->streams_capacity = (w->streams_capacity == 0) ? 16 : w->streams_capacity * 2;
+        streams = realloc(w->streams, w->streams_capacity * sizeof(c2b_starch_stream_t *));
+        if (!streams) {
+            fprintf(stderr, "Error: Could not allocate space for Starch streams\n");
+            c2b_print_usage(stderr);
+            exit(ENOMEM); /* Not enough space (POSIX.1) */
+        }
+        w->streams = streams;
+    }
+
+    stream = malloc(sizeof(c2b_starch_stream_t));
+    if (!stream) {
+        fprintf(stderr, "Error: Could not allocate space for Starch stream\n");
+        c2b_print_usage(stderr);
+        exit(ENOMEM); /* Not enough space (POSIX.1) */
+    }
+    stream->chrom = malloc(chrom->length + 1);
+    if (!stream->chrom) {
+        fprintf(stderr, "Error: Could not allocate space for Starch stream chromosome\n");
+        c2b_print_usage(stderr);
+        exit(ENOMEM); /* Not enough space (POSIX.1) */
+    }
+    memcpy(stream->chrom, chrom->name, chrom->length);
+    stream->chrom[chrom->length] = '\0';
+    stream->line_count = 0;
+    stream->non_unique_bases = 0;
+    stream->unique_bases = 0;
+    stream->duplicate_exists = kFalse;
+    stream->nested_exists = kFalse;
+    stream->head = NULL;
+    stream->tail = NULL;
+    stream->num_queued = 0;
+    stream->is_complete = kFalse;
+    stream->is_done = kFalse;
+    stream->compressed_size = 0;
+    stream->held = NULL;
+    stream->held_size = 0;
+    stream->held_capacity = 0;
+    stream->spill_fd = -1;
+    stream->writer = w;
+    pthread_mutex_init(&stream->lock, NULL);
+    pthread_cond_init(&stream->changed, NULL);
+    w->streams[w->num_streams++] = stream;
+
+    /* if every earlier stream is written out, this one is written as it is compressed */
+
+    stream->is_streaming = (w->num_written == w->num_streams - 1) ? kTrue : kFalse;
+
+    w->current_chrom = chrom;
+    w->last_start = 0;
+    w->last_stop = 0;
+    w->last_length = 0;
+    w->coverage_stop = 0;
+
+    errsv = pthread_create(&stream->thread, NULL, c2b_compress_starch_stream, stream);
+    if (errsv != 0) {
+        fprintf(stderr, "Error: Could not start Starch compression thread (%s)\n", strerror(errsv));
+        exit(errsv);
+    }
+}
+
+static void
+c2b_queue_starch_chunk(c2b_starch_writer_t *w)
+{
+    c2b_starch_stream_t *stream = w->streams[w->num_streams - 1];
+    c2b_starch_chunk_t *chunk = NULL;
+
+    chunk = malloc(sizeof(c2b_starch_chunk_t));
+    if (!chunk) {
+        fprintf(stderr, "Error: Could not allocate space for Starch chunk\n");
+        c2b_print_usage(stderr);
+        exit(ENOMEM); /* Not enough space (POSIX.1) */
+    }
+    chunk->data = w->chunk;
+    chunk->size = w->chunk_size;
+    chunk->next = NULL;
+    w->chunk = NULL;
+    w->chunk_size = 0;
+    w->chunk_capacity = 0;
+
+    pthread_mutex_lock(&stream->lock);
+    while (stream->num_queued >= w->max_queued_chunks)
+        pthread_cond_wait(&stream->changed, &stream->lock);
+    if (stream->tail)
+        stream->tail->next = chunk;
+    else
+        stream->head = chunk;
+    stream->tail = chunk;
+    stream->num_queued++;
+    pthread_cond_broadcast(&stream->changed);
+    pthread_mutex_unlock(&stream->lock);
+}
+
+static void
+c2b_end_starch_stream(c2b_starch_writer_t *w)
+{
+    c2b_starch_stream_t *stream = w->streams[w->num_streams - 1];
+
+    if (w->chunk_size > 0)
+        c2b_queue_starch_chunk(w);
+
+    pthread_mutex_lock(&stream->lock);
+    stream->is_complete = kTrue;
+    pthread_cond_broadcast(&stream->changed);
+    pthread_mutex_unlock(&stream->lock);
+
+    w->current_chrom = NULL;
+}
+
+static void
+c2b_write_starch_streams(c2b_starch_writer_t *w, size_t max_pending)
+{
+    c2b_starch_stream_t *stream = NULL;
+    boolean is_done = kFalse;
+
+    /* 
+       Streams are written in chromosome order: the oldest unwritten stream 
+       writes to the output as it is compressed, and is retired once it is 
+       done, or waited on while more than max_pending streams are outstanding
+    */
+
+    while (w->num_written < w->num_streams) {
+        stream = w->streams[w->num_written];
+        c2b_promote_starch_stream(stream);
+        pthread_mutex_lock(&stream->lock);
+        is_done = stream->is_done;
+        pthread_mutex_unlock(&stream->lock);
+        if ((!is_done) && (w->num_streams - w->num_written <= max_pending))
+            break;
+        pthread_join(stream->thread, NULL);
+        w->archive_size += stream->compressed_size;
+        w->num_written++;
+    }
+}
+
+static void *
+c2b_compress_starch_stream(void *arg)
+{
+    c2b_starch_stream_t *stream = (c2b_starch_stream_t *) arg;
+    c2b_starch_chunk_t *chunk = NULL;
+    boolean is_bzip2 = !c2b_globals.starch->gzip;
+    bz_stream bz;
+    z_stream z;
+    int result = 0;
+    char *out = NULL;
+    size_t out_size = 0;
+
+    /* compressed bytes are gathered in out, which is handed on each time it fills */
+
+    out = malloc(C2B_STARCH_CHUNK_SIZE);
+    if (!out) {
+        fprintf(stderr, "Error: Could not allocate space for compressed Starch stream\n");
+        exit(ENOMEM); /* Not enough space (POSIX.1) */
+    }
+
+    memset(&bz, 0, sizeof(bz));
+    memset(&z, 0, sizeof(z));
+    if (is_bzip2)
+        result = (BZ2_bzCompressInit(&bz, C2B_STARCH_BZIP2_BLOCK_SIZE, 0, 0) == BZ_OK);
+    else
+        result = (deflateInit(&z, C2B_STARCH_GZIP_LEVEL) == Z_OK);
+    if (!result) {
+        fprintf(stderr, "Error: Could not initialize Starch stream compression\n");
+        exit(EINVAL); /* Invalid argument (POSIX.1) */
+    }
+
+    do {
+        pthread_mutex_lock(&stream->lock);
+        while ((!stream->head) && (!stream->is_complete))
+            pthread_cond_wait(&stream->changed, &stream->lock);
+        chunk = stream->head;
+        if (chunk) {
+            stream->head = chunk->next;
+            if (!stream->head)
+                stream->tail = NULL;
+            stream->num_queued--;
+            pthread_cond_broadcast(&stream->changed);
+        }
+        pthread_mutex_unlock(&stream->lock);
+
+        /* a NULL chunk means the stream is complete and its compressor is flushed */
+
+        if (is_bzip2) {
+            bz.next_in = (chunk) ? chunk->data : NULL;
+            bz.avail_in = (chunk) ? (unsigned int) chunk->size : 0;
+            do {
+                bz.next_out = out + out_size;
+                bz.avail_out = (unsigned int) (C2B_STARCH_CHUNK_SIZE - out_size);
+                result = BZ2_bzCompress(&bz, (chunk) ? BZ_RUN : BZ_FINISH);
+                if ((result != BZ_RUN_OK) && (result != BZ_FINISH_OK) && (result != BZ_STREAM_END)) {
+                    fprintf(stderr, "Error: Could not compress Starch stream (bzip2 error %d)\n", result);
+                    exit(EIO); /* Input/output error (POSIX.1) */
+                }
+                out_size = (size_t) (bz.next_out - out);
+                if (out_size == C2B_STARCH_CHUNK_SIZE)
+                    c2b_emit_starch_compressed(stream, out, out_size), out_size = 0;
+            } while ((chunk) ? (bz.avail_in > 0) : (result != BZ_STREAM_END));
         }
         else {
-            return;
-        }                
+            z.next_in = (chunk) ? (Bytef *) chunk->data : Z_NULL;
+            z.avail_in = (chunk) ? (uInt) chunk->size : 0;
+            do {
+                z.next_out = (Bytef *) out + out_size;
+                z.avail_out = (uInt) (C2B_STARCH_CHUNK_SIZE - out_size);
+                result = deflate(&z, (chunk) ? Z_NO_FLUSH : Z_FINISH);
+                if ((result != Z_OK) && (result != Z_STREAM_END) && (result != Z_BUF_ERROR)) {
+                    fprintf(stderr, "Error: Could not compress Starch stream (zlib error %d)\n", result);
+                    exit(EIO); /* Input/output error (POSIX.1) */
+                }
+                out_size = (size_t) ((char *) z.next_out - out);
+                if (out_size == C2B_STARCH_CHUNK_SIZE)
+                    c2b_emit_starch_compressed(stream, out, out_size), out_size = 0;
+            } while ((chunk) ? (z.avail_in > 0) : (result != Z_STREAM_END));
+        }
+
+        if (chunk) {
+            free(chunk->data), chunk->data = NULL;
+            free(chunk), chunk = NULL;
+        }
+        else
+            break;
+    } while (1);
+
+    if (out_size > 0)
+        c2b_emit_starch_compressed(stream, out, out_size);
+    free(out), out = NULL;
+
+    if (is_bzip2)
+        BZ2_bzCompressEnd(&bz);
+    else
+        deflateEnd(&z);
+
+    pthread_mutex_lock(&stream->lock);
+    stream->is_done = kTrue;
+    pthread_mutex_unlock(&stream->lock);
+
+    pthread_exit(NULL);
+}
+
+static void
+c2b_emit_starch_compressed(c2b_starch_stream_t *stream, char *src, size_t size)
+{
+    c2b_starch_writer_t *w = stream->writer;
+    char *held = NULL;
+    size_t capacity = stream->held_capacity;
+    boolean is_held = kFalse;
+
+    /* the oldest stream writes straight to the output; others hold what they can, and spill the rest */
+
+    pthread_mutex_lock(&stream->lock);
+    stream->compressed_size += size;
+    if (stream->is_streaming) {
+        c2b_write_sort_bytes(w->dest_fd, src, size);
+        pthread_mutex_unlock(&stream->lock);
+        return;
     }
-    else if (strncmp(src, c2b_wig_fixed_step_prefix, strlen(c2b_wig_fixed_step_prefix)) == 0) {
-        memcpy(src_line_str, src, src_size);
-        src_line_str[src_size] = '\0';
-        int fixed_step_fields = sscanf(src_line_str, 
-                                       "fixedStep chrom=%s start=%" SCNu64 " step=%" SCNu64 " span=%" SCNu64 "\n", 
-                                       c2b_globals.wig->chr, 
-                                       &(c2b_globals.wig->start_pos), 
-                                       &(c2b_globals.wig->step), 
-                                       &(c2b_globals.wig->span));
-        if (fixed_step_fields < 3) {
-            fprintf(stderr, "Error: Invalid fixedStep header on line %u\n", c2b_globals.wig->line);
-            exit(EINVAL); /* Invalid argument (POSIX.1) */
+
+    if (capacity == 0)
+        capacity = size;
+    while (capacity - stream->held_size < size)
+        capacity *= 2;
+    pthread_mutex_lock(&w->lock);
+    if (w->held_memory + (capacity - stream->held_capacity) <= w->max_held_memory) {
+        w->held_memory += capacity - stream->held_capacity;
+        is_held = kTrue;
+    }
+    pthread_mutex_unlock(&w->lock);
+
+    if (!is_held) {
+        c2b_spill_starch_stream(stream, src, size);
+        pthread_mutex_unlock(&stream->lock);
+        return;
+    }
+    if (capacity > stream->held_capacity) {
+        held = realloc(stream->held, capacity);
+        if (!held) {
+            fprintf(stderr, "Error: Could not allocate space for compressed Starch stream\n");
+            exit(ENOMEM); /* Not enough space (POSIX.1) */
         }
-        if (fixed_step_fields == 3) {
-            c2b_globals.wig->span = 1;
+        stream->held = held;
+        stream->held_capacity = capacity;
+    }
+    memcpy(stream->held + stream->held_size, src, size);
+    stream->held_size += size;
+    pthread_mutex_unlock(&stream->lock);
+}
+
+static void
+c2b_spill_starch_stream(c2b_starch_stream_t *stream, char *src, size_t size)
+{
+    /* called with the stream locked: what it holds, then src, go to its spill file */
+
+    if (stream->spill_fd == -1)
+        stream->spill_fd = c2b_open_tmp_file("Starch stream spill");
+    if (stream->held_size > 0)
+        c2b_write_sort_bytes(stream->spill_fd, stream->held, stream->held_size);
+    c2b_write_sort_bytes(stream->spill_fd, src, size);
+    c2b_release_starch_held(stream);
+}
+
+static void
+c2b_release_starch_held(c2b_starch_stream_t *stream)
+{
+    c2b_starch_writer_t *w = stream->writer;
+
+    pthread_mutex_lock(&w->lock);
+    w->held_memory -= stream->held_capacity;
+    pthread_mutex_unlock(&w->lock);
+    if (stream->held)
+        free(stream->held), stream->held = NULL;
+    stream->held_size = 0;
+    stream->held_capacity = 0;
+}
+
+static void
+c2b_promote_starch_stream(c2b_starch_stream_t *stream)
+{
+    c2b_starch_writer_t *w = stream->writer;
+    char *buffer = NULL;
+    off_t offset = 0;
+    ssize_t bytes_read = 0;
+    int errsv = 0;
+
+    /* 
+       Called once every earlier stream is written out: what the stream spilled, and 
+       then what it holds, are written, after which its compressor writes directly
+    */
+
+    pthread_mutex_lock(&stream->lock);
+    if (stream->is_streaming) {
+        pthread_mutex_unlock(&stream->lock);
+        return;
+    }
+    if (stream->spill_fd != -1) {
+        buffer = malloc(C2B_STARCH_CHUNK_SIZE);
+        if (!buffer) {
+            fprintf(stderr, "Error: Could not allocate space for Starch stream spill buffer\n");
+            c2b_print_usage(stderr);
+            exit(ENOMEM); /* Not enough space (POSIX.1) */
         }
-        c2b_globals.wig->is_fixed_step = kTrue;
-        if (c2b_globals.keep_header_flag) { 
-            /* copy header line to destination stream buffer */
-            if (!c2b_globals.wig->basename) {
-                sprintf(dest_line_str, 
-                        "%s\t%u\t%u\t%s\n", 
-                        c2b_header_chr_name, 
-                        c2b_globals.header_line_idx, 
-                        c2b_globals.header_line_idx + 1, 
-                        src_line_str);
-            }
-            else {
-                sprintf(dest_line_str, 
-                        "%s\t%u\t%u\t%s\t%s\n", 
-                        c2b_header_chr_name, 
-                        c2b_globals.header_line_idx, 
-                        c2b_globals.header_line_idx + 1, 
-                        c2b_globals.wig->id,
-                        src_line_str);
+        while ((bytes_read = pread(stream->spill_fd, buffer, C2B_STARCH_CHUNK_SIZE, offset)) != 0) {
+            if (bytes_read == -1) {
+                errsv = errno;
+                if (errsv == EINTR)
+                    continue;
+                fprintf(stderr, "Error: Could not read Starch stream spill file (%s)\n", strerror(errsv));
+                exit(errsv);
             }
-            memcpy(dest + *dest_size, dest_line_str, strlen(dest_line_str));
-            *dest_size += strlen(dest_line_str);
-            c2b_globals.header_line_idx++;
-            return;
+            c2b_write_sort_bytes(w->dest_fd, buffer, (size_t) bytes_read);
+            offset += bytes_read;
+        }
+        free(buffer), buffer = NULL;
+        close(stream->spill_fd), stream->spill_fd = -1;
+    }
+    if (stream->held_size > 0)
+        c2b_write_sort_bytes(w->dest_fd, stream->held, stream->held_size);
+    c2b_release_starch_held(stream);
+    stream->is_streaming = kTrue;
+    pthread_mutex_unlock(&stream->lock);
+}
+
+static void
+c2b_finish_starch_writer(c2b_starch_writer_t *w)
+{
+    c2b_starch_stream_t *stream = NULL;
+    FILE *metadata_stream = NULL;
+    char *metadata = NULL;
+    size_t metadata_size = 0;
+    char footer[C2B_STARCH_FOOTER_LENGTH + 1];
+    char timestamp[C2B_MAX_FIELD_LENGTH_VALUE];
+    unsigned char digest[20];
+    time_t now = time(NULL);
+    struct tm local_now;
+    pid_t pid = getpid();
+    size_t n;
+
+    if (w->current_chrom)
+        c2b_end_starch_stream(w);
+    c2b_write_starch_streams(w, 0);
+
+    localtime_r(&now, &local_now);
+    strftime(timestamp, sizeof(timestamp), "%Y-%m-%dT%H:%M:%S%z", &local_now);
+
+    metadata_stream = open_memstream(&metadata, &metadata_size);
+    if (!metadata_stream) {
+        fprintf(stderr, "Error: Could not allocate space for Starch metadata\n");
+        c2b_print_usage(stderr);
+        exit(ENOMEM); /* Not enough space (POSIX.1) */
+    }
+    fprintf(metadata_stream,
+            "{\n"                                                   \
+            "  \"archive\": {\n"                                    \
+            "    \"type\": \"starch\",\n"                           \
+            "    \"customUCSCHeaders\": false,\n"                   \
+            "    \"creationTimestamp\": \"%s\",\n"                  \
+            "    \"version\": {\n"                                  \
+            "      \"major\": %d,\n"                                \
+            "      \"minor\": %d,\n"                                \
+            "      \"revision\": %d\n"                              \
+            "    },\n"                                              \
+            "    \"compressionFormat\": %d",
+            timestamp,
+            C2B_STARCH_VERSION_MAJOR,
+            C2B_STARCH_VERSION_MINOR,
+            C2B_STARCH_VERSION_REVISION,
+            (c2b_globals.starch->gzip) ? 1 : 0);
+    if (c2b_globals.starch->note) {
+        fprintf(metadata_stream, ",\n    \"note\": \"");
+        c2b_print_json_string(metadata_stream, c2b_globals.starch->note);
+        fprintf(metadata_stream, "\"");
+    }
+    fprintf(metadata_stream, "\n  },\n  \"streams\": [");
+    for (n = 0; n < w->num_streams; n++) {
+        stream = w->streams[n];
+        fprintf(metadata_stream, "%s\n    {\n      \"chromosome\": \"", (n > 0) ? "," : "");
+        c2b_print_json_string(metadata_stream, stream->chrom);
+        fprintf(metadata_stream, "\",\n      \"filename\": \"");
+        c2b_print_json_string(metadata_stream, stream->chrom);
+        fprintf(metadata_stream, ".pid%d.", (int) pid);
+        c2b_print_json_string(metadata_stream, w->hostname);
+        fprintf(metadata_stream,
+                "\",\n"                                                    \
+                "      \"size\": \"%zu\",\n"                                \
+                "      \"uncompressedLineCount\": %" PRIu64 ",\n"           \
+                "      \"nonUniqueBaseCount\": %" PRIu64 ",\n"              \
+                "      \"uniqueBaseCount\": %" PRIu64 ",\n"                 \
+                "      \"duplicateElementExists\": %s,\n"                   \
+                "      \"nestedElementExists\": %s\n"                       \
+                "    }",
+                stream->compressed_size,
+                stream->line_count,
+                stream->non_unique_bases,
+                stream->unique_bases,
+                (stream->duplicate_exists) ? "true" : "false",
+                (stream->nested_exists) ? "true" : "false");
+    }
+    fprintf(metadata_stream, "%s]\n}", (w->num_streams > 0) ? "\n  " : "");
+    fclose(metadata_stream);
+
+    c2b_sha1((const unsigned char *) metadata, metadata_size, digest);
+    sprintf(footer, "%0*" PRIu64, C2B_STARCH_FOOTER_OFFSET_LENGTH, w->archive_size);
+    c2b_base64_encode(digest, sizeof(digest), footer + C2B_STARCH_FOOTER_OFFSET_LENGTH);
+    memset(footer + C2B_STARCH_FOOTER_OFFSET_LENGTH + C2B_STARCH_SIGNATURE_LENGTH, ' ', C2B_STARCH_FOOTER_LENGTH - C2B_STARCH_FOOTER_OFFSET_LENGTH - C2B_STARCH_SIGNATURE_LENGTH - 1);
+    footer[C2B_STARCH_FOOTER_LENGTH - 1] = '\n';
+
+    c2b_write_sort_bytes(w->dest_fd, metadata, metadata_size);
+    c2b_write_sort_bytes(w->dest_fd, footer, C2B_STARCH_FOOTER_LENGTH);
+    free(metadata), metadata = NULL;
+}
+
+static void
+c2b_print_json_string(FILE *stream, const char *s)
+{
+    /* writes s with JSON escapes, leaving the enclosing quotes to the caller */
+
+    for (; *s != '\0'; s++) {
+        switch (*s) {
+            case '"':
+                fputs("\\\"", stream);
+                break;
+            case '\\':
+                fputs("\\\\", stream);
+                break;
+            case '\n':
+                fputs("\\n", stream);
+                break;
+            case '\t':
+                fputs("\\t", stream);
+                break;
+            default:
+                if ((unsigned char) *s < 0x20)
+                    fprintf(stream, "\\u%04x", (unsigned int) (unsigned char) *s);
+                else
+                    fputc(*s, stream);
+                break;
         }
-        else {
-            return;
-        }        
     }
-    else if (strncmp(src, c2b_wig_chr_prefix, strlen(c2b_wig_chr_prefix)) == 0) {
-        memcpy(src_line_str, src, src_size);
-        src_line_str[src_size] = '\0';
-        int bed_fields = sscanf(src_line_str, 
-                                "%s\t%" SCNu64 "\t%" SCNu64 "\t%lf\n", 
-                                c2b_globals.wig->chr,
-                                &(c2b_globals.wig->start_pos), 
-                                &(c2b_globals.wig->end_pos), 
-                                &(c2b_globals.wig->score));
-        if (bed_fields != 4) {
-            fprintf(stderr, "Error: Invalid WIG line %u\n", c2b_globals.wig->line);
-            exit(EINVAL); /* Invalid argument (POSIX.1) */
-        }
-        c2b_globals.wig->pos_lines++;
-        if ((c2b_globals.wig->start_pos == 0) && (!c2b_globals.zero_indexed_flag)) {
-            fprintf(stderr, "Error: WIG data contains 0-indexed element at line %u\n", c2b_globals.wig->line);
-            fprintf(stderr, "       Consider adding --zero-indexed (-x) option to convert zero-indexed WIG data\n");
-            exit(EINVAL); /* Invalid argument (POSIX.1) */
+}
+
+static inline uint32_t
+c2b_sha1_rotate(uint32_t x, int n)
+{
+    return (x << n) | (x >> (32 - n));
+}
+
+static void
+c2b_sha1(const unsigned char *data, size_t size, unsigned char *digest)
+{
+    uint32_t h[5] = { 0x67452301, 0xefcdab89, 0x98badcfe, 0x10325476, 0xc3d2e1f0 };
+    uint32_t m[80];
+    uint32_t a, b, c, d, e, f, k, t;
+    unsigned char block[64];
+    uint64_t bit_size = (uint64_t) size * 8;
+    size_t num_blocks = (size + 8) / 64 + 1;
+    size_t offset = 0;
+    size_t n, i;
+
+    for (n = 0; n < num_blocks; n++) {
+        /* the message is followed by a 0x80 byte, zero padding and its length in bits */
+        for (i = 0; i < 64; i++) {
+            offset = n * 64 + i;
+            if (offset < size)
+                block[i] = data[offset];
+            else if (offset == size)
+                block[i] = 0x80;
+            else if ((n == num_blocks - 1) && (i >= 56))
+                block[i] = (unsigned char) (bit_size >> (8 * (63 - i)));
+            else
+                block[i] = 0;
         }
-        if (!c2b_globals.wig->basename) {
-            sprintf(dest_line_str,
-                    "%s\t"                      \
-                    "%" PRIu64 "\t"             \
-                    "%" PRIu64 "\t"             \
-                    "id-%d\t"                   \
-                    "%lf\n",
-                    c2b_globals.wig->chr,
-                    c2b_globals.wig->start_pos - c2b_globals.wig->start_shift,
-                    c2b_globals.wig->end_pos - c2b_globals.wig->end_shift,
-                    c2b_globals.wig->pos_lines,
-                    c2b_globals.wig->score);
+        for (i = 0; i < 16; i++)
+            m[i] = ((uint32_t) block[4*i] << 24) | ((uint32_t) block[4*i + 1] << 16) | ((uint32_t) block[4*i + 2] << 8) | (uint32_t) block[4*i + 3];
+        for (i = 16; i < 80; i++)
+            m[i] = c2b_sha1_rotate(m[i - 3] ^ m[i - 8] ^ m[i - 14] ^ m[i - 16], 1);
+        a = h[0], b = h[1], c = h[2], d = h[3], e = h[4];
+        for (i = 0; i < 80; i++) {
+            if (i < 20)
+                f = (b & c) | (~b & d), k = 0x5a827999;
+            else if (i < 40)
+                f = b ^ c ^ d, k = 0x6ed9eba1;
+            else if (i < 60)
+                f = (b & c) | (b & d) | (c & d), k = 0x8f1bbcdc;
+            else
+                f = b ^ c ^ d, k = 0xca62c1d6;
+            t = c2b_sha1_rotate(a, 5) + f + e + k + m[i];
+            e = d, d = c, c = c2b_sha1_rotate(b, 30), b = a, a = t;
         }
-        else {
-            sprintf(dest_line_str,
-                    "%s\t"                      \
-                    "%" PRIu64 "\t"             \
-                    "%" PRIu64 "\t"             \
-                    "%s-%d\t"                   \
-                    "%lf\n",
-                    c2b_globals.wig->chr,
-                    c2b_globals.wig->start_pos - c2b_globals.wig->start_shift,
-                    c2b_globals.wig->end_pos - c2b_globals.wig->end_shift,
-                    c2b_globals.wig->id,
-                    c2b_globals.wig->pos_lines,
-                    c2b_globals.wig->score);
-        }
-        c2b_globals.wig->start_write = kTrue;
-        memcpy(dest + *dest_size, dest_line_str, strlen(dest_line_str));
-        *dest_size += strlen(dest_line_str);
+        h[0] += a, h[1] += b, h[2] += c, h[3] += d, h[4] += e;
     }
-    else {
-        memcpy(src_line_str, src, src_size);
-        src_line_str[src_size] = '\0';
 
-        if (c2b_globals.wig->is_fixed_step) {
+    for (i = 0; i < 20; i++)
+        digest[i] = (unsigned char) (h[i / 4] >> (8 * (3 - i % 4)));
+}
 
-            int fixed_step_column_fields = sscanf(src_line_str, "%lf\n", &(c2b_globals.wig->score));
-            if (fixed_step_column_fields != 1) {
-                fprintf(stderr, "Error: Invalid WIG line %u\n", c2b_globals.wig->line);
-                exit(EINVAL); /* Invalid argument (POSIX.1) */
-            }
-            c2b_globals.wig->pos_lines++;
-            if ((c2b_globals.wig->start_pos == 0) && (!c2b_globals.zero_indexed_flag)) {
-                fprintf(stderr, "Error: WIG data contains 0-indexed element at line %u\n", c2b_globals.wig->line);
-                fprintf(stderr, "       Consider adding --zero-indexed (-x) option to convert zero-indexed WIG data\n");
-                exit(EINVAL); /* Invalid argument (POSIX.1) */
-            }
-            if (!c2b_globals.wig->basename) {
-                sprintf(dest_line_str,
-                        "%s\t"                  \
-                        "%" PRIu64 "\t"         \
-                        "%" PRIu64 "\t"         \
-                        "id-%d\t"               \
-                        "%lf\n",
-                        c2b_globals.wig->chr,
-                        c2b_globals.wig->start_pos - c2b_globals.wig->start_shift,
-                        c2b_globals.wig->start_pos + c2b_globals.wig->span - c2b_globals.wig->end_shift,
-                        c2b_globals.wig->pos_lines,
-                        c2b_globals.wig->score);
-            }
-            else {
-                sprintf(dest_line_str,
-                        "%s\t"                  \
-                        "%" PRIu64 "\t"         \
-                        "%" PRIu64 "\t"         \
-                        "%s-%d\t"               \
-                        "%lf\n",
-                        c2b_globals.wig->chr,
-                        c2b_globals.wig->start_pos - c2b_globals.wig->start_shift,
-                        c2b_globals.wig->start_pos + c2b_globals.wig->span - c2b_globals.wig->end_shift,
-                        c2b_globals.wig->id,
-                        c2b_globals.wig->pos_lines,
-                        c2b_globals.wig->score);
-            }            
-            c2b_globals.wig->start_pos += c2b_globals.wig->step;
-            c2b_globals.wig->start_write = kTrue;
-            memcpy(dest + *dest_size, dest_line_str, strlen(dest_line_str));
-            *dest_size += strlen(dest_line_str);
-        }
-        else {
-            int variable_step_column_fields = sscanf(src_line_str, 
-                                                     "%" SCNu64 "\t%lf\n", 
-                                                     &(c2b_globals.wig->start_pos), 
-                                                     &(c2b_globals.wig->score));
-            if (variable_step_column_fields != 2) {
-                fprintf(stderr, "Error: Invalid WIG line %u\n", c2b_globals.wig->line);
-                exit(EINVAL); /* Invalid argument (POSIX.1) */
-            }
-            c2b_globals.wig->pos_lines++;
-            if ((c2b_globals.wig->start_pos == 0) && (!c2b_globals.zero_indexed_flag)) {
-                fprintf(stderr, "Error: WIG data contains 0-indexed element at line %u\n", c2b_globals.wig->line);
-                fprintf(stderr, "       Consider adding --zero-indexed (-x) option to convert zero-indexed WIG data\n");
-                exit(EINVAL); /* Invalid argument (POSIX.1) */
-            }
-            if (!c2b_globals.wig->basename) {
-                sprintf(dest_line_str,
-                        "%s\t"                  \
-                        "%" PRIu64 "\t"         \
-                        "%" PRIu64 "\t"         \
-                        "id-%d\t"               \
-                        "%lf\n",
-                        c2b_globals.wig->chr,
-                        c2b_globals.wig->start_pos - c2b_globals.wig->start_shift,
-                        c2b_globals.wig->start_pos + c2b_globals.wig->span - c2b_globals.wig->end_shift,
-                        c2b_globals.wig->pos_lines,
-                        c2b_globals.wig->score);
-            }
-            else {
-                sprintf(dest_line_str,
-                        "%s\t"                  \
-                        "%" PRIu64 "\t"         \
-                        "%" PRIu64 "\t"         \
-                        "%s-%d\t"               \
-                        "%lf\n",
-                        c2b_globals.wig->chr,
-                        c2b_globals.wig->start_pos - c2b_globals.wig->start_shift,
-                        c2b_globals.wig->start_pos + c2b_globals.wig->span - c2b_globals.wig->end_shift,
-                        c2b_globals.wig->id,
-                        c2b_globals.wig->pos_lines,
-                        c2b_globals.wig->score);
-            }            
-            c2b_globals.wig->start_pos += c2b_globals.wig->step;
-            c2b_globals.wig->start_write = kTrue;
-            memcpy(dest + *dest_size, dest_line_str, strlen(dest_line_str));
-            *dest_size += strlen(dest_line_str);
-        }
+static void
+c2b_base64_encode(const unsigned char *data, size_t size, char *encoded)
+{
+    uint32_t triple = 0;
+    size_t n;
+
+    for (n = 0; n < size; n += 3) {
+        triple = (uint32_t) data[n] << 16;
+        if (n + 1 < size)
+            triple |= (uint32_t) data[n + 1] << 8;
+        if (n + 2 < size)
+            triple |= (uint32_t) data[n + 2];
+        *encoded++ = c2b_base64_alphabet[(triple >> 18) & 0x3f];
+        *encoded++ = c2b_base64_alphabet[(triple >> 12) & 0x3f];
+        *encoded++ = (n + 1 < size) ? c2b_base64_alphabet[(triple >> 6) & 0x3f] : '=';
+        *encoded++ = (n + 2 < size) ? c2b_base64_alphabet[triple & 0x3f] : '=';
     }
 }
 
 static void *
-c2b_read_bytes_from_stdin(void *arg)
+c2b_write_in_bytes_to_stdout(void *arg)
 {
     c2b_pipeline_stage_t *stage = (c2b_pipeline_stage_t *) arg;
     c2b_pipeset_t *pipes = stage->pipeset;
-    char buffer[C2B_MAX_LINE_LENGTH_VALUE];
-    ssize_t bytes_read;
+    int src_fd = pipes->in[stage->src][PIPE_READ];
     int exit_status = 0;
+    double stage_wall_start = c2b_seconds();
+    double stage_cpu_start = c2b_thread_cpu_seconds();
 
-#ifdef DEBUG
-    fprintf(stderr, "\t-> c2b_read_bytes_from_stdin | reading from fd     (%02d) | writing to fd     (%02d)\n", STDIN_FILENO, pipes->in[stage->dest][PIPE_WRITE]);
-#endif
+    if (!c2b_splice_bytes(&c2b_globals.pipe->stdout_stats, src_fd, STDOUT_FILENO))
+        c2b_copy_bytes(&c2b_globals.pipe->stdout_stats, src_fd, STDOUT_FILENO);
 
-#pragma GCC diagnostic push
-#pragma GCC diagnostic ignored "-Wunused-result"
-    while ((bytes_read = read(STDIN_FILENO, buffer, C2B_MAX_LINE_LENGTH_VALUE)) > 0) {
-        write(pipes->in[stage->dest][PIPE_WRITE], buffer, bytes_read);
-    }
-#pragma GCC diagnostic pop
-    close(pipes->in[stage->dest][PIPE_WRITE]);
+    c2b_globals.stats->output.wall_seconds = c2b_seconds() - stage_wall_start;
+    c2b_globals.stats->output.cpu_seconds = c2b_thread_cpu_seconds() - stage_cpu_start;
 
     if (WIFEXITED(stage->status) || WIFSIGNALED(stage->status)) {
         waitpid(stage->pid, &stage->status, WUNTRACED);
@@ -3574,317 +7244,544 @@ c2b_read_bytes_from_stdin(void *arg)
                     exit_status);
     }
 
-
     pthread_exit(NULL);
 }
 
-static void *
-c2b_process_intermediate_bytes_by_lines(void *arg)
+static boolean
+c2b_splice_bytes(c2b_io_stats_t *stats, int src_fd, int dest_fd)
 {
-    c2b_pipeline_stage_t *stage = (c2b_pipeline_stage_t *) arg;
-    c2b_pipeset_t *pipes = stage->pipeset;
-    char *src_buffer = NULL;
-    ssize_t src_buffer_size = C2B_MAX_LINE_LENGTH_VALUE;
-    ssize_t src_bytes_read = 0;
-    ssize_t remainder_length = 0;
-    ssize_t remainder_offset = 0;
-    char line_delim = '\n';
-    ssize_t lines_offset = 0;
-    ssize_t start_offset = 0;
-    ssize_t end_offset = 0;
-    char *dest_buffer = NULL;
-    ssize_t dest_buffer_size = C2B_MAX_LINE_LENGTH_VALUE * C2B_MAX_LINES_VALUE;
-    ssize_t dest_bytes_written = 0;
-    void (*line_functor)(char *, ssize_t *, char *, ssize_t) = stage->line_functor;
-    int exit_status = 0;
+    /* 
+       The source is a pipe, so its pages can be handed to dest_fd by the kernel,
+       without a copy through userspace. Not every dest_fd can take them (a terminal,
+       or a file opened for appending, for instance); on error, we return kFalse, and
+       the caller picks up with c2b_copy_bytes() from wherever splice() stopped.
+
+       A single splice() call can block on either end, so when timing we first wait
+       for input with poll(), which is counted as time blocked on read; once input is 
+       there, splice() only blocks on dest_fd.
+    */
 
-#ifdef DEBUG
-    fprintf(stderr, "\t-> c2b_process_intermediate_bytes_by_lines | reading from fd  (%02d) | writing to fd  (%02d)\n", pipes->out[stage->src][PIPE_READ], pipes->in[stage->dest][PIPE_WRITE]);
+#ifdef C2B_HAVE_SPLICE
+    ssize_t bytes_spliced = 0;
+    boolean is_timed = ((stats) && (c2b_globals.pipe->is_timed)) ? kTrue : kFalse;
+    struct pollfd src_poll;
+    double start = 0;
+
+    src_poll.fd = src_fd;
+    src_poll.events = POLLIN;
+    for (;;) {
+        if (is_timed) {
+            start = c2b_seconds();
+            poll(&src_poll, 1, -1);
+            stats->read_seconds += c2b_seconds() - start;
+            start = c2b_seconds();
+        }
+        bytes_spliced = splice(src_fd, NULL, dest_fd, NULL, C2B_SPLICE_CHUNK_SIZE, SPLICE_F_MOVE | SPLICE_F_MORE);
+        if (is_timed) {
+            stats->write_seconds += c2b_seconds() - start;
+            if (bytes_spliced > 0) {
+                stats->bytes_read += (uint64_t) bytes_spliced;
+                stats->bytes_written += (uint64_t) bytes_spliced;
+            }
+        }
+        if (bytes_spliced == 0)
+            return kTrue;
+        if ((bytes_spliced == -1) && (errno != EINTR) && (errno != EAGAIN))
+            return kFalse;
+    }
+#else
+    (void) stats;
+    (void) src_fd;
+    (void) dest_fd;
+    return kFalse;
 #endif
+}
+
+static void
+c2b_copy_bytes(c2b_io_stats_t *stats, int src_fd, int dest_fd)
+{
+    char buffer[C2B_MAX_LINE_LENGTH_VALUE];
+    ssize_t bytes_read;
+
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wunused-result"
+    while ((bytes_read = c2b_timed_read(stats, src_fd, buffer, C2B_MAX_LINE_LENGTH_VALUE)) > 0) {
+        c2b_timed_write(stats, dest_fd, buffer, bytes_read);
+    }
+#pragma GCC diagnostic pop
+}
+
+static inline ssize_t
+c2b_timed_read(c2b_io_stats_t *stats, int fd, void *buf, size_t count)
+{
+    ssize_t bytes_read = 0;
+    double start = 0;
+
+    if ((!stats) || (!c2b_globals.pipe->is_timed))
+        return read(fd, buf, count);
+
+    start = c2b_seconds();
+    bytes_read = read(fd, buf, count);
+    stats->read_seconds += c2b_seconds() - start;
+    if (bytes_read > 0)
+        stats->bytes_read += (uint64_t) bytes_read;
+
+    return bytes_read;
+}
+
+static inline ssize_t
+c2b_timed_write(c2b_io_stats_t *stats, int fd, const void *buf, size_t count)
+{
+    ssize_t bytes_written = 0;
+    double start = 0;
+
+    if ((!stats) || (!c2b_globals.pipe->is_timed))
+        return write(fd, buf, count);
+
+    start = c2b_seconds();
+    bytes_written = write(fd, buf, count);
+    stats->write_seconds += c2b_seconds() - start;
+    if (bytes_written > 0)
+        stats->bytes_written += (uint64_t) bytes_written;
+
+    return bytes_written;
+}
+
+static void
+c2b_set_pipe_size(int fd)
+{
+    static boolean is_warned = kFalse;
 
     /* 
-       We read from the src out pipe, then write to the dest in pipe 
+       The default size is only a hint: if the kernel will not grant it (it may be
+       over /proc/sys/fs/pipe-max-size), the pipe keeps its size. A size asked for with
+       --pipe-size that is not granted is reported, once
     */
-    
-    src_buffer = malloc(src_buffer_size);
-    if (!src_buffer) {
-        fprintf(stderr, "Error: Could not allocate space for intermediate source buffer.\n");
-        c2b_print_usage(stderr);
-        exit(ENOMEM); /* Not enough space (POSIX.1) */
-    }
 
-    dest_buffer = malloc(dest_buffer_size);
-    if (!dest_buffer) {
-        fprintf(stderr, "Error: Could not allocate space for intermediate destination buffer.\n");
-        c2b_print_usage(stderr);
-        exit(ENOMEM); /* Not enough space (POSIX.1) */
+#ifdef F_SETPIPE_SZ
+    if ((fcntl(fd, F_SETPIPE_SZ, (int) c2b_globals.pipe->size) == -1) && (c2b_globals.pipe->is_size_set) && (!is_warned)) {
+        fprintf(stderr, "Warning: Could not set pipe size to %" PRIu64 " bytes (%s); pipe size is %d bytes\n", c2b_globals.pipe->size, strerror(errno), fcntl(fd, F_GETPIPE_SZ));
+        is_warned = kTrue;
+    }
+#else
+    (void) fd;
+    if ((c2b_globals.pipe->is_size_set) && (!is_warned)) {
+        fprintf(stderr, "Warning: Pipe sizes cannot be set on this platform; --pipe-size is ignored\n");
+        is_warned = kTrue;
     }
-    dest_buffer[0] = '\0';
+#endif
+}
 
-    while ((src_bytes_read = read(pipes->out[stage->src][PIPE_READ],
-                                  src_buffer + remainder_length,
-                                  src_buffer_size - remainder_length)) > 0) {
+static inline double
+c2b_process_cpu_seconds()
+{
+    struct rusage usage;
 
-        /* 
-           So here's what src_buffer looks like initially; basically, some stuff separated by
-           newlines. The src_buffer will probably not terminate with a newline. So we first use 
-           a custom memrchr() call to find the remainder_offset index value:
-           
-           src_buffer  [  .  .  .  \n  .  .  .  \n  .  .  .  \n  .  .  .  .  .  .  ]
-           index        0 1 2 ...                            ^                    ^
-                                                             |                    |
-                                                             |   src_bytes_read --
-                                                             | 
-                                         remainder_offset --- 
+    /* user and system time of every thread in the process */
 
-           In other words, everything at and after index [remainder_offset + 1] to index
-           [src_bytes_read - 1] is a remainder byte ("R"):
+    if (getrusage(RUSAGE_SELF, &usage) == -1)
+        return 0;
+    return (double) usage.ru_utime.tv_sec + (double) usage.ru_utime.tv_usec / 1e6 + 
+           (double) usage.ru_stime.tv_sec + (double) usage.ru_stime.tv_usec / 1e6;
+}
 
-           src_buffer  [  .  .  .  \n  .  .  .  \n  .  .  .  \n R R R R R ]
-           
-           Assuming this failed:
+static inline double
+c2b_thread_cpu_seconds()
+{
+    struct timespec now;
 
-           If remainder_offset is -1 and we have read src_buffer_size bytes, then we know there 
-           are no newlines anywhere in the src_buffer and so we terminate early with an error state.
-           This would suggest either src_buffer_size is too small to hold a whole intermediate 
-           line or the input data is perhaps corrupt. Basically, something went wrong and we need 
-           to investigate.
-           
-           Asumming this worked:
-           
-           We can now parse byte indices {[0 .. remainder_offset]} into lines, which are fed one
-           by one to the line_functor. This functor parses out tab offsets and writes out a 
-           reordered string based on the rules for the format (see BEDOPS docs for reordering 
-           table).
-           
-           Finally, we write bytes from index [remainder_offset + 1] to [src_bytes_read - 1] 
-           back to src_buffer. We are writing remainder_length bytes:
-           
-           new_remainder_length = current_src_bytes_read + old_remainder_length - new_remainder_offset
-           
-           Note that we can leave the rest of the buffer untouched:
-           
-           src_buffer  [ R R R R R \n  .  .  .  \n  .  .  .  \n  .  .  .  ]
-           
-           On the subsequent read, we want to read() into src_buffer at position remainder_length
-           and read up to, at most, (src_buffer_size - remainder_length) bytes:
-           
-           read(byte_source, 
-                src_buffer + remainder_length,
-                src_buffer_size - remainder_length)
+    if (clock_gettime(CLOCK_THREAD_CPUTIME_ID, &now) == -1)
+        return 0;
+    return (double) now.tv_sec + (double) now.tv_nsec / 1e9;
+}
 
-           Second and subsequent reads should reduce the maximum number of src_bytes_read from 
-           src_buffer_size to something smaller.
-        */
+static void
+c2b_add_record_counts(const c2b_record_counts_t *counts)
+{
+    pthread_mutex_lock(&c2b_globals.stats->lock);
+    c2b_globals.stats->counts.lines += counts->lines;
+    c2b_globals.stats->counts.unmapped_reads += counts->unmapped_reads;
+    c2b_globals.stats->counts.filtered_reads += counts->filtered_reads;
+    c2b_globals.stats->counts.filtered_alleles += counts->filtered_alleles;
+    c2b_globals.stats->counts.unpaired_reads += counts->unpaired_reads;
+    c2b_globals.stats->counts.orphan_reads += counts->orphan_reads;
+    pthread_mutex_unlock(&c2b_globals.stats->lock);
+}
 
-        c2b_memrchr_offset(&remainder_offset, src_buffer, src_buffer_size, src_bytes_read + remainder_length, line_delim);
+static void
+c2b_print_stats()
+{
+    c2b_stats_params_t *st = c2b_globals.stats;
+    c2b_pipe_params_t *pp = c2b_globals.pipe;
+    struct rusage self_usage;
+    struct rusage child_usage;
+    FILE *out = stderr;
+    boolean has_stdout_stage = ((!c2b_globals.sort->is_enabled) && (c2b_globals.output_format_idx == BED_FORMAT)) ? kTrue : kFalse;
+    double convert_cpu_seconds = 0;
+    size_t n;
 
-        if (remainder_offset == -1) {
-            if (src_bytes_read + remainder_length == src_buffer_size) {
-                fprintf(stderr, "Error: Could not find newline in intermediate buffer; check input\n");
-                c2b_print_usage(stderr);
-                exit(EINVAL); /* Invalid argument (POSIX.1) */
-            }
-            remainder_offset = 0;
-        }
+    if (!st->is_enabled)
+        return;
 
-        /* 
-           We next want to process bytes from index [0] to index [remainder_offset - 1] for all
-           lines contained within. We basically build a buffer containing all translated 
-           lines to write downstream.
-        */
+    if (st->path) {
+        out = fopen(st->path, "w");
+        if (!out) {
+            fprintf(stderr, "Error: Could not open stats file [%s] (%s)\n", st->path, strerror(errno));
+            exit(EINVAL); /* Invalid argument (POSIX.1) */
+        }
+    }
 
-        lines_offset = 0;
-        start_offset = 0;
-        dest_bytes_written = 0;
-        while (lines_offset < remainder_offset) {
-            if (src_buffer[lines_offset] == line_delim) {
-                end_offset = lines_offset;
-                /* for a given line from src, we write dest_bytes_written number of bytes to dest_buffer (plus written offset) */
-                (*line_functor)(dest_buffer, &dest_bytes_written, src_buffer + start_offset, end_offset - start_offset);
-                start_offset = end_offset + 1;
-            }
-            lines_offset++;            
+    memset(&self_usage, 0, sizeof(struct rusage));
+    memset(&child_usage, 0, sizeof(struct rusage));
+    getrusage(RUSAGE_SELF, &self_usage);
+    getrusage(RUSAGE_CHILDREN, &child_usage);
+
+    /* the stdout thread runs alongside conversion, so its time comes out of the convert stage */
+
+    convert_cpu_seconds = st->convert.cpu_seconds;
+    if (has_stdout_stage)
+        convert_cpu_seconds = (convert_cpu_seconds > st->output.cpu_seconds) ? convert_cpu_seconds - st->output.cpu_seconds : 0;
+
+    fprintf(out, "{\n");
+    fprintf(out, "  \"version\": \"%s\",\n", C2B_VERSION);
+    fprintf(out, "  \"input_format\": \"%s\",\n", c2b_globals.input_format);
+    fprintf(out, "  \"output_format\": \"%s\",\n", c2b_globals.output_format);
+    fprintf(out, "  \"sorted\": %s,\n", (c2b_globals.sort->is_enabled) ? "true" : "false");
+    fprintf(out, "  \"threads\": %u,\n", c2b_globals.threads);
+    fprintf(out, "  \"wall_seconds\": %.6f,\n", c2b_seconds() - st->start_seconds);
+    fprintf(out, "  \"user_seconds\": %.6f,\n", (double) self_usage.ru_utime.tv_sec + (double) self_usage.ru_utime.tv_usec / 1e6);
+    fprintf(out, "  \"system_seconds\": %.6f,\n", (double) self_usage.ru_stime.tv_sec + (double) self_usage.ru_stime.tv_usec / 1e6);
+    fprintf(out, "  \"max_rss_kilobytes\": %ld,\n", self_usage.ru_maxrss);
+    fprintf(out, "  \"stages\": [\n");
+    fprintf(out, "    {\n");
+    fprintf(out, "      \"name\": \"convert\",\n");
+    fprintf(out, "      \"bytes_in\": %" PRIu64 ",\n", pp->convert_stats.bytes_read);
+    fprintf(out, "      \"bytes_out\": %" PRIu64 ",\n", st->bytes_out);
+    fprintf(out, "      \"lines_in\": %" PRIu64 ",\n", st->counts.lines);
+    fprintf(out, "      \"lines_out\": %" PRIu64 ",\n", st->lines_out);
+    fprintf(out, "      \"records_dropped\": { \"unmapped_reads\": %" PRIu64 ", \"filtered_reads\": %" PRIu64 ", \"filtered_alleles\": %" PRIu64 ", \"unpaired_reads\": %" PRIu64 ", \"orphan_reads\": %" PRIu64 " },\n", st->counts.unmapped_reads, st->counts.filtered_reads, st->counts.filtered_alleles, st->counts.unpaired_reads, st->counts.orphan_reads);
+    fprintf(out, "      \"wall_seconds\": %.6f,\n", st->convert.wall_seconds);
+    fprintf(out, "      \"cpu_seconds\": %.6f\n", convert_cpu_seconds);
+    if (c2b_globals.sort->is_enabled) {
+        fprintf(out, "    },\n");
+        fprintf(out, "    {\n");
+        fprintf(out, "      \"name\": \"%s\",\n", (c2b_globals.output_format_idx == STARCH_FORMAT) ? "starch" : "sort");
+        fprintf(out, "      \"bytes_in\": %" PRIu64 ",\n", st->bytes_out);
+        fprintf(out, "      \"bytes_out\": %" PRIu64 ",\n", pp->sort_stats.bytes_written);
+        fprintf(out, "      \"lines_in\": %" PRIu64 ",\n", st->sorted_records);
+        fprintf(out, "      \"lines_out\": %" PRIu64 ",\n", st->sorted_records);
+        fprintf(out, "      \"wall_seconds\": %.6f,\n", st->sort.wall_seconds);
+        fprintf(out, "      \"cpu_seconds\": %.6f\n", st->sort.cpu_seconds);
+    }
+    else if (has_stdout_stage) {
+        fprintf(out, "    },\n");
+        fprintf(out, "    {\n");
+        fprintf(out, "      \"name\": \"stdout\",\n");
+        fprintf(out, "      \"bytes_in\": %" PRIu64 ",\n", pp->stdout_stats.bytes_read);
+        fprintf(out, "      \"bytes_out\": %" PRIu64 ",\n", pp->stdout_stats.bytes_written);
+        fprintf(out, "      \"wall_seconds\": %.6f,\n", st->output.wall_seconds);
+        fprintf(out, "      \"cpu_seconds\": %.6f\n", st->output.cpu_seconds);
+    }
+    fprintf(out, "    }\n");
+    fprintf(out, "  ],\n");
+    if (c2b_globals.sort->is_enabled) {
+        fprintf(out, "  \"sort\": {\n");
+        fprintf(out, "    \"records\": %" PRIu64 ",\n", st->sorted_records);
+        fprintf(out, "    \"memory_limit_bytes\": %" PRIu64 ",\n", st->sort_max_memory);
+        fprintf(out, "    \"peak_memory_bytes\": %" PRIu64 ",\n", st->sort_peak_memory);
+        fprintf(out, "    \"run_file_bytes\": %jd,\n", (intmax_t) st->sort_run_file_size);
+        fprintf(out, "    \"write_seconds\": %.6f,\n", st->sort_write_seconds);
+        fprintf(out, "    \"runs\": [");
+        for (n = 0; n < st->num_sort_runs; n++) {
+            fprintf(out, "%s\n      { \"records\": %zu, \"memory_bytes\": %" PRIu64 ", \"bytes\": %jd, \"sort_seconds\": %.6f, \"write_seconds\": %.6f }",
+                    (n > 0) ? "," : "",
+                    st->sort_runs[n].num_records,
+                    st->sort_runs[n].memory,
+                    (intmax_t) st->sort_runs[n].size,
+                    st->sort_runs[n].sort_seconds,
+                    st->sort_runs[n].write_seconds);
         }
-        
-        /* 
-           We have filled up dest_buffer with translated bytes (dest_bytes_written of them)
-           and can now write() this buffer to the in-pipe of the destination stage
-        */
-        
-#pragma GCC diagnostic push
-#pragma GCC diagnostic ignored "-Wunused-result"
-        write(pipes->in[stage->dest][PIPE_WRITE], dest_buffer, dest_bytes_written);
-#pragma GCC diagnostic pop
+        fprintf(out, "%s]\n", (st->num_sort_runs > 0) ? "\n    " : "");
+        fprintf(out, "  },\n");
+    }
+    else
+        fprintf(out, "  \"sort\": null,\n");
+    fprintf(out, "  \"line\": {\n");
+    fprintf(out, "    \"buffer_growths\": %zu,\n", c2b_globals.line->num_growths);
+    fprintf(out, "    \"largest_buffer_bytes\": %zd,\n", c2b_globals.line->largest_buffer_size);
+    fprintf(out, "    \"peak_buffer_bytes\": %zd,\n", c2b_globals.line->peak_buffer_bytes);
+    fprintf(out, "    \"buffer_limit_bytes\": %" PRIu64 "\n", c2b_globals.line->max_line_length);
+    fprintf(out, "  },\n");
+    fprintf(out, "  \"pipe\": {\n");
+    fprintf(out, "    \"size_bytes\": %" PRIu64 ",\n", pp->size);
+    fprintf(out, "    \"stages\": [\n");
+    fprintf(out, "      { \"name\": \"convert\", \"bytes_read\": %" PRIu64 ", \"read_wait_seconds\": %.6f, \"bytes_written\": %" PRIu64 ", \"write_wait_seconds\": %.6f }",
+            pp->convert_stats.bytes_read, pp->convert_stats.read_seconds, pp->convert_stats.bytes_written, pp->convert_stats.write_seconds);
+    if (c2b_globals.sort->is_enabled) {
+        fprintf(out, ",\n      { \"name\": \"%s\", \"bytes_written\": %" PRIu64 ", \"write_wait_seconds\": %.6f }",
+                (c2b_globals.output_format_idx == STARCH_FORMAT) ? "starch" : "sort",
+                pp->sort_stats.bytes_written, pp->sort_stats.write_seconds);
+    }
+    else if (has_stdout_stage) {
+        fprintf(out, ",\n      { \"name\": \"stdout\", \"bytes_read\": %" PRIu64 ", \"read_wait_seconds\": %.6f, \"bytes_written\": %" PRIu64 ", \"write_wait_seconds\": %.6f }",
+                pp->stdout_stats.bytes_read, pp->stdout_stats.read_seconds, pp->stdout_stats.bytes_written, pp->stdout_stats.write_seconds);
+    }
+    fprintf(out, "\n    ]\n");
+    fprintf(out, "  },\n");
+    fprintf(out, "  \"children\": { \"user_seconds\": %.6f, \"system_seconds\": %.6f }\n",
+            (double) child_usage.ru_utime.tv_sec + (double) child_usage.ru_utime.tv_usec / 1e6,
+            (double) child_usage.ru_stime.tv_sec + (double) child_usage.ru_stime.tv_usec / 1e6);
+    fprintf(out, "}\n");
+
+    if (out != stderr)
+        fclose(out);
+}
 
-        remainder_length = src_bytes_read + remainder_length - remainder_offset;
-        memcpy(src_buffer, src_buffer + remainder_offset, remainder_length);
-    }
+static void
+c2b_memrchr_offset(ssize_t *offset, char *buf, ssize_t buf_size, ssize_t len, char delim)
+{
+    ssize_t left = len;
+    
+    *offset = -1;
+    if (len > buf_size)
+        return;
 
-    close(pipes->in[stage->dest][PIPE_WRITE]);
+    while (left > 0) {
+        if (buf[left - 1] == delim) {
+            *offset = left;
+            return;
+        }
+        left--;
+    }
+}
 
-    if (src_buffer) 
-        free(src_buffer), src_buffer = NULL;
+static ssize_t
+c2b_grow_line_capacity(ssize_t capacity)
+{
+    ssize_t new_capacity = 2 * capacity;
 
-    if (dest_buffer)
-        free(dest_buffer), dest_buffer = NULL;
+    /* a buffer that is full without a newline holds part of one line, which needs more room */
 
-    if (WIFEXITED(stage->status) || WIFSIGNALED(stage->status)) {
-        waitpid(stage->pid, &stage->status, WUNTRACED);
-        exit_status = WEXITSTATUS(stage->status);
-        if (exit_status != 0) 
-            fprintf(stderr, 
-                    "Error: Stage [%s] failed -- exit status [%d | %d]\n", 
-                    stage->description,
-                    stage->status, 
-                    exit_status);
+    if ((uint64_t) capacity >= c2b_globals.line->max_line_length) {
+        fprintf(stderr, "Error: Input line is longer than %" PRIu64 " bytes; check input, or raise --max-line-length\n", c2b_globals.line->max_line_length);
+        c2b_print_usage(stderr);
+        exit(EINVAL); /* Invalid argument (POSIX.1) */
     }
+    if ((uint64_t) new_capacity > c2b_globals.line->max_line_length)
+        new_capacity = (ssize_t) c2b_globals.line->max_line_length;
 
-    pthread_exit(NULL);
+    c2b_globals.line->num_growths++;
+    if (new_capacity > c2b_globals.line->largest_buffer_size)
+        c2b_globals.line->largest_buffer_size = new_capacity;
+
+    return new_capacity;
 }
 
-static void *
-c2b_write_in_bytes_to_in_process(void *arg)
+static char *
+c2b_resize_line_buffer(char *buffer, ssize_t capacity, ssize_t new_capacity)
 {
-    c2b_pipeline_stage_t *stage = (c2b_pipeline_stage_t *) arg;
-    c2b_pipeset_t *pipes = stage->pipeset;
-    char buffer[C2B_MAX_LINE_LENGTH_VALUE];
-    ssize_t bytes_read;
-    int exit_status = 0;
+    char *resized_buffer = realloc(buffer, new_capacity);
 
-#pragma GCC diagnostic push
-#pragma GCC diagnostic ignored "-Wunused-result"
-    /* read buffer from p->in[1] and write buffer to p->in[2] */
-    while ((bytes_read = read(pipes->in[stage->src][PIPE_READ], buffer, C2B_MAX_LINE_LENGTH_VALUE)) > 0) { 
-        write(pipes->in[stage->dest][PIPE_WRITE], buffer, bytes_read);
+    if (!resized_buffer) {
+        fprintf(stderr, "Error: Could not allocate space for %zd-byte line buffer\n", new_capacity);
+        c2b_print_usage(stderr);
+        exit(ENOMEM); /* Not enough space (POSIX.1) */
     }
-#pragma GCC diagnostic pop
+    c2b_globals.line->buffer_bytes += new_capacity - capacity;
+    if (c2b_globals.line->buffer_bytes > c2b_globals.line->peak_buffer_bytes)
+        c2b_globals.line->peak_buffer_bytes = c2b_globals.line->buffer_bytes;
 
-    close(pipes->in[stage->dest][PIPE_WRITE]);
+    return resized_buffer;
+}
 
-    if (WIFEXITED(stage->status) || WIFSIGNALED(stage->status)) {
-        waitpid(stage->pid, &stage->status, WUNTRACED);
-        exit_status = WEXITSTATUS(stage->status);
-        if (exit_status != 0) 
-            fprintf(stderr, 
-                    "Error: Stage [%s] failed -- exit status [%d | %d]\n", 
-                    stage->description,
-                    stage->status, 
-                    exit_status);
+static void
+c2b_init_delim_kernel()
+{
+    c2b_globals.delim_kernel = c2b_scan_delims_scalar;
+    c2b_globals.delim_kernel_name = "scalar";
+
+#ifdef C2B_HAVE_X86_SIMD
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) {
+        c2b_globals.delim_kernel = c2b_scan_delims_avx2;
+        c2b_globals.delim_kernel_name = "avx2";
     }
+    else if (__builtin_cpu_supports("sse2")) {
+        c2b_globals.delim_kernel = c2b_scan_delims_sse2;
+        c2b_globals.delim_kernel_name = "sse2";
+    }
+#endif
 
-    pthread_exit(NULL);
+#ifdef DEBUG
+    fprintf(stderr, "\t-> c2b_init_delim_kernel | using [%s] delimiter scan kernel\n", c2b_globals.delim_kernel_name);
+#endif
 }
 
-static void *
-c2b_write_out_bytes_to_in_process(void *arg)
+static void
+c2b_scan_delims_scalar(const char *src, size_t src_size, uint64_t *line_bits, uint64_t *tab_bits)
 {
-    c2b_pipeline_stage_t *stage = (c2b_pipeline_stage_t *) arg;
-    c2b_pipeset_t *pipes = stage->pipeset;
-    char buffer[C2B_MAX_LINE_LENGTH_VALUE];
-    ssize_t bytes_read;
-    int exit_status = 0;
-
-#pragma GCC diagnostic push
-#pragma GCC diagnostic ignored "-Wunused-result"
-    /* read buffer from p->out[1] and write buffer to p->in[2] */
-    while ((bytes_read = read(pipes->out[stage->src][PIPE_READ], buffer, C2B_MAX_LINE_LENGTH_VALUE)) > 0) { 
-        write(pipes->in[stage->dest][PIPE_WRITE], buffer, bytes_read);
+    size_t num_words = (src_size + 63) / 64;
+    size_t word_idx;
+    size_t byte_idx;
+
+    /* bits past the end of src, in the last word, are left clear */
+
+    for (word_idx = 0; word_idx < num_words; word_idx++) {
+        const char *word_src = src + word_idx * 64;
+        size_t word_size = ((src_size - word_idx * 64) < 64) ? (src_size - word_idx * 64) : 64;
+        uint64_t lines = 0;
+        uint64_t tabs = 0;
+        for (byte_idx = 0; byte_idx < word_size; byte_idx++) {
+            lines |= (uint64_t) (word_src[byte_idx] == c2b_line_delim) << byte_idx;
+            tabs |= (uint64_t) (word_src[byte_idx] == c2b_tab_delim) << byte_idx;
+        }
+        line_bits[word_idx] = lines;
+        tab_bits[word_idx] = tabs;
     }
-#pragma GCC diagnostic pop
+}
 
-    close(pipes->in[stage->dest][PIPE_WRITE]);
+#ifdef C2B_HAVE_X86_SIMD
 
-    if (WIFEXITED(stage->status) || WIFSIGNALED(stage->status)) {
-        waitpid(stage->pid, &stage->status, WUNTRACED);
-        exit_status = WEXITSTATUS(stage->status);
-        if (exit_status != 0) 
-            fprintf(stderr, 
-                    "Error: Stage [%s] failed -- exit status [%d | %d]\n", 
-                    stage->description,
-                    stage->status, 
-                    exit_status);
+static void
+c2b_scan_delims_sse2(const char *src, size_t src_size, uint64_t *line_bits, uint64_t *tab_bits)
+{
+    const __m128i newlines = _mm_set1_epi8(c2b_line_delim);
+    const __m128i tabs = _mm_set1_epi8(c2b_tab_delim);
+    size_t num_full_words = src_size / 64;
+    size_t word_idx;
+    int lane;
+
+    for (word_idx = 0; word_idx < num_full_words; word_idx++) {
+        const char *word_src = src + word_idx * 64;
+        uint64_t line_word = 0;
+        uint64_t tab_word = 0;
+        for (lane = 0; lane < 4; lane++) {
+            __m128i v = _mm_loadu_si128((const __m128i *) (word_src + 16 * lane));
+            line_word |= (uint64_t) (uint16_t) _mm_movemask_epi8(_mm_cmpeq_epi8(v, newlines)) << (16 * lane);
+            tab_word |= (uint64_t) (uint16_t) _mm_movemask_epi8(_mm_cmpeq_epi8(v, tabs)) << (16 * lane);
+        }
+        line_bits[word_idx] = line_word;
+        tab_bits[word_idx] = tab_word;
     }
 
-    pthread_exit(NULL);
+    if (num_full_words * 64 < src_size)
+        c2b_scan_delims_scalar(src + num_full_words * 64, src_size - num_full_words * 64, line_bits + num_full_words, tab_bits + num_full_words);
 }
 
-static void *
-c2b_write_in_bytes_to_stdout(void *arg)
+__attribute__((target("avx2")))
+static void
+c2b_scan_delims_avx2(const char *src, size_t src_size, uint64_t *line_bits, uint64_t *tab_bits)
 {
-    c2b_pipeline_stage_t *stage = (c2b_pipeline_stage_t *) arg;
-    c2b_pipeset_t *pipes = stage->pipeset;
-    char buffer[C2B_MAX_LINE_LENGTH_VALUE];
-    ssize_t bytes_read;
-    int exit_status = 0;
+    const __m256i newlines = _mm256_set1_epi8(c2b_line_delim);
+    const __m256i tabs = _mm256_set1_epi8(c2b_tab_delim);
+    size_t num_full_words = src_size / 64;
+    size_t word_idx;
+
+    for (word_idx = 0; word_idx < num_full_words; word_idx++) {
+        const char *word_src = src + word_idx * 64;
+        __m256i lo = _mm256_loadu_si256((const __m256i *) word_src);
+        __m256i hi = _mm256_loadu_si256((const __m256i *) (word_src + 32));
+        line_bits[word_idx] = (uint64_t) (uint32_t) _mm256_movemask_epi8(_mm256_cmpeq_epi8(lo, newlines)) | 
+                              ((uint64_t) (uint32_t) _mm256_movemask_epi8(_mm256_cmpeq_epi8(hi, newlines)) << 32);
+        tab_bits[word_idx] = (uint64_t) (uint32_t) _mm256_movemask_epi8(_mm256_cmpeq_epi8(lo, tabs)) | 
+                             ((uint64_t) (uint32_t) _mm256_movemask_epi8(_mm256_cmpeq_epi8(hi, tabs)) << 32);
+    }
+
+    if (num_full_words * 64 < src_size)
+        c2b_scan_delims_scalar(src + num_full_words * 64, src_size - num_full_words * 64, line_bits + num_full_words, tab_bits + num_full_words);
+}
 
-#pragma GCC diagnostic push
-#pragma GCC diagnostic ignored "-Wunused-result"
-    while ((bytes_read = read(pipes->in[stage->src][PIPE_READ], buffer, C2B_MAX_LINE_LENGTH_VALUE)) > 0) {
-        write(STDOUT_FILENO, buffer, bytes_read);
-    }
-#pragma GCC diagnostic pop
+#endif
 
-    if (WIFEXITED(stage->status) || WIFSIGNALED(stage->status)) {
-        waitpid(stage->pid, &stage->status, WUNTRACED);
-        exit_status = WEXITSTATUS(stage->status);
-        if (exit_status != 0) 
-            fprintf(stderr, 
-                    "Error: Stage [%s] failed -- exit status [%d | %d]\n", 
-                    stage->description,
-                    stage->status, 
-                    exit_status);
+static void
+c2b_init_delim_index(c2b_delim_index_t *idx)
+{
+    idx->src = NULL;
+    idx->src_size = 0;
+    idx->line_bits = NULL;
+    idx->tab_bits = NULL;
+    idx->capacity = 0;
+}
+
+static void
+c2b_delete_delim_index(c2b_delim_index_t *idx)
+{
+    free(idx->line_bits), idx->line_bits = NULL;
+    free(idx->tab_bits), idx->tab_bits = NULL;
+    idx->src = NULL;
+    idx->src_size = 0;
+    idx->capacity = 0;
+}
+
+static void
+c2b_index_delims(c2b_delim_index_t *idx, char *src, ssize_t src_size)
+{
+    size_t num_words = ((size_t) src_size + 63) / 64;
+
+    if (num_words > idx->capacity) {
+        uint64_t *line_bits = realloc(idx->line_bits, num_words * sizeof(uint64_t));
+        uint64_t *tab_bits = NULL;
+        if (line_bits)
+            idx->line_bits = line_bits;
+        tab_bits = realloc(idx->tab_bits, num_words * sizeof(uint64_t));
+        if (tab_bits)
+            idx->tab_bits = tab_bits;
+        if ((!line_bits) || (!tab_bits)) {
+            fprintf(stderr, "Error: Could not allocate space for delimiter index\n");
+            c2b_print_usage(stderr);
+            exit(ENOMEM); /* Not enough space (POSIX.1) */
+        }
+        idx->capacity = num_words;
     }
 
-    pthread_exit(NULL);
+    (*c2b_globals.delim_kernel)(src, (size_t) src_size, idx->line_bits, idx->tab_bits);
+    idx->src = src;
+    idx->src_size = src_size;
 }
 
-static void *
-c2b_write_out_bytes_to_stdout(void *arg)
+static inline ssize_t
+c2b_next_delim(const uint64_t *bits, ssize_t from, ssize_t to)
 {
-    c2b_pipeline_stage_t *stage = (c2b_pipeline_stage_t *) arg;
-    c2b_pipeset_t *pipes = stage->pipeset;
-    char buffer[C2B_MAX_LINE_LENGTH_VALUE];
-    ssize_t bytes_read;
-    int exit_status = 0;
+    /* offset of the first set bit in [from, to), or -1 */
 
-#pragma GCC diagnostic push
-#pragma GCC diagnostic ignored "-Wunused-result"
-    while ((bytes_read = read(pipes->out[stage->src][PIPE_READ], buffer, C2B_MAX_LINE_LENGTH_VALUE)) > 0) {
-        write(STDOUT_FILENO, buffer, bytes_read);
-    }
-#pragma GCC diagnostic pop
+    ssize_t word_idx = from >> 6;
+    uint64_t word = 0;
+    ssize_t posn = 0;
 
-    if (WIFEXITED(stage->status) || WIFSIGNALED(stage->status)) {
-        waitpid(stage->pid, &stage->status, WUNTRACED);
-        exit_status = WEXITSTATUS(stage->status);
-        if (exit_status != 0) 
-            fprintf(stderr, 
-                    "Error: Stage [%s] failed -- exit status [%d | %d]\n", 
-                    stage->description,
-                    stage->status, 
-                    exit_status);
+    if (from >= to)
+        return -1;
+
+    word = bits[word_idx] & (~UINT64_C(0) << (from & 63));
+    while (!word) {
+        if (((++word_idx) << 6) >= to)
+            return -1;
+        word = bits[word_idx];
     }
+    posn = (word_idx << 6) + __builtin_ctzll(word);
 
-    pthread_exit(NULL);
+    return (posn < to) ? posn : -1;
 }
 
-static void
-c2b_memrchr_offset(ssize_t *offset, char *buf, ssize_t buf_size, ssize_t len, char delim)
+static inline ssize_t
+c2b_last_delim(const uint64_t *bits, ssize_t to)
 {
-    ssize_t left = len;
-    
-    *offset = -1;
-    if (len > buf_size)
-        return;
+    /* offset of the last set bit in [0, to), or -1 */
 
-    while (left > 0) {
-        if (buf[left - 1] == delim) {
-            *offset = left;
-            return;
-        }
-        left--;
+    ssize_t word_idx = (to - 1) >> 6;
+    int top_bit = (int) ((to - 1) & 63);
+    uint64_t word = 0;
+
+    if (to <= 0)
+        return -1;
+
+    word = bits[word_idx] & ((top_bit == 63) ? ~UINT64_C(0) : ((UINT64_C(1) << (top_bit + 1)) - 1));
+    while (!word) {
+        if (word_idx == 0)
+            return -1;
+        word = bits[--word_idx];
     }
+
+    return (word_idx << 6) + 63 - __builtin_clzll(word);
 }
 
 static void
@@ -3940,6 +7837,9 @@ c2b_init_pipeset(c2b_pipeset_t *p, const size_t num)
 	c2b_pipe4_cloexec(p->out[n]);
 	c2b_pipe4_cloexec(p->err[n]);
 
+        c2b_set_pipe_size(p->in[n][PIPE_READ]);
+        c2b_set_pipe_size(p->out[n][PIPE_READ]);
+
         /* set stderr as output for each err write */
         p->err[n][PIPE_WRITE] = STDERR_FILENO;
     }
@@ -4009,12 +7909,6 @@ c2b_set_close_exec_flag(int fd)
     fcntl(fd, F_SETFD, fcntl(fd, F_GETFD) | FD_CLOEXEC);
 }
 
-static void
-c2b_unset_close_exec_flag(int fd)
-{
-    fcntl(fd, F_SETFD, fcntl(fd, F_GETFD) & ~FD_CLOEXEC);
-}
-
 static int
 c2b_pipe4(int fd[2], int flags)
 {
@@ -4028,353 +7922,349 @@ c2b_pipe4(int fd[2], int flags)
     return ret;
 }
 
-static pid_t
-c2b_popen4(const char* cmd, int pin[2], int pout[2], int perr[2], int flags)
+static char *
+c2b_strsep(char **stringp, const char *delim)
 {
-    pid_t ret = fork();
-    int execl_ret = 0;
+    char *s;
+    const char *spanp;
+    int c, sc;
+    char *tok;
 
-    if (ret < 0) {
-        fprintf(stderr, "fork() failed!\n");
-        return ret;
-    } 
-    else if (ret == 0) {
-        /* 
-           Child-side of fork
-        */
-        if (flags & POPEN4_FLAG_CLOSE_CHILD_STDIN) {
-            close(STDIN_FILENO);
-        }
-        else {
-            c2b_unset_close_exec_flag(pin[PIPE_READ]);
-            dup2(pin[PIPE_READ], STDIN_FILENO);
-        }
-        if (flags & POPEN4_FLAG_CLOSE_CHILD_STDOUT) {
-            close(STDOUT_FILENO);
-        }
-        else {
-            c2b_unset_close_exec_flag(pout[PIPE_WRITE]);
-            dup2(pout[PIPE_WRITE], STDOUT_FILENO);
-        }
-        if (flags & POPEN4_FLAG_CLOSE_CHILD_STDERR) {
-            close(STDERR_FILENO);
-        }
-        else {
-            c2b_unset_close_exec_flag(perr[PIPE_WRITE]);
-            dup2(perr[PIPE_WRITE], STDERR_FILENO);
-        }
-        execl_ret = execl("/bin/sh", "/bin/sh", "-c", cmd, NULL);
-        if (execl_ret == -1) {
-            int errsv = errno;
-            fprintf(stderr, "Error: exec() failed (%d)\n", errsv);
-            exit(errsv);
-        }
-    }
-    else {
-        /* 
-           Parent-side of fork
-        */
-        if (~flags & POPEN4_FLAG_NOCLOSE_PARENT_STDIN && ~flags & POPEN4_FLAG_CLOSE_CHILD_STDIN) {
-            close(pin[PIPE_READ]);
-        }
-        if (~flags & POPEN4_FLAG_NOCLOSE_PARENT_STDOUT && ~flags & POPEN4_FLAG_CLOSE_CHILD_STDOUT) {
-            close(pout[PIPE_WRITE]);
-        }
-        if (~flags & POPEN4_FLAG_NOCLOSE_PARENT_STDERR && ~flags & POPEN4_FLAG_CLOSE_CHILD_STDERR) {
-            //close(perr[PIPE_WRITE]);
-        }
-        return ret;
+    if ((s = *stringp) == NULL)
+        return NULL;
+
+    for (tok = s;;) {
+        c = *s++;
+        spanp = delim;
+        do {
+            if ((sc = *spanp++) == c) {
+                if (c == 0)
+                    s = NULL;
+                else
+                    s[-1] = 0;
+                *stringp = s;
+                return tok;
+            }
+        } while (sc != 0);
     }
 
-    /* Unreachable */
-    return ret;
+    return NULL;
 }
 
-static void
-c2b_test_dependencies()
+static inline int
+c2b_split_fields(c2b_context_t *ctx, char *src, ssize_t src_size, c2b_span_t *fields)
 {
-#ifdef DEBUG
-    fprintf(stderr, "--- c2b_test_dependencies() - enter ---\n");
-#endif
-
-    char *p = NULL;
-    char *path = NULL;
+    /* 
+       Split the line into tab-delimited field spans, without copying; the
+       return value is the index of the last field, i.e., the number of 
+       delimiters found. If the line lies within the block covered by the 
+       context's delimiter index, tabs are taken from its bitmap; lines never 
+       hold a newline, as they were split on them.
+    */
 
-    if ((p = getenv("PATH")) == NULL) {
-        fprintf(stderr, "Error: Cannot retrieve environment PATH variable\n");
-        c2b_print_usage(stderr);
-        exit(EINVAL); /* Invalid argument (POSIX.1) */
-    }
-    path = malloc(strlen(p) + 1);
-    if (!path) {
-        fprintf(stderr, "Error: Cannot allocate space for path variable copy\n");
-        c2b_print_usage(stderr);
-        exit(ENOMEM); /* Not enough space (POSIX.1) */
+    int field_idx = 0;
+    ssize_t field_start = 0;
+    ssize_t current_src_posn = -1;
+    c2b_delim_index_t *idx = ctx->delims;
+
+    if ((idx) && (src >= idx->src) && (src + src_size <= idx->src + idx->src_size)) {
+        ssize_t src_offset = src - idx->src;
+        ssize_t src_end = src_offset + src_size;
+        ssize_t field_offset = src_offset;
+        while ((current_src_posn = c2b_next_delim(idx->tab_bits, field_offset, src_end)) != -1) {
+            fields[field_idx].s = idx->src + field_offset;
+            fields[field_idx].length = current_src_posn - field_offset;
+            field_offset = current_src_posn + 1;
+            field_idx++;
+            if (field_idx >= C2B_MAX_FIELD_COUNT_VALUE) {
+                fprintf(stderr, "Error: Invalid field count (%d) -- input file may have too many fields\n", field_idx);
+                c2b_print_usage(stderr);
+                exit(EINVAL); /* Invalid argument (POSIX.1) */
+            }
+        }
+        fields[field_idx].s = idx->src + field_offset;
+        fields[field_idx].length = src_end - field_offset;
+        return field_idx;
     }
-    memcpy(path, p, strlen(p) + 1);
 
-    if ((c2b_globals.input_format_idx == BAM_FORMAT) || (c2b_globals.input_format_idx == SAM_FORMAT)) {
-        char *samtools = NULL;
-        samtools = malloc(strlen(c2b_samtools) + 1);
-        if (!samtools) {
-            fprintf(stderr, "Error: Cannot allocate space for samtools variable copy\n");
-            c2b_print_usage(stderr);
-            exit(ENOMEM); /* Not enough space (POSIX.1) */
+    while (++current_src_posn < src_size) {
+        if ((src[current_src_posn] == c2b_tab_delim) || (src[current_src_posn] == c2b_line_delim)) {
+            fields[field_idx].s = src + field_start;
+            fields[field_idx].length = current_src_posn - field_start;
+            field_start = current_src_posn + 1;
+            field_idx++;
         }
-        memcpy(samtools, c2b_samtools, strlen(c2b_samtools) + 1);
-
-        char *path_samtools = NULL;
-        path_samtools = malloc(strlen(path) + 1);
-        if (!path_samtools) {
-            fprintf(stderr, "Error: Cannot allocate space for path (samtools) copy\n");
+        if (field_idx >= C2B_MAX_FIELD_COUNT_VALUE) {
+            fprintf(stderr, "Error: Invalid field count (%d) -- input file may have too many fields\n", field_idx);
             c2b_print_usage(stderr);
-            exit(ENOMEM); /* Not enough space (POSIX.1) */
+            exit(EINVAL); /* Invalid argument (POSIX.1) */
         }
-        memcpy(path_samtools, path, strlen(path) + 1);
+    }
+    fields[field_idx].s = src + field_start;
+    fields[field_idx].length = src_size - field_start;
 
-#ifdef DEBUG
-        fprintf(stderr, "Debug: Searching [%s] for samtools\n", path_samtools);
-#endif
+    return field_idx;
+}
 
-        if (c2b_print_matches(path_samtools, samtools) != kTrue) {
-            fprintf(stderr, "Error: Cannot find samtools binary required for conversion of BAM and SAM format\n");
-            c2b_print_usage(stderr);
-            exit(ENOENT); /* No such file or directory (POSIX.1) */
+static inline int
+c2b_split_leading_fields(c2b_context_t *ctx, char *src, ssize_t src_size, c2b_span_t *fields, int max_field_idx)
+{
+    /* 
+       As c2b_split_fields(), but only the first max_field_idx fields are split 
+       out; the last field spans the remainder of the line, tabs included. This 
+       suits formats like SAM and VCF, whose trailing columns (optional tags, 
+       genotypes) are copied through as one block and may number in the thousands.
+    */
+
+    int field_idx = 0;
+    ssize_t field_offset = 0;
+    ssize_t current_src_posn = -1;
+    c2b_delim_index_t *idx = ctx->delims;
+
+    if ((idx) && (src >= idx->src) && (src + src_size <= idx->src + idx->src_size)) {
+        ssize_t src_offset = src - idx->src;
+        ssize_t src_end = src_offset + src_size;
+        field_offset = src_offset;
+        while ((field_idx < max_field_idx) && ((current_src_posn = c2b_next_delim(idx->tab_bits, field_offset, src_end)) != -1)) {
+            fields[field_idx].s = idx->src + field_offset;
+            fields[field_idx].length = current_src_posn - field_offset;
+            field_offset = current_src_posn + 1;
+            field_idx++;
         }
-        free(path_samtools), path_samtools = NULL;
-        free(samtools), samtools = NULL;
+        fields[field_idx].s = idx->src + field_offset;
+        fields[field_idx].length = src_end - field_offset;
+        return field_idx;
     }
 
-    if (c2b_globals.sort->is_enabled) {
-        char *sort_bed = NULL;
-        sort_bed = malloc(strlen(c2b_sort_bed) + 1);
-        if (!sort_bed) {
-            fprintf(stderr, "Error: Cannot allocate space for sort-bed variable copy\n");
-            c2b_print_usage(stderr);
-            exit(ENOMEM); /* Not enough space (POSIX.1) */
-        }
-        memcpy(sort_bed, c2b_sort_bed, strlen(c2b_sort_bed) + 1);
+    while (field_idx < max_field_idx) {
+        char *field_end = memchr(src + field_offset, c2b_tab_delim, src_size - field_offset);
+        if (!field_end)
+            break;
+        fields[field_idx].s = src + field_offset;
+        fields[field_idx].length = (field_end - src) - field_offset;
+        field_offset = (field_end - src) + 1;
+        field_idx++;
+    }
+    fields[field_idx].s = src + field_offset;
+    fields[field_idx].length = src_size - field_offset;
 
-        char *path_sort_bed = NULL;
-        path_sort_bed = malloc(strlen(path) + 1);
-        if (!path_sort_bed) {
-            fprintf(stderr, "Error: Cannot allocate space for path (samtools) copy\n");
-            c2b_print_usage(stderr);
-            exit(ENOMEM); /* Not enough space (POSIX.1) */
-        }
-        memcpy(path_sort_bed, path, strlen(path) + 1);
+    return field_idx;
+}
 
-#ifdef DEBUG
-        fprintf(stderr, "Debug: Searching [%s] for sort-bed\n", path_sort_bed);
-#endif
+static inline boolean
+c2b_span_to_double(c2b_span_t f, double *val)
+{
+    /* as c2b_span_to_uint64(), parsed from a stack copy; returns kFalse unless all of f is a number */
 
-        if (c2b_print_matches(path_sort_bed, sort_bed) != kTrue) {
-            fprintf(stderr, "Error: Cannot find sort-bed binary required for sorting BED output\n");
-            c2b_print_usage(stderr);
-            exit(ENOENT); /* No such file or directory (POSIX.1) */
-        }
-        free(path_sort_bed), path_sort_bed = NULL;
-        free(sort_bed), sort_bed = NULL;
-    }
+    char num_str[C2B_MAX_OPERATION_FIELD_LENGTH_VALUE];
+    char *num_end = NULL;
 
-    if (c2b_globals.output_format_idx == STARCH_FORMAT) {
-        char *starch = NULL;
-        starch = malloc(strlen(c2b_starch) + 1);
-        if (!starch) {
-            fprintf(stderr, "Error: Cannot allocate space for starch variable copy\n");
-            c2b_print_usage(stderr);
-            exit(ENOMEM); /* Not enough space (POSIX.1) */
-        }
-        memcpy(starch, c2b_starch, strlen(c2b_starch) + 1);
+    if ((f.length == 0) || (f.length >= C2B_MAX_OPERATION_FIELD_LENGTH_VALUE))
+        return kFalse;
+    memcpy(num_str, f.s, f.length);
+    num_str[f.length] = '\0';
+    *val = strtod(num_str, &num_end);
 
-        char *path_starch = NULL;
-        path_starch = malloc(strlen(path) + 1);
-        if (!path_starch) {
-            fprintf(stderr, "Error: Cannot allocate space for path (starch) copy\n");
-            c2b_print_usage(stderr);
-            exit(ENOMEM); /* Not enough space (POSIX.1) */
-        }
-        memcpy(path_starch, path, strlen(path) + 1);
+    return (*num_end == '\0') ? kTrue : kFalse;
+}
 
-#ifdef DEBUG
-        fprintf(stderr, "Debug: Searching [%s] for starch\n", path_starch);
-#endif
+static inline uint64_t
+c2b_span_to_uint64(c2b_span_t f)
+{
+    /* 
+       strtoull() needs a terminated string, and would otherwise read past
+       an empty field into its neighbor, so the field is parsed from a stack
+       copy; numeric fields are short, and longer ones are rare enough to 
+       take the slow path
+    */
 
-        if (c2b_print_matches(path_starch, starch) != kTrue) {
-            fprintf(stderr, "Error: Cannot find starch binary required for compression of BED output\n");
-            c2b_print_usage(stderr);
-            exit(ENOENT); /* No such file or directory (POSIX.1) */
+    char num_str[C2B_MAX_OPERATION_FIELD_LENGTH_VALUE];
+
+    if (f.length >= C2B_MAX_OPERATION_FIELD_LENGTH_VALUE) {
+        char long_num_str[C2B_MAX_FIELD_LENGTH_VALUE];
+        if (f.length >= C2B_MAX_FIELD_LENGTH_VALUE) {
+            fprintf(stderr, "Error: Numeric field is too long (%zd bytes)\n", f.length);
+            exit(EINVAL); /* Invalid argument (POSIX.1) */
         }
-        free(path_starch), path_starch = NULL;
-        free(starch), starch = NULL;
+        memcpy(long_num_str, f.s, f.length);
+        long_num_str[f.length] = '\0';
+        return strtoull(long_num_str, NULL, 10);
     }
+    memcpy(num_str, f.s, f.length);
+    num_str[f.length] = '\0';
 
-    if (c2b_globals.input_format_idx != BAM_FORMAT) {
-        char *cat = NULL;
-        cat = malloc(strlen(c2b_cat) + 1);
-        if (!cat) {
-            fprintf(stderr, "Error: Cannot allocate space for cat variable copy\n");
-            c2b_print_usage(stderr);
-            exit(ENOMEM); /* Not enough space (POSIX.1) */
-        }
-        memcpy(cat, c2b_cat, strlen(c2b_cat) + 1);
-        
-        char *path_cat = NULL;
-        path_cat = malloc(strlen(path) + 1);
-        if (!path_cat) {
-            fprintf(stderr, "Error: Cannot allocate space for path (cat) copy\n");
-            c2b_print_usage(stderr);
-            exit(ENOMEM); /* Not enough space (POSIX.1) */
-        }
-        memcpy(path_cat, path, strlen(path) + 1);
-        
-#ifdef DEBUG
-        fprintf(stderr, "Debug: Searching [%s] for cat\n", path_cat);
-#endif
-        
-        if (c2b_print_matches(path_cat, cat) != kTrue) {
-            fprintf(stderr, "Error: Cannot find cat binary required for piping IO\n");
-            c2b_print_usage(stderr);
-            exit(ENOENT); /* No such file or directory (POSIX.1) */
+    return strtoull(num_str, NULL, 10);
+}
+
+static char *
+c2b_span_find(c2b_span_t f, const char *needle)
+{
+    ssize_t needle_size = strlen(needle);
+    ssize_t posn;
+
+    for (posn = 0; posn + needle_size <= f.length; posn++) {
+        if (memcmp(f.s + posn, needle, needle_size) == 0) {
+            return f.s + posn;
         }
-        free(path_cat), path_cat = NULL;
-        free(cat), cat = NULL;
     }
 
-    free(path), path = NULL;
+    return NULL;
+}
 
-#ifdef DEBUG
-    fprintf(stderr, "--- c2b_test_dependencies() - exit  ---\n");
-#endif
+static inline c2b_span_t
+c2b_span_from_str(char *s)
+{
+    c2b_span_t f;
+    f.s = s;
+    f.length = strlen(s);
+    return f;
 }
 
-static boolean
-c2b_print_matches(char *path, char *fn)
+static inline boolean
+c2b_span_equals(c2b_span_t f, const char *s)
 {
-#ifdef DEBUG
-    fprintf(stderr, "--- c2b_print_matches() - enter ---\n");
-#endif
+    return (f.length == (ssize_t) strlen(s)) && (memcmp(f.s, s, f.length) == 0);
+}
+
+static inline char *
+c2b_emit_span(char *dest, c2b_span_t f, char delim)
+{
+    memcpy(dest, f.s, f.length);
+    dest[f.length] = delim;
+    return dest + f.length + 1;
+}
+
+static inline char *
+c2b_emit_str(char *dest, const char *s, char delim)
+{
+    size_t length = strlen(s);
+    memcpy(dest, s, length);
+    dest[length] = delim;
+    return dest + length + 1;
+}
+
+static inline char *
+c2b_emit_uint64(char *dest, uint64_t val, char delim)
+{
+    char digits[20];
+    char *digits_end = digits + sizeof(digits);
+    char *digit = digits_end;
+    size_t pair_idx = 0;
 
-    char candidate[PATH_MAX];
-    const char *d;
-    boolean found = kFalse;
+    /* digits are written from the right, two at a time */
 
-    if (strchr(fn, '/') != NULL) {
-        return (c2b_is_there(fn) ? kTrue : kFalse);
+    while (val >= 100) {
+        pair_idx = (size_t) (val % 100) * 2;
+        val /= 100;
+        *--digit = c2b_digit_pairs[pair_idx + 1];
+        *--digit = c2b_digit_pairs[pair_idx];
     }
-    while ((d = c2b_strsep(&path, ":")) != NULL) {
-        if (*d == '\0') {
-            d = ".";
-        }
-        if (snprintf(candidate, sizeof(candidate), "%s/%s", d, fn) >= (int) sizeof(candidate)) {
-            continue;
-        }
-        if (c2b_is_there(candidate)) {
-            found = kTrue;
-            if (strcmp(fn, c2b_samtools) == 0) {
-                c2b_globals.sam->samtools_path = malloc(strlen(candidate) + 1);
-                if (!c2b_globals.sam->samtools_path) {
-                    fprintf(stderr, "Error: Could not allocate space for storing samtools path global\n");
-                    c2b_print_usage(stderr);
-                    exit(ENOMEM); /* Not enough space (POSIX.1) */
-                }
-                memcpy(c2b_globals.sam->samtools_path, candidate, strlen(candidate));
-                c2b_globals.sam->samtools_path[strlen(candidate)] = '\0';
-            }
-            else if (strcmp(fn, c2b_sort_bed) == 0) {
-                c2b_globals.sort->sort_bed_path = malloc(strlen(candidate) + 1);
-                if (!c2b_globals.sort->sort_bed_path) {
-                    fprintf(stderr, "Error: Could not allocate space for storing sortbed path global\n");
-                    c2b_print_usage(stderr);
-                    exit(ENOMEM); /* Not enough space (POSIX.1) */
-                }
-                memcpy(c2b_globals.sort->sort_bed_path, candidate, strlen(candidate));
-                c2b_globals.sort->sort_bed_path[strlen(candidate)] = '\0';
-            }
-            else if (strcmp(fn, c2b_starch) == 0) {
-                c2b_globals.starch->path = malloc(strlen(candidate) + 1);
-                if (!c2b_globals.starch->path) {
-                    fprintf(stderr, "Error: Could not allocate space for storing starch path global\n");
-                    c2b_print_usage(stderr);
-                    exit(ENOMEM); /* Not enough space (POSIX.1) */
-                }
-                memcpy(c2b_globals.starch->path, candidate, strlen(candidate));
-                c2b_globals.starch->path[strlen(candidate)] = '\0';
-            }
-            else if (strcmp(fn, c2b_cat) == 0) {
-                c2b_globals.cat->path = malloc(strlen(candidate) + 1);
-                if (!c2b_globals.cat->path) {
-                    fprintf(stderr, "Errrpr: Could not allocate space for storing cat path global\n");
-                    exit(ENOMEM); /* Not enough space (POSIX.1) */
-                }
-                memcpy(c2b_globals.cat->path, candidate, strlen(candidate));
-                c2b_globals.cat->path[strlen(candidate)] = '\0';
-            }
-            break;
-        }
+    if (val >= 10) {
+        pair_idx = (size_t) val * 2;
+        *--digit = c2b_digit_pairs[pair_idx + 1];
+        *--digit = c2b_digit_pairs[pair_idx];
+    }
+    else {
+        *--digit = (char) ('0' + val);
     }
 
-#ifdef DEBUG
-    fprintf(stderr, "--- c2b_print_matches() - exit  ---\n");
-#endif
-
-    return found;
+    memcpy(dest, digit, (size_t) (digits_end - digit));
+    dest += digits_end - digit;
+    *dest++ = delim;
+    return dest;
 }
 
-static char *
-c2b_strsep(char **stringp, const char *delim)
+static inline char *
+c2b_emit_int64(char *dest, int64_t val, char delim)
 {
-    char *s;
-    const char *spanp;
-    int c, sc;
-    char *tok;
-
-    if ((s = *stringp) == NULL)
-        return NULL;
+    if (val < 0) {
+        *dest++ = '-';
+        return c2b_emit_uint64(dest, (uint64_t) 0 - (uint64_t) val, delim);
+    }
+    return c2b_emit_uint64(dest, (uint64_t) val, delim);
+}
 
-    for (tok = s;;) {
-        c = *s++;
-        spanp = delim;
-        do {
-            if ((sc = *spanp++) == c) {
-                if (c == 0)
-                    s = NULL;
-                else
-                    s[-1] = 0;
-                *stringp = s;
-                return tok;
-            }
-        } while (sc != 0);
+static void
+c2b_init_output(c2b_output_t *out, int fd, c2b_sorter_t *sorter)
+{
+    out->buf = malloc(C2B_OUTPUT_INITIAL_CAPACITY_VALUE);
+    if (!out->buf) {
+        fprintf(stderr, "Error: Could not allocate space for output buffer\n");
+        c2b_print_usage(stderr);
+        exit(ENOMEM); /* Not enough space (POSIX.1) */
     }
+    out->size = 0;
+    out->capacity = C2B_OUTPUT_INITIAL_CAPACITY_VALUE;
+    out->watermark = C2B_OUTPUT_WATERMARK_VALUE;
+    out->fd = fd;
+    out->sorter = sorter;
+}
 
-    return NULL;
+static void
+c2b_delete_output(c2b_output_t *out)
+{
+    free(out->buf), out->buf = NULL;
+    out->size = 0;
+    out->capacity = 0;
 }
 
-static boolean
-c2b_is_there(char *candidate)
+static inline char *
+c2b_reserve_output(c2b_output_t *out, ssize_t length)
 {
-#ifdef DEBUG
-    fprintf(stderr, "--- c2b_is_there() - enter ---\n");
-#endif
+    char *buf = NULL;
+    ssize_t capacity = out->capacity;
 
-    struct stat fin;
-    boolean found = kFalse;
+    if (out->size + length <= out->capacity)
+        return out->buf + out->size;
 
-    if (access(candidate, X_OK) == 0 
-        && stat(candidate, &fin) == 0 
-        && S_ISREG(fin.st_mode) 
-        && (getuid() != 0 || (fin.st_mode & (S_IXUSR | S_IXGRP | S_IXOTH)) != 0)) {
-#ifdef DEBUG
-	    fprintf(stderr, "Debug: Found dependency [%s]\n", candidate);
-#endif
-        found = kTrue;
+    if ((out->size >= out->watermark) && ((out->fd != -1) || (out->sorter)))
+        c2b_flush_output(out);
+
+    if (out->size + length > out->capacity) {
+        while (out->size + length > capacity)
+            capacity *= 2;
+        buf = realloc(out->buf, capacity);
+        if (!buf) {
+            fprintf(stderr, "Error: Could not allocate space for output buffer\n");
+            c2b_print_usage(stderr);
+            exit(ENOMEM); /* Not enough space (POSIX.1) */
+        }
+        out->buf = buf;
+        out->capacity = capacity;
     }
 
-#ifdef DEBUG
-    fprintf(stderr, "--- c2b_is_there() - exit  ---\n");
-#endif
+    return out->buf + out->size;
+}
+
+static void
+c2b_flush_output(c2b_output_t *out)
+{
+    if (out->size > 0)
+        c2b_write_converted_bytes(out->fd, out->sorter, out->buf, out->size);
+    out->size = 0;
+}
+
+static inline void
+c2b_write_output(c2b_output_t *out, const char *src, ssize_t src_size)
+{
+    memcpy(c2b_reserve_output(out, src_size), src, src_size);
+    out->size += src_size;
+}
 
-    return found;
+static inline void
+c2b_line_convert_header_to_bed(c2b_context_t *ctx, c2b_output_t *dest, char *src, ssize_t src_size)
+{
+    char *dest_posn = c2b_reserve_output(dest, 
+                                         (ssize_t) strlen(c2b_header_chr_name) + src_size + 
+                                         2 + 2 * C2B_MAX_UINT64_FIELD_LENGTH_VALUE);
+    c2b_span_t header = { src, src_size };
+
+    dest_posn = c2b_emit_str(dest_posn, c2b_header_chr_name, c2b_tab_delim);
+    dest_posn = c2b_emit_uint64(dest_posn, ctx->header_line_idx, c2b_tab_delim);
+    dest_posn = c2b_emit_uint64(dest_posn, ctx->header_line_idx + 1, c2b_tab_delim);
+    dest_posn = c2b_emit_span(dest_posn, header, c2b_line_delim);
+    dest->size = dest_posn - dest->buf;
+    ctx->header_line_idx++;
 }
 
 static void
@@ -4391,18 +8281,24 @@ c2b_init_globals()
     c2b_globals.all_reads_flag = kFalse;
     c2b_globals.keep_header_flag = kFalse;
     c2b_globals.split_flag = kFalse;
+    c2b_globals.split_bed6_flag = kFalse;
     c2b_globals.zero_indexed_flag = kFalse;
-    c2b_globals.header_line_idx = 0U;
-    c2b_globals.gff = NULL, c2b_init_global_gff_state();
-    c2b_globals.gtf = NULL, c2b_init_global_gtf_state();
+    c2b_globals.threads = 1U;
     c2b_globals.psl = NULL, c2b_init_global_psl_state();
-    c2b_globals.rmsk = NULL, c2b_init_global_rmsk_state();
-    c2b_globals.sam = NULL, c2b_init_global_sam_state();
     c2b_globals.vcf = NULL, c2b_init_global_vcf_state(); 
     c2b_globals.wig = NULL, c2b_init_global_wig_state();
-    c2b_globals.cat = NULL, c2b_init_global_cat_params();
+    c2b_globals.bam = NULL, c2b_init_global_bam_params();
+    c2b_globals.columns = NULL, c2b_init_global_columns_params();
+    c2b_globals.filter = NULL, c2b_init_global_filter_params();
+    c2b_globals.fragments = NULL, c2b_init_global_fragments_params();
+    c2b_globals.coverage = NULL, c2b_init_global_coverage_params();
     c2b_globals.sort = NULL, c2b_init_global_sort_params();
+    c2b_globals.line = NULL, c2b_init_global_line_params();
+    c2b_globals.pipe = NULL, c2b_init_global_pipe_params();
+    c2b_globals.stats = NULL, c2b_init_global_stats_params();
     c2b_globals.starch = NULL, c2b_init_global_starch_params();
+    c2b_init_delim_kernel();
+    c2b_init_cigar_op_classes();
 
 #ifdef DEBUG
     fprintf(stderr, "--- c2b_init_globals() - exit  ---\n");
@@ -4422,16 +8318,19 @@ c2b_delete_globals()
     c2b_globals.all_reads_flag = kFalse;
     c2b_globals.keep_header_flag = kFalse;
     c2b_globals.split_flag = kFalse;
-    c2b_globals.header_line_idx = 0U;
-    if (c2b_globals.gff) c2b_delete_global_gff_state();
-    if (c2b_globals.gtf) c2b_delete_global_gtf_state();
+    c2b_globals.split_bed6_flag = kFalse;
     if (c2b_globals.psl) c2b_delete_global_psl_state();
-    if (c2b_globals.rmsk) c2b_delete_global_rmsk_state();
-    if (c2b_globals.sam) c2b_delete_global_sam_state();
     if (c2b_globals.vcf) c2b_delete_global_vcf_state();
     if (c2b_globals.wig) c2b_delete_global_wig_state();
-    if (c2b_globals.cat) c2b_delete_global_cat_params();
+    if (c2b_globals.bam) c2b_delete_global_bam_params();
+    if (c2b_globals.columns) c2b_delete_global_columns_params();
+    if (c2b_globals.filter) c2b_delete_global_filter_params();
+    if (c2b_globals.fragments) c2b_delete_global_fragments_params();
+    if (c2b_globals.coverage) c2b_delete_global_coverage_params();
     if (c2b_globals.sort) c2b_delete_global_sort_params();
+    if (c2b_globals.line) c2b_delete_global_line_params();
+    if (c2b_globals.pipe) c2b_delete_global_pipe_params();
+    if (c2b_globals.stats) c2b_delete_global_stats_params();
     if (c2b_globals.starch) c2b_delete_global_starch_params();
 
 #ifdef DEBUG
@@ -4440,419 +8339,650 @@ c2b_delete_globals()
 }
 
 static void
-c2b_init_global_gff_state()
+c2b_init_global_psl_state()
+{
+#ifdef DEBUG
+    fprintf(stderr, "--- c2b_init_global_psl_state() - enter ---\n");
+#endif
+
+    c2b_globals.psl = malloc(sizeof(c2b_psl_state_t));
+    if (!c2b_globals.psl) {
+        fprintf(stderr, "Error: Could not allocate space for PSL state global\n");
+        exit(ENOMEM); /* Not enough space (POSIX.1) */
+    }
+
+    c2b_globals.psl->is_headered = kTrue;
+
+#ifdef DEBUG
+    fprintf(stderr, "--- c2b_init_global_psl_state() - exit  ---\n");
+#endif
+}
+
+static void             
+c2b_delete_global_psl_state()
+{
+#ifdef DEBUG
+    fprintf(stderr, "--- c2b_delete_global_psl_state() - enter ---\n");
+#endif
+
+    free(c2b_globals.psl), c2b_globals.psl = NULL;
+
+#ifdef DEBUG
+    fprintf(stderr, "--- c2b_delete_global_psl_state() - exit  ---\n");
+#endif
+}
+
+static void
+c2b_init_global_vcf_state()
+{
+#ifdef DEBUG
+    fprintf(stderr, "--- c2b_init_global_vcf_state() - enter ---\n");
+#endif
+    
+    c2b_globals.vcf = malloc(sizeof(c2b_vcf_state_t));
+    if (!c2b_globals.vcf) {
+        fprintf(stderr, "Error: Could not allocate space for VCF state global\n");
+        exit(ENOMEM); /* Not enough space (POSIX.1) */
+    }
+    
+    c2b_globals.vcf->do_not_split = kFalse;
+    c2b_globals.vcf->only_snvs = kFalse;
+    c2b_globals.vcf->only_insertions = kFalse;
+    c2b_globals.vcf->only_deletions = kFalse;    
+    c2b_globals.vcf->filter_count = 0U;
+
+#ifdef DEBUG
+    fprintf(stderr, "--- c2b_init_global_vcf_state() - exit  ---\n");
+#endif
+}
+
+static void
+c2b_delete_global_vcf_state()
+{
+#ifdef DEBUG
+    fprintf(stderr, "--- c2b_delete_global_vcf_state() - enter ---\n");
+#endif
+
+    free(c2b_globals.vcf), c2b_globals.vcf = NULL;
+
+#ifdef DEBUG
+    fprintf(stderr, "--- c2b_delete_global_vcf_state() - exit  ---\n");
+#endif
+}
+
+static void
+c2b_init_global_wig_state()
+{
+#ifdef DEBUG
+    fprintf(stderr, "--- c2b_init_global_wig_state() - enter ---\n");
+#endif
+
+    c2b_globals.wig = malloc(sizeof(c2b_wig_state_t));
+    if (!c2b_globals.wig) {
+        fprintf(stderr, "Error: Could not allocate space for WIG state global\n");
+        exit(ENOMEM); /* Not enough space (POSIX.1) */
+    }
+
+    c2b_globals.wig->basename = NULL;
+    c2b_globals.wig->start_shift = 1;
+    c2b_globals.wig->end_shift = 1;
+
+#ifdef DEBUG
+    fprintf(stderr, "--- c2b_init_global_wig_state() - exit  ---\n");
+#endif
+}
+
+static void
+c2b_delete_global_wig_state()
+{
+#ifdef DEBUG
+    fprintf(stderr, "--- c2b_delete_global_wig_state() - enter ---\n");
+#endif
+
+    if (c2b_globals.wig->basename)
+        free(c2b_globals.wig->basename), c2b_globals.wig->basename = NULL;
+
+    free(c2b_globals.wig), c2b_globals.wig = NULL;
+
+#ifdef DEBUG
+    fprintf(stderr, "--- c2b_delete_global_wig_state() - exit  ---\n");
+#endif
+}
+
+static void
+c2b_init_global_bam_params()
 {
 #ifdef DEBUG
-    fprintf(stderr, "--- c2b_init_global_gff_state() - enter ---\n");
+    fprintf(stderr, "--- c2b_init_global_bam_params() - enter ---\n");
 #endif
 
-    c2b_globals.gff = malloc(sizeof(c2b_gff_state_t));
-    if (!c2b_globals.gff) {
-        fprintf(stderr, "Error: Could not allocate space for GFF state global\n");
+    c2b_globals.bam = malloc(sizeof(c2b_bam_params_t));
+    if (!c2b_globals.bam) {
+        fprintf(stderr, "Error: Could not allocate space for BAM parameters global\n");
         exit(ENOMEM); /* Not enough space (POSIX.1) */
     }
 
-    c2b_globals.gff->id = malloc(C2B_MAX_FIELD_LENGTH_VALUE);
-    if (!c2b_globals.gff->id) {
-        fprintf(stderr, "Error: Could not allocate space for GFF ID global\n");
+    c2b_globals.bam->index_path = NULL;
+    c2b_globals.bam->regions = NULL;
+
+#ifdef DEBUG
+    fprintf(stderr, "--- c2b_init_global_bam_params() - exit  ---\n");
+#endif
+}
+
+static void
+c2b_delete_global_bam_params()
+{
+#ifdef DEBUG
+    fprintf(stderr, "--- c2b_delete_global_bam_params() - enter ---\n");
+#endif
+
+    if (c2b_globals.bam->index_path)
+        free(c2b_globals.bam->index_path), c2b_globals.bam->index_path = NULL;
+    if (c2b_globals.bam->regions)
+        free(c2b_globals.bam->regions), c2b_globals.bam->regions = NULL;
+
+    free(c2b_globals.bam), c2b_globals.bam = NULL;
+
+#ifdef DEBUG
+    fprintf(stderr, "--- c2b_delete_global_bam_params() - exit  ---\n");
+#endif
+}
+
+static void
+c2b_init_global_columns_params()
+{
+#ifdef DEBUG
+    fprintf(stderr, "--- c2b_init_global_columns_params() - enter ---\n");
+#endif
+
+    c2b_globals.columns = malloc(sizeof(c2b_columns_params_t));
+    if (!c2b_globals.columns) {
+        fprintf(stderr, "Error: Could not allocate space for columns parameters global\n");
         exit(ENOMEM); /* Not enough space (POSIX.1) */
     }
-    memset(c2b_globals.gff->id, 0, C2B_MAX_FIELD_LENGTH_VALUE);
+
+    c2b_globals.columns->is_enabled = kFalse;
+    c2b_globals.columns->num_columns = 0;
+    c2b_globals.columns->max_field_idx = 11;
+    c2b_globals.columns->needs_cigar = kFalse;
+    c2b_globals.columns->needs_seq = kFalse;
+    c2b_globals.columns->needs_qual = kFalse;
+    c2b_globals.columns->needs_opt = kFalse;
 
 #ifdef DEBUG
-    fprintf(stderr, "--- c2b_init_global_gff_state() - exit  ---\n");
+    fprintf(stderr, "--- c2b_init_global_columns_params() - exit  ---\n");
 #endif
 }
 
-static void             
-c2b_delete_global_gff_state()
+static void
+c2b_delete_global_columns_params()
 {
 #ifdef DEBUG
-    fprintf(stderr, "--- c2b_delete_global_gff_state() - enter ---\n");
+    fprintf(stderr, "--- c2b_delete_global_columns_params() - enter ---\n");
+#endif
+
+    free(c2b_globals.columns), c2b_globals.columns = NULL;
+
+#ifdef DEBUG
+    fprintf(stderr, "--- c2b_delete_global_columns_params() - exit  ---\n");
 #endif
+}
 
-    if (c2b_globals.gff->id)
-        free(c2b_globals.gff->id), c2b_globals.gff->id = NULL;
+static void
+c2b_parse_columns(const char *columns)
+{
+    /* 
+       SAM fields are named as in the specification, in lowercase; "opt" is all optional
+       fields, and any other two-character name is a tag. Each column raises the index of
+       the last SAM field that must be split out of a line; the first six are always needed,
+       for the BED columns, and the optional fields are split out as one, after QUAL.
+    */
+
+    static const char *field_names[] = { "flag", "cigar", "rnext", "pnext", "tlen", "seq", "qual", "opt" };
+    static const int field_idxs[] = { 1, 5, 6, 7, 8, 9, 10, 11 };
+    c2b_columns_params_t *params = c2b_globals.columns;
+    c2b_sam_column_t *column = NULL;
+    char *columns_copy = NULL;
+    char *columns_ptr = NULL;
+    char *name = NULL;
+    size_t name_idx = 0;
+    size_t num_names = sizeof(field_names) / sizeof(field_names[0]);
+    int field_idx = 0;
+
+    columns_copy = malloc(strlen(columns) + 1);
+    if (!columns_copy) {
+        fprintf(stderr, "Error: Could not allocate space for columns argument copy\n");
+        c2b_print_usage(stderr);
+        exit(ENOMEM); /* Not enough space (POSIX.1) */
+    }
+    memcpy(columns_copy, columns, strlen(columns) + 1);
 
-    free(c2b_globals.gff), c2b_globals.gff = NULL;
+    params->is_enabled = kTrue;
+    params->num_columns = 0;
+    params->max_field_idx = 6;
+    columns_ptr = columns_copy;
+    while ((name = c2b_strsep(&columns_ptr, ",")) != NULL) {
+        if ((*name == '\0') || (strcmp(name, "bed6") == 0))
+            continue;
+        if (params->num_columns == C2B_MAX_SAM_COLUMNS_VALUE) {
+            fprintf(stderr, "Error: Cannot list more than %d columns with --columns\n", C2B_MAX_SAM_COLUMNS_VALUE);
+            c2b_print_usage(stderr);
+            exit(EINVAL); /* Invalid argument (POSIX.1) */
+        }
+        column = &params->columns[params->num_columns++];
+        for (name_idx = 0; name_idx < num_names; name_idx++) {
+            if (strcmp(name, field_names[name_idx]) == 0)
+                break;
+        }
+        if (name_idx < num_names) {
+            column->type = (c2b_sam_column_type_t) name_idx;
+            field_idx = field_idxs[name_idx];
+        }
+        else if ((strlen(name) == 2) && (isalpha((unsigned char) name[0])) && (isalnum((unsigned char) name[1]))) {
+            column->type = C2B_SAM_TAG_COLUMN;
+            column->tag[0] = name[0];
+            column->tag[1] = name[1];
+            field_idx = 11;
+        }
+        else {
+            fprintf(stderr, "Error: Column [%s] is not a SAM field or tag name\n", name);
+            c2b_print_usage(stderr);
+            exit(EINVAL); /* Invalid argument (POSIX.1) */
+        }
+        if (field_idx + 1 > params->max_field_idx)
+            params->max_field_idx = (field_idx < 11) ? field_idx + 1 : 11;
+        params->needs_cigar |= (column->type == C2B_SAM_CIGAR_COLUMN);
+        params->needs_seq |= (column->type == C2B_SAM_SEQ_COLUMN);
+        params->needs_qual |= (column->type == C2B_SAM_QUAL_COLUMN);
+        params->needs_opt |= ((column->type == C2B_SAM_OPT_COLUMN) || (column->type == C2B_SAM_TAG_COLUMN));
+    }
 
-#ifdef DEBUG
-    fprintf(stderr, "--- c2b_delete_global_gff_state() - exit  ---\n");
-#endif
+    free(columns_copy), columns_copy = NULL;
 }
 
 static void
-c2b_init_global_gtf_state()
+c2b_init_global_filter_params()
 {
 #ifdef DEBUG
-    fprintf(stderr, "--- c2b_init_global_gtf_state() - enter ---\n");
+    fprintf(stderr, "--- c2b_init_global_filter_params() - enter ---\n");
 #endif
 
-    c2b_globals.gtf = malloc(sizeof(c2b_gtf_state_t));
-    if (!c2b_globals.gtf) {
-        fprintf(stderr, "Error: Could not allocate space for GTF state global\n");
+    c2b_globals.filter = malloc(sizeof(c2b_filter_params_t));
+    if (!c2b_globals.filter) {
+        fprintf(stderr, "Error: Could not allocate space for filter parameters global\n");
         exit(ENOMEM); /* Not enough space (POSIX.1) */
     }
 
-    c2b_globals.gtf->id = malloc(C2B_MAX_FIELD_LENGTH_VALUE);
-    if (!c2b_globals.gtf->id) {
-        fprintf(stderr, "Error: Could not allocate space for GTF ID global\n");
-        exit(ENOMEM); /* Not enough space (POSIX.1) */
-    }
-    memset(c2b_globals.gtf->id, 0, C2B_MAX_FIELD_LENGTH_VALUE);
+    c2b_globals.filter->is_enabled = kFalse;
+    c2b_globals.filter->required_flags = 0;
+    c2b_globals.filter->excluded_flags = 0;
+    c2b_globals.filter->min_mapq = 0;
+    c2b_globals.filter->num_tag_filters = 0;
 
 #ifdef DEBUG
-    fprintf(stderr, "--- c2b_init_global_gtf_state() - exit  ---\n");
+    fprintf(stderr, "--- c2b_init_global_filter_params() - exit  ---\n");
 #endif
 }
 
-static void             
-c2b_delete_global_gtf_state()
+static void
+c2b_delete_global_filter_params()
 {
+    int filter_idx = 0;
+
 #ifdef DEBUG
-    fprintf(stderr, "--- c2b_delete_global_gtf_state() - enter ---\n");
+    fprintf(stderr, "--- c2b_delete_global_filter_params() - enter ---\n");
 #endif
 
-    if (c2b_globals.gtf->id)
-        free(c2b_globals.gtf->id), c2b_globals.gtf->id = NULL;
-
-    free(c2b_globals.gtf), c2b_globals.gtf = NULL;
+    for (filter_idx = 0; filter_idx < c2b_globals.filter->num_tag_filters; filter_idx++) {
+        if (c2b_globals.filter->tag_filters[filter_idx].value)
+            free(c2b_globals.filter->tag_filters[filter_idx].value), c2b_globals.filter->tag_filters[filter_idx].value = NULL;
+    }
+    free(c2b_globals.filter), c2b_globals.filter = NULL;
 
 #ifdef DEBUG
-    fprintf(stderr, "--- c2b_delete_global_gtf_state() - exit  ---\n");
+    fprintf(stderr, "--- c2b_delete_global_filter_params() - exit  ---\n");
 #endif
 }
 
 static void
-c2b_init_global_psl_state()
+c2b_init_global_fragments_params()
 {
 #ifdef DEBUG
-    fprintf(stderr, "--- c2b_init_global_psl_state() - enter ---\n");
+    fprintf(stderr, "--- c2b_init_global_fragments_params() - enter ---\n");
 #endif
 
-    c2b_globals.psl = malloc(sizeof(c2b_psl_state_t));
-    if (!c2b_globals.psl) {
-        fprintf(stderr, "Error: Could not allocate space for PSL state global\n");
-        exit(ENOMEM); /* Not enough space (POSIX.1) */
-    }
-
-    c2b_globals.psl->is_headered = kTrue;
-
-    c2b_globals.psl->block = NULL;
-    c2b_globals.psl->block = malloc(sizeof(c2b_psl_block_t));
-    if (!c2b_globals.psl->block) {
-        fprintf(stderr, "Error: Could not allocate space for PSL block state global\n");
+    c2b_globals.fragments = malloc(sizeof(c2b_fragments_params_t));
+    if (!c2b_globals.fragments) {
+        fprintf(stderr, "Error: Could not allocate space for fragments parameters global\n");
         exit(ENOMEM); /* Not enough space (POSIX.1) */
     }
 
-    c2b_globals.psl->block->max_count = 0;
-
-    c2b_globals.psl->block->sizes = NULL;
-    c2b_globals.psl->block->sizes = malloc(sizeof(uint64_t) * C2B_MAX_PSL_BLOCKS);
-    if (!c2b_globals.psl->block->sizes) {
-        fprintf(stderr, "Error: Could not allocate space for PSL block state sizes global\n");
-        exit(ENOMEM); /* Not enough space (POSIX.1) */
-    }
-
-    c2b_globals.psl->block->starts = NULL;
-    c2b_globals.psl->block->starts = malloc(sizeof(uint64_t) * C2B_MAX_PSL_BLOCKS);
-    if (!c2b_globals.psl->block->starts) {
-        fprintf(stderr, "Error: Could not allocate space for PSL block state starts global\n");
-        exit(ENOMEM); /* Not enough space (POSIX.1) */
-    }
-
-    c2b_globals.psl->block->max_count = C2B_MAX_PSL_BLOCKS;
+    c2b_globals.fragments->is_enabled = kFalse;
+    c2b_globals.fragments->max_mem = C2B_FRAGMENTS_MAX_MEM_DEFAULT;
 
 #ifdef DEBUG
-    fprintf(stderr, "--- c2b_init_global_psl_state() - exit  ---\n");
+    fprintf(stderr, "--- c2b_init_global_fragments_params() - exit  ---\n");
 #endif
 }
 
-static void             
-c2b_delete_global_psl_state()
+static void
+c2b_delete_global_fragments_params()
 {
 #ifdef DEBUG
-    fprintf(stderr, "--- c2b_delete_global_psl_state() - enter ---\n");
+    fprintf(stderr, "--- c2b_delete_global_fragments_params() - enter ---\n");
 #endif
 
-    free(c2b_globals.psl->block->starts), c2b_globals.psl->block->starts = NULL;
-    free(c2b_globals.psl->block->sizes), c2b_globals.psl->block->sizes = NULL;
-    c2b_globals.psl->block->max_count = 0;
-    free(c2b_globals.psl->block), c2b_globals.psl->block = NULL;
-    free(c2b_globals.psl), c2b_globals.psl = NULL;
+    free(c2b_globals.fragments), c2b_globals.fragments = NULL;
 
 #ifdef DEBUG
-    fprintf(stderr, "--- c2b_delete_global_psl_state() - exit  ---\n");
+    fprintf(stderr, "--- c2b_delete_global_fragments_params() - exit  ---\n");
 #endif
 }
 
 static void
-c2b_init_global_rmsk_state()
+c2b_init_global_coverage_params()
 {
 #ifdef DEBUG
-    fprintf(stderr, "--- c2b_init_global_rmsk_state() - enter ---\n");
+    fprintf(stderr, "--- c2b_init_global_coverage_params() - enter ---\n");
 #endif
 
-    c2b_globals.rmsk = malloc(sizeof(c2b_rmsk_state_t));
-    if (!c2b_globals.rmsk) {
-        fprintf(stderr, "Error: Could not allocate space for RepeatMasker annotation state global\n");
+    c2b_globals.coverage = malloc(sizeof(c2b_coverage_params_t));
+    if (!c2b_globals.coverage) {
+        fprintf(stderr, "Error: Could not allocate space for coverage parameters global\n");
         exit(ENOMEM); /* Not enough space (POSIX.1) */
     }
 
-    c2b_globals.rmsk->line = 0U;
-    c2b_globals.rmsk->is_start_of_line = kTrue;
-    c2b_globals.rmsk->is_start_of_gap = kFalse;
+    c2b_globals.coverage->is_enabled = kFalse;
+    c2b_globals.coverage->is_bedgraph = kTrue;
+    c2b_globals.coverage->line_functor = NULL;
 
 #ifdef DEBUG
-    fprintf(stderr, "--- c2b_init_global_rmsk_state() - exit  ---\n");
+    fprintf(stderr, "--- c2b_init_global_coverage_params() - exit  ---\n");
 #endif
 }
 
-static void             
-c2b_delete_global_rmsk_state()
+static void
+c2b_delete_global_coverage_params()
 {
 #ifdef DEBUG
-    fprintf(stderr, "--- c2b_delete_global_rmsk_state() - enter ---\n");
+    fprintf(stderr, "--- c2b_delete_global_coverage_params() - enter ---\n");
 #endif
 
-    free(c2b_globals.rmsk), c2b_globals.rmsk = NULL;
+    free(c2b_globals.coverage), c2b_globals.coverage = NULL;
 
 #ifdef DEBUG
-    fprintf(stderr, "--- c2b_delete_global_rmsk_state() - exit  ---\n");
+    fprintf(stderr, "--- c2b_delete_global_coverage_params() - exit  ---\n");
 #endif
 }
 
+static int
+c2b_parse_filter_int(const char *arg, const char *name, int max_val)
+{
+    /* FLAG masks may be given in decimal, or in hexadecimal or octal with a C prefix */
+
+    char *arg_end = NULL;
+    long val = 0;
+
+    errno = 0;
+    val = strtol(arg, &arg_end, 0);
+    if ((errno != 0) || (arg_end == arg) || (*arg_end != '\0') || (val < 0) || (val > max_val)) {
+        fprintf(stderr, "Error: --%s value must be an integer from 0 to %d\n", name, max_val);
+        c2b_print_usage(stderr);
+        exit(EINVAL); /* Invalid argument (POSIX.1) */
+    }
+    c2b_globals.filter->is_enabled = kTrue;
+
+    return (int) val;
+}
+
 static void
-c2b_init_global_sam_state()
+c2b_parse_tag_filter(const char *predicate)
 {
-#ifdef DEBUG
-    fprintf(stderr, "--- c2b_init_global_sam_state() - enter ---\n");
-#endif
+    static const char *op_names[] = { "!=", "<=", ">=", "=", "<", ">" };
+    static const c2b_tag_filter_op_t ops[] = { C2B_TAG_NE, C2B_TAG_LE, C2B_TAG_GE, C2B_TAG_EQ, C2B_TAG_LT, C2B_TAG_GT };
+    c2b_filter_params_t *filter = c2b_globals.filter;
+    c2b_tag_filter_t *f = NULL;
+    const char *tag = predicate;
+    const char *rest = NULL;
+    char *number_end = NULL;
+    size_t op_idx = 0;
+    size_t num_ops = sizeof(op_names) / sizeof(op_names[0]);
+
+    if (filter->num_tag_filters == C2B_MAX_TAG_FILTERS_VALUE) {
+        fprintf(stderr, "Error: Cannot specify --tag-filter more than %d times\n", C2B_MAX_TAG_FILTERS_VALUE);
+        c2b_print_usage(stderr);
+        exit(EINVAL); /* Invalid argument (POSIX.1) */
+    }
 
-    c2b_globals.sam = malloc(sizeof(c2b_sam_state_t));
-    if (!c2b_globals.sam) {
-        fprintf(stderr, "Error: Could not allocate space for SAM state global\n");
-        exit(ENOMEM); /* Not enough space (POSIX.1) */
+    if (tag[0] == '!')
+        tag++;
+    if ((strlen(tag) < 2) || (!isalpha((unsigned char) tag[0])) || (!isalnum((unsigned char) tag[1]))) {
+        fprintf(stderr, "Error: Tag filter [%s] does not start with a two-character tag name\n", predicate);
+        c2b_print_usage(stderr);
+        exit(EINVAL); /* Invalid argument (POSIX.1) */
     }
 
-    c2b_globals.sam->samtools_path = NULL;
+    f = &filter->tag_filters[filter->num_tag_filters];
+    f->tag[0] = tag[0];
+    f->tag[1] = tag[1];
+    f->value = NULL;
+    f->value_length = 0;
+    f->is_numeric = kFalse;
+    f->number = 0.0;
+    rest = tag + 2;
 
-    c2b_globals.sam->cigar = NULL, c2b_sam_init_cigar_ops(&(c2b_globals.sam->cigar), C2B_MAX_OPERATIONS_VALUE);
+    if (*rest == '\0') {
+        f->op = (tag != predicate) ? C2B_TAG_ABSENT : C2B_TAG_PRESENT;
+    }
+    else {
+        for (op_idx = 0; op_idx < num_ops; op_idx++) {
+            if (strncmp(rest, op_names[op_idx], strlen(op_names[op_idx])) == 0)
+                break;
+        }
+        if ((tag != predicate) || (op_idx == num_ops) || (rest[strlen(op_names[op_idx])] == '\0')) {
+            fprintf(stderr, "Error: Tag filter [%s] is not TAG, !TAG or TAG, an operator and a value\n", predicate);
+            c2b_print_usage(stderr);
+            exit(EINVAL); /* Invalid argument (POSIX.1) */
+        }
+        f->op = ops[op_idx];
+        rest += strlen(op_names[op_idx]);
+        f->value_length = (ssize_t) strlen(rest);
+        f->value = malloc(strlen(rest) + 1);
+        if (!f->value) {
+            fprintf(stderr, "Error: Could not allocate space for tag filter value\n");
+            c2b_print_usage(stderr);
+            exit(ENOMEM); /* Not enough space (POSIX.1) */
+        }
+        memcpy(f->value, rest, strlen(rest) + 1);
+        f->number = strtod(f->value, &number_end);
+        f->is_numeric = ((number_end != f->value) && (*number_end == '\0') && (!isspace((unsigned char) f->value[0]))) ? kTrue : kFalse;
+        if ((!f->is_numeric) && (c2b_tag_is_integer(f->tag))) {
+            fprintf(stderr, "Error: Tag filter [%s] compares integer tag %c%c with a value that is not a number\n", predicate, f->tag[0], f->tag[1]);
+            c2b_print_usage(stderr);
+            exit(EINVAL); /* Invalid argument (POSIX.1) */
+        }
+        if ((!f->is_numeric) && (f->op != C2B_TAG_EQ) && (f->op != C2B_TAG_NE)) {
+            fprintf(stderr, "Error: Tag filter [%s] compares with a value that is not a number\n", predicate);
+            c2b_print_usage(stderr);
+            exit(EINVAL); /* Invalid argument (POSIX.1) */
+        }
+    }
 
-#ifdef DEBUG
-    fprintf(stderr, "--- c2b_init_global_sam_state() - exit  ---\n");
-#endif
+    filter->num_tag_filters++;
+    filter->is_enabled = kTrue;
 }
 
-static void
-c2b_delete_global_sam_state()
+static boolean
+c2b_tag_is_integer(const char *tag)
 {
-#ifdef DEBUG
-    fprintf(stderr, "--- c2b_delete_global_sam_state() - enter ---\n");
-#endif
+    const char *name = NULL;
 
-    if (c2b_globals.sam->samtools_path)
-        free(c2b_globals.sam->samtools_path), c2b_globals.sam->samtools_path = NULL;
-    
-    if (c2b_globals.sam->cigar)
-        c2b_sam_delete_cigar_ops(c2b_globals.sam->cigar);
-    
-    free(c2b_globals.sam), c2b_globals.sam = NULL;
+    for (name = c2b_sam_integer_tags; *name != '\0'; name += (name[2] == ' ') ? 3 : 2) {
+        if ((name[0] == tag[0]) && (name[1] == tag[1]))
+            return kTrue;
+    }
 
-#ifdef DEBUG
-    fprintf(stderr, "--- c2b_delete_global_sam_state() - exit  ---\n");
-#endif
+    return kFalse;
 }
 
 static void
-c2b_init_global_vcf_state()
+c2b_init_global_sort_params()
 {
 #ifdef DEBUG
-    fprintf(stderr, "--- c2b_init_global_vcf_state() - enter ---\n");
+    fprintf(stderr, "--- c2b_init_global_sort_params() - enter ---\n");
 #endif
-    
-    c2b_globals.vcf = malloc(sizeof(c2b_vcf_state_t));
-    if (!c2b_globals.vcf) {
-        fprintf(stderr, "Error: Could not allocate space for VCF state global\n");
+
+    c2b_globals.sort = malloc(sizeof(c2b_sort_params_t));
+    if (!c2b_globals.sort) {
+        fprintf(stderr, "Error: Could not allocate space for sort parameters global\n");
         exit(ENOMEM); /* Not enough space (POSIX.1) */
     }
-    
-    c2b_globals.vcf->do_not_split = kFalse;
-    c2b_globals.vcf->only_snvs = kFalse;
-    c2b_globals.vcf->only_insertions = kFalse;
-    c2b_globals.vcf->only_deletions = kFalse;    
-    c2b_globals.vcf->filter_count = 0U;
+
+    c2b_globals.sort->is_enabled = kTrue;
+    c2b_globals.sort->max_mem = C2B_SORT_MAX_MEM_DEFAULT;
+    c2b_globals.sort->sort_tmpdir_path = NULL;
 
 #ifdef DEBUG
-    fprintf(stderr, "--- c2b_init_global_vcf_state() - exit  ---\n");
+    fprintf(stderr, "--- c2b_init_global_sort_params() - exit  ---\n");
 #endif
 }
 
 static void
-c2b_delete_global_vcf_state()
+c2b_delete_global_sort_params()
 {
 #ifdef DEBUG
-    fprintf(stderr, "--- c2b_delete_global_vcf_state() - enter ---\n");
+    fprintf(stderr, "--- c2b_delete_global_sort_params() - enter ---\n");
 #endif
 
-    free(c2b_globals.vcf), c2b_globals.vcf = NULL;
+
+
+    if (c2b_globals.sort->sort_tmpdir_path)
+        free(c2b_globals.sort->sort_tmpdir_path), c2b_globals.sort->sort_tmpdir_path = NULL;
+
+    free(c2b_globals.sort), c2b_globals.sort = NULL;
 
 #ifdef DEBUG
-    fprintf(stderr, "--- c2b_delete_global_vcf_state() - exit  ---\n");
+    fprintf(stderr, "--- c2b_delete_global_sort_params() - exit  ---\n");
 #endif
 }
 
 static void
-c2b_init_global_wig_state()
+c2b_init_global_line_params()
 {
 #ifdef DEBUG
-    fprintf(stderr, "--- c2b_init_global_wig_state() - enter ---\n");
+    fprintf(stderr, "--- c2b_init_global_line_params() - enter ---\n");
 #endif
 
-    c2b_globals.wig = malloc(sizeof(c2b_wig_state_t));
-    if (!c2b_globals.wig) {
-        fprintf(stderr, "Error: Could not allocate space for WIG state global\n");
-        exit(ENOMEM); /* Not enough space (POSIX.1) */
-    }
-
-    c2b_globals.wig->section = 1;
-    c2b_globals.wig->line = 0;
-    c2b_globals.wig->pos_lines = 0;
-    c2b_globals.wig->span = 0;
-    c2b_globals.wig->step = 0;
-    c2b_globals.wig->start_pos = 0;
-    c2b_globals.wig->end_pos = 0;
-    c2b_globals.wig->score = 0.0f;
-    c2b_globals.wig->chr = NULL;
-    c2b_globals.wig->id = NULL;
-    c2b_globals.wig->is_fixed_step = kFalse;
-    c2b_globals.wig->start_write = kFalse;
-    c2b_globals.wig->basename = NULL;
-    c2b_globals.wig->start_shift = 1;
-    c2b_globals.wig->end_shift = 1;
-
-    c2b_globals.wig->chr = malloc(C2B_MAX_CHROMOSOME_LENGTH);
-    if (!c2b_globals.wig->chr) {
-        fprintf(stderr, "Error: Could not allocate space for global WIG chromosome string\n");
+    c2b_globals.line = malloc(sizeof(c2b_line_params_t));
+    if (!c2b_globals.line) {
+        fprintf(stderr, "Error: Could not allocate space for line parameters global\n");
         exit(ENOMEM); /* Not enough space (POSIX.1) */
     }
-    memset(c2b_globals.wig->chr, 0, C2B_MAX_CHROMOSOME_LENGTH);
 
-    c2b_globals.wig->id = malloc(C2B_MAX_FIELD_LENGTH_VALUE);
-    if (!c2b_globals.wig->id) {
-        fprintf(stderr, "Error: Could not allocate space for global WIG ID string\n");
-        exit(ENOMEM); /* Not enough space (POSIX.1) */
-    }
-    memset(c2b_globals.wig->id, 0, C2B_MAX_FIELD_LENGTH_VALUE);
+    c2b_globals.line->max_line_length = C2B_MAX_LONG_LINE_LENGTH_DEFAULT;
+    c2b_globals.line->num_growths = 0;
+    c2b_globals.line->largest_buffer_size = C2B_MAX_LINE_LENGTH_VALUE;
+    c2b_globals.line->buffer_bytes = 0;
+    c2b_globals.line->peak_buffer_bytes = 0;
 
 #ifdef DEBUG
-    fprintf(stderr, "--- c2b_init_global_wig_state() - exit  ---\n");
+    fprintf(stderr, "--- c2b_init_global_line_params() - exit  ---\n");
 #endif
 }
 
 static void
-c2b_delete_global_wig_state()
+c2b_delete_global_line_params()
 {
 #ifdef DEBUG
-    fprintf(stderr, "--- c2b_delete_global_wig_state() - enter ---\n");
+    fprintf(stderr, "--- c2b_delete_global_line_params() - enter ---\n");
 #endif
 
-    if (c2b_globals.wig->chr)
-        free(c2b_globals.wig->chr), c2b_globals.wig->chr = NULL;
-
-    if (c2b_globals.wig->id)
-        free(c2b_globals.wig->id), c2b_globals.wig->id = NULL;
-
-    if (c2b_globals.wig->basename)
-        free(c2b_globals.wig->basename), c2b_globals.wig->basename = NULL;
-
-    free(c2b_globals.wig), c2b_globals.wig = NULL;
+    free(c2b_globals.line), c2b_globals.line = NULL;
 
 #ifdef DEBUG
-    fprintf(stderr, "--- c2b_delete_global_wig_state() - exit  ---\n");
+    fprintf(stderr, "--- c2b_delete_global_line_params() - exit  ---\n");
 #endif
 }
 
 static void
-c2b_init_global_cat_params()
+c2b_init_global_pipe_params()
 {
 #ifdef DEBUG
-    fprintf(stderr, "--- c2b_init_global_cat_params() - enter ---\n");
+    fprintf(stderr, "--- c2b_init_global_pipe_params() - enter ---\n");
 #endif
 
-    c2b_globals.cat = malloc(sizeof(c2b_cat_params_t));
-    if (!c2b_globals.cat) {
-        fprintf(stderr, "Error: Could not allocate space for cat parameters global\n");
+    c2b_globals.pipe = malloc(sizeof(c2b_pipe_params_t));
+    if (!c2b_globals.pipe) {
+        fprintf(stderr, "Error: Could not allocate space for pipe parameters global\n");
         exit(ENOMEM); /* Not enough space (POSIX.1) */
     }
 
-    c2b_globals.cat->path = NULL;
+    c2b_globals.pipe->size = C2B_PIPE_SIZE_DEFAULT;
+    c2b_globals.pipe->is_size_set = kFalse;
+    c2b_globals.pipe->is_timed = kFalse;
+    memset(&c2b_globals.pipe->convert_stats, 0, sizeof(c2b_io_stats_t));
+    memset(&c2b_globals.pipe->sort_stats, 0, sizeof(c2b_io_stats_t));
+    memset(&c2b_globals.pipe->stdout_stats, 0, sizeof(c2b_io_stats_t));
 
 #ifdef DEBUG
-    fprintf(stderr, "--- c2b_init_global_cat_params() - exit  ---\n");
+    fprintf(stderr, "--- c2b_init_global_pipe_params() - exit  ---\n");
 #endif
 }
 
 static void
-c2b_delete_global_cat_params()
+c2b_delete_global_pipe_params()
 {
 #ifdef DEBUG
-    fprintf(stderr, "--- c2b_delete_global_cat_params() - enter ---\n");
+    fprintf(stderr, "--- c2b_delete_global_pipe_params() - enter ---\n");
 #endif
 
-    if (c2b_globals.cat->path)
-        free(c2b_globals.cat->path), c2b_globals.cat->path = NULL;
-
-    free(c2b_globals.cat), c2b_globals.cat = NULL;
+    free(c2b_globals.pipe), c2b_globals.pipe = NULL;
 
 #ifdef DEBUG
-    fprintf(stderr, "--- c2b_delete_global_cat_params() - exit  ---\n");
+    fprintf(stderr, "--- c2b_delete_global_pipe_params() - exit  ---\n");
 #endif
 }
 
 static void
-c2b_init_global_sort_params()
+c2b_init_global_stats_params()
 {
 #ifdef DEBUG
-    fprintf(stderr, "--- c2b_init_global_sort_params() - enter ---\n");
+    fprintf(stderr, "--- c2b_init_global_stats_params() - enter ---\n");
 #endif
 
-    c2b_globals.sort = malloc(sizeof(c2b_sort_params_t));
-    if (!c2b_globals.sort) {
-        fprintf(stderr, "Error: Could not allocate space for sort parameters global\n");
+    c2b_globals.stats = malloc(sizeof(c2b_stats_params_t));
+    if (!c2b_globals.stats) {
+        fprintf(stderr, "Error: Could not allocate space for stats parameters global\n");
         exit(ENOMEM); /* Not enough space (POSIX.1) */
     }
 
-    c2b_globals.sort->is_enabled = kTrue;
-    c2b_globals.sort->sort_bed_path = NULL;
-    c2b_globals.sort->max_mem_value = NULL;
-    c2b_globals.sort->sort_tmpdir_path = NULL;
+    memset(c2b_globals.stats, 0, sizeof(c2b_stats_params_t));
+    c2b_globals.stats->is_enabled = kFalse;
+    c2b_globals.stats->path = NULL;
+    pthread_mutex_init(&c2b_globals.stats->lock, NULL);
 
 #ifdef DEBUG
-    fprintf(stderr, "--- c2b_init_global_sort_params() - exit  ---\n");
+    fprintf(stderr, "--- c2b_init_global_stats_params() - exit  ---\n");
 #endif
 }
 
 static void
-c2b_delete_global_sort_params()
+c2b_delete_global_stats_params()
 {
 #ifdef DEBUG
-    fprintf(stderr, "--- c2b_delete_global_sort_params() - enter ---\n");
+    fprintf(stderr, "--- c2b_delete_global_stats_params() - enter ---\n");
 #endif
 
-    if (c2b_globals.sort->max_mem_value)
-        free(c2b_globals.sort->max_mem_value), c2b_globals.sort->max_mem_value = NULL;
-
-    if (c2b_globals.sort->sort_bed_path)
-        free(c2b_globals.sort->sort_bed_path), c2b_globals.sort->sort_bed_path = NULL;
-
-    if (c2b_globals.sort->sort_tmpdir_path)
-        free(c2b_globals.sort->sort_tmpdir_path), c2b_globals.sort->sort_tmpdir_path = NULL;
-
-    free(c2b_globals.sort), c2b_globals.sort = NULL;
+    if (c2b_globals.stats->path)
+        free(c2b_globals.stats->path), c2b_globals.stats->path = NULL;
+    if (c2b_globals.stats->sort_runs)
+        free(c2b_globals.stats->sort_runs), c2b_globals.stats->sort_runs = NULL;
+    pthread_mutex_destroy(&c2b_globals.stats->lock);
+    free(c2b_globals.stats), c2b_globals.stats = NULL;
 
 #ifdef DEBUG
-    fprintf(stderr, "--- c2b_delete_global_sort_params() - exit  ---\n");
+    fprintf(stderr, "--- c2b_delete_global_stats_params() - exit  ---\n");
 #endif
 }
 
@@ -4869,10 +8999,10 @@ c2b_init_global_starch_params()
         exit(ENOMEM); /* Not enough space (POSIX.1) */
     }
 
-    c2b_globals.starch->path = NULL;
     c2b_globals.starch->bzip2 = kFalse;
     c2b_globals.starch->gzip = kFalse;
     c2b_globals.starch->note = NULL;
+    c2b_globals.starch->threads = 0;
 
 #ifdef DEBUG
     fprintf(stderr, "--- c2b_init_global_starch_params() - exit  ---\n");
@@ -4886,9 +9016,6 @@ c2b_delete_global_starch_params()
     fprintf(stderr, "--- c2b_delete_global_starch_params() - enter ---\n");
 #endif
 
-    if (c2b_globals.starch->path)
-        free(c2b_globals.starch->path), c2b_globals.starch->path = NULL;
-
     if (c2b_globals.starch->note)
         free(c2b_globals.starch->note), c2b_globals.starch->note = NULL;
 
@@ -4908,6 +9035,8 @@ c2b_init_command_line_options(int argc, char **argv)
 
     char *input_format = NULL;
     char *output_format = NULL;
+    char *threads_end = NULL;
+    long threads_val = 0;
     int client_long_index;
     int client_opt = getopt_long(argc,
                                  argv,
@@ -4945,18 +9074,17 @@ c2b_init_command_line_options(int argc, char **argv)
                 free(output_format), output_format = NULL;
                 break;
             case 'm':
-                c2b_globals.sort->max_mem_value = malloc(strlen(optarg) + 1);
-                if (!c2b_globals.sort->max_mem_value) {
-                    fprintf(stderr, "Error: Could not allocate space for sort-bed max-mem argument\n");
+                c2b_globals.sort->max_mem = c2b_parse_max_mem(optarg);
+                if (c2b_globals.sort->max_mem < C2B_SORT_MIN_MAX_MEM) {
+                    fprintf(stderr, "Error: Sort memory must be at least 16M, to hold the record index and I/O buffers\n");
                     c2b_print_usage(stderr);
-                    exit(ENOMEM); /* Not enough space (POSIX.1) */
+                    exit(EINVAL); /* Invalid argument (POSIX.1) */
                 }
-                memcpy(c2b_globals.sort->max_mem_value, optarg, strlen(optarg) + 1);
                 break;
             case 'r':
                 c2b_globals.sort->sort_tmpdir_path = malloc(strlen(optarg) + 1);
                 if (!c2b_globals.sort->sort_tmpdir_path) {
-                    fprintf(stderr, "Error: Could not allocate space for sort-bed temporary directory argument\n");
+                    fprintf(stderr, "Error: Could not allocate space for sort temporary directory argument\n");
                     c2b_print_usage(stderr);
                     exit(ENOMEM); /* Not enough space (POSIX.1) */
                 }
@@ -4983,6 +9111,53 @@ c2b_init_command_line_options(int argc, char **argv)
             case 's':
                 c2b_globals.split_flag = kTrue;
                 break;
+            case 'B':
+                c2b_globals.split_bed6_flag = kTrue;
+                break;
+            case 'f':
+                c2b_globals.filter->required_flags = c2b_parse_filter_int(optarg, "require-flags", 0xffff);
+                break;
+            case 'F':
+                c2b_globals.filter->excluded_flags = c2b_parse_filter_int(optarg, "exclude-flags", 0xffff);
+                break;
+            case 'q':
+                c2b_globals.filter->min_mapq = (unsigned int) c2b_parse_filter_int(optarg, "min-mapq", 255);
+                break;
+            case 'G':
+                c2b_parse_tag_filter(optarg);
+                break;
+            case 'R':
+                c2b_globals.fragments->is_enabled = kTrue;
+                break;
+            case 'M':
+                c2b_globals.fragments->max_mem = c2b_parse_max_mem(optarg);
+                break;
+            case 'C':
+                if (c2b_globals.columns->is_enabled) {
+                    fprintf(stderr, "Error: Cannot specify --columns more than once\n");
+                    c2b_print_usage(stderr);
+                    exit(EINVAL); /* Invalid argument (POSIX.1) */
+                }
+                c2b_parse_columns(optarg);
+                break;
+            case 'j':
+                c2b_globals.bam->index_path = malloc(strlen(optarg) + 1);
+                if (!c2b_globals.bam->index_path) {
+                    fprintf(stderr, "Error: Could not allocate space for BAM index argument\n");
+                    c2b_print_usage(stderr);
+                    exit(ENOMEM); /* Not enough space (POSIX.1) */
+                }
+                memcpy(c2b_globals.bam->index_path, optarg, strlen(optarg) + 1);
+                break;
+            case 'l':
+                c2b_globals.bam->regions = malloc(strlen(optarg) + 1);
+                if (!c2b_globals.bam->regions) {
+                    fprintf(stderr, "Error: Could not allocate space for regions argument\n");
+                    c2b_print_usage(stderr);
+                    exit(ENOMEM); /* Not enough space (POSIX.1) */
+                }
+                memcpy(c2b_globals.bam->regions, optarg, strlen(optarg) + 1);
+                break;
             case 'p':
                 c2b_globals.vcf->do_not_split = kTrue;
                 break;
@@ -5001,6 +9176,53 @@ c2b_init_command_line_options(int argc, char **argv)
             case 'd':
                 c2b_globals.sort->is_enabled = kFalse;
                 break;
+            case 'V':
+                c2b_globals.coverage->is_enabled = kTrue;
+                if ((optarg) && (strcmp(optarg, "bed") == 0)) {
+                    c2b_globals.coverage->is_bedgraph = kFalse;
+                }
+                else if ((optarg) && (strcmp(optarg, "bedgraph") != 0)) {
+                    fprintf(stderr, "Error: Coverage type must be bedgraph or bed\n");
+                    c2b_print_usage(stderr);
+                    exit(EINVAL); /* Invalid argument (POSIX.1) */
+                }
+                break;
+            case 'L':
+                c2b_globals.line->max_line_length = c2b_parse_max_mem(optarg);
+                if (c2b_globals.line->max_line_length < C2B_MAX_LINE_LENGTH_VALUE) {
+                    fprintf(stderr, "Error: Maximum line length must be at least %d bytes (128K)\n", C2B_MAX_LINE_LENGTH_VALUE);
+                    c2b_print_usage(stderr);
+                    exit(EINVAL); /* Invalid argument (POSIX.1) */
+                }
+                else if (c2b_globals.line->max_line_length > SSIZE_MAX / 2)
+                    c2b_globals.line->max_line_length = SSIZE_MAX / 2;
+                break;
+            case 'P':
+                c2b_globals.pipe->size = c2b_parse_max_mem(optarg);
+                if (c2b_globals.pipe->size > INT32_MAX)
+                    c2b_globals.pipe->size = INT32_MAX;
+                c2b_globals.pipe->is_size_set = kTrue;
+                break;
+            case 'y':
+            case 'u':
+            case 'T':
+                /* --sort-stats, --line-stats and --pipe-stats are kept as aliases of --stats */
+                c2b_globals.stats->is_enabled = kTrue;
+                c2b_globals.pipe->is_timed = kTrue;
+                break;
+            case 'S':
+                c2b_globals.stats->is_enabled = kTrue;
+                c2b_globals.pipe->is_timed = kTrue;
+                if (optarg) {
+                    c2b_globals.stats->path = malloc(strlen(optarg) + 1);
+                    if (!c2b_globals.stats->path) {
+                        fprintf(stderr, "Error: Could not allocate space for stats file argument\n");
+                        c2b_print_usage(stderr);
+                        exit(ENOMEM); /* Not enough space (POSIX.1) */
+                    }
+                    memcpy(c2b_globals.stats->path, optarg, strlen(optarg) + 1);
+                }
+                break;
             case 'a':
                 c2b_globals.all_reads_flag = kTrue;
                 break;
@@ -5013,6 +9235,26 @@ c2b_init_command_line_options(int argc, char **argv)
             case 'g':
                 c2b_globals.starch->gzip = kTrue;
                 break;
+            case 'c':
+                errno = 0;
+                threads_val = strtol(optarg, &threads_end, 10);
+                if ((errno != 0) || (threads_end == optarg) || (*threads_end != '\0') || (threads_val < 1) || (threads_val > C2B_MAX_THREADS_VALUE)) {
+                    fprintf(stderr, "Error: Starch thread count must be an integer from 1 to %d\n", C2B_MAX_THREADS_VALUE);
+                    c2b_print_usage(stderr);
+                    exit(EINVAL); /* Invalid argument (POSIX.1) */
+                }
+                c2b_globals.starch->threads = (unsigned int) threads_val;
+                break;
+            case '@':
+                errno = 0;
+                threads_val = strtol(optarg, &threads_end, 10);
+                if ((errno != 0) || (threads_end == optarg) || (*threads_end != '\0') || (threads_val < 1) || (threads_val > C2B_MAX_THREADS_VALUE)) {
+                    fprintf(stderr, "Error: Thread count must be an integer from 1 to %d\n", C2B_MAX_THREADS_VALUE);
+                    c2b_print_usage(stderr);
+                    exit(EINVAL); /* Invalid argument (POSIX.1) */
+                }
+                c2b_globals.threads = (unsigned int) threads_val;
+                break;
             case 'x':
                 c2b_globals.wig->start_shift = 0;
                 c2b_globals.wig->end_shift = 0;
@@ -5095,6 +9337,86 @@ c2b_init_command_line_options(int argc, char **argv)
         exit(EINVAL); /* Invalid argument (POSIX.1) */
     }
     
+    if ((c2b_globals.bam->index_path || c2b_globals.bam->regions) && (c2b_globals.input_format_idx != BAM_FORMAT)) {
+        fprintf(stderr, "Error: Cannot specify --bai or --regions without BAM input\n");
+        c2b_print_usage(stderr);
+        exit(EINVAL); /* Invalid argument (POSIX.1) */
+    }
+
+    if ((c2b_globals.bam->regions) && (!c2b_globals.bam->index_path)) {
+        fprintf(stderr, "Error: Cannot specify --regions without --bai\n");
+        c2b_print_usage(stderr);
+        exit(EINVAL); /* Invalid argument (POSIX.1) */
+    }
+
+    if ((c2b_globals.coverage->is_enabled) && 
+        ((c2b_globals.fragments->is_enabled) || (c2b_globals.columns->is_enabled) || (c2b_globals.all_reads_flag) || (c2b_globals.keep_header_flag))) {
+        fprintf(stderr, "Error: Cannot specify --coverage with --fragments, --columns, --all-reads or --keep-header\n");
+        c2b_print_usage(stderr);
+        exit(EINVAL); /* Invalid argument (POSIX.1) */
+    }
+
+    if ((c2b_globals.split_bed6_flag) && ((!c2b_globals.split_flag) || ((c2b_globals.input_format_idx != BAM_FORMAT) && (c2b_globals.input_format_idx != SAM_FORMAT)))) {
+        fprintf(stderr, "Error: Cannot specify --split-bed6 without --split and BAM or SAM input\n");
+        c2b_print_usage(stderr);
+        exit(EINVAL); /* Invalid argument (POSIX.1) */
+    }
+
+    if ((c2b_globals.columns->is_enabled) && (c2b_globals.input_format_idx != BAM_FORMAT) && (c2b_globals.input_format_idx != SAM_FORMAT)) {
+        fprintf(stderr, "Error: Cannot specify --columns without BAM or SAM input\n");
+        c2b_print_usage(stderr);
+        exit(EINVAL); /* Invalid argument (POSIX.1) */
+    }
+
+    if (c2b_globals.split_bed6_flag) {
+        if (c2b_globals.columns->is_enabled) {
+            fprintf(stderr, "Error: Cannot specify both --split-bed6 and --columns\n");
+            c2b_print_usage(stderr);
+            exit(EINVAL); /* Invalid argument (POSIX.1) */
+        }
+        c2b_parse_columns("bed6");
+    }
+
+    /* 
+       With --fragments, SAM lines are split up to TLEN, and BAM records are decoded 
+       as for --split-bed6
+    */
+
+    if (c2b_globals.fragments->is_enabled) {
+        if ((c2b_globals.input_format_idx != BAM_FORMAT) && (c2b_globals.input_format_idx != SAM_FORMAT)) {
+            fprintf(stderr, "Error: Cannot specify --fragments without BAM or SAM input\n");
+            c2b_print_usage(stderr);
+            exit(EINVAL); /* Invalid argument (POSIX.1) */
+        }
+        if ((c2b_globals.split_flag) || (c2b_globals.columns->is_enabled)) {
+            fprintf(stderr, "Error: Cannot specify --fragments with --split or --columns\n");
+            c2b_print_usage(stderr);
+            exit(EINVAL); /* Invalid argument (POSIX.1) */
+        }
+        c2b_parse_columns("bed6");
+        c2b_globals.columns->max_field_idx = 9;
+    }
+
+    /* coverage is taken from the six BED columns alone */
+
+    if ((c2b_globals.coverage->is_enabled) && 
+        (!c2b_globals.columns->is_enabled) && 
+        ((c2b_globals.input_format_idx == BAM_FORMAT) || (c2b_globals.input_format_idx == SAM_FORMAT)))
+        c2b_parse_columns("bed6");
+
+    if ((c2b_globals.filter->is_enabled) && (c2b_globals.input_format_idx != BAM_FORMAT) && (c2b_globals.input_format_idx != SAM_FORMAT)) {
+        fprintf(stderr, "Error: Cannot specify read filters without BAM or SAM input\n");
+        c2b_print_usage(stderr);
+        exit(EINVAL); /* Invalid argument (POSIX.1) */
+    }
+
+    /* tag predicates are tested on the optional fields, which must then be found, whatever --columns lists */
+
+    if (c2b_globals.filter->num_tag_filters > 0) {
+        c2b_globals.columns->max_field_idx = 11;
+        c2b_globals.columns->needs_opt = kTrue;
+    }
+
     if ((c2b_globals.starch->bzip2) && (c2b_globals.starch->gzip)) {
         fprintf(stderr, "Error: Cannot specify both Starch compression options\n");
         c2b_print_usage(stderr);
@@ -5110,6 +9432,16 @@ c2b_init_command_line_options(int argc, char **argv)
         exit(EINVAL); /* Invalid argument (POSIX.1) */
     }
 
+    if (c2b_globals.starch->threads == 0) {
+        c2b_globals.starch->threads = (c2b_globals.threads > C2B_STARCH_THREADS_DEFAULT) ? c2b_globals.threads : C2B_STARCH_THREADS_DEFAULT;
+    }
+
+    if ((!c2b_globals.sort->is_enabled) && (c2b_globals.output_format_idx == STARCH_FORMAT)) {
+        fprintf(stderr, "Error: Cannot specify --do-not-sort with Starch output\n");
+        c2b_print_usage(stderr);
+        exit(EINVAL); /* Invalid argument (POSIX.1) */
+    }
+
 #ifdef DEBUG
     fprintf(stderr, "--- c2b_init_command_line_options() - exit  ---\n");
 #endif
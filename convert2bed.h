@@ -24,8 +24,14 @@
 #define C2B_H
 
 #define __STDC_FORMAT_MACROS
+#define _POSIX_C_SOURCE 200809L
+#ifdef __linux__
+#define _GNU_SOURCE
+#define C2B_HAVE_SPLICE 1
+#endif
 
 #ifdef __cplusplus
+#include <cstddef>
 #include <cstdio>
 #include <cstdlib>
 #include <cgetopt>
@@ -34,7 +40,9 @@
 #include <cctype>
 #include <cinttypes>
 #include <cerrno>
+#include <ctime>
 #else
+#include <stddef.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <getopt.h>
@@ -43,13 +51,24 @@
 #include <ctype.h>
 #include <inttypes.h>
 #include <errno.h>
+#include <time.h>
 #endif
 #include <unistd.h>
 #include <pthread.h>
 #include <fcntl.h>
+#include <poll.h>
 #include <sys/stat.h>
+#include <sys/mman.h>
 #include <sys/param.h>
 #include <sys/wait.h>
+#include <sys/resource.h>
+#include <bzlib.h>
+#include <zlib.h>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#include <immintrin.h>
+#define C2B_HAVE_X86_SIMD 1
+#endif
 
 #define C2B_VERSION "1.6"
 
@@ -64,29 +83,47 @@ const boolean kFalse = 0;
 #define C2B_MAX_OPERATION_FIELD_LENGTH_VALUE 32
 #define C2B_MAX_STRAND_LENGTH_VALUE 4
 #define C2B_MAX_LINE_LENGTH_VALUE 131072
+#define C2B_MAX_LONG_LINE_LENGTH_DEFAULT 268435456ULL
 #define C2B_MAX_LINES_VALUE 32
 #define C2B_MAX_OPERATIONS_VALUE 32
+#define C2B_MAX_UINT64_FIELD_LENGTH_VALUE 21
+#define C2B_OUTPUT_INITIAL_CAPACITY_VALUE 65536
+#define C2B_OUTPUT_WATERMARK_VALUE 1048576
 #define C2B_MAX_CHROMOSOME_LENGTH 32
 #define C2B_MAX_PSL_BLOCKS 1024
 #define C2B_MAX_PSL_BLOCK_SIZES_STRING_LENGTH 20
 #define C2B_MAX_PSL_T_STARTS_STRING_LENGTH 20
+#define C2B_MAX_THREADS_VALUE 256
+#define C2B_SPLICE_CHUNK_SIZE 1048576
+#define C2B_PIPE_SIZE_DEFAULT 1048576
+#define C2B_CHUNKS_PER_THREAD 2
+#define C2B_SORT_BLOCK_SIZE 8388608
+#define C2B_SORT_MIN_RECORDS_PER_THREAD 65536
+#define C2B_SORT_INSERTION_THRESHOLD 16
+#define C2B_SORT_MAX_MEM_DEFAULT 2147483648ULL
+#define C2B_SORT_MIN_RUN_BUFFER_SIZE 65536
+#define C2B_SORT_MIN_MAX_MEM 16777216ULL
+#define C2B_SORT_IO_BUFFER_SIZE (C2B_MAX_LINE_LENGTH_VALUE * C2B_MAX_LINES_VALUE)
+#define C2B_STARCH_CHUNK_SIZE 1048576
+#define C2B_STARCH_MAX_QUEUED_CHUNKS 8
+#define C2B_STARCH_THREADS_DEFAULT 2
+#define C2B_STARCH_VERSION_MAJOR 2
+#define C2B_STARCH_VERSION_MINOR 1
+#define C2B_STARCH_VERSION_REVISION 0
+#define C2B_STARCH_BZIP2_BLOCK_SIZE 9
+#define C2B_STARCH_GZIP_LEVEL 1
+#define C2B_STARCH_BZIP2_STATE_SIZE (400000 + 800000 * C2B_STARCH_BZIP2_BLOCK_SIZE)
+#define C2B_STARCH_GZIP_STATE_SIZE 278528
+#define C2B_STARCH_FOOTER_LENGTH 127
+#define C2B_STARCH_FOOTER_OFFSET_LENGTH 20
+#define C2B_STARCH_SIGNATURE_LENGTH 28
 
-extern const char *c2b_samtools;
-extern const char *c2b_sort_bed;
-extern const char *c2b_starch;
-extern const char *c2b_cat;
 extern const char *c2b_default_output_format;
 extern const char *c2b_unmapped_read_chr_name;
 extern const char *c2b_header_chr_name;
-extern const char *sort_bed_max_mem_arg;
-extern const char *sort_bed_max_mem_default_arg;
-extern const char *sort_bed_tmpdir_arg;
-extern const char *sort_bed_stdin;
-extern const char *starch_bzip2_arg;
-extern const char *starch_gzip_arg;
-extern const char *starch_note_prefix_arg;
-extern const char *starch_note_suffix_arg;
-extern const char *starch_stdin_arg;
+extern const char *c2b_sort_run_file_template;
+extern const unsigned char c2b_starch_magic[4];
+extern const char *c2b_base64_alphabet;
 extern const char c2b_tab_delim;
 extern const char c2b_line_delim;
 extern const char c2b_space_delim;
@@ -122,23 +159,14 @@ extern const char *c2b_wig_browser_prefix;
 extern const char *c2b_wig_variable_step_prefix;
 extern const char *c2b_wig_fixed_step_prefix;
 extern const char *c2b_wig_chr_prefix;
+extern const char *c2b_digit_pairs;
 
-const char *c2b_samtools = "samtools";
-const char *c2b_sort_bed = "sort-bed";
-const char *c2b_starch = "starch";
-const char *c2b_cat = "cat";
 const char *c2b_default_output_format = "bed";
 const char *c2b_unmapped_read_chr_name = "_unmapped";
 const char *c2b_header_chr_name = "_header";
-const char *sort_bed_max_mem_arg = " --max-mem ";
-const char *sort_bed_max_mem_default_arg = " --max-mem 2G ";
-const char *sort_bed_tmpdir_arg = " --tmpdir ";
-const char *sort_bed_stdin = " - ";
-const char *starch_bzip2_arg = " --bzip2 ";
-const char *starch_gzip_arg = " --gzip ";
-const char *starch_note_prefix_arg = " --note=\"";
-const char *starch_note_suffix_arg = "\" ";
-const char *starch_stdin_arg = " - ";
+const char *c2b_sort_run_file_template = "convert2bed.XXXXXX";
+const unsigned char c2b_starch_magic[4] = { 0xca, 0x5c, 0xad, 0xe5 };
+const char *c2b_base64_alphabet = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
 const char c2b_tab_delim = '\t';
 const char c2b_line_delim = '\n';
 const char c2b_space_delim = 0x20;
@@ -174,6 +202,7 @@ const char *c2b_wig_browser_prefix = "browser";
 const char *c2b_wig_variable_step_prefix = "variableStep";
 const char *c2b_wig_fixed_step_prefix = "fixedStep";
 const char *c2b_wig_chr_prefix = "chr";
+const char *c2b_digit_pairs = "00010203040506070809101112131415161718192021222324252627282930313233343536373839404142434445464748495051525354555657585960616263646566676869707172737475767778798081828384858687888990919293949596979899";
 
 /* 
    Allowed input and output formats
@@ -194,12 +223,72 @@ typedef enum format {
     UNDEFINED_FORMAT
 } c2b_format_t;
 
+/* 
+   Field spans
+   -------------------------------------------------------------------------
+   A span is a view of one field of an input line: a pointer into the line
+   buffer and the number of bytes in the field. Spans are not terminated, 
+   so they are written with c2b_emit_span() (or the "%.*s" conversion and 
+   C2B_SPAN_ARGS), and numeric fields are parsed with c2b_span_to_uint64().
+
+   BED records are built with the c2b_emit_*() routines, which each append
+   one column and the delimiter that follows it at a destination pointer, 
+   and return the pointer just past that delimiter. Coordinates are 
+   formatted two digits at a time from c2b_digit_pairs. Each format's 
+   c2b_line_convert_*_to_bed() routine is then a fixed sequence of inlined 
+   copies, with no format string to parse at run time.
+*/
+
+typedef struct span {
+    char *s;
+    ssize_t length;
+} c2b_span_t;
+
+#define C2B_SPAN_ARGS(f) (int) (f).length, (f).s
+
+/* 
+   Delimiter index
+   -------------------------------------------------------------------------
+   A block of input is scanned once for newlines and tabs, and their 
+   positions are kept as bitmaps of one bit per input byte, packed into 
+   64-bit words. Lines and fields are then found by walking set bits, rather
+   than by testing each byte again. 
+
+   The scan kernel is chosen at startup from what the CPU supports: AVX2 or 
+   SSE2 on x86, or portable C elsewhere. Every kernel fills the same 
+   bitmaps, so the choice is invisible to callers.
+*/
+
+typedef void (*c2b_delim_kernel_t)(const char *src, size_t src_size, uint64_t *line_bits, uint64_t *tab_bits);
+
+typedef struct delim_index {
+    char *src;
+    ssize_t src_size;
+    uint64_t *line_bits;
+    uint64_t *tab_bits;
+    size_t capacity;
+} c2b_delim_index_t;
+
 /* 
    BAM/SAM CIGAR operations
    -------------------------------------------------------------------------
    Allowed ops: \*|([0-9]+[MIDNSHPX=])+
+
+   Operations are decoded into inline_ops, which holds the few operations 
+   of a short-read alignment; long-read alignments, with thousands of 
+   operations, move ops to the heap and grow it as needed (see 
+   c2b_grow_cigar()). The bases of every operation are summed into bases 
+   as they are decoded, and give the stop position of an unsplit read.
+
+   Each operation character is classed with c2b_cigar_op_classes: M, = and
+   X are aligned to the reference, and D and N skip over it, splitting the 
+   read into blocks with --split.
 */
 
+#define C2B_CIGAR_OP_VALID 0x01
+#define C2B_CIGAR_OP_ALIGNED 0x02
+#define C2B_CIGAR_OP_SKIPPED 0x04
+
 typedef struct cigar_op {
     unsigned int bases;
     char operation;
@@ -209,13 +298,11 @@ typedef struct cigar {
     c2b_cigar_op_t *ops;
     ssize_t size;
     ssize_t length;
+    uint64_t bases;
+    c2b_cigar_op_t inline_ops[C2B_MAX_OPERATIONS_VALUE];
 } c2b_cigar_t;
 
-extern const unsigned int default_cigar_op_bases;
-const unsigned int default_cigar_op_bases = 0;
-
-extern const char default_cigar_op_operation;
-const char default_cigar_op_operation = '-';
+static unsigned char c2b_cigar_op_classes[256];
 
 /* 
    The SAM format is described at:
@@ -241,22 +328,144 @@ const char default_cigar_op_operation = '-';
 */
 
 typedef struct sam {
-    char *qname;
+    c2b_span_t qname;
     int flag;
-    char *strand;
-    char *rname;
+    c2b_span_t strand;
+    c2b_span_t rname;
     uint64_t start;
     uint64_t stop;
-    char *mapq;
-    char *cigar;
-    char *rnext;
-    char *pnext;
-    char *tlen;
-    char *seq;
-    char *qual;
-    char *opt;
+    c2b_span_t mapq;
+    c2b_span_t cigar;
+    c2b_span_t rnext;
+    c2b_span_t pnext;
+    c2b_span_t tlen;
+    c2b_span_t seq;
+    c2b_span_t qual;
+    c2b_span_t opt;
 } c2b_sam_t;
 
+/* 
+   BAM is the binary, BGZF-compressed form of SAM, described in section 4 of 
+   the same specification. A BGZF file is a series of gzip members, each 
+   holding at most 64 KB of uncompressed data and recording its own size in
+   a "BC" extra subfield, so that blocks can be found without inflating them.
+   The uncompressed data are the "BAM\1" magic string, the SAM header text, 
+   the reference sequence names and lengths, and then a series of alignment
+   records, each prefixed with its length in bytes. Integers are little-endian.
+   A BGZF file ends with an empty block, the end-of-file marker; as with 
+   samtools, input without it is converted, with a warning that it may be 
+   truncated.
+
+   Records are decoded directly to the SAM fields that make up BED output; 
+   a record is never printed as a SAM line and parsed back. The CIGAR 
+   string, SEQ, QUAL and tags are decoded into inline buffers, which hold
+   the fields of a short read; the fields of a long read move to the heap 
+   and grow as needed (see c2b_reserve_bam_field()), as CIGAR operations do.
+*/
+
+#define C2B_BGZF_MAX_BLOCK_SIZE 65536
+#define C2B_BGZF_HEADER_LENGTH 18
+#define C2B_BGZF_FOOTER_LENGTH 8
+#define C2B_BGZF_EOF_MARKER_LENGTH 28
+#define C2B_BGZF_SOURCE_BUFFER_SIZE 262144
+#define C2B_BAM_RECORD_CORE_LENGTH 32
+#define C2B_BGZF_BLOCKS_PER_THREAD 4
+#define C2B_BAI_PSEUDO_BIN 37450
+#define C2B_BAM_REGION_MAX_PENDING 8388608
+
+extern const char *c2b_bam_magic;
+const char *c2b_bam_magic = "BAM\1";
+
+extern const unsigned char c2b_bgzf_eof_marker[C2B_BGZF_EOF_MARKER_LENGTH];
+const unsigned char c2b_bgzf_eof_marker[C2B_BGZF_EOF_MARKER_LENGTH] = {
+    0x1f, 0x8b, 0x08, 0x04, 0x00, 0x00, 0x00, 0x00, 0x00, 0xff, 0x06, 0x00, 0x42, 0x43,
+    0x02, 0x00, 0x1b, 0x00, 0x03, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00
+};
+
+extern const char *c2b_bai_magic;
+const char *c2b_bai_magic = "BAI\1";
+
+extern const char *c2b_bam_cigar_ops;
+const char *c2b_bam_cigar_ops = "MIDNSHP=X";
+
+extern const char *c2b_bam_seq_bases;
+const char *c2b_bam_seq_bases = "=ACMGRSVTWYHKDBN";
+
+/*
+   With --threads=N, BGZF blocks are inflated by N worker threads. A reader
+   thread finds block boundaries from the block headers alone and copies
+   each compressed block into the next free slot of a ring. Workers inflate
+   filled slots in whatever order they become free, and the record decoder
+   takes inflated blocks strictly in input order, so records that span
+   block boundaries are reassembled exactly as in the single-threaded case.
+*/
+
+typedef enum bgzf_slot_state {
+    C2B_BGZF_SLOT_EMPTY,
+    C2B_BGZF_SLOT_FILLED,
+    C2B_BGZF_SLOT_INFLATED
+} c2b_bgzf_slot_state_t;
+
+typedef struct bgzf_slot {
+    unsigned char *src;
+    size_t src_size;
+    uint32_t crc;
+    uint32_t isize;
+    unsigned char *block;
+    c2b_bgzf_slot_state_t state;
+} c2b_bgzf_slot_t;
+
+typedef struct bgzf_ring {
+    c2b_bgzf_slot_t *slots;
+    size_t num;
+    size_t next_fill;
+    size_t next_inflate;
+    size_t next_read;
+    boolean is_done;
+    pthread_mutex_t lock;
+    pthread_cond_t changed;
+    pthread_t reader_thread;
+    pthread_t *worker_threads;
+    unsigned int num_workers;
+} c2b_bgzf_ring_t;
+
+typedef struct bgzf {
+    int fd;
+    off_t offset;
+    off_t block_coffset;
+    boolean is_positioned;
+    boolean is_at_eof_marker;
+    unsigned char *src;
+    size_t src_start;
+    size_t src_end;
+    size_t src_capacity;
+    unsigned char *block;
+    size_t block_size;
+    size_t block_offset;
+    z_stream z;
+    c2b_bgzf_ring_t *ring;
+} c2b_bgzf_t;
+
+typedef struct bam_field {
+    char *s;
+    size_t capacity;
+    char inline_s[C2B_MAX_FIELD_LENGTH_VALUE];
+} c2b_bam_field_t;
+
+typedef struct bam_record {
+    int32_t ref_id;
+    int32_t pos;
+    char strand[C2B_MAX_STRAND_LENGTH_VALUE];
+    char mapq[C2B_MAX_OPERATION_FIELD_LENGTH_VALUE];
+    char pnext[C2B_MAX_OPERATION_FIELD_LENGTH_VALUE];
+    char tlen[C2B_MAX_OPERATION_FIELD_LENGTH_VALUE];
+    char *rnext;
+    c2b_bam_field_t cigar;
+    c2b_bam_field_t seq;
+    c2b_bam_field_t qual;
+    c2b_bam_field_t opt;
+} c2b_bam_record_t;
+
 /* 
    The GFF format is described at:
 
@@ -278,16 +487,16 @@ typedef struct sam {
 */
 
 typedef struct gff {
-    char *seqid;
-    char *source;
-    char *type;
+    c2b_span_t seqid;
+    c2b_span_t source;
+    c2b_span_t type;
     uint64_t start;
     uint64_t end;
-    char *score;
-    char *strand;
-    char *phase;
-    char *attributes;
-    char *id;
+    c2b_span_t score;
+    c2b_span_t strand;
+    c2b_span_t phase;
+    c2b_span_t attributes;
+    c2b_span_t id;
 } c2b_gff_t;
 
 /* 
@@ -312,17 +521,17 @@ typedef struct gff {
 */
 
 typedef struct gtf {
-    char *seqname;
-    char *source;
-    char *feature;
+    c2b_span_t seqname;
+    c2b_span_t source;
+    c2b_span_t feature;
     uint64_t start;
     uint64_t end;
-    char *score;
-    char *strand;
-    char *frame;
-    char *attributes;
-    char *id;
-    char *comments;
+    c2b_span_t score;
+    c2b_span_t strand;
+    c2b_span_t frame;
+    c2b_span_t attributes;
+    c2b_span_t id;
+    c2b_span_t comments;
 } c2b_gtf_t;
 
 /* 
@@ -366,27 +575,21 @@ typedef struct psl {
     uint64_t qBaseInsert;
     uint64_t tNumInsert;
     uint64_t tBaseInsert;
-    char *strand;
-    char *qName;
+    c2b_span_t strand;
+    c2b_span_t qName;
     uint64_t qSize;
     uint64_t qStart;
     uint64_t qEnd;
-    char *tName;
+    c2b_span_t tName;
     uint64_t tSize;
     uint64_t tStart;
     uint64_t tEnd;
     uint64_t blockCount;
-    char *blockSizes;
-    char *qStarts;
-    char *tStarts;
+    c2b_span_t blockSizes;
+    c2b_span_t qStarts;
+    c2b_span_t tStarts;
 } c2b_psl_t;
 
-typedef struct block {
-    uint64_t *sizes;
-    uint64_t *starts;
-    uint64_t max_count;
-} c2b_psl_block_t;
-
 /* 
    The RepeatMasker OUT (RMSK) format is described at:
 
@@ -420,22 +623,22 @@ typedef struct block {
 */
 
 typedef struct rmsk {
-    char *sw_score;
-    char *perc_div;
-    char *perc_deleted;
-    char *perc_inserted;
-    char *query_seq;
+    c2b_span_t sw_score;
+    c2b_span_t perc_div;
+    c2b_span_t perc_deleted;
+    c2b_span_t perc_inserted;
+    c2b_span_t query_seq;
     uint64_t query_start;
     uint64_t query_end;
-    char *bases_past_match;
-    char *strand;
-    char *repeat_name;
-    char *repeat_class;
-    char *bases_before_match_comp;
-    char *match_start;
-    char *match_end;
-    char *unique_id;
-    char *higher_score_match;
+    c2b_span_t bases_past_match;
+    c2b_span_t strand;
+    c2b_span_t repeat_name;
+    c2b_span_t repeat_class;
+    c2b_span_t bases_before_match_comp;
+    c2b_span_t match_start;
+    c2b_span_t match_end;
+    c2b_span_t unique_id;
+    c2b_span_t higher_score_match;
 } c2b_rmsk_t;
 
 /* 
@@ -469,42 +672,37 @@ typedef struct rmsk {
 */
 
 typedef struct vcf {
-    char *chrom;
+    c2b_span_t chrom;
     uint64_t pos;
     uint64_t start;
     uint64_t end;
-    char *id;
-    char *ref;
-    char *alt;
-    char *qual;
-    char *filter;
-    char *info;
-    char *format;
-    char *samples;
+    c2b_span_t id;
+    c2b_span_t ref;
+    c2b_span_t alt;
+    c2b_span_t qual;
+    c2b_span_t filter;
+    c2b_span_t info;
+    c2b_span_t format;
+    c2b_span_t samples;
 } c2b_vcf_t;
 
 /* 
-   At most, we need 4 pipes to handle the most complex conversion
-   pipeline used with the BEDOPS suite: 
-   
-    BAM -> SAM -> BED (unsorted) -> BED (sorted) -> Starch
-   
-   Here, each arrow represents a unidirectional path of data 
-   between processing steps. 
-   
-   The other two possibilities are:
-     
-    BAM -> SAM -> BED (unsorted) -> BED (sorted)
-    BAM -> SAM -> BED (unsorted)
-   
-   More generically, other formats typically follow one of these three paths:
+   Conversion pipelines used with the BEDOPS suite follow one of these 
+   three paths:
 
     XYZ -> BED (unsorted) -> BED (sorted) -> Starch
     XYZ -> BED (unsorted) -> BED (sorted)
     XYZ -> BED (unsorted)
 
-   Here, XYZ is one of GFF, GTF, PSL, RepeatMasker (OUT), SAM, VCF, or WIG.
-   
+   Here, XYZ is one of BAM, GFF, GTF, PSL, RepeatMasker (OUT), SAM, VCF, or
+   WIG. Input is read from standard input directly by the line processing
+   stage, without an intermediate process or pipe; BAM records are decoded
+   from their BGZF blocks by that stage, rather than printed as SAM by an
+   external samtools process. Sorting and Starch compression are done in
+   the same stage, so only unsorted BED passes through a pipe, to a stage
+   that writes it to standard output. On Linux, that stage moves bytes from
+   the pipe with splice(), so they are not copied through userspace.
+
    If a more complex pipeline arises, we can increase the value of MAX_PIPES.
 
    Each pipe has a read and write stream. The write stream handles
@@ -542,19 +740,479 @@ typedef struct pipeline_stage {
     pid_t pid;
 } c2b_pipeline_stage_t;
 
+/*
+   A conversion context holds the parser state that carries over from
+   one input line to the next: the running header line index, the last
+   GTF gene_id, the RepeatMasker header line count, the current WIG
+   section and the BAM reference sequence names. Each line functor reads and updates only the context it is
+   given, so that several contexts can be in use at once.
+*/
+
+typedef struct gtf_context {
+    char id[C2B_MAX_FIELD_LENGTH_VALUE];
+} c2b_gtf_context_t;
+
+typedef struct rmsk_context {
+    uint64_t line;
+    boolean is_start_of_line;
+    boolean is_start_of_gap;
+} c2b_rmsk_context_t;
+
+typedef struct wig_context {
+    uint32_t section;
+    uint32_t line;
+    uint32_t pos_lines;
+    uint64_t span;
+    uint64_t step;
+    uint64_t start_pos;
+    uint64_t end_pos;
+    double score;
+    char chr[C2B_MAX_CHROMOSOME_LENGTH];
+    char id[C2B_MAX_FIELD_LENGTH_VALUE];
+    boolean is_fixed_step;
+    boolean start_write;
+} c2b_wig_context_t;
+
+typedef struct bam_context {
+    char **ref_names;
+    int32_t num_refs;
+} c2b_bam_context_t;
+
+/*
+   Lines read, and records dropped on the way to output, are counted in 
+   the context that converts them, and summed into the global --stats
+   counters when the converting thread is done. BAM records count as lines.
+*/
+
+typedef struct record_counts {
+    uint64_t lines;
+    uint64_t unmapped_reads;
+    uint64_t filtered_reads;
+    uint64_t filtered_alleles;
+    uint64_t unpaired_reads;
+    uint64_t orphan_reads;
+} c2b_record_counts_t;
+
+/*
+   With --fragments, each properly paired template is written as one BED
+   element, from the leftmost start to the rightmost stop of its two primary
+   alignments. A read waits in a table of pending mates, keyed by QNAME (and 
+   checked against the mate's reference, position and first/last segment
+   flag), until its mate arrives. The table is open-addressed on an FNV-1a
+   hash of QNAME, probed linearly, and grown at half load up to 
+   --fragments-max-mem. Past that, its mates are spilled by hash to one of
+   C2B_FRAGMENT_PARTITIONS_VALUE unlinked files in --sort-tmpdir, and the 
+   table is emptied.
+
+   At the end of input, if anything was spilled, the pending mates are 
+   spilled as well, and each partition is read back and paired in turn. 
+   Mates share a hash, and so a partition. A partition that does not fit 
+   either is itself partitioned on the next four bits of the hash. Reads 
+   that are not one of a proper pair's primary alignments are counted as 
+   unpaired, and reads whose mate never arrives, as orphans. Chromosome 
+   names are interned per context, as for the sorter.
+*/
+
+#define C2B_FRAGMENT_PARTITIONS_VALUE 16
+#define C2B_MAX_FRAGMENT_DEPTH_VALUE 8
+#define C2B_MAX_QNAME_LENGTH_VALUE 254
+#define C2B_FRAGMENTS_MAX_MEM_DEFAULT 536870912ULL
+
+typedef struct fragment_mate {
+    uint64_t hash;
+    uint64_t start;
+    uint64_t stop;
+    uint64_t mate_start;
+    uint32_t chrom;
+    uint16_t flag;
+    uint8_t mapq;
+    uint8_t qname_length;
+    char qname[C2B_MAX_QNAME_LENGTH_VALUE + 1];
+} c2b_fragment_mate_t;
+
+typedef struct fragment_table {
+    c2b_fragment_mate_t *mates;
+    size_t num_mates;
+    size_t capacity;
+    unsigned int depth;
+    int spill_fds[C2B_FRAGMENT_PARTITIONS_VALUE];
+    boolean is_spilled;
+} c2b_fragment_table_t;
+
+typedef struct fragment_state {
+    c2b_fragment_table_t table;
+    char **chrom_names;
+    size_t *chrom_lengths;
+    uint32_t num_chroms;
+    uint32_t chroms_capacity;
+    uint32_t *chrom_slots;
+    uint32_t chrom_slots_capacity;
+    uint32_t last_chrom;
+} c2b_fragment_state_t;
+
+typedef struct context {
+    unsigned int header_line_idx;
+    c2b_gtf_context_t gtf;
+    c2b_rmsk_context_t rmsk;
+    c2b_wig_context_t wig;
+    c2b_bam_context_t bam;
+    c2b_delim_index_t *delims;
+    c2b_fragment_state_t *fragments;
+    struct coverage_state *coverage;
+    c2b_record_counts_t counts;
+} c2b_context_t;
+
+/*
+   BED output is sorted in process. The line processing stage hands each
+   buffer of converted lines to the sorter in place of writing it to a 
+   pipe. The text is copied once into large blocks, and each line is 
+   indexed by a record that holds its chromosome, start and stop, parsed 
+   as the line is added. Sorting then compares these keys alone and never
+   goes back to the text, except to order records whose keys are equal.
+
+   Chromosome names are interned as they are seen; before sorting, each
+   name is given its lexicographic rank, so that records compare on one
+   integer for the chromosome. Records are sorted on --threads threads, 
+   each merge-sorting one slice, after which adjacent slices are merged 
+   pairwise until one run remains. 
+
+   Blocks and records are counted against --max-mem, as are the scratch
+   records they are merge-sorted through and the buffer that runs and 
+   output are written through. When they would exceed it, the records 
+   held are sorted and spilled as a run to a temporary file in 
+   --sort-tmpdir, and memory is released. --max-mem may not be less than
+   C2B_SORT_MIN_MAX_MEM, which leaves room for these fixed costs. A run is a sequence of binary 
+   records: a fixed header with the interned chromosome id, start, stop 
+   and text length, followed by the line text less its chromosome name. 
+   All runs share one unlinked file, each at its own offset. At the end of
+   input, the records still in memory are sorted and merged with the runs
+   through a loser tree, which reads each run through its own buffer. The
+   sorted lines are written to stdout, or to the Starch writer.
+*/
+
+typedef struct sort_record {
+    uint64_t start;
+    uint64_t stop;
+    uint32_t chrom;
+    uint32_t length;
+    char *line;
+} c2b_sort_record_t;
+
+typedef struct sort_chrom {
+    char *name;
+    size_t length;
+    uint32_t rank;
+} c2b_sort_chrom_t;
+
+typedef struct sort_run {
+    off_t offset;
+    off_t size;
+    size_t num_records;
+    uint64_t memory;
+    double sort_seconds;
+    double write_seconds;
+} c2b_sort_run_t;
+
+typedef struct sort_run_record {
+    uint32_t chrom;
+    uint32_t length;
+    uint64_t start;
+    uint64_t stop;
+} c2b_sort_run_record_t;
+
+typedef struct sort_source {
+    uint32_t chrom;
+    uint64_t start;
+    uint64_t stop;
+    char *rest;
+    uint32_t rest_length;
+    boolean is_exhausted;
+    c2b_sort_run_t *run;
+    off_t offset;
+    char *buffer;
+    size_t buffer_capacity;
+    size_t buffer_start;
+    size_t buffer_end;
+    size_t index;
+} c2b_sort_source_t;
+
+/*
+   With --output=starch, sorted records go to a Starch writer rather than to
+   stdout. The writer produces a Starch (v2.1) archive itself: a four-byte
+   magic number, one compressed stream per chromosome, JSON metadata and a
+   footer that holds the metadata offset and the base64 SHA-1 digest of the
+   metadata.
+
+   Each stream holds the chromosome's records in Starch's transformed form:
+   a "p<length>" line whenever the element length changes, then the start 
+   less the previous stop, and the remaining columns. The writer transforms
+   records into chunks and queues them to a compression thread that is 
+   started for each chromosome when its first record arrives, so that 
+   chromosomes are compressed in parallel. Up to --starch-threads streams
+   are compressed at once; past that, a new chromosome waits on the oldest
+   stream. Queues are bounded, so that the writer also waits on a 
+   compressor that falls behind. 
+
+   Streams are written out in chromosome order. The oldest unwritten 
+   stream is written to the output as it is compressed. Later streams 
+   hold their compressed bytes until it is their turn; the bytes held by 
+   all streams are counted against a quarter of --max-mem, and a stream 
+   that would pass that spills what it holds to an unlinked file in 
+   --sort-tmpdir. When a stream becomes the oldest, what it spilled and 
+   then what it holds are written out, and it goes on to write directly.
+
+   The writer may take up to half of --max-mem: its queued chunks, the 
+   chunk each compressor works on, their output blocks and compressor 
+   state, and the bytes its streams may hold. If that does not fit, queues
+   are shortened and then fewer streams are compressed at once. What the
+   writer takes is set aside before the sorter spills or merges any run.
+*/
+
+typedef struct starch_chunk {
+    char *data;
+    size_t size;
+    struct starch_chunk *next;
+} c2b_starch_chunk_t;
+
+typedef struct starch_stream {
+    char *chrom;
+    uint64_t line_count;
+    uint64_t non_unique_bases;
+    uint64_t unique_bases;
+    boolean duplicate_exists;
+    boolean nested_exists;
+    c2b_starch_chunk_t *head;
+    c2b_starch_chunk_t *tail;
+    size_t num_queued;
+    boolean is_complete;
+    boolean is_done;
+    boolean is_streaming;
+    size_t compressed_size;
+    char *held;
+    size_t held_size;
+    size_t held_capacity;
+    int spill_fd;
+    struct starch_writer *writer;
+    pthread_t thread;
+    pthread_mutex_t lock;
+    pthread_cond_t changed;
+} c2b_starch_stream_t;
+
+typedef struct starch_writer {
+    int dest_fd;
+    c2b_starch_stream_t **streams;
+    size_t num_streams;
+    size_t streams_capacity;
+    size_t num_written;
+    uint64_t archive_size;
+    c2b_sort_chrom_t *current_chrom;
+    char *chunk;
+    size_t chunk_size;
+    size_t chunk_capacity;
+    uint64_t last_start;
+    uint64_t last_stop;
+    uint64_t last_length;
+    uint64_t coverage_stop;
+    unsigned int num_threads;
+    size_t max_queued_chunks;
+    uint64_t memory;
+    uint64_t held_memory;
+    uint64_t max_held_memory;
+    pthread_mutex_t lock;
+    char hostname[C2B_MAX_FIELD_LENGTH_VALUE];
+} c2b_starch_writer_t;
+
+typedef struct sorter {
+    c2b_sort_record_t *records;
+    size_t num_records;
+    size_t records_capacity;
+    char **blocks;
+    size_t num_blocks;
+    size_t blocks_capacity;
+    size_t block_size;
+    size_t block_capacity;
+    c2b_sort_chrom_t *chroms;
+    uint32_t num_chroms;
+    uint32_t chroms_capacity;
+    uint32_t *chrom_slots;
+    uint32_t chrom_slots_capacity;
+    uint32_t last_chrom;
+    c2b_sort_chrom_t **chroms_by_rank;
+    uint64_t memory;
+    uint64_t max_memory;
+    uint64_t peak_memory;
+    size_t total_records;
+    int run_fd;
+    off_t run_file_size;
+    c2b_sort_run_t *runs;
+    size_t num_runs;
+    size_t runs_capacity;
+    c2b_starch_writer_t *starch;
+} c2b_sorter_t;
+
+/*
+   Converted records are appended to an output buffer. Before writing a
+   record, a functor reserves an upper bound on its length with 
+   c2b_reserve_output(). If the record does not fit and the buffer holds at
+   least its watermark, the buffer is first flushed to the fd or in-process
+   sorter it was opened on; failing that, it is grown. Buffers opened with 
+   no downstream (fd of -1 and no sorter) only grow, and are drained by 
+   their owners: chunk and BAM region workers, and the merge step's scratch
+   buffer.
+
+   Buffers therefore start small, and a line that converts to many records,
+   as with --split SAM or multi-allelic VCF input, cannot overrun them.
+*/
+
+typedef struct output {
+    char *buf;
+    ssize_t size;
+    ssize_t capacity;
+    ssize_t watermark;
+    int fd;
+    c2b_sorter_t *sorter;
+} c2b_output_t;
+
+/*
+   With --coverage, converted elements are summed into runs of constant 
+   depth rather than written out. Each call to the format's functor writes 
+   its lines to a scratch buffer, from which the chromosome, start and stop 
+   of each element are read back. Starts and stops are held as events in a
+   binary min-heap, one 64-bit word each (the position, shifted left, with
+   the low bit set for a start). 
+
+   Input must be sorted by coordinate within each chromosome. The lowest 
+   start among the lines of a call is then a watermark that no later element
+   falls below -- this holds for the blocks of a split read, which may start
+   past the next read -- so events below it are taken off the heap and runs 
+   are written out as depth changes. A run ends only where depth changes, 
+   and runs of zero depth are not written. When the chromosome changes, 
+   the remaining events are swept. A start below the watermark, or a 
+   chromosome that returns after another, is an error. Memory is bounded 
+   by the number of elements that overlap the watermark.
+*/
+
+typedef struct coverage_state {
+    char *chrom;
+    size_t chrom_length;
+    size_t chrom_capacity;
+    boolean has_chrom;
+    char **done_chroms;
+    size_t num_done_chroms;
+    size_t done_chroms_capacity;
+    uint64_t watermark;
+    uint64_t *events;
+    size_t num_events;
+    size_t events_capacity;
+    uint64_t run_start;
+    uint64_t depth;
+    c2b_output_t scratch;
+} c2b_coverage_state_t;
+
+typedef struct sort_task {
+    c2b_sort_record_t *records;
+    c2b_sort_record_t *buffer;
+    size_t start;
+    size_t middle;
+    size_t end;
+} c2b_sort_task_t;
+
+/*
+   With --threads=N, the line processing stage reads newline-aligned chunks
+   of input into a ring of chunk slots. N worker threads convert filled
+   chunks in whatever order they become free, while a writer thread sends
+   converted chunks downstream strictly in input order. Unsorted output is
+   therefore identical to that of the single-threaded path.
+
+   Each chunk carries a copy of the context as it stood before its first
+   line. The reader thread builds these copies in input order: after
+   filling a chunk, it advances a running context over the chunk's lines
+   (see c2b_advance_context()). This merge step runs the line functor
+   only on those lines that can change the context -- header lines, WIG
+   section headers and so on -- and applies the cheaper updates for plain
+   data lines directly, which leaves the bulk of the conversion to the
+   workers.
+
+   A chunk holds at most C2B_MAX_LINE_LENGTH_VALUE bytes of input, unless a
+   line is longer than that, in which case the chunk size is doubled (up to
+   --max-line-length) until the line fits. Its output buffer grows to take
+   whatever its lines convert to.
+*/
+
+typedef enum chunk_state {
+    C2B_CHUNK_EMPTY,
+    C2B_CHUNK_FILLED,
+    C2B_CHUNK_CONVERTED
+} c2b_chunk_state_t;
+
+typedef struct chunk {
+    char *src;
+    ssize_t src_size;
+    char *src_buffer;
+    ssize_t src_capacity;
+    c2b_output_t dest;
+    c2b_context_t context;
+    c2b_delim_index_t delims;
+    c2b_chunk_state_t state;
+} c2b_chunk_t;
+
+typedef struct chunk_queue {
+    c2b_chunk_t *chunks;
+    size_t num;
+    size_t next_fill;
+    size_t next_convert;
+    size_t next_write;
+    boolean is_done;
+    pthread_mutex_t lock;
+    pthread_cond_t changed;
+    void (*line_functor)(c2b_context_t *, c2b_output_t *, char *, ssize_t);
+    int dest_fd;
+    c2b_sorter_t *sorter;
+} c2b_chunk_queue_t;
+
+/*
+   With --bai, BAM input is converted one reference sequence at a time. 
+   The index gives the virtual offsets that bound the records of each 
+   reference, and each of --threads workers seeks a BGZF reader of its own
+   to the next unclaimed region and converts it. The stage takes converted
+   bytes region by region, in the order regions were listed, and passes 
+   them on to the sorter (or stdout) as they arrive. No temporary files 
+   are made: only the output of regions ahead of the one being written is
+   held in memory until its turn comes. A worker whose region has more than
+   C2B_BAM_REGION_MAX_PENDING bytes held waits for the stage to take them,
+   so that no more than about that much per worker is ever held.
+
+   With --all-reads and no --regions, unplaced reads at the end of the 
+   file make up one more region, which runs to the end of input.
+*/
+
+typedef struct bam_region {
+    int32_t ref_id;
+    uint64_t begin;
+    uint64_t end;
+    char *pending;
+    size_t pending_size;
+    size_t pending_capacity;
+    boolean is_done;
+} c2b_bam_region_t;
+
+typedef struct bam_region_queue {
+    c2b_bam_region_t *regions;
+    size_t num;
+    size_t next_convert;
+    int src_fd;
+    c2b_context_t *context;
+    pthread_mutex_t lock;
+    pthread_cond_t changed;
+    void (*line_functor)(c2b_context_t *, c2b_output_t *, char *, ssize_t);
+} c2b_bam_region_queue_t;
+
 #define PIPE4_FLAG_NONE       (0U)
 #define PIPE4_FLAG_RD_CLOEXEC (1U << 0)
 #define PIPE4_FLAG_WR_CLOEXEC (1U << 1)
 
 #define c2b_pipe4_cloexec(fd) c2b_pipe4((fd), PIPE4_FLAG_RD_CLOEXEC | PIPE4_FLAG_WR_CLOEXEC)
 
-#define POPEN4_FLAG_NONE                        (0U)
-#define POPEN4_FLAG_NOCLOSE_PARENT_STDIN        (1U << 0)
-#define POPEN4_FLAG_NOCLOSE_PARENT_STDOUT       (1U << 1)
-#define POPEN4_FLAG_NOCLOSE_PARENT_STDERR       (1U << 2)
-#define POPEN4_FLAG_CLOSE_CHILD_STDIN           (1U << 3)
-#define POPEN4_FLAG_CLOSE_CHILD_STDOUT          (1U << 4)
-#define POPEN4_FLAG_CLOSE_CHILD_STDERR          (1U << 5)
 
 static const char *general_name = "convert2bed";
 
@@ -587,14 +1245,36 @@ static const char *general_io_options =                                 \
 static const char *general_options =                                    \
     "  Other processing options:\n\n"                                   \
     "  --do-not-sort (-d)\n"                                            \
-    "      Do not sort BED output with sort-bed (not compatible with --output=starch)\n" \
+    "      Do not sort BED output (not compatible with --output=starch)\n" \
+    "  --coverage[=bedgraph|bed] (-V[<type>])\n"                        \
+    "      Write runs of constant coverage depth over the converted elements\n" \
+    "      in place of the elements themselves, as bedGraph (the default) or\n" \
+    "      as BED with the depth in the score column. Input must be sorted by\n" \
+    "      coordinate; with --split, coverage is taken over read blocks\n" \
     "  --max-mem=<value> (-m <val>)\n"                                  \
     "      Sets aside <value> memory for sorting BED output. For example, <value> can\n" \
-    "      be 8G, 8000M or 8000000000 to specify 8 GB of memory (default is 2G)\n" \
+    "      be 8G, 8000M or 8000000000 to specify 8 GB of memory (default is 2G). Data\n" \
+    "      beyond this are sorted in runs, which are written to a temporary file.\n" \
+    "      The minimum is 16M. With --output=starch, up to half of <value> is set\n" \
+    "      aside for compression\n" \
     "  --sort-tmpdir=<dir> (-r <dir>)\n"                                \
     "      Optionally sets [dir] as temporary directory for sort data, when used in\n" \
     "      conjunction with --max-mem=[value], instead of the host's operating system\n" \
     "      default temporary directory\n"                               \
+    "  --max-line-length=<value> (-L <val>)\n"                         \
+    "      Input lines longer than 131072 bytes are read into buffers that grow up to\n" \
+    "      <value> bytes; longer lines are rejected. Takes the same suffixes as\n" \
+    "      --max-mem (default is 256M, and the minimum is 128K)\n"     \
+    "  --pipe-size=<value> (-P <val>)\n"                               \
+    "      Sets the capacity of the pipe between conversion and output stages, and of\n" \
+    "      standard input and output where these are pipes, to <value> bytes. Takes the\n" \
+    "      same suffixes as --max-mem (default is 1M, for the internal pipe only)\n" \
+    "  --stats[=<file>] (-S[<file>])\n"                                \
+    "      Report bytes and lines in and out, records dropped, and wall and CPU time\n" \
+    "      of each stage as JSON, to standard error or to <file>. The report has\n" \
+    "      sort, line and pipe sections, with each sort run, line buffer growth,\n" \
+    "      and the time each stage spent blocked on a pipe. --sort-stats (-y),\n" \
+    "      --line-stats (-u) and --pipe-stats (-T) are kept as aliases\n" \
     "  --starch-bzip2 (-z)\n"                                           \
     "      Used with --output=starch, the compressed output explicitly applies the bzip2\n" \
     "      algorithm to compress intermediate data (default is bzip2)\n" \
@@ -603,6 +1283,13 @@ static const char *general_options =                                    \
     "      intermediate data\n"                                         \
     "  --starch-note=\"xyz...\" (-e \"xyz...\")\n"                      \
     "      Used with --output=starch, this adds a note to the Starch archive metadata\n" \
+    "  --starch-threads=<n> (-c <n>)\n"                                 \
+    "      Used with --output=starch, compresses up to <n> chromosomes at once (default\n" \
+    "      is 2, or the --threads value if greater). Fewer are used if they do not\n" \
+    "      fit in half of --max-mem\n"                                  \
+    "  --threads=<n> (-@ <n>)\n"                                        \
+    "      Convert input lines on <n> worker threads (default is 1); BAM input is\n" \
+    "      decompressed on <n> threads instead. Output order is preserved\n" \
     "  --help | --help[-bam|-gff|-gtf|-gvf|-psl|-rmsk|-sam|-vcf|-wig] (-h | -h <fmt>)\n" \
     "      Show general help message (or detailed help for a specified input format)\n" \
     "  --version (-w)\n"                                                \
@@ -613,9 +1300,9 @@ static const char *bam_name = "convert2bed -i bam";
 static const char *bam_description =                                    \
     "  The BAM format is an indexed, binary representation of a SAM (Sequence\n" \
     "  Alignment/Map) file. Internally, it is a 0-based, half-open [a-1,b)\n" \
-    "  file, but printing it to text via samtools turns it into a SAM file, which\n" \
-    "  is 1-based, closed [a,b]. We convert this indexing back to 0-based, half-\n" \
-    "  open when creating BED output.\n"                                \
+    "  file, while its SAM text form is 1-based, closed [a,b]. We decode BAM\n" \
+    "  records directly, without samtools, and write the same 0-based, half-open\n" \
+    "  BED output as for the equivalent SAM input.\n"                 \
     "\n"                                                                \
     "  We process SAM columns from mappable reads (as described by \n"  \
     "  http://samtools.github.io/hts-specs/SAMv1.pdf) converting them into the first\n" \
@@ -662,7 +1349,41 @@ static const char *bam_options =                                        \
     "      Preserve header section as pseudo-BED elements\n"            \
     "  --split (-s)\n"                                                  \
     "      Split reads with 'N' CIGAR operations into separate BED\n"   \
-    "      elements\n";
+    "      elements\n"                                                  \
+    "  --split-bed6 (-B)\n"                                             \
+    "      Used with --split, write only the first six BED columns\n"  \
+    "  --columns=<name>[,<name>...] (-C <names>)\n"                    \
+    "      Write the six BED columns followed by only the named SAM\n"  \
+    "      fields (flag, cigar, rnext, pnext, tlen, seq, qual, or opt\n" \
+    "      for all optional fields) and the values of the named tags\n" \
+    "      (for example, NM), in order. Use bed6 for the six columns\n" \
+    "      alone\n"                                                 \
+    "  --require-flags=<int> (-f <int>)\n"                             \
+    "      Only convert reads with all of the <int> FLAG bits set\n"    \
+    "  --exclude-flags=<int> (-F <int>)\n"                             \
+    "      Only convert reads with none of the <int> FLAG bits set\n"   \
+    "  --min-mapq=<int> (-q <int>)\n"                                  \
+    "      Only convert reads with a MAPQ of at least <int>\n"          \
+    "  --tag-filter=<predicate> (-G <predicate>)\n"                    \
+    "      Only convert reads whose optional tags satisfy <predicate>:\n" \
+    "      TAG or !TAG (tag present or absent), or TAG=v, TAG!=v,\n"    \
+    "      TAG<v, TAG<=v, TAG>v or TAG>=v (for example, NM<=2). Values\n" \
+    "      of standard integer tags, such as NM, must be numbers. May be\n" \
+    "      given more than once; reads must satisfy every predicate\n" \
+    "  --fragments (-R)\n"                                              \
+    "      Write one BED element per properly paired template, from the\n" \
+    "      leftmost start to the rightmost stop of its mates, with the\n" \
+    "      QNAME, the lower MAPQ and the strand of the first segment.\n" \
+    "      Other reads are skipped. Input need not be sorted by name\n" \
+    "  --fragments-max-mem=<value> (-M <value>)\n"                     \
+    "      Hold at most <value> bytes of reads awaiting their mates in\n" \
+    "      memory before spilling them to --sort-tmpdir (default 512M)\n" \
+    "  --bai=<file> (-j <file>)\n"                                     \
+    "      Use the BAM index <file> to convert reference sequences in\n" \
+    "      parallel on --threads workers. Input must be a regular file\n" \
+    "      redirected to standard input\n"                              \
+    "  --regions=<name>[,<name>...] (-l <names>)\n"                    \
+    "      Used with --bai, convert only the named reference sequences\n";
 
 static const char *bam_usage =                                          \
     "  Converts 0-based, half-open [a-1,b) headered or headerless BAM input\n" \
@@ -678,8 +1399,8 @@ static const char *bam_usage =                                          \
     "  $ convert2bed -i bam -o starch < foo.bam > sorted-foo.bam.starch\n" \
     "\n"                                                                \
     "  We make no assumptions about sort order from converted output. Apply\n" \
-    "  the usage case displayed to pass data to the BEDOPS sort-bed application,\n" \
-    "  which generates lexicographically-sorted BED data as output.\n"  \
+    "  the usage case displayed to sort converted data, which generates\n" \
+    "  lexicographically-sorted BED data as output.\n"                 \
     "\n"                                                                \
     "  If you want to skip sorting, use the --do-not-sort option:\n"    \
     "\n"                                                                \
@@ -737,8 +1458,8 @@ static const char *gff_usage =                                          \
     "  $ convert2bed -i gff -o starch < foo.gff > sorted-foo.gff.starch\n" \
     "\n"                                                                \
     "  We make no assumptions about sort order from converted output. Apply\n" \
-    "  the usage case displayed to pass data to the sort-bed application,\n" \
-    "  which generates lexicographically-sorted BED data as output.\n"  \
+    "  the usage case displayed to sort converted data, which generates\n" \
+    "  lexicographically-sorted BED data as output.\n"                 \
     "\n"                                                                \
     "  If you want to skip sorting, use the --do-not-sort option:\n"    \
     "\n"                                                                \
@@ -761,8 +1482,8 @@ static const char *gtf_usage =                                          \
     "  $ convert2bed -i gtf -o starch < foo.gtf > sorted-foo.gtf.starch\n" \
     "\n"                                                                \
     "  We make no assumptions about sort order from converted output. Apply\n" \
-    "  the usage case displayed to pass data to the sort-bed application,\n" \
-    "  which generates lexicographically-sorted BED data as output.\n"  \
+    "  the usage case displayed to sort converted data, which generates\n" \
+    "  lexicographically-sorted BED data as output.\n"                 \
     "\n"                                                                \
     "  If you want to skip sorting, use the --do-not-sort option:\n"    \
     "\n"                                                                \
@@ -855,8 +1576,8 @@ static const char *gvf_usage =                                          \
     "  $ convert2bed -i gvf -o starch < foo.gvf > sorted-foo.gvf.starch\n" \
     "\n"                                                                \
     "  We make no assumptions about sort order from converted output. Apply\n" \
-    "  the usage case displayed to pass data to the sort-bed application,\n" \
-    "  which generates lexicographically-sorted BED data as output.\n"  \
+    "  the usage case displayed to sort converted data, which generates\n" \
+    "  lexicographically-sorted BED data as output.\n"                 \
     "\n"                                                                \
     "  If you want to skip sorting, use the --do-not-sort option:\n"    \
     "\n"                                                                \
@@ -877,8 +1598,8 @@ static const char *psl_usage =                                          \
     "  $ convert2bed -i psl -o starch < foo.psl > sorted-foo.psl.starch\n" \
     "\n"                                                                \
     "  We make no assumptions about sort order from converted output. Apply\n" \
-    "  the usage case displayed to pass data to the BEDOPS sort-bed application\n" \
-    "  which generates lexicographically-sorted BED data as output.\n"  \
+    "  the usage case displayed to sort converted data, which generates\n" \
+    "  lexicographically-sorted BED data as output.\n"                 \
     "\n"                                                                \
     "  If you want to skip sorting, use the --do-not-sort option:\n"    \
     "\n"                                                                \
@@ -953,8 +1674,8 @@ static const char *rmsk_usage =                                         \
     "  $ convert2bed -i rmsk -o starch < foo.out > sorted-foo.out.starch\n" \
     "\n"                                                                \
     "  We make no assumptions about sort order from converted output. Apply\n" \
-    "  the usage case displayed to pass data to the BEDOPS sort-bed application,\n" \
-    "  which generates lexicographically-sorted BED data as output.\n"  \
+    "  the usage case displayed to sort converted data, which generates\n" \
+    "  lexicographically-sorted BED data as output.\n"                 \
     "\n"                                                                \
     "  If you want to skip sorting, use the --do-not-sort option:\n"    \
     "\n"                                                                \
@@ -1015,8 +1736,8 @@ static const char *sam_usage =                                          \
     "  $ convert2bed -i sam -o starch < foo.sam > sorted-foo.sam.starch\n" \
     "\n"                                                                \
     "  We make no assumptions about sort order from converted output. Apply\n" \
-    "  the usage case displayed to pass data to the BEDOPS sort-bed application,\n" \
-    "  which generates lexicographically-sorted BED data as output.\n"  \
+    "  the usage case displayed to sort converted data, which generates\n" \
+    "  lexicographically-sorted BED data as output.\n"                 \
     "\n"                                                                \
     "  If you want to skip sorting, use the --do-not-sort option:\n"    \
     "\n"                                                                \
@@ -1072,7 +1793,35 @@ static const char *sam_options =                                        \
     "      Preserve header section as pseudo-BED elements\n"            \
     "  --split (-s)\n"                                                  \
     "      Split reads with 'N' CIGAR operations into separate BED\n"   \
-    "      elements\n";
+    "      elements\n"                                                  \
+    "  --split-bed6 (-B)\n"                                             \
+    "      Used with --split, write only the first six BED columns\n"  \
+    "  --columns=<name>[,<name>...] (-C <names>)\n"                    \
+    "      Write the six BED columns followed by only the named SAM\n"  \
+    "      fields (flag, cigar, rnext, pnext, tlen, seq, qual, or opt\n" \
+    "      for all optional fields) and the values of the named tags\n" \
+    "      (for example, NM), in order. Use bed6 for the six columns\n" \
+    "      alone\n"                                                 \
+    "  --require-flags=<int> (-f <int>)\n"                             \
+    "      Only convert reads with all of the <int> FLAG bits set\n"    \
+    "  --exclude-flags=<int> (-F <int>)\n"                             \
+    "      Only convert reads with none of the <int> FLAG bits set\n"   \
+    "  --min-mapq=<int> (-q <int>)\n"                                  \
+    "      Only convert reads with a MAPQ of at least <int>\n"          \
+    "  --tag-filter=<predicate> (-G <predicate>)\n"                    \
+    "      Only convert reads whose optional tags satisfy <predicate>:\n" \
+    "      TAG or !TAG (tag present or absent), or TAG=v, TAG!=v,\n"    \
+    "      TAG<v, TAG<=v, TAG>v or TAG>=v (for example, NM<=2). Values\n" \
+    "      of standard integer tags, such as NM, must be numbers. May be\n" \
+    "      given more than once; reads must satisfy every predicate\n" \
+    "  --fragments (-R)\n"                                              \
+    "      Write one BED element per properly paired template, from the\n" \
+    "      leftmost start to the rightmost stop of its mates, with the\n" \
+    "      QNAME, the lower MAPQ and the strand of the first segment.\n" \
+    "      Other reads are skipped. Input need not be sorted by name\n" \
+    "  --fragments-max-mem=<value> (-M <value>)\n"                     \
+    "      Hold at most <value> bytes of reads awaiting their mates in\n" \
+    "      memory before spilling them to --sort-tmpdir (default 512M)\n";
 
 static const char *vcf_name = "convert2bed -i vcf";
 
@@ -1091,8 +1840,8 @@ static const char *vcf_usage =                                          \
     "  $ convert2bed -i vcf -o starch < foo.vcf > sorted-foo.vcf.starch\n" \
     "\n"                                                                \
     "  We make no assumptions about sort order from converted output. Apply\n" \
-    "  the usage case displayed to pass data to the BEDOPS sort-bed application,\n" \
-    "  which generates lexicographically-sorted BED data as output.\n"  \
+    "  the usage case displayed to sort converted data, which generates\n" \
+    "  lexicographically-sorted BED data as output.\n"                 \
     "\n"                                                                \
     "  If you want to skip sorting, use the --do-not-sort option:\n"    \
     "\n"                                                                \
@@ -1162,8 +1911,8 @@ static const char *wig_usage =                                          \
     "  $ convert2bed -i wig -o starch < foo.wig > sorted-foo.wig.starch\n" \
     "\n"                                                                \
     "  We make no assumptions about sort order from converted output. Apply\n" \
-    "  the usage case displayed to pass data to the BEDOPS sort-bed application,\n" \
-    "  which generates lexicographically-sorted BED data as output.\n"  \
+    "  the usage case displayed to sort converted data, which generates\n" \
+    "  lexicographically-sorted BED data as output.\n"                 \
     "\n"                                                                \
     "  If you want to skip sorting, use the --do-not-sort option:\n"    \
     "\n"                                                                \
@@ -1175,8 +1924,8 @@ static const char *wig_description =                                    \
     "  We convert either variety to 0-based, half-open [a-1, b) indexing when creating\n" \
     "  BED output.\n"                                                   \
     "\n"                                                                \
-    "  By default, data are passed internally to BEDOPS sort-bed to provide sorted\n" \
-    "  output ready for use with other BEDOPS utilities.\n";
+    "  By default, data are sorted internally to provide sorted output ready for\n" \
+    "  use with other BEDOPS utilities.\n";
 
 static const char *wig_options =                                        \
     "  WIG conversion options:\n\n"                                     \
@@ -1195,30 +1944,10 @@ static const char *format_undefined_usage =                             \
     "  Note: Please specify format to get detailed usage parameters:\n\n" \
     "  --help[-bam|-gff|-gtf|-gvf|-psl|-rmsk|-sam|-vcf|-wig] (-h <fmt>)\n";
 
-typedef struct gff_state {
-    char *id;
-} c2b_gff_state_t;
-
-typedef struct gtf_state {
-    char *id;
-} c2b_gtf_state_t;
-
 typedef struct psl_state {
     boolean is_headered;
-    c2b_psl_block_t *block;
 } c2b_psl_state_t;
 
-typedef struct rmsk_state {
-    uint64_t line;
-    boolean is_start_of_line;
-    boolean is_start_of_gap;
-} c2b_rmsk_state_t;
-
-typedef struct sam_state {
-    char *samtools_path;
-    c2b_cigar_t *cigar;
-} c2b_sam_state_t;
-
 typedef struct vcf_state {
     boolean do_not_split;
     boolean only_snvs;
@@ -1228,71 +1957,259 @@ typedef struct vcf_state {
 } c2b_vcf_state_t;
 
 typedef struct wig_state {
-    uint32_t section;
-    uint32_t line;
-    uint32_t pos_lines;
-    uint64_t span;
-    uint64_t step;
-    uint64_t start_pos;
-    uint64_t end_pos;
-    double score;
-    char *chr;
-    char *id;
-    boolean is_fixed_step;
-    boolean start_write;
     char *basename;
     int start_shift;
     int end_shift;
 } c2b_wig_state_t;
 
-typedef struct cat_params {
-    char *path;
-} c2b_cat_params_t;
-
 typedef struct sort_params {
     boolean is_enabled;
-    char *sort_bed_path;
-    char *max_mem_value;
+    uint64_t max_mem;
     char *sort_tmpdir_path;
 } c2b_sort_params_t;
 
-typedef struct starch_params {
+/*
+   Line buffers start at C2B_MAX_LINE_LENGTH_VALUE bytes. When one fills
+   without a newline, it is doubled, up to max_line_length bytes; past that,
+   the line is rejected. Buffers keep their size once grown, so that later long
+   lines do not pay for growth again. Growth only happens on the thread that
+   reads input, so the counters below need no lock.
+*/
+
+typedef struct line_params {
+    uint64_t max_line_length;
+    size_t num_growths;
+    ssize_t largest_buffer_size;
+    ssize_t buffer_bytes;
+    ssize_t peak_buffer_bytes;
+} c2b_line_params_t;
+
+/*
+   Internal pipes are sized to size bytes with F_SETPIPE_SZ, where it is
+   available; if --pipe-size is given, a standard input or output that is a
+   pipe is sized to match. With --stats, the time each stage spends in
+   read() and write() calls on its input and output -- that is, blocked on
+   the stage on the other end of a pipe -- is totalled and reported, so that
+   the slowest stage of a pipeline can be found. Each counter is only
+   updated by one thread. Sorted or Starch output is written to standard
+   output by the sort stage, and is counted in sort_stats.
+*/
+
+typedef struct io_stats {
+    uint64_t bytes_read;
+    uint64_t bytes_written;
+    double read_seconds;
+    double write_seconds;
+} c2b_io_stats_t;
+
+typedef struct pipe_params {
+    uint64_t size;
+    boolean is_size_set;
+    boolean is_timed;
+    c2b_io_stats_t convert_stats;
+    c2b_io_stats_t sort_stats;
+    c2b_io_stats_t stdout_stats;
+} c2b_pipe_params_t;
+
+/*
+   With --stats, a summary of the run is written as a JSON object to standard
+   error, or to the given file, once conversion is done. Each stage records
+   its wall time and CPU time: the stdout stage is one thread, timed on its
+   own, while the convert and sort stages take the CPU time of the whole
+   process over their span, so that their worker threads are included (less
+   the stdout thread, which runs alongside conversion). Record counts and 
+   output counters are updated under lock.
+
+   The report also has a section for each of the sorter, line buffers and
+   pipes: the sorter's memory limit and peak, the time taken to write out
+   (and merge) sorted records, and the records, bytes and timing of each 
+   run it spilled; line buffer growth; and the bytes each 
+   stage moved through pipes, with the time it spent blocked on them. The
+   sorter is deleted before the report is written, so its figures are kept
+   here once sorted records are written out.
+*/
+
+typedef struct stage_times {
+    double wall_seconds;
+    double cpu_seconds;
+} c2b_stage_times_t;
+
+typedef struct stats_params {
+    boolean is_enabled;
     char *path;
+    double start_seconds;
+    pthread_mutex_t lock;
+    c2b_record_counts_t counts;
+    uint64_t lines_out;
+    uint64_t bytes_out;
+    uint64_t sorted_records;
+    c2b_sort_run_t *sort_runs;
+    size_t num_sort_runs;
+    off_t sort_run_file_size;
+    uint64_t sort_max_memory;
+    uint64_t sort_peak_memory;
+    double sort_write_seconds;
+    c2b_stage_times_t convert;
+    c2b_stage_times_t sort;
+    c2b_stage_times_t output;
+} c2b_stats_params_t;
+
+typedef struct bam_params {
+    char *index_path;
+    char *regions;
+} c2b_bam_params_t;
+
+/*
+   With --columns, BAM and SAM records are written as the six BED columns
+   followed by the listed SAM fields and optional tags alone, in the order
+   given. The list is parsed once, into columns. Fields that no column needs
+   are neither split out of SAM lines (max_field_idx bounds the tokenizer) 
+   nor decoded from BAM records. A tag column holds the value of the tag, or
+   "." where the record does not carry it, as does an opt column for a record
+   without optional fields. --split-bed6 is the empty list.
+*/
+
+#define C2B_MAX_SAM_COLUMNS_VALUE 64
+
+typedef enum sam_column_type {
+    C2B_SAM_FLAG_COLUMN,
+    C2B_SAM_CIGAR_COLUMN,
+    C2B_SAM_RNEXT_COLUMN,
+    C2B_SAM_PNEXT_COLUMN,
+    C2B_SAM_TLEN_COLUMN,
+    C2B_SAM_SEQ_COLUMN,
+    C2B_SAM_QUAL_COLUMN,
+    C2B_SAM_OPT_COLUMN,
+    C2B_SAM_TAG_COLUMN
+} c2b_sam_column_type_t;
+
+typedef struct sam_column {
+    c2b_sam_column_type_t type;
+    char tag[2];
+} c2b_sam_column_t;
+
+typedef struct columns_params {
+    boolean is_enabled;
+    c2b_sam_column_t columns[C2B_MAX_SAM_COLUMNS_VALUE];
+    int num_columns;
+    int max_field_idx;
+    boolean needs_cigar;
+    boolean needs_seq;
+    boolean needs_qual;
+    boolean needs_opt;
+} c2b_columns_params_t;
+
+typedef struct starch_params {
     boolean bzip2;
     boolean gzip;
     char *note;
+    unsigned int threads;
 } c2b_starch_params_t;
 
+/*
+   BAM and SAM reads are filtered as they are parsed. FLAG and MAPQ are 
+   taken first -- from the leading fields of a SAM line, or the fixed-length
+   core of a BAM record -- and a read that is unmapped (without --all-reads),
+   or that fails --require-flags, --exclude-flags or --min-mapq, is dropped
+   before any other field is found or decoded. Tag predicates are tested
+   once the optional fields are found; a read without the tag fails every
+   predicate but "!TAG". Values are compared as numbers where both parse as
+   numbers, and as strings otherwise. Standard tags that the SAM tags 
+   specification types as integers are only ever compared with numbers.
+*/
+
+#define C2B_MAX_TAG_FILTERS_VALUE 16
+
+extern const char *c2b_sam_integer_tags;
+const char *c2b_sam_integer_tags = "AM AS CM CP FI H0 H1 H2 HI IH MQ NH NM OP PQ SM TC UQ";
+
+typedef enum tag_filter_op {
+    C2B_TAG_PRESENT,
+    C2B_TAG_ABSENT,
+    C2B_TAG_EQ,
+    C2B_TAG_NE,
+    C2B_TAG_LT,
+    C2B_TAG_LE,
+    C2B_TAG_GT,
+    C2B_TAG_GE
+} c2b_tag_filter_op_t;
+
+typedef struct tag_filter {
+    char tag[2];
+    c2b_tag_filter_op_t op;
+    char *value;
+    ssize_t value_length;
+    boolean is_numeric;
+    double number;
+} c2b_tag_filter_t;
+
+typedef struct filter_params {
+    boolean is_enabled;
+    int required_flags;
+    int excluded_flags;
+    unsigned int min_mapq;
+    c2b_tag_filter_t tag_filters[C2B_MAX_TAG_FILTERS_VALUE];
+    int num_tag_filters;
+} c2b_filter_params_t;
+
+typedef struct fragments_params {
+    boolean is_enabled;
+    uint64_t max_mem;
+} c2b_fragments_params_t;
+
+typedef struct coverage_params {
+    boolean is_enabled;
+    boolean is_bedgraph;
+    void (*line_functor)(c2b_context_t *, c2b_output_t *, char *, ssize_t);
+} c2b_coverage_params_t;
+
 static struct globals {
     c2b_format_t help_format_idx;
     char *input_format;
     c2b_format_t input_format_idx;
     char *output_format;
     c2b_format_t output_format_idx;
-    unsigned int header_line_idx;
     boolean all_reads_flag;
     boolean keep_header_flag;
     boolean split_flag;
+    boolean split_bed6_flag;
     boolean zero_indexed_flag;
-    c2b_gff_state_t *gff;
-    c2b_gtf_state_t *gtf;
+    unsigned int threads;
     c2b_psl_state_t *psl;
-    c2b_rmsk_state_t *rmsk;
-    c2b_sam_state_t *sam;
     c2b_vcf_state_t *vcf;
     c2b_wig_state_t *wig;
-    c2b_cat_params_t *cat;
+    c2b_bam_params_t *bam;
+    c2b_columns_params_t *columns;
+    c2b_filter_params_t *filter;
+    c2b_fragments_params_t *fragments;
+    c2b_coverage_params_t *coverage;
     c2b_sort_params_t *sort;
+    c2b_line_params_t *line;
+    c2b_pipe_params_t *pipe;
+    c2b_stats_params_t *stats;
     c2b_starch_params_t *starch;
+    c2b_delim_kernel_t delim_kernel;
+    const char *delim_kernel_name;
 } c2b_globals;
 
 static struct option c2b_client_long_options[] = {
     { "input",          required_argument,   NULL,    'i' },
     { "output",         required_argument,   NULL,    'o' },
     { "do-not-sort",    no_argument,         NULL,    'd' },
+    { "coverage",       optional_argument,   NULL,    'V' },
     { "all-reads",      no_argument,         NULL,    'a' },
     { "keep-header",    no_argument,         NULL,    'k' },
     { "split",          no_argument,         NULL,    's' },
+    { "split-bed6",     no_argument,         NULL,    'B' },
+    { "columns",        required_argument,   NULL,    'C' },
+    { "require-flags",  required_argument,   NULL,    'f' },
+    { "exclude-flags",  required_argument,   NULL,    'F' },
+    { "min-mapq",       required_argument,   NULL,    'q' },
+    { "tag-filter",     required_argument,   NULL,    'G' },
+    { "fragments",      no_argument,         NULL,    'R' },
+    { "fragments-max-mem", required_argument, NULL,   'M' },
+    { "bai",            required_argument,   NULL,    'j' },
+    { "regions",        required_argument,   NULL,    'l' },
     { "do-not-split",   no_argument,         NULL,    'p' },
     { "snvs",           no_argument,         NULL,    'v' },
     { "insertions",     no_argument,         NULL,    't' },
@@ -1300,10 +2217,18 @@ static struct option c2b_client_long_options[] = {
     { "starch-bzip2",   no_argument,         NULL,    'z' },
     { "starch-gzip",    no_argument,         NULL,    'g' },
     { "starch-note",    required_argument,   NULL,    'e' },
+    { "starch-threads", required_argument,   NULL,    'c' },
     { "max-mem",        required_argument,   NULL,    'm' },
     { "sort-tmpdir",    required_argument,   NULL,    'r' },
+    { "sort-stats",     no_argument,         NULL,    'y' },
+    { "max-line-length", required_argument,  NULL,    'L' },
+    { "line-stats",     no_argument,         NULL,    'u' },
+    { "pipe-size",      required_argument,   NULL,    'P' },
+    { "pipe-stats",     no_argument,         NULL,    'T' },
+    { "stats",          optional_argument,   NULL,    'S' },
     { "multisplit",     required_argument,   NULL,    'b' },
     { "zero-indexed",   no_argument,         NULL,    'x' },
+    { "threads",        required_argument,   NULL,    '@' },
     { "help",           no_argument,         NULL,    'h' },
     { "version",        no_argument,         NULL,    'w' },
     { "help-bam",       no_argument,         NULL,    '1' },
@@ -1318,7 +2243,7 @@ static struct option c2b_client_long_options[] = {
     { NULL,             no_argument,         NULL,     0  }
 };
 
-static const char *c2b_client_opt_string = "i:o:dakspvtnzge:m:r:b:xhw12345678?";
+static const char *c2b_client_opt_string = "i:o:dV::aksBC:f:F:q:G:RM:j:l:pvtnzge:c:m:r:yL:uP:TS::b:x@:hw12345678?";
 
 #ifdef __cplusplus
 extern "C" {
@@ -1333,74 +2258,246 @@ extern "C" {
     static void              c2b_init_sam_conversion(c2b_pipeset_t *p);
     static void              c2b_init_vcf_conversion(c2b_pipeset_t *p);
     static void              c2b_init_wig_conversion(c2b_pipeset_t *p);
-    static void              c2b_init_generic_conversion(c2b_pipeset_t *p, void(*to_bed_line_functor)(char *, ssize_t *, char *, ssize_t));
+    static void              c2b_init_generic_conversion(c2b_pipeset_t *p, void(*to_bed_line_functor)(c2b_context_t *, c2b_output_t *, char *, ssize_t));
     static void              c2b_init_bam_conversion(c2b_pipeset_t *p);
-    static inline void       c2b_cmd_cat_stdin(char *cmd);
-    static inline void       c2b_cmd_bam_to_sam(char *cmd);
-    static inline void       c2b_cmd_sort_bed(char *cmd);
-    static inline void       c2b_cmd_starch_bed(char *cmd);
-    static void              c2b_line_convert_gff_to_bed_unsorted(char *dest, ssize_t *dest_size, char *src, ssize_t src_size);
-    static inline void       c2b_line_convert_gff_to_bed(c2b_gff_t g, char *dest_line, ssize_t *dest_size);
-    static void              c2b_line_convert_gtf_to_bed_unsorted(char *dest, ssize_t *dest_size, char *src, ssize_t src_size);
-    static inline void       c2b_line_convert_gtf_to_bed(c2b_gtf_t g, char *dest_line, ssize_t *dest_size);
-    static void              c2b_line_convert_psl_to_bed_unsorted(char *dest, ssize_t *dest_size, char *src, ssize_t src_size);
-    static inline void       c2b_psl_blockSizes_to_ptr(char *s, uint64_t bc);
-    static inline void       c2b_psl_tStarts_to_ptr(char *s, uint64_t bc);
-    static inline void       c2b_line_convert_psl_to_bed(c2b_psl_t p, char *dest_line, ssize_t *dest_size);
-    static void              c2b_line_convert_rmsk_to_bed_unsorted(char *dest, ssize_t *dest_size, char *src, ssize_t src_size);
-    static inline void       c2b_line_convert_rmsk_to_bed(c2b_rmsk_t r, char *dest_line, ssize_t *dest_size);
-    static void              c2b_line_convert_sam_to_bed_unsorted_without_split_operation(char *dest, ssize_t *dest_size, char *src, ssize_t src_size);
-    static void              c2b_line_convert_sam_to_bed_unsorted_with_split_operation(char *dest, ssize_t *dest_size, char *src, ssize_t src_size); 
-    static inline void       c2b_sam_cigar_str_to_ops(char *s);
-    static void              c2b_sam_init_cigar_ops(c2b_cigar_t **c, const ssize_t size);
+    static void              c2b_line_convert_gff_to_bed_unsorted(c2b_context_t *ctx, c2b_output_t *dest, char *src, ssize_t src_size);
+    static inline void       c2b_line_convert_gff_to_bed(c2b_gff_t g, c2b_output_t *dest);
+    static void              c2b_line_convert_gtf_to_bed_unsorted(c2b_context_t *ctx, c2b_output_t *dest, char *src, ssize_t src_size);
+    static inline void       c2b_line_convert_gtf_to_bed(c2b_gtf_t g, c2b_output_t *dest);
+    static void              c2b_line_convert_psl_to_bed_unsorted(c2b_context_t *ctx, c2b_output_t *dest, char *src, ssize_t src_size);
+    static inline void       c2b_psl_blockSizes_to_ptr(c2b_span_t s, uint64_t bc, uint64_t *sizes);
+    static inline void       c2b_psl_tStarts_to_ptr(c2b_span_t s, uint64_t bc, uint64_t *starts);
+    static inline void       c2b_line_convert_psl_to_bed(c2b_psl_t p, c2b_output_t *dest);
+    static void              c2b_line_convert_rmsk_to_bed_unsorted(c2b_context_t *ctx, c2b_output_t *dest, char *src, ssize_t src_size);
+    static inline void       c2b_line_convert_rmsk_to_bed(c2b_rmsk_t r, c2b_output_t *dest);
+    static void              c2b_line_convert_sam_to_bed_unsorted_without_split_operation(c2b_context_t *ctx, c2b_output_t *dest, char *src, ssize_t src_size);
+    static void              c2b_line_convert_sam_to_bed_unsorted_with_split_operation(c2b_context_t *ctx, c2b_output_t *dest, char *src, ssize_t src_size); 
+    static inline void       c2b_line_convert_sam_split_ops_to_bed(c2b_sam_t sam, c2b_cigar_t *cigar, uint64_t stop_val, c2b_output_t *dest);
+    static inline void       c2b_line_convert_sam_block_to_bed(c2b_sam_t *s, size_t block_idx, ssize_t *tail_length, ssize_t *tail_offset, c2b_output_t *dest);
+    static void              c2b_init_cigar_op_classes();
+    static inline void       c2b_init_cigar(c2b_cigar_t *c);
+    static inline void       c2b_delete_cigar(c2b_cigar_t *c);
+    static void              c2b_grow_cigar(c2b_cigar_t *c, ssize_t min_size);
+    static inline uint64_t   c2b_sam_cigar_str_to_bases(c2b_span_t s);
+    static inline void       c2b_sam_cigar_str_to_ops(c2b_span_t s, c2b_cigar_t *c);
     static void              c2b_sam_debug_cigar_ops(c2b_cigar_t *c);
-    static void              c2b_sam_delete_cigar_ops(c2b_cigar_t *c);
-    static inline void       c2b_line_convert_sam_to_bed(c2b_sam_t s, char *dest_line, ssize_t *dest_size);
-    static void              c2b_line_convert_vcf_to_bed_unsorted(char *dest, ssize_t *dest_size, char *src, ssize_t src_size);
-    static inline boolean    c2b_vcf_allele_is_id(char *s);
-    static inline boolean    c2b_vcf_record_is_snv(char *ref, char *alt);
-    static inline boolean    c2b_vcf_record_is_insertion(char *ref, char *alt);
-    static inline boolean    c2b_vcf_record_is_deletion(char *ref, char *alt);
-    static inline void       c2b_line_convert_vcf_to_bed(c2b_vcf_t v, char *dest_line, ssize_t *dest_size);
-    static void              c2b_line_convert_wig_to_bed_unsorted(char *dest, ssize_t *dest_size, char *src, ssize_t src_size);
-    static void *            c2b_read_bytes_from_stdin(void *arg);
+    static inline void       c2b_line_convert_sam_to_bed(c2b_sam_t s, c2b_output_t *dest);
+    static inline ssize_t    c2b_sam_bed_tail_length(c2b_sam_t *s);
+    static inline char *     c2b_emit_sam_bed_tail(char *dest_posn, c2b_sam_t *s);
+    static inline void       c2b_sam_fields_to_sam(c2b_span_t *fields, int field_idx, c2b_sam_t *s);
+    static inline c2b_span_t c2b_sam_find_tag(c2b_span_t opt, const char *tag);
+    static inline int        c2b_sam_split_fields(c2b_context_t *ctx, char *src, ssize_t src_size, c2b_span_t *fields, int *flag_val);
+    static inline boolean    c2b_read_is_dropped(c2b_context_t *ctx, int flag_val, unsigned int mapq_val);
+    static inline boolean    c2b_read_tags_are_dropped(c2b_context_t *ctx, c2b_span_t opt);
+    static inline boolean    c2b_tag_filter_matches(const c2b_tag_filter_t *f, c2b_span_t value);
+    static inline boolean    c2b_span_to_double(c2b_span_t f, double *val);
+    static inline boolean    c2b_bam_record_is_dropped(c2b_context_t *ctx, char *src, ssize_t src_size);
+    static void              c2b_line_convert_bam_to_bed_unsorted_without_split_operation(c2b_context_t *ctx, c2b_output_t *dest, char *src, ssize_t src_size);
+    static void              c2b_line_convert_bam_to_bed_unsorted_with_split_operation(c2b_context_t *ctx, c2b_output_t *dest, char *src, ssize_t src_size);
+    static void              c2b_line_convert_sam_to_bed_fragments(c2b_context_t *ctx, c2b_output_t *dest, char *src, ssize_t src_size);
+    static void              c2b_line_convert_bam_to_bed_fragments(c2b_context_t *ctx, c2b_output_t *dest, char *src, ssize_t src_size);
+    static inline boolean    c2b_read_is_fragment_mate(int flag_val, boolean is_mate_on_same_ref, boolean has_tlen);
+    static void              c2b_add_fragment_mate(c2b_context_t *ctx, c2b_output_t *dest, c2b_span_t rname, c2b_span_t qname, c2b_fragment_mate_t *m);
+    static c2b_fragment_state_t * c2b_new_fragment_state();
+    static void              c2b_delete_fragment_state(c2b_fragment_state_t *f);
+    static uint32_t          c2b_fragment_chrom_id(c2b_fragment_state_t *f, char *name, size_t length);
+    static void              c2b_init_fragment_table(c2b_fragment_table_t *t, unsigned int depth);
+    static void              c2b_delete_fragment_table(c2b_fragment_table_t *t);
+    static void              c2b_pair_fragment_mate(c2b_fragment_state_t *f, c2b_fragment_table_t *t, const c2b_fragment_mate_t *m, c2b_output_t *dest);
+    static void              c2b_remove_fragment_mate(c2b_fragment_table_t *t, size_t idx);
+    static void              c2b_grow_fragment_table(c2b_fragment_table_t *t, size_t capacity);
+    static void              c2b_spill_fragment_table(c2b_fragment_table_t *t);
+    static void              c2b_write_fragment_partition(c2b_fragment_table_t *t, int partition_idx, char *buffer, size_t size);
+    static void              c2b_pair_fragment_partition(c2b_context_t *ctx, int fd, unsigned int depth, c2b_output_t *dest);
+    static void              c2b_finish_fragment_table(c2b_context_t *ctx, c2b_fragment_table_t *t, c2b_output_t *dest);
+    static void              c2b_finish_fragments(c2b_context_t *ctx, c2b_output_t *dest);
+    static inline void       c2b_emit_fragment(c2b_fragment_state_t *f, const c2b_fragment_mate_t *a, const c2b_fragment_mate_t *b, c2b_output_t *dest);
+    static void              c2b_line_convert_to_coverage(c2b_context_t *ctx, c2b_output_t *dest, char *src, ssize_t src_size);
+    static c2b_coverage_state_t * c2b_new_coverage_state();
+    static void              c2b_delete_coverage_state(c2b_coverage_state_t *c);
+    static void              c2b_add_coverage_element(c2b_coverage_state_t *c, c2b_output_t *dest, char *chrom, size_t chrom_length, uint64_t start, uint64_t stop, uint64_t watermark);
+    static void              c2b_begin_coverage_chrom(c2b_coverage_state_t *c, c2b_output_t *dest, char *chrom, size_t chrom_length);
+    static void              c2b_push_coverage_event(c2b_coverage_state_t *c, uint64_t event);
+    static uint64_t          c2b_pop_coverage_event(c2b_coverage_state_t *c);
+    static void              c2b_sweep_coverage_events(c2b_coverage_state_t *c, c2b_output_t *dest, uint64_t limit);
+    static inline void       c2b_emit_coverage_run(c2b_coverage_state_t *c, c2b_output_t *dest, uint64_t stop);
+    static void              c2b_finish_coverage(c2b_context_t *ctx, c2b_output_t *dest);
+    static inline void       c2b_init_bam_record(c2b_bam_record_t *r);
+    static inline void       c2b_delete_bam_record(c2b_bam_record_t *r);
+    static char *            c2b_reserve_bam_field(c2b_bam_field_t *f, size_t length);
+    static void              c2b_bam_record_to_sam(c2b_context_t *ctx, char *src, ssize_t src_size, c2b_bam_record_t *r, c2b_sam_t *sam, c2b_cigar_t *cigar);
+    static void              c2b_bam_tags_to_str(const unsigned char *tags, const unsigned char *tags_end, c2b_bam_field_t *dest);
+    static inline uint16_t   c2b_bam_le16(const unsigned char *p);
+    static inline uint32_t   c2b_bam_le32(const unsigned char *p);
+    static void              c2b_field_overflow(const char *name);
+    static void              c2b_line_convert_vcf_to_bed_unsorted(c2b_context_t *ctx, c2b_output_t *dest, char *src, ssize_t src_size);
+    static inline boolean    c2b_vcf_allele_is_id(c2b_span_t s);
+    static inline boolean    c2b_vcf_record_is_snv(c2b_span_t ref, c2b_span_t alt);
+    static inline boolean    c2b_vcf_record_is_insertion(c2b_span_t ref, c2b_span_t alt);
+    static inline boolean    c2b_vcf_record_is_deletion(c2b_span_t ref, c2b_span_t alt);
+    static inline void       c2b_line_convert_vcf_to_bed(c2b_vcf_t v, c2b_output_t *dest);
+    static void              c2b_line_convert_wig_to_bed_unsorted(c2b_context_t *ctx, c2b_output_t *dest, char *src, ssize_t src_size);
     static void *            c2b_process_intermediate_bytes_by_lines(void *arg);
-    static void *            c2b_write_in_bytes_to_in_process(void *arg);
-    static void *            c2b_write_out_bytes_to_in_process(void *arg);
+    static boolean           c2b_process_mapped_bytes_by_lines(c2b_pipeline_stage_t *stage, int src_fd, c2b_output_t *dest, c2b_context_t *ctx);
+    static inline void       c2b_write_converted_bytes(int dest_fd, c2b_sorter_t *sorter, char *buffer, ssize_t size);
+    static boolean           c2b_map_input(int fd, char **map, size_t *map_size, char **start);
+    static void              c2b_init_context(c2b_context_t *ctx);
+    static void              c2b_process_bam_records(c2b_pipeline_stage_t *stage, int src_fd, c2b_output_t *dest, c2b_context_t *ctx);
+    static boolean           c2b_read_bam_record(c2b_bgzf_t *b, char **record, size_t *record_capacity, size_t *record_length);
+    static void              c2b_read_bam_header(c2b_bgzf_t *b, c2b_context_t *ctx, c2b_output_t *dest);
+    static void              c2b_process_bam_regions(c2b_pipeline_stage_t *stage, int src_fd, c2b_context_t *ctx, uint64_t header_end, int dest_fd, c2b_sorter_t *sorter);
+    static void              c2b_init_bam_regions(c2b_bam_region_queue_t *q, c2b_context_t *ctx, uint64_t header_end);
+    static void              c2b_delete_bam_regions(c2b_bam_region_queue_t *q);
+    static void *            c2b_convert_bam_regions(void *arg);
+    static void              c2b_append_bam_region_bytes(c2b_bam_region_queue_t *q, c2b_bam_region_t *region, char *src, size_t src_size);
+    static void              c2b_seek_bgzf(c2b_bgzf_t *b, uint64_t voffset);
+    static boolean           c2b_tell_bgzf(c2b_bgzf_t *b, uint64_t *voffset);
+    static void              c2b_init_bgzf(c2b_bgzf_t *b, int fd);
+    static void              c2b_delete_bgzf(c2b_bgzf_t *b);
+    static boolean           c2b_fill_bgzf_source(c2b_bgzf_t *b, size_t size);
+    static void              c2b_check_bgzf_eof_marker(int fd);
+    static void              c2b_warn_bgzf_eof_marker();
+    static boolean           c2b_scan_bgzf_block(c2b_bgzf_t *b, unsigned char **data, size_t *data_size, uint32_t *crc, uint32_t *isize);
+    static void              c2b_inflate_bgzf_data(z_stream *z, const unsigned char *data, size_t data_size, uint32_t crc, uint32_t isize, unsigned char *block);
+    static boolean           c2b_inflate_bgzf_block(c2b_bgzf_t *b);
+    static void              c2b_init_bgzf_ring(c2b_bgzf_t *b, unsigned int num_workers);
+    static void              c2b_delete_bgzf_ring(c2b_bgzf_t *b);
+    static void *            c2b_scan_bgzf_blocks(void *arg);
+    static void *            c2b_inflate_bgzf_blocks(void *arg);
+    static boolean           c2b_read_bgzf_ring_block(c2b_bgzf_t *b);
+    static boolean           c2b_read_bgzf(c2b_bgzf_t *b, void *dest, size_t size);
+    static void              c2b_advance_context(c2b_context_t *ctx, void (*line_functor)(c2b_context_t *, c2b_output_t *, char *, ssize_t), c2b_output_t *scratch, char *src, ssize_t src_size);
+    static void              c2b_advance_context_over_headers(c2b_context_t *ctx, void (*line_functor)(c2b_context_t *, c2b_output_t *, char *, ssize_t), c2b_output_t *scratch, char *src, ssize_t src_size, const char prefix);
+    static void              c2b_advance_gtf_context(c2b_context_t *ctx, void (*line_functor)(c2b_context_t *, c2b_output_t *, char *, ssize_t), c2b_output_t *scratch, char *src, ssize_t src_size);
+    static void              c2b_advance_psl_context(c2b_context_t *ctx, void (*line_functor)(c2b_context_t *, c2b_output_t *, char *, ssize_t), c2b_output_t *scratch, char *src, ssize_t src_size);
+    static void              c2b_advance_rmsk_context(c2b_context_t *ctx, void (*line_functor)(c2b_context_t *, c2b_output_t *, char *, ssize_t), c2b_output_t *scratch, char *src, ssize_t src_size);
+    static void              c2b_advance_wig_context(c2b_context_t *ctx, void (*line_functor)(c2b_context_t *, c2b_output_t *, char *, ssize_t), c2b_output_t *scratch, char *src, ssize_t src_size);
+    static void              c2b_process_intermediate_bytes_by_chunks(c2b_pipeline_stage_t *stage, int src_fd, int dest_fd, c2b_sorter_t *sorter);
+    static void              c2b_init_chunk_queue(c2b_chunk_queue_t *q, c2b_pipeline_stage_t *stage, const size_t num);
+    static void              c2b_delete_chunk_queue(c2b_chunk_queue_t *q);
+    static void *            c2b_convert_chunks(void *arg);
+    static void *            c2b_write_chunks(void *arg);
+    static void              c2b_init_sorter(c2b_sorter_t *s);
+    static void              c2b_delete_sorter(c2b_sorter_t *s);
+    static void              c2b_add_sort_block(c2b_sorter_t *s, size_t size);
+    static void              c2b_add_sort_records(c2b_sorter_t *s, char *src, ssize_t src_size);
+    static inline char *     c2b_parse_sort_coordinate(char *s, char *end, uint64_t *val);
+    static uint32_t          c2b_sort_chrom_id(c2b_sorter_t *s, char *name, size_t length);
+    static int               c2b_compare_sort_chroms(const void *a, const void *b);
+    static inline int        c2b_compare_sort_records(const c2b_sort_record_t *a, const c2b_sort_record_t *b);
+    static void              c2b_merge_sort_records(c2b_sort_record_t *records, c2b_sort_record_t *buffer, size_t num);
+    static void              c2b_merge_sort_runs(c2b_sort_record_t *records, c2b_sort_record_t *buffer, size_t start, size_t middle, size_t end);
+    static void *            c2b_sort_slice(void *arg);
+    static void *            c2b_merge_slices(void *arg);
+    static void              c2b_rank_sort_chroms(c2b_sorter_t *s);
+    static void              c2b_sort_records(c2b_sorter_t *s);
+    static void              c2b_write_sorted_records(c2b_sorter_t *s, int dest_fd);
+    static void              c2b_keep_sort_stats(c2b_sorter_t *s, double write_seconds);
+    static inline double     c2b_seconds();
+    static void              c2b_write_sort_bytes(int fd, char *buffer, size_t size);
+    static void              c2b_open_sort_run_file(c2b_sorter_t *s);
+    static int               c2b_open_tmp_file(const char *description);
+    static void              c2b_spill_sort_records(c2b_sorter_t *s);
+    static boolean           c2b_fill_sort_source(c2b_sorter_t *s, c2b_sort_source_t *src, size_t size);
+    static void              c2b_next_sort_source_record(c2b_sorter_t *s, c2b_sort_source_t *src);
+    static inline boolean    c2b_sort_source_precedes(c2b_sort_source_t *sources, size_t num_sources, size_t a, size_t b);
+    static void              c2b_adjust_sort_loser_tree(c2b_sort_source_t *sources, size_t *tree, size_t num_sources, size_t idx);
+    static void              c2b_merge_sorted_runs(c2b_sorter_t *s, int dest_fd);
+    static uint64_t          c2b_parse_max_mem(const char *value);
+    static void              c2b_init_starch_writer(c2b_starch_writer_t *w, int dest_fd);
+    static uint64_t          c2b_starch_stream_memory(size_t max_queued_chunks);
+    static void              c2b_delete_starch_writer(c2b_starch_writer_t *w);
+    static void              c2b_add_starch_record(c2b_starch_writer_t *w, c2b_sort_chrom_t *chrom, uint64_t start, uint64_t stop, char *rest, uint32_t rest_length);
+    static void              c2b_begin_starch_stream(c2b_starch_writer_t *w, c2b_sort_chrom_t *chrom);
+    static void              c2b_queue_starch_chunk(c2b_starch_writer_t *w);
+    static void              c2b_end_starch_stream(c2b_starch_writer_t *w);
+    static void              c2b_write_starch_streams(c2b_starch_writer_t *w, size_t max_pending);
+    static void *            c2b_compress_starch_stream(void *arg);
+    static void              c2b_emit_starch_compressed(c2b_starch_stream_t *stream, char *src, size_t size);
+    static void              c2b_spill_starch_stream(c2b_starch_stream_t *stream, char *src, size_t size);
+    static void              c2b_release_starch_held(c2b_starch_stream_t *stream);
+    static void              c2b_promote_starch_stream(c2b_starch_stream_t *stream);
+    static void              c2b_finish_starch_writer(c2b_starch_writer_t *w);
+    static void              c2b_print_json_string(FILE *stream, const char *s);
+    static inline uint32_t   c2b_sha1_rotate(uint32_t x, int n);
+    static void              c2b_sha1(const unsigned char *data, size_t size, unsigned char *digest);
+    static void              c2b_base64_encode(const unsigned char *data, size_t size, char *encoded);
     static void *            c2b_write_in_bytes_to_stdout(void *arg);
-    static void *            c2b_write_out_bytes_to_stdout(void *arg);
+    static boolean           c2b_splice_bytes(c2b_io_stats_t *stats, int src_fd, int dest_fd);
+    static void              c2b_copy_bytes(c2b_io_stats_t *stats, int src_fd, int dest_fd);
+    static void              c2b_set_pipe_size(int fd);
+    static inline ssize_t    c2b_timed_read(c2b_io_stats_t *stats, int fd, void *buf, size_t count);
+    static inline ssize_t    c2b_timed_write(c2b_io_stats_t *stats, int fd, const void *buf, size_t count);
+    static inline double     c2b_process_cpu_seconds();
+    static inline double     c2b_thread_cpu_seconds();
+    static void              c2b_add_record_counts(const c2b_record_counts_t *counts);
+    static void              c2b_print_stats();
     static void              c2b_memrchr_offset(ssize_t *offset, char *buf, ssize_t buf_size, ssize_t len, char delim);
+    static ssize_t           c2b_grow_line_capacity(ssize_t capacity);
+    static char *            c2b_resize_line_buffer(char *buffer, ssize_t capacity, ssize_t new_capacity);
+    static void              c2b_init_delim_kernel();
+    static void              c2b_scan_delims_scalar(const char *src, size_t src_size, uint64_t *line_bits, uint64_t *tab_bits);
+#ifdef C2B_HAVE_X86_SIMD
+    static void              c2b_scan_delims_sse2(const char *src, size_t src_size, uint64_t *line_bits, uint64_t *tab_bits);
+    static void              c2b_scan_delims_avx2(const char *src, size_t src_size, uint64_t *line_bits, uint64_t *tab_bits);
+#endif
+    static void              c2b_init_delim_index(c2b_delim_index_t *idx);
+    static void              c2b_delete_delim_index(c2b_delim_index_t *idx);
+    static void              c2b_index_delims(c2b_delim_index_t *idx, char *src, ssize_t src_size);
+    static inline ssize_t    c2b_next_delim(const uint64_t *bits, ssize_t from, ssize_t to);
+    static inline ssize_t    c2b_last_delim(const uint64_t *bits, ssize_t to);
     static void              c2b_init_pipeset(c2b_pipeset_t *p, const size_t num);
     static void              c2b_debug_pipeset(c2b_pipeset_t *p, const size_t num);
     static void              c2b_delete_pipeset(c2b_pipeset_t *p);
     static void              c2b_set_close_exec_flag(int fd);
-    static void              c2b_unset_close_exec_flag(int fd);
     static int               c2b_pipe4(int fd[2], int flags);
-    static pid_t             c2b_popen4(const char* cmd, int pin[2], int pout[2], int perr[2], int flags);
-    static void              c2b_test_dependencies();
-    static boolean           c2b_print_matches(char *path, char *fn);
     static char *            c2b_strsep(char **stringp, const char *delim);
-    static boolean           c2b_is_there(char *candidate);
+    static inline int        c2b_split_fields(c2b_context_t *ctx, char *src, ssize_t src_size, c2b_span_t *fields);
+    static inline int        c2b_split_leading_fields(c2b_context_t *ctx, char *src, ssize_t src_size, c2b_span_t *fields, int max_field_idx);
+    static inline uint64_t   c2b_span_to_uint64(c2b_span_t f);
+    static char *            c2b_span_find(c2b_span_t f, const char *needle);
+    static inline boolean    c2b_span_equals(c2b_span_t f, const char *s);
+    static inline c2b_span_t c2b_span_from_str(char *s);
+    static inline char *     c2b_emit_span(char *dest, c2b_span_t f, char delim);
+    static inline char *     c2b_emit_str(char *dest, const char *s, char delim);
+    static inline char *     c2b_emit_uint64(char *dest, uint64_t val, char delim);
+    static inline char *     c2b_emit_int64(char *dest, int64_t val, char delim);
+    static void              c2b_init_output(c2b_output_t *out, int fd, c2b_sorter_t *sorter);
+    static void              c2b_delete_output(c2b_output_t *out);
+    static inline char *     c2b_reserve_output(c2b_output_t *out, ssize_t length);
+    static void              c2b_flush_output(c2b_output_t *out);
+    static inline void       c2b_write_output(c2b_output_t *out, const char *src, ssize_t src_size);
+    static inline void       c2b_line_convert_header_to_bed(c2b_context_t *ctx, c2b_output_t *dest, char *src, ssize_t src_size);
     static void              c2b_init_globals();
     static void              c2b_delete_globals();
-    static void              c2b_init_global_gff_state();
-    static void              c2b_delete_global_gff_state();
-    static void              c2b_init_global_gtf_state();
-    static void              c2b_delete_global_gtf_state();
     static void              c2b_init_global_psl_state();
     static void              c2b_delete_global_psl_state();
-    static void              c2b_init_global_rmsk_state();
-    static void              c2b_delete_global_rmsk_state();
-    static void              c2b_init_global_sam_state();
-    static void              c2b_delete_global_sam_state();
     static void              c2b_init_global_vcf_state();
     static void              c2b_delete_global_vcf_state();
     static void              c2b_init_global_wig_state();
     static void              c2b_delete_global_wig_state();
-    static void              c2b_init_global_cat_params();
-    static void              c2b_delete_global_cat_params();
     static void              c2b_init_global_sort_params();
     static void              c2b_delete_global_sort_params();
+    static void              c2b_init_global_line_params();
+    static void              c2b_delete_global_line_params();
+    static void              c2b_init_global_pipe_params();
+    static void              c2b_delete_global_pipe_params();
+    static void              c2b_init_global_stats_params();
+    static void              c2b_delete_global_stats_params();
+    static void              c2b_init_global_bam_params();
+    static void              c2b_delete_global_bam_params();
+    static void              c2b_init_global_columns_params();
+    static void              c2b_delete_global_columns_params();
+    static void              c2b_parse_columns(const char *columns);
+    static void              c2b_init_global_filter_params();
+    static void              c2b_delete_global_filter_params();
+    static void              c2b_init_global_fragments_params();
+    static void              c2b_delete_global_fragments_params();
+    static void              c2b_init_global_coverage_params();
+    static void              c2b_delete_global_coverage_params();
+    static int               c2b_parse_filter_int(const char *arg, const char *name, int max_val);
+    static void              c2b_parse_tag_filter(const char *predicate);
+    static boolean           c2b_tag_is_integer(const char *tag);
     static void              c2b_init_global_starch_params();
     static void              c2b_delete_global_starch_params();
     static void              c2b_init_command_line_options(int argc, char **argv);
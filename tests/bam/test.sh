@@ -3,6 +3,7 @@
 bin_dir="/usr/local/bin"
 bam2bed_bin="${bin_dir}/bam2bed"
 bam2starch_bin="${bin_dir}/bam2starch"
+convert2bed_bin="${bin_dir}/convert2bed"
 
 echo "[bam2bed] testing sorted output..."
 sample_bam_fn="sample.bam"
@@ -36,4 +37,74 @@ ${bam2starch_bin} --starch-gzip < ${sample_bam_fn} > ${observed_starch_fn} 2> /d
 diff -q <(unstarch ${expected_starch_fn}) <(unstarch ${observed_starch_fn})
 rm -f ${observed_starch_fn}
 
+echo "[bam2bed] testing multi-threaded output..."
+threaded_bam_fn="sample.bam"
+expected_threaded_bed_fn="sample.expected.bed"
+observed_threaded_bed_fn="$(mktemp /tmp/XXXXXX)"
+${convert2bed_bin} --input=bam --threads=4 < ${threaded_bam_fn} > ${observed_threaded_bed_fn} 2> /dev/null
+diff -q ${expected_threaded_bed_fn} ${observed_threaded_bed_fn}
+rm -f ${observed_threaded_bed_fn}
+
+echo "[bam2bed] testing indexed output..."
+indexed_bam_fn="reads.bam"
+indexed_bai_fn="reads.bam.bai"
+expected_indexed_bed_fn="reads.expected.bed"
+observed_indexed_bed_fn="$(mktemp /tmp/XXXXXX)"
+${convert2bed_bin} --input=bam --bai=${indexed_bai_fn} < ${indexed_bam_fn} > ${observed_indexed_bed_fn} 2> /dev/null
+diff -q ${expected_indexed_bed_fn} ${observed_indexed_bed_fn}
+rm -f ${observed_indexed_bed_fn}
+
+echo "[bam2bed] testing multi-threaded indexed output against a full scan..."
+indexed_bam_fn="reads.bam"
+indexed_bai_fn="reads.bam.bai"
+expected_indexed_bed_fn="reads.expected.unsorted.bed"
+observed_indexed_bed_fn="$(mktemp /tmp/XXXXXX)"
+${convert2bed_bin} --input=bam --do-not-sort --bai=${indexed_bai_fn} --threads=4 < ${indexed_bam_fn} > ${observed_indexed_bed_fn} 2> /dev/null
+diff -q ${expected_indexed_bed_fn} ${observed_indexed_bed_fn}
+rm -f ${observed_indexed_bed_fn}
+
+echo "[bam2bed] testing indexed output of listed regions..."
+indexed_bam_fn="reads.bam"
+indexed_bai_fn="reads.bam.bai"
+expected_regions_bed_fn="reads.expected.regions.bed"
+observed_regions_bed_fn="$(mktemp /tmp/XXXXXX)"
+${convert2bed_bin} --input=bam --do-not-sort --bai=${indexed_bai_fn} --regions=chr10,chr1 --threads=2 < ${indexed_bam_fn} > ${observed_regions_bed_fn} 2> /dev/null
+diff -q ${expected_regions_bed_fn} ${observed_regions_bed_fn}
+rm -f ${observed_regions_bed_fn}
+
+echo "[bam2bed] testing split BED6 output..."
+split_bed6_bam_fn="reads.bam"
+expected_split_bed6_bed_fn="reads.expected.split-bed6.bed"
+observed_split_bed6_bed_fn="$(mktemp /tmp/XXXXXX)"
+${convert2bed_bin} --input=bam --split --split-bed6 < ${split_bed6_bam_fn} > ${observed_split_bed6_bed_fn} 2> /dev/null
+diff -q ${expected_split_bed6_bed_fn} ${observed_split_bed6_bed_fn}
+rm -f ${observed_split_bed6_bed_fn}
+
+echo "[bam2bed] testing fragments of proper, improper and orphaned pairs..."
+fragments_bam_fn="reads.bam"
+expected_fragments_bed_fn="reads.expected.fragments.bed"
+observed_fragments_bed_fn="$(mktemp /tmp/XXXXXX)"
+${convert2bed_bin} --input=bam --fragments < ${fragments_bam_fn} > ${observed_fragments_bed_fn} 2> /dev/null
+diff -q ${expected_fragments_bed_fn} ${observed_fragments_bed_fn}
+rm -f ${observed_fragments_bed_fn}
+
+echo "[bam2bed] testing long reads with fields over 24 KB..."
+long_bam_fn="longreads.bam"
+expected_long_bed_fn="longreads.expected.bed"
+observed_long_bed_fn="$(mktemp /tmp/XXXXXX)"
+${convert2bed_bin} --input=bam < ${long_bam_fn} > ${observed_long_bed_fn} 2> /dev/null
+diff -q ${expected_long_bed_fn} ${observed_long_bed_fn}
+rm -f ${observed_long_bed_fn}
+
+echo "[bam2bed] testing input without the BGZF end-of-file marker..."
+noeof_bam_fn="noeof.bam"
+expected_noeof_bed_fn="sample.expected.bed"
+expected_noeof_warning_fn="noeof.expected.warning.txt"
+observed_noeof_bed_fn="$(mktemp /tmp/XXXXXX)"
+observed_noeof_warning_fn="$(mktemp /tmp/XXXXXX)"
+${convert2bed_bin} --input=bam < ${noeof_bam_fn} > ${observed_noeof_bed_fn} 2> ${observed_noeof_warning_fn}
+diff -q ${expected_noeof_bed_fn} ${observed_noeof_bed_fn}
+diff -q ${expected_noeof_warning_fn} ${observed_noeof_warning_fn}
+rm -f ${observed_noeof_bed_fn} ${observed_noeof_warning_fn}
+
 echo "[bam2bed] tests complete!"
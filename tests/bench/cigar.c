@@ -0,0 +1,237 @@
+/*
+   cigar.c
+   -----------------------------------------------------------------------
+   Microbenchmark for the convert2bed CIGAR decoders. Synthetic short-read
+   and long-read CIGAR strings are decoded to operations, as with --split,
+   and to a sum of bases alone, as without it. The decoders are checked
+   against a strtoul()-based reference, and throughput (MB/s), CIGARs and
+   operations per second are reported, alongside the isdigit()/atoi()
+   decoder that convert2bed used before, for comparison.
+*/
+
+#define C2B_NO_MAIN
+#include "../../convert2bed.c"
+
+#define C2B_CIGAR_BENCH_STRINGS 256
+#define C2B_CIGAR_BENCH_TOTAL_BYTES (UINT64_C(1) << 28)
+
+typedef struct cigar_set {
+    const char *name;
+    c2b_span_t spans[C2B_CIGAR_BENCH_STRINGS];
+    size_t total_length;
+    size_t total_ops;
+} c2b_cigar_set_t;
+
+static double
+c2b_cigar_now()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double) ts.tv_sec + (double) ts.tv_nsec / 1e9;
+}
+
+static void
+c2b_cigar_fill_set(c2b_cigar_set_t *set, const char *name, boolean is_long)
+{
+    static const char *ops = "MIDNS=X";
+    unsigned int seed = 1;
+    size_t string_idx;
+    size_t num_ops;
+    size_t op_idx;
+    size_t capacity;
+    size_t length;
+    char *s;
+
+    /* short reads are one to three operations; long reads, 500 to 10000, mostly matches */
+
+    set->name = name;
+    set->total_length = 0;
+    set->total_ops = 0;
+    for (string_idx = 0; string_idx < C2B_CIGAR_BENCH_STRINGS; string_idx++) {
+        seed = seed * 1103515245 + 12345;
+        num_ops = (is_long) ? 500 + (seed >> 16) % 9500 : 1 + (seed >> 16) % 3;
+        capacity = num_ops * 8 + 1;
+        s = malloc(capacity);
+        if (!s) {
+            fprintf(stderr, "Error: Could not allocate space for CIGAR string\n");
+            exit(ENOMEM);
+        }
+        for (op_idx = 0, length = 0; op_idx < num_ops; op_idx++) {
+            seed = seed * 1103515245 + 12345;
+            if (op_idx % 2 == 0)
+                length += (size_t) sprintf(s + length, "%u%c", 1 + (seed >> 16) % ((is_long) ? 2000 : 100), 'M');
+            else
+                length += (size_t) sprintf(s + length, "%u%c", 1 + (seed >> 16) % ((is_long) ? 20 : 5000), ops[1 + (seed >> 8) % 6]);
+        }
+        set->spans[string_idx].s = s;
+        set->spans[string_idx].length = length;
+        set->total_length += length;
+        set->total_ops += num_ops;
+    }
+}
+
+static void
+c2b_cigar_delete_set(c2b_cigar_set_t *set)
+{
+    size_t string_idx;
+
+    for (string_idx = 0; string_idx < C2B_CIGAR_BENCH_STRINGS; string_idx++) {
+        free(set->spans[string_idx].s);
+    }
+}
+
+static inline void
+c2b_cigar_legacy_str_to_ops(c2b_span_t s, c2b_cigar_op_t *ops, ssize_t *num_ops)
+{
+    ssize_t s_idx;
+    size_t bases_idx = 0;
+    boolean bases_flag = kTrue;
+    boolean operation_flag = kFalse;
+    char curr_bases_field[C2B_MAX_OPERATION_FIELD_LENGTH_VALUE];
+    char curr_char = '-';
+    unsigned int curr_bases = 0;
+    ssize_t op_idx = 0;
+
+    /* the decoder that convert2bed used before, less its fixed limit on operations */
+
+    for (s_idx = 0; s_idx < s.length; ++s_idx) {
+        curr_char = s.s[s_idx];
+        if (isdigit(curr_char)) {
+            if (operation_flag) {
+                ops[op_idx++].bases = curr_bases;
+                operation_flag = kFalse;
+                bases_flag = kTrue;
+            }
+            curr_bases_field[bases_idx++] = curr_char;
+            curr_bases_field[bases_idx] = '\0';
+        }
+        else {
+            if (bases_flag) {
+                curr_bases = atoi(curr_bases_field);
+                bases_flag = kFalse;
+                operation_flag = kTrue;
+                bases_idx = 0;
+                memset(curr_bases_field, 0, strlen(curr_bases_field));
+            }
+            ops[op_idx].operation = curr_char;
+        }
+    }
+    ops[op_idx].bases = curr_bases;
+    *num_ops = op_idx + 1;
+}
+
+static void
+c2b_cigar_verify(c2b_cigar_set_t *set)
+{
+    c2b_cigar_t cigar;
+    char *posn = NULL;
+    char *end = NULL;
+    unsigned long bases = 0;
+    uint64_t total_bases = 0;
+    ssize_t op_idx = 0;
+    size_t string_idx;
+
+    c2b_init_cigar(&cigar);
+    for (string_idx = 0; string_idx < C2B_CIGAR_BENCH_STRINGS; string_idx++) {
+        c2b_sam_cigar_str_to_ops(set->spans[string_idx], &cigar);
+        posn = set->spans[string_idx].s;
+        end = posn + set->spans[string_idx].length;
+        for (op_idx = 0, total_bases = 0; posn < end; op_idx++) {
+            bases = strtoul(posn, &posn, 10);
+            if ((op_idx >= cigar.length) || (cigar.ops[op_idx].bases != bases) || (cigar.ops[op_idx].operation != *posn)) {
+                fprintf(stderr, "Error: [%s] CIGAR %zu differs from reference at operation %zd\n", set->name, string_idx, op_idx);
+                exit(EXIT_FAILURE);
+            }
+            total_bases += bases;
+            posn++;
+        }
+        if ((op_idx != cigar.length) || (cigar.bases != total_bases) || (c2b_sam_cigar_str_to_bases(set->spans[string_idx]) != total_bases)) {
+            fprintf(stderr, "Error: [%s] CIGAR %zu operation count or bases differ from reference\n", set->name, string_idx);
+            exit(EXIT_FAILURE);
+        }
+    }
+    c2b_delete_cigar(&cigar);
+}
+
+static void
+c2b_cigar_report(c2b_cigar_set_t *set, const char *decoder, uint64_t num_rounds, double elapsed, uint64_t checksum)
+{
+    fprintf(stdout, "%-6s %-8s %8.1f MB/s | %8.2f M CIGARs/s | %8.1f M ops/s | checksum %" PRIu64 "\n",
+            set->name,
+            decoder,
+            (double) (num_rounds * set->total_length) / elapsed / 1e6,
+            (double) (num_rounds * C2B_CIGAR_BENCH_STRINGS) / elapsed / 1e6,
+            (double) (num_rounds * set->total_ops) / elapsed / 1e6,
+            checksum);
+}
+
+static void
+c2b_cigar_measure(c2b_cigar_set_t *set)
+{
+    c2b_cigar_t cigar;
+    c2b_cigar_op_t *legacy_ops = NULL;
+    ssize_t legacy_num_ops = 0;
+    uint64_t num_rounds = C2B_CIGAR_BENCH_TOTAL_BYTES / set->total_length + 1;
+    uint64_t round_idx;
+    uint64_t checksum = 0;
+    size_t string_idx;
+    double start;
+
+    c2b_cigar_verify(set);
+
+    /* as in the --split functors, each CIGAR starts from an empty, inline set of operations */
+
+    start = c2b_cigar_now();
+    for (round_idx = 0, checksum = 0; round_idx < num_rounds; round_idx++) {
+        for (string_idx = 0; string_idx < C2B_CIGAR_BENCH_STRINGS; string_idx++) {
+            c2b_init_cigar(&cigar);
+            c2b_sam_cigar_str_to_ops(set->spans[string_idx], &cigar);
+            checksum += cigar.bases + (uint64_t) cigar.length;
+            c2b_delete_cigar(&cigar);
+        }
+    }
+    c2b_cigar_report(set, "ops", num_rounds, c2b_cigar_now() - start, checksum);
+
+    start = c2b_cigar_now();
+    for (round_idx = 0, checksum = 0; round_idx < num_rounds; round_idx++) {
+        for (string_idx = 0; string_idx < C2B_CIGAR_BENCH_STRINGS; string_idx++) {
+            checksum += c2b_sam_cigar_str_to_bases(set->spans[string_idx]);
+        }
+    }
+    c2b_cigar_report(set, "bases", num_rounds, c2b_cigar_now() - start, checksum);
+
+    legacy_ops = malloc((set->total_length + 1) * sizeof(c2b_cigar_op_t));
+    if (!legacy_ops) {
+        fprintf(stderr, "Error: Could not allocate space for legacy CIGAR operations\n");
+        exit(ENOMEM);
+    }
+    start = c2b_cigar_now();
+    for (round_idx = 0, checksum = 0; round_idx < num_rounds; round_idx++) {
+        for (string_idx = 0; string_idx < C2B_CIGAR_BENCH_STRINGS; string_idx++) {
+            c2b_cigar_legacy_str_to_ops(set->spans[string_idx], legacy_ops, &legacy_num_ops);
+            checksum += legacy_ops[legacy_num_ops - 1].bases + (uint64_t) legacy_num_ops;
+        }
+    }
+    c2b_cigar_report(set, "legacy", num_rounds, c2b_cigar_now() - start, checksum);
+    free(legacy_ops);
+}
+
+int
+main()
+{
+    c2b_cigar_set_t short_set;
+    c2b_cigar_set_t long_set;
+
+    c2b_init_globals();
+    c2b_cigar_fill_set(&short_set, "short", kFalse);
+    c2b_cigar_fill_set(&long_set, "long", kTrue);
+
+    c2b_cigar_measure(&short_set);
+    c2b_cigar_measure(&long_set);
+
+    c2b_cigar_delete_set(&short_set);
+    c2b_cigar_delete_set(&long_set);
+    c2b_delete_globals();
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,595 @@
+/*
+   gen.c
+   -----------------------------------------------------------------------
+   Deterministic synthetic input for the convert2bed benchmarks. Writes
+   about the given number of megabytes of one input format to standard
+   output:
+
+     $ ./gen <bam|sam|vcf|gff|gvf|gtf|psl|rmsk|wig> <megabytes>
+     $ ./gen <bam|sam> <megabytes> long
+
+   Records are spread over a few chromosomes in no particular order, so
+   that sorting has work to do. SAM and BAM reads come from the same
+   stream, so that their BED output is the same; a third of reads are
+   spliced, and one in sixteen is unmapped. With "long", reads are 
+   long-read alignments, with hundreds to thousands of CIGAR operations
+   and sequences of tens of kilobases. VCF records carry eight
+   samples, and a third of them are multi-allelic. PSL records have up to
+   64 blocks, and WIG input alternates fixedStep and variableStep sections.
+*/
+
+#define C2B_NO_MAIN
+#include "../../convert2bed.c"
+#include <stdarg.h>
+
+#define C2B_GEN_NUM_CHROMS 4
+#define C2B_GEN_CHROM_LENGTH 200000000
+#define C2B_GEN_BGZF_BLOCK_SIZE 65280
+#define C2B_GEN_VCF_SAMPLES 8
+#define C2B_GEN_PSL_MAX_BLOCKS 64
+#define C2B_GEN_SHORT_READ_LENGTH 100
+#define C2B_GEN_MAX_CIGAR_OPS 4096
+
+typedef struct gen_read {
+    int ref_id;
+    uint32_t pos;
+    uint16_t flag;
+    uint8_t mapq;
+    char name[32];
+    uint32_t cigar[C2B_GEN_MAX_CIGAR_OPS];
+    uint16_t n_cigar_op;
+    uint32_t l_seq;
+    char *seq;
+    size_t seq_capacity;
+} c2b_gen_read_t;
+
+typedef struct gen_bgzf {
+    unsigned char *block;
+    size_t block_size;
+    unsigned char *deflated;
+} c2b_gen_bgzf_t;
+
+static const char *c2b_gen_bases = "ACGT";
+static uint64_t c2b_gen_state = 0x9e3779b97f4a7c15ULL;
+static uint64_t c2b_gen_bytes = 0;
+
+static void
+c2b_gen_printf(FILE *out, const char *format, ...)
+{
+    va_list args;
+    int length = 0;
+
+    /* text formats are measured as they are written, as standard output may be a pipe */
+
+    va_start(args, format);
+    length = vfprintf(out, format, args);
+    va_end(args);
+    if (length > 0)
+        c2b_gen_bytes += (uint64_t) length;
+}
+
+static inline void
+c2b_gen_putc(int c, FILE *out)
+{
+    fputc(c, out);
+    c2b_gen_bytes++;
+}
+
+static inline uint32_t
+c2b_gen_next(uint32_t bound)
+{
+    /* xorshift64*, so that every run writes the same bytes */
+
+    c2b_gen_state ^= c2b_gen_state >> 12;
+    c2b_gen_state ^= c2b_gen_state << 25;
+    c2b_gen_state ^= c2b_gen_state >> 27;
+    return (uint32_t) (((c2b_gen_state * 0x2545f4914f6cdd1dULL) >> 32) % bound);
+}
+
+static void
+c2b_gen_seq(char *dest, uint32_t length)
+{
+    uint32_t idx;
+
+    for (idx = 0; idx < length; idx++) {
+        dest[idx] = c2b_gen_bases[c2b_gen_next(4)];
+    }
+    dest[length] = '\0';
+}
+
+static void
+c2b_gen_next_read(c2b_gen_read_t *r, uint64_t read_idx, boolean is_long)
+{
+    uint32_t ops_left = 0;
+    uint32_t op_bases = 0;
+    uint32_t query_length = 0;
+    uint32_t op = 0;
+
+    r->ref_id = (int) c2b_gen_next(C2B_GEN_NUM_CHROMS);
+    r->pos = c2b_gen_next(C2B_GEN_CHROM_LENGTH - 1000000);
+    r->flag = (uint16_t) ((c2b_gen_next(2) ? 0x10 : 0) | ((c2b_gen_next(16) == 0) ? 0x4 : 0));
+    r->mapq = (uint8_t) c2b_gen_next(61);
+    snprintf(r->name, sizeof(r->name), "read%" PRIu64, read_idx);
+    r->n_cigar_op = 0;
+
+    if (is_long) {
+        /* a soft clip, then matches broken up by small insertions and deletions */
+        ops_left = 200 + c2b_gen_next(C2B_GEN_MAX_CIGAR_OPS - 202);
+        r->cigar[r->n_cigar_op++] = ((1 + c2b_gen_next(200)) << 4) | 4;
+        while (ops_left-- > 0) {
+            op = (r->n_cigar_op % 2) ? 0 : ((c2b_gen_next(2)) ? 1 : 2);
+            op_bases = (op == 0) ? 1 + c2b_gen_next(300) : 1 + c2b_gen_next(8);
+            r->cigar[r->n_cigar_op++] = (op_bases << 4) | op;
+        }
+        r->cigar[r->n_cigar_op++] = ((1 + c2b_gen_next(200)) << 4) | 0;
+    }
+    else if (c2b_gen_next(3) == 0) {
+        /* spliced, as by an RNA-seq aligner */
+        op_bases = 10 + c2b_gen_next(C2B_GEN_SHORT_READ_LENGTH - 20);
+        r->cigar[r->n_cigar_op++] = (op_bases << 4) | 0;
+        r->cigar[r->n_cigar_op++] = ((100 + c2b_gen_next(20000)) << 4) | 3;
+        r->cigar[r->n_cigar_op++] = ((C2B_GEN_SHORT_READ_LENGTH - op_bases) << 4) | 0;
+    }
+    else {
+        r->cigar[r->n_cigar_op++] = (C2B_GEN_SHORT_READ_LENGTH << 4) | 0;
+    }
+
+    for (op = 0, query_length = 0; op < r->n_cigar_op; op++) {
+        if (strchr("MIS=X", c2b_bam_cigar_ops[r->cigar[op] & 0xf]))
+            query_length += r->cigar[op] >> 4;
+    }
+    if (query_length + 1 > r->seq_capacity) {
+        r->seq_capacity = 2 * (query_length + 1);
+        free(r->seq);
+        r->seq = malloc(r->seq_capacity);
+        if (!r->seq) {
+            fprintf(stderr, "Error: Could not allocate space for read sequence\n");
+            exit(ENOMEM);
+        }
+    }
+    r->l_seq = query_length;
+    c2b_gen_seq(r->seq, query_length);
+}
+
+static void
+c2b_gen_sam_read(FILE *out, c2b_gen_read_t *r)
+{
+    uint16_t op;
+    uint32_t idx;
+
+    if (r->flag & 0x4) {
+        c2b_gen_printf(out, "%s\t%u\t*\t0\t0\t*\t*\t0\t0\t%s\t*\tNM:i:%u\n", r->name, r->flag, r->seq, r->mapq % 5);
+        return;
+    }
+    c2b_gen_printf(out, "%s\t%u\tchr%d\t%u\t%u\t", r->name, r->flag, r->ref_id + 1, r->pos + 1, r->mapq);
+    for (op = 0; op < r->n_cigar_op; op++) {
+        c2b_gen_printf(out, "%u%c", r->cigar[op] >> 4, c2b_bam_cigar_ops[r->cigar[op] & 0xf]);
+    }
+    c2b_gen_printf(out, "\t*\t0\t0\t%s\t", r->seq);
+    for (idx = 0; idx < r->l_seq; idx++) {
+        c2b_gen_putc('!' + (int) ((idx * 7 + r->pos) % 41), out);
+    }
+    c2b_gen_printf(out, "\tNM:i:%u\n", r->mapq % 5);
+}
+
+static void
+c2b_gen_le32(unsigned char *dest, uint32_t value)
+{
+    dest[0] = (unsigned char) (value & 0xff);
+    dest[1] = (unsigned char) ((value >> 8) & 0xff);
+    dest[2] = (unsigned char) ((value >> 16) & 0xff);
+    dest[3] = (unsigned char) ((value >> 24) & 0xff);
+}
+
+static void
+c2b_gen_le16(unsigned char *dest, uint16_t value)
+{
+    dest[0] = (unsigned char) (value & 0xff);
+    dest[1] = (unsigned char) ((value >> 8) & 0xff);
+}
+
+static void
+c2b_gen_bgzf_flush(FILE *out, c2b_gen_bgzf_t *b)
+{
+    z_stream z;
+    uLong crc = crc32(0L, Z_NULL, 0);
+    size_t deflated_size = 0;
+
+    /* one BGZF block: a gzip member with a BC extra field that gives its size */
+
+    memset(&z, 0, sizeof(z_stream));
+    if (deflateInit2(&z, Z_DEFAULT_COMPRESSION, Z_DEFLATED, -15, 8, Z_DEFAULT_STRATEGY) != Z_OK) {
+        fprintf(stderr, "Error: Could not initialize deflate stream\n");
+        exit(EXIT_FAILURE);
+    }
+    z.next_in = b->block;
+    z.avail_in = (uInt) b->block_size;
+    z.next_out = b->deflated + 18;
+    z.avail_out = (uInt) (2 * C2B_GEN_BGZF_BLOCK_SIZE);
+    if (deflate(&z, Z_FINISH) != Z_STREAM_END) {
+        fprintf(stderr, "Error: Could not deflate BGZF block\n");
+        exit(EXIT_FAILURE);
+    }
+    deflated_size = 2 * C2B_GEN_BGZF_BLOCK_SIZE - z.avail_out;
+    deflateEnd(&z);
+
+    memcpy(b->deflated, "\x1f\x8b\x08\x04\x00\x00\x00\x00\x00\xff\x06\x00\x42\x43\x02\x00", 16);
+    c2b_gen_le16(b->deflated + 16, (uint16_t) (18 + deflated_size + 8 - 1));
+    crc = crc32(crc, b->block, (uInt) b->block_size);
+    c2b_gen_le32(b->deflated + 18 + deflated_size, (uint32_t) crc);
+    c2b_gen_le32(b->deflated + 18 + deflated_size + 4, (uint32_t) b->block_size);
+    fwrite(b->deflated, 1, 18 + deflated_size + 8, out);
+    b->block_size = 0;
+}
+
+static void
+c2b_gen_bgzf_write(FILE *out, c2b_gen_bgzf_t *b, const void *src, size_t size)
+{
+    const unsigned char *posn = (const unsigned char *) src;
+    size_t n = 0;
+
+    while (size > 0) {
+        n = (size < C2B_GEN_BGZF_BLOCK_SIZE - b->block_size) ? size : C2B_GEN_BGZF_BLOCK_SIZE - b->block_size;
+        memcpy(b->block + b->block_size, posn, n);
+        b->block_size += n;
+        posn += n;
+        size -= n;
+        if (b->block_size == C2B_GEN_BGZF_BLOCK_SIZE)
+            c2b_gen_bgzf_flush(out, b);
+    }
+}
+
+static void
+c2b_gen_bam_header(FILE *out, c2b_gen_bgzf_t *b)
+{
+    unsigned char word[4];
+    char name[16];
+    int ref_idx;
+
+    c2b_gen_bgzf_write(out, b, "BAM\1", 4);
+    c2b_gen_le32(word, 0);
+    c2b_gen_bgzf_write(out, b, word, 4);
+    c2b_gen_le32(word, C2B_GEN_NUM_CHROMS);
+    c2b_gen_bgzf_write(out, b, word, 4);
+    for (ref_idx = 0; ref_idx < C2B_GEN_NUM_CHROMS; ref_idx++) {
+        snprintf(name, sizeof(name), "chr%d", ref_idx + 1);
+        c2b_gen_le32(word, (uint32_t) strlen(name) + 1);
+        c2b_gen_bgzf_write(out, b, word, 4);
+        c2b_gen_bgzf_write(out, b, name, strlen(name) + 1);
+        c2b_gen_le32(word, C2B_GEN_CHROM_LENGTH);
+        c2b_gen_bgzf_write(out, b, word, 4);
+    }
+}
+
+static void
+c2b_gen_bam_read(FILE *out, c2b_gen_bgzf_t *b, c2b_gen_read_t *r, unsigned char **record, size_t *record_capacity)
+{
+    static const unsigned char base_codes[256] = { ['A'] = 1, ['C'] = 2, ['G'] = 4, ['T'] = 8 };
+    size_t l_read_name = strlen(r->name) + 1;
+    size_t record_length = 4 + C2B_BAM_RECORD_CORE_LENGTH + l_read_name + 4 * (size_t) r->n_cigar_op + (r->l_seq + 1) / 2 + r->l_seq + 4;
+    unsigned char *posn = NULL;
+    boolean is_mapped = !(r->flag & 0x4);
+    uint32_t idx;
+
+    if (record_length > *record_capacity) {
+        *record_capacity = 2 * record_length;
+        free(*record);
+        *record = malloc(*record_capacity);
+        if (!*record) {
+            fprintf(stderr, "Error: Could not allocate space for BAM record\n");
+            exit(ENOMEM);
+        }
+    }
+    posn = *record;
+    c2b_gen_le32(posn, (uint32_t) (record_length - 4));
+    c2b_gen_le32(posn + 4, (uint32_t) ((is_mapped) ? r->ref_id : -1));
+    c2b_gen_le32(posn + 8, (uint32_t) ((is_mapped) ? (int32_t) r->pos : -1));
+    posn[12] = (unsigned char) l_read_name;
+    posn[13] = (is_mapped) ? r->mapq : 0;
+    c2b_gen_le16(posn + 14, 4680);
+    c2b_gen_le16(posn + 16, (is_mapped) ? r->n_cigar_op : 0);
+    c2b_gen_le16(posn + 18, r->flag);
+    c2b_gen_le32(posn + 20, r->l_seq);
+    c2b_gen_le32(posn + 24, (uint32_t) -1);
+    c2b_gen_le32(posn + 28, (uint32_t) -1);
+    c2b_gen_le32(posn + 32, 0);
+    posn += 4 + C2B_BAM_RECORD_CORE_LENGTH;
+    memcpy(posn, r->name, l_read_name);
+    posn += l_read_name;
+    if (is_mapped) {
+        for (idx = 0; idx < r->n_cigar_op; idx++, posn += 4) {
+            c2b_gen_le32(posn, r->cigar[idx]);
+        }
+    }
+    else {
+        record_length -= 4 * (size_t) r->n_cigar_op;
+        c2b_gen_le32(*record, (uint32_t) (record_length - 4));
+    }
+    memset(posn, 0, (r->l_seq + 1) / 2);
+    for (idx = 0; idx < r->l_seq; idx++) {
+        posn[idx / 2] |= (unsigned char) (base_codes[(unsigned char) r->seq[idx]] << ((idx % 2) ? 0 : 4));
+    }
+    posn += (r->l_seq + 1) / 2;
+    if (is_mapped) {
+        for (idx = 0; idx < r->l_seq; idx++) {
+            posn[idx] = (unsigned char) ((idx * 7 + r->pos) % 41);
+        }
+    }
+    else {
+        memset(posn, 0xff, r->l_seq);
+    }
+    posn += r->l_seq;
+    memcpy(posn, "NMC", 3);
+    posn[3] = (unsigned char) (r->mapq % 5);
+    c2b_gen_bgzf_write(out, b, *record, record_length);
+}
+
+static void
+c2b_gen_reads(FILE *out, uint64_t target_bytes, boolean is_bam, boolean is_long)
+{
+    c2b_gen_read_t read;
+    c2b_gen_bgzf_t bgzf;
+    unsigned char *record = NULL;
+    size_t record_capacity = 0;
+    uint64_t read_idx = 0;
+    FILE *sam_out = out;
+    int ref_idx;
+
+    memset(&read, 0, sizeof(c2b_gen_read_t));
+    memset(&bgzf, 0, sizeof(c2b_gen_bgzf_t));
+    if (is_bam) {
+        bgzf.block = malloc(C2B_GEN_BGZF_BLOCK_SIZE);
+        bgzf.deflated = malloc(2 * C2B_GEN_BGZF_BLOCK_SIZE + 26);
+        if ((!bgzf.block) || (!bgzf.deflated)) {
+            fprintf(stderr, "Error: Could not allocate space for BGZF blocks\n");
+            exit(ENOMEM);
+        }
+        c2b_gen_bam_header(out, &bgzf);
+
+        /* BAM input is measured by the SAM text of its reads, so that SAM and BAM hold the same reads */
+
+        sam_out = fopen("/dev/null", "w");
+        if (!sam_out) {
+            fprintf(stderr, "Error: Could not open /dev/null\n");
+            exit(EXIT_FAILURE);
+        }
+    }
+    c2b_gen_printf(sam_out, "@HD\tVN:1.6\tSO:unsorted\n");
+    for (ref_idx = 0; ref_idx < C2B_GEN_NUM_CHROMS; ref_idx++) {
+        c2b_gen_printf(sam_out, "@SQ\tSN:chr%d\tLN:%d\n", ref_idx + 1, C2B_GEN_CHROM_LENGTH);
+    }
+
+    while (c2b_gen_bytes < target_bytes) {
+        c2b_gen_next_read(&read, read_idx++, is_long);
+        c2b_gen_sam_read(sam_out, &read);
+        if (is_bam)
+            c2b_gen_bam_read(out, &bgzf, &read, &record, &record_capacity);
+    }
+
+    if (is_bam) {
+        if (bgzf.block_size > 0)
+            c2b_gen_bgzf_flush(out, &bgzf);
+        fwrite("\x1f\x8b\x08\x04\x00\x00\x00\x00\x00\xff\x06\x00\x42\x43\x02\x00\x1b\x00\x03\x00\x00\x00\x00\x00\x00\x00\x00\x00", 1, 28, out);
+        free(bgzf.block);
+        free(bgzf.deflated);
+        free(record);
+        fclose(sam_out);
+    }
+    free(read.seq);
+}
+
+static void
+c2b_gen_vcf(FILE *out, uint64_t target_bytes)
+{
+    char ref[16];
+    char alt[64];
+    int num_alts = 0;
+    int alt_idx;
+    int sample_idx;
+    uint32_t ref_length = 0;
+
+    c2b_gen_printf(out, "##fileformat=VCFv4.2\n");
+    c2b_gen_printf(out, "##INFO=<ID=DP,Number=1,Type=Integer,Description=\"Total Depth\">\n");
+    c2b_gen_printf(out, "##FORMAT=<ID=GT,Number=1,Type=String,Description=\"Genotype\">\n");
+    c2b_gen_printf(out, "##FORMAT=<ID=GQ,Number=1,Type=Integer,Description=\"Genotype Quality\">\n");
+    c2b_gen_printf(out, "#CHROM\tPOS\tID\tREF\tALT\tQUAL\tFILTER\tINFO\tFORMAT");
+    for (sample_idx = 0; sample_idx < C2B_GEN_VCF_SAMPLES; sample_idx++) {
+        c2b_gen_printf(out, "\tNA%05d", sample_idx + 1);
+    }
+    c2b_gen_putc('\n', out);
+
+    while (c2b_gen_bytes < target_bytes) {
+        /* SNVs, insertions and deletions, a third of them with more than one allele */
+        ref_length = (c2b_gen_next(4) == 0) ? 2 + c2b_gen_next(6) : 1;
+        c2b_gen_seq(ref, ref_length);
+        num_alts = (c2b_gen_next(3) == 0) ? 2 + (int) c2b_gen_next(2) : 1;
+        alt[0] = '\0';
+        for (alt_idx = 0; alt_idx < num_alts; alt_idx++) {
+            size_t alt_length = strlen(alt);
+            uint32_t kind = c2b_gen_next(3);
+            if (alt_idx > 0)
+                alt[alt_length++] = ',';
+            if ((kind == 0) || (ref_length > 1))
+                c2b_gen_seq(alt + alt_length, (kind == 0) ? ref_length : 1);
+            else
+                c2b_gen_seq(alt + alt_length, 2 + c2b_gen_next(6));
+        }
+        c2b_gen_printf(out, "chr%u\t%u\t.\t%s\t%s\t%u\tPASS\tDP=%u\tGT:GQ",
+                c2b_gen_next(C2B_GEN_NUM_CHROMS) + 1, 1 + c2b_gen_next(C2B_GEN_CHROM_LENGTH), ref, alt, c2b_gen_next(100), c2b_gen_next(200));
+        for (sample_idx = 0; sample_idx < C2B_GEN_VCF_SAMPLES; sample_idx++) {
+            c2b_gen_printf(out, "\t%u/%u:%u", c2b_gen_next((uint32_t) num_alts + 1), c2b_gen_next((uint32_t) num_alts + 1), c2b_gen_next(100));
+        }
+        c2b_gen_putc('\n', out);
+    }
+}
+
+static void
+c2b_gen_gff(FILE *out, uint64_t target_bytes, const char *format)
+{
+    static const char *types[] = { "gene", "mRNA", "exon", "CDS", "SNV" };
+    boolean is_gtf = (strcmp(format, "gtf") == 0) ? kTrue : kFalse;
+    boolean is_gvf = (strcmp(format, "gvf") == 0) ? kTrue : kFalse;
+    uint64_t record_idx = 0;
+    uint32_t start = 0;
+
+    if (is_gvf)
+        c2b_gen_printf(out, "##gvf-version 1.10\n");
+    else if (!is_gtf)
+        c2b_gen_printf(out, "##gff-version 3\n");
+
+    while (c2b_gen_bytes < target_bytes) {
+        start = 1 + c2b_gen_next(C2B_GEN_CHROM_LENGTH);
+        c2b_gen_printf(out, "chr%u\tsynthetic\t%s\t%u\t%u\t%s\t%c\t%c\t",
+                c2b_gen_next(C2B_GEN_NUM_CHROMS) + 1,
+                (is_gvf) ? "SNV" : types[c2b_gen_next(4)],
+                start,
+                (is_gvf) ? start : start + c2b_gen_next(5000),
+                (c2b_gen_next(2)) ? "." : "0.5",
+                "+-."[c2b_gen_next(3)],
+                ".012"[c2b_gen_next(4)]);
+        if (is_gtf)
+            c2b_gen_printf(out, "gene_id \"GENE%" PRIu64 "\"; transcript_id \"TX%" PRIu64 ".%u\"; gene_name \"SYN%" PRIu64 "\";\n", record_idx / 4, record_idx / 4, c2b_gen_next(4), record_idx / 4);
+        else if (is_gvf)
+            c2b_gen_printf(out, "ID=var%" PRIu64 ";Variant_seq=%c,%c;Reference_seq=%c;Genotype=0:1;\n", record_idx, c2b_gen_bases[c2b_gen_next(4)], c2b_gen_bases[c2b_gen_next(4)], c2b_gen_bases[c2b_gen_next(4)]);
+        else
+            c2b_gen_printf(out, "ID=feature%" PRIu64 ";Parent=gene%" PRIu64 ";Name=SYN%" PRIu64 ";score=%u\n", record_idx, record_idx / 4, record_idx / 4, c2b_gen_next(1000));
+        record_idx++;
+    }
+}
+
+static void
+c2b_gen_psl(FILE *out, uint64_t target_bytes)
+{
+    uint32_t block_sizes[C2B_GEN_PSL_MAX_BLOCKS];
+    uint32_t q_starts[C2B_GEN_PSL_MAX_BLOCKS];
+    uint32_t t_starts[C2B_GEN_PSL_MAX_BLOCKS];
+    uint32_t num_blocks = 0;
+    uint32_t block_idx;
+    uint32_t q_posn = 0;
+    uint32_t t_posn = 0;
+    uint32_t t_start = 0;
+    uint32_t matches = 0;
+    uint64_t record_idx = 0;
+
+    while (c2b_gen_bytes < target_bytes) {
+        num_blocks = 1 + c2b_gen_next(C2B_GEN_PSL_MAX_BLOCKS);
+        t_start = c2b_gen_next(C2B_GEN_CHROM_LENGTH - 10000000);
+        for (block_idx = 0, q_posn = 0, t_posn = t_start, matches = 0; block_idx < num_blocks; block_idx++) {
+            block_sizes[block_idx] = 20 + c2b_gen_next(200);
+            q_starts[block_idx] = q_posn;
+            t_starts[block_idx] = t_posn;
+            matches += block_sizes[block_idx];
+            q_posn += block_sizes[block_idx];
+            t_posn += block_sizes[block_idx] + 50 + c2b_gen_next(50000);
+        }
+        c2b_gen_printf(out, "%u\t0\t0\t0\t0\t0\t%u\t%u\t%c\tquery%" PRIu64 "\t%u\t0\t%u\tchr%u\t%u\t%u\t%u\t%u\t",
+                matches, num_blocks - 1, t_posn - t_start - matches, "+-"[c2b_gen_next(2)], record_idx++, q_posn, q_posn,
+                c2b_gen_next(C2B_GEN_NUM_CHROMS) + 1, C2B_GEN_CHROM_LENGTH, t_start, t_posn, num_blocks);
+        for (block_idx = 0; block_idx < num_blocks; block_idx++)
+            c2b_gen_printf(out, "%u,", block_sizes[block_idx]);
+        c2b_gen_putc('\t', out);
+        for (block_idx = 0; block_idx < num_blocks; block_idx++)
+            c2b_gen_printf(out, "%u,", q_starts[block_idx]);
+        c2b_gen_putc('\t', out);
+        for (block_idx = 0; block_idx < num_blocks; block_idx++)
+            c2b_gen_printf(out, "%u,", t_starts[block_idx]);
+        c2b_gen_putc('\n', out);
+    }
+}
+
+static void
+c2b_gen_rmsk(FILE *out, uint64_t target_bytes)
+{
+    static const char *repeats[] = { "AluSx", "L1PA2", "MIR", "Tigger1", "(CA)n" };
+    static const char *classes[] = { "SINE/Alu", "LINE/L1", "SINE/MIR", "DNA/TcMar-Tigger", "Simple_repeat" };
+    uint32_t repeat_idx = 0;
+    uint32_t start = 0;
+    uint64_t record_idx = 0;
+    char query_left[16];
+    char repeat_left[16];
+
+    c2b_gen_printf(out, "   SW  perc perc perc  query      position in query           matching       repeat              position in  repeat\n");
+    c2b_gen_printf(out, "score  div. del. ins.  sequence    begin     end    (left)    repeat         class/family         begin  end (left)   ID\n");
+    c2b_gen_printf(out, "\n");
+
+    /* columns are padded with spaces, as RepeatMasker does; bases left over are in parentheses */
+
+    while (c2b_gen_bytes < target_bytes) {
+        repeat_idx = c2b_gen_next(5);
+        start = 1 + c2b_gen_next(C2B_GEN_CHROM_LENGTH);
+        snprintf(query_left, sizeof(query_left), "(%u)", c2b_gen_next(C2B_GEN_CHROM_LENGTH));
+        snprintf(repeat_left, sizeof(repeat_left), "(%u)", c2b_gen_next(100));
+        c2b_gen_printf(out, "%6u %5.1f %4.1f %4.1f  chr%-8u %9u %9u %11s %c  %-14s %-20s %6u %5u %6s %6" PRIu64 "\n",
+                200 + c2b_gen_next(30000), c2b_gen_next(300) / 10.0, c2b_gen_next(100) / 10.0, c2b_gen_next(100) / 10.0,
+                c2b_gen_next(C2B_GEN_NUM_CHROMS) + 1, start, start + 20 + c2b_gen_next(6000), query_left,
+                "+C"[c2b_gen_next(2)], repeats[repeat_idx], classes[repeat_idx], 1 + c2b_gen_next(100), 100 + c2b_gen_next(6000), repeat_left,
+                ++record_idx);
+    }
+}
+
+static void
+c2b_gen_wig(FILE *out, uint64_t target_bytes)
+{
+    uint32_t section_lines = 0;
+    uint32_t line_idx;
+    uint32_t posn = 0;
+    uint32_t span = 0;
+    boolean is_fixed_step = kTrue;
+
+    while (c2b_gen_bytes < target_bytes) {
+        section_lines = 100 + c2b_gen_next(10000);
+        posn = 1 + c2b_gen_next(C2B_GEN_CHROM_LENGTH - 10000000);
+        span = 1 + c2b_gen_next(50);
+        if (is_fixed_step) {
+            c2b_gen_printf(out, "fixedStep chrom=chr%u start=%u step=%u span=%u\n", c2b_gen_next(C2B_GEN_NUM_CHROMS) + 1, posn, span + c2b_gen_next(20), span);
+            for (line_idx = 0; line_idx < section_lines; line_idx++)
+                c2b_gen_printf(out, "%.3f\n", (double) c2b_gen_next(200000) / 1000.0 - 100.0);
+        }
+        else {
+            c2b_gen_printf(out, "variableStep chrom=chr%u span=%u\n", c2b_gen_next(C2B_GEN_NUM_CHROMS) + 1, span);
+            for (line_idx = 0; line_idx < section_lines; line_idx++) {
+                posn += span + c2b_gen_next(500);
+                c2b_gen_printf(out, "%u\t%.3f\n", posn, (double) c2b_gen_next(200000) / 1000.0 - 100.0);
+            }
+        }
+        is_fixed_step = !is_fixed_step;
+    }
+}
+
+int
+main(int argc, char **argv)
+{
+    static char out_buffer[1 << 20];
+    uint64_t target_bytes = 0;
+    const char *format = NULL;
+    boolean is_long = kFalse;
+
+    if ((argc < 3) || (argc > 4) || ((argc == 4) && ((strcmp(argv[3], "long") != 0) || ((strcmp(argv[1], "sam") != 0) && (strcmp(argv[1], "bam") != 0))))) {
+        fprintf(stderr, "Usage: %s <bam|sam|vcf|gff|gvf|gtf|psl|rmsk|wig> <megabytes>\n       %s <bam|sam> <megabytes> long\n", argv[0], argv[0]);
+        return EINVAL;
+    }
+    format = argv[1];
+    target_bytes = strtoull(argv[2], NULL, 10) * 1048576;
+    is_long = (argc == 4) ? kTrue : kFalse;
+    setvbuf(stdout, out_buffer, _IOFBF, sizeof(out_buffer));
+
+    if ((strcmp(format, "bam") == 0) || (strcmp(format, "sam") == 0))
+        c2b_gen_reads(stdout, target_bytes, (format[0] == 'b') ? kTrue : kFalse, is_long);
+    else if (strcmp(format, "vcf") == 0)
+        c2b_gen_vcf(stdout, target_bytes);
+    else if ((strcmp(format, "gff") == 0) || (strcmp(format, "gvf") == 0) || (strcmp(format, "gtf") == 0))
+        c2b_gen_gff(stdout, target_bytes, format);
+    else if (strcmp(format, "psl") == 0)
+        c2b_gen_psl(stdout, target_bytes);
+    else if (strcmp(format, "rmsk") == 0)
+        c2b_gen_rmsk(stdout, target_bytes);
+    else if (strcmp(format, "wig") == 0)
+        c2b_gen_wig(stdout, target_bytes);
+    else {
+        fprintf(stderr, "Error: Unknown format [%s]\n", format);
+        return EINVAL;
+    }
+    fflush(stdout);
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,157 @@
+/*
+   scan.c
+   -----------------------------------------------------------------------
+   Microbenchmark for the convert2bed delimiter scan kernels. Each kernel
+   builds the newline and tab bitmaps for a synthetic SAM-like block; its
+   bitmaps are checked against the scalar kernel, and throughput (GB/s) is
+   reported for the scan alone and for the scan plus a walk over every line
+   and field in the block.
+*/
+
+#define C2B_NO_MAIN
+#include "../../convert2bed.c"
+
+#define C2B_SCAN_BLOCK_SIZE C2B_MAX_LINE_LENGTH_VALUE
+#define C2B_SCAN_TOTAL_BYTES (UINT64_C(1) << 31)
+
+static double
+c2b_scan_now()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double) ts.tv_sec + (double) ts.tv_nsec / 1e9;
+}
+
+static void
+c2b_scan_fill_block(char *block, size_t block_size)
+{
+    static const char *bases = "ACGT";
+    size_t posn = 0;
+    unsigned int seed = 1;
+    int field_idx;
+    int field_length;
+    int char_idx;
+
+    /* eleven fields of varying length per line, like a SAM record */
+
+    while (posn < block_size) {
+        for (field_idx = 0; (field_idx < 11) && (posn < block_size); field_idx++) {
+            seed = seed * 1103515245 + 12345;
+            field_length = (field_idx == 9 || field_idx == 10) ? 100 + (int) ((seed >> 16) % 50) : 1 + (int) ((seed >> 16) % 12);
+            for (char_idx = 0; (char_idx < field_length) && (posn < block_size); char_idx++)
+                block[posn++] = bases[(seed >> (char_idx % 16)) & 3];
+            if (posn < block_size)
+                block[posn++] = (field_idx == 10) ? c2b_line_delim : c2b_tab_delim;
+        }
+    }
+}
+
+static size_t
+c2b_scan_walk(c2b_delim_index_t *idx)
+{
+    c2b_context_t ctx;
+    c2b_span_t fields[C2B_MAX_FIELD_COUNT_VALUE];
+    ssize_t line_offset = 0;
+    ssize_t line_end_offset = 0;
+    size_t num_fields = 0;
+
+    c2b_init_context(&ctx);
+    ctx.delims = idx;
+    while ((line_end_offset = c2b_next_delim(idx->line_bits, line_offset, idx->src_size)) != -1) {
+        num_fields += (size_t) c2b_split_fields(&ctx, idx->src + line_offset, line_end_offset - line_offset, fields) + 1;
+        line_offset = line_end_offset + 1;
+    }
+
+    return num_fields;
+}
+
+static void
+c2b_scan_verify(const char *name, c2b_delim_kernel_t kernel, char *block)
+{
+    static const size_t sizes[] = { 1, 15, 63, 64, 65, 1000, C2B_SCAN_BLOCK_SIZE - 37, C2B_SCAN_BLOCK_SIZE };
+    size_t num_words = (C2B_SCAN_BLOCK_SIZE + 63) / 64;
+    uint64_t *bits = calloc(4 * num_words, sizeof(uint64_t));
+    size_t size_idx;
+
+    if (!bits) {
+        fprintf(stderr, "Error: Could not allocate space for scan bitmaps\n");
+        exit(ENOMEM);
+    }
+    for (size_idx = 0; size_idx < sizeof(sizes) / sizeof(sizes[0]); size_idx++) {
+        size_t size_words = (sizes[size_idx] + 63) / 64;
+        c2b_scan_delims_scalar(block, sizes[size_idx], bits, bits + num_words);
+        (*kernel)(block, sizes[size_idx], bits + 2 * num_words, bits + 3 * num_words);
+        if ((memcmp(bits, bits + 2 * num_words, size_words * sizeof(uint64_t)) != 0) ||
+            (memcmp(bits + num_words, bits + 3 * num_words, size_words * sizeof(uint64_t)) != 0)) {
+            fprintf(stderr, "Error: [%s] kernel bitmaps differ from scalar kernel over %zu bytes\n", name, sizes[size_idx]);
+            exit(EXIT_FAILURE);
+        }
+    }
+    free(bits);
+}
+
+static void
+c2b_scan_measure(const char *name, c2b_delim_kernel_t kernel, char *block)
+{
+    c2b_delim_index_t idx;
+    size_t num_words = (C2B_SCAN_BLOCK_SIZE + 63) / 64;
+    uint64_t num_blocks = C2B_SCAN_TOTAL_BYTES / C2B_SCAN_BLOCK_SIZE;
+    uint64_t block_idx;
+    size_t checksum = 0;
+    double start;
+    double scan_time;
+    double walk_time;
+
+    c2b_scan_verify(name, kernel, block);
+
+    c2b_init_delim_index(&idx);
+    c2b_globals.delim_kernel = kernel;
+
+    start = c2b_scan_now();
+    for (block_idx = 0; block_idx < num_blocks; block_idx++) {
+        c2b_index_delims(&idx, block, C2B_SCAN_BLOCK_SIZE);
+        checksum += idx.line_bits[block_idx % num_words];
+    }
+    scan_time = c2b_scan_now() - start;
+
+    start = c2b_scan_now();
+    for (block_idx = 0; block_idx < num_blocks / 4; block_idx++) {
+        c2b_index_delims(&idx, block, C2B_SCAN_BLOCK_SIZE);
+        checksum += c2b_scan_walk(&idx);
+    }
+    walk_time = c2b_scan_now() - start;
+
+    fprintf(stdout, "%-8s scan %7.2f GB/s | scan+split %7.2f GB/s | checksum %zu\n",
+            name,
+            (double) C2B_SCAN_TOTAL_BYTES / scan_time / 1e9,
+            (double) (C2B_SCAN_TOTAL_BYTES / 4) / walk_time / 1e9,
+            checksum);
+
+    c2b_delete_delim_index(&idx);
+}
+
+int
+main()
+{
+    char *block = NULL;
+
+    block = malloc(C2B_SCAN_BLOCK_SIZE);
+    if (!block) {
+        fprintf(stderr, "Error: Could not allocate space for scan block\n");
+        return ENOMEM;
+    }
+    c2b_scan_fill_block(block, C2B_SCAN_BLOCK_SIZE);
+
+    c2b_scan_measure("scalar", c2b_scan_delims_scalar, block);
+#ifdef C2B_HAVE_X86_SIMD
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("sse2"))
+        c2b_scan_measure("sse2", c2b_scan_delims_sse2, block);
+    if (__builtin_cpu_supports("avx2"))
+        c2b_scan_measure("avx2", c2b_scan_delims_avx2, block);
+#endif
+
+    free(block);
+
+    return EXIT_SUCCESS;
+}
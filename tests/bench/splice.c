@@ -0,0 +1,149 @@
+/*
+   splice.c
+   -----------------------------------------------------------------------
+   Microbenchmark for the convert2bed pass-through stage, which moves
+   unsorted BED from its intermediate pipe to standard output. A feeder
+   thread writes a BED-like block into a pipe repeatedly, and the bytes are
+   moved on with splice() and with the read()/write() fallback, first to
+   /dev/null and then into a second pipe that a reader thread drains, as
+   when output is piped into another process. Throughput (GB/s) is reported
+   for each.
+*/
+
+#define C2B_NO_MAIN
+#include "../../convert2bed.c"
+
+#define C2B_PASS_BLOCK_SIZE 65536
+#define C2B_PASS_TOTAL_BYTES (UINT64_C(1) << 32)
+
+static char c2b_pass_block[C2B_PASS_BLOCK_SIZE];
+
+static double
+c2b_pass_now()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double) ts.tv_sec + (double) ts.tv_nsec / 1e9;
+}
+
+static void
+c2b_pass_fill_block()
+{
+    size_t posn = 0;
+    unsigned int start = 10000;
+    int line_length = 0;
+
+    while (posn < C2B_PASS_BLOCK_SIZE) {
+        line_length = snprintf(c2b_pass_block + posn, C2B_PASS_BLOCK_SIZE - posn, "chr1\t%u\t%u\tread%u\t60\t+\n", start, start + 100, start);
+        if ((line_length < 0) || ((size_t) line_length >= C2B_PASS_BLOCK_SIZE - posn))
+            break;
+        posn += (size_t) line_length;
+        start += 7;
+    }
+    memset(c2b_pass_block + posn, '\n', C2B_PASS_BLOCK_SIZE - posn);
+}
+
+static void *
+c2b_pass_feed(void *arg)
+{
+    int fd = *(int *) arg;
+    uint64_t bytes_written = 0;
+    ssize_t n = 0;
+
+    while (bytes_written < C2B_PASS_TOTAL_BYTES) {
+        n = write(fd, c2b_pass_block, C2B_PASS_BLOCK_SIZE);
+        if (n <= 0)
+            break;
+        bytes_written += (uint64_t) n;
+    }
+    close(fd);
+
+    return NULL;
+}
+
+static void *
+c2b_pass_drain(void *arg)
+{
+    int fd = *(int *) arg;
+    char *buffer = malloc(C2B_PASS_BLOCK_SIZE);
+
+    if (!buffer) {
+        fprintf(stderr, "Error: Could not allocate space for drain buffer\n");
+        exit(ENOMEM);
+    }
+    while (read(fd, buffer, C2B_PASS_BLOCK_SIZE) > 0)
+        ;
+    free(buffer);
+
+    return NULL;
+}
+
+static void
+c2b_pass_measure(const char *name, boolean use_splice, boolean to_pipe)
+{
+    int src_fds[PIPE_STREAMS];
+    int sink_fds[PIPE_STREAMS];
+    int dest_fd = -1;
+    pthread_t feeder;
+    pthread_t drainer;
+    boolean is_spliced = kFalse;
+    double start;
+    double elapsed;
+
+    if (pipe(src_fds) != 0) {
+        fprintf(stderr, "Error: Could not create source pipe\n");
+        exit(EXIT_FAILURE);
+    }
+    if (to_pipe) {
+        if (pipe(sink_fds) != 0) {
+            fprintf(stderr, "Error: Could not create sink pipe\n");
+            exit(EXIT_FAILURE);
+        }
+        dest_fd = sink_fds[PIPE_WRITE];
+        pthread_create(&drainer, NULL, c2b_pass_drain, &sink_fds[PIPE_READ]);
+    }
+    else {
+        dest_fd = open("/dev/null", O_WRONLY);
+        if (dest_fd == -1) {
+            fprintf(stderr, "Error: Could not open /dev/null\n");
+            exit(EXIT_FAILURE);
+        }
+    }
+
+    start = c2b_pass_now();
+    pthread_create(&feeder, NULL, c2b_pass_feed, &src_fds[PIPE_WRITE]);
+    if (use_splice)
+        is_spliced = c2b_splice_bytes(NULL, src_fds[PIPE_READ], dest_fd);
+    if (!is_spliced)
+        c2b_copy_bytes(NULL, src_fds[PIPE_READ], dest_fd);
+    pthread_join(feeder, NULL);
+    close(dest_fd);
+    if (to_pipe) {
+        pthread_join(drainer, NULL);
+        close(sink_fds[PIPE_READ]);
+    }
+    elapsed = c2b_pass_now() - start;
+    close(src_fds[PIPE_READ]);
+
+    fprintf(stdout, "%-10s -> %-9s %7.2f GB/s%s\n",
+            name,
+            (to_pipe) ? "pipe" : "/dev/null",
+            (double) C2B_PASS_TOTAL_BYTES / elapsed / 1e9,
+            (use_splice && !is_spliced) ? " (splice unsupported; fell back to read/write)" : "");
+}
+
+int
+main()
+{
+    c2b_init_globals();
+    c2b_pass_fill_block();
+
+    c2b_pass_measure("read/write", kFalse, kFalse);
+    c2b_pass_measure("splice", kTrue, kFalse);
+    c2b_pass_measure("read/write", kFalse, kTrue);
+    c2b_pass_measure("splice", kTrue, kTrue);
+
+    c2b_delete_globals();
+
+    return EXIT_SUCCESS;
+}
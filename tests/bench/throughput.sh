@@ -0,0 +1,92 @@
+#!/bin/bash
+
+#
+# Generates deterministic synthetic inputs of a target size for each input
+# format (see gen.c) and reports conversion throughput, in MB/s and records/s,
+# for unsorted, sorted and Starch output, and --split where it applies. If a
+# baseline binary is given, it is timed on the same inputs for a before/after
+# comparison:
+#
+#   $ BASELINE=/path/to/old/convert2bed SCALE_MB=4096 ./throughput.sh
+#
+# Starch output is measured only if the starch binary is found in the PATH.
+# Long reads are not split, as every block repeats the read's SEQ and QUAL
+# fields; see cigar.c for long-read CIGAR decoding.
+#
+
+bench_dir="$(cd "$(dirname "$0")" && pwd)"
+candidate_bin="${CANDIDATE:-${bench_dir}/../../convert2bed}"
+baseline_bin="${BASELINE:-}"
+gen_bin="${bench_dir}/gen"
+scale_mb="${SCALE_MB:-1024}"
+work_dir="$(mktemp -d /tmp/XXXXXX)"
+trap 'rm -rf ${work_dir}' EXIT
+
+if [ ! -x "${gen_bin}" ]; then
+    echo "[bench] ${gen_bin} not found; run make in ${bench_dir} first" >&2
+    exit 1
+fi
+
+modes=("unsorted:--do-not-sort" "sorted:")
+if command -v starch > /dev/null 2>&1; then
+    modes+=("starch:--output=starch")
+fi
+
+# count <format> <scaled-fn> -- input records, as read by the convert stage
+count() {
+    local format="$1"
+    local scaled_fn="$2"
+    local stats_fn="${work_dir}/stats.json"
+    "${candidate_bin}" --input=${format} --do-not-sort --stats=${stats_fn} < "${scaled_fn}" > /dev/null 2> /dev/null
+    awk -F'[:,]' '/"lines_in"/ { gsub(/ /, "", $2); print $2; exit; }' "${stats_fn}"
+    rm -f "${stats_fn}"
+}
+
+# measure <label> <bin> <scaled-fn> <records> <args...>
+measure() {
+    local label="$1"
+    local bin="$2"
+    local scaled_fn="$3"
+    local records="$4"
+    shift 4
+    local bytes
+    local start
+    local end
+    local status
+    bytes=$(stat -c %s "${scaled_fn}")
+    start=$(date +%s.%N)
+    "${bin}" "$@" < "${scaled_fn}" > /dev/null 2> /dev/null
+    status=$?
+    end=$(date +%s.%N)
+    if [ ${status} -ne 0 ]; then
+        printf "%-40s failed (exit status %d)\n" "${label}" ${status}
+        return
+    fi
+    awk -v l="${label}" -v b="${bytes}" -v r="${records}" -v s="${start}" -v e="${end}" \
+        'BEGIN { t = e - s; printf("%-40s %10.1f MB in %7.2f s : %8.1f MB/s %10.0f records/s\n", l, b / 1048576, t, (b / 1048576) / t, r / t); }'
+}
+
+for spec in "sam:sam" "sam long:sam" "bam:bam" "bam long:bam" "vcf:vcf" "gff:gff" "gvf:gvf" "gtf:gtf" "psl:psl" "rmsk:rmsk" "wig:wig"; do
+    name="${spec%%:*}"
+    format="${spec#*:}"
+    scaled_fn="${work_dir}/scaled.${format}"
+    echo "[bench] generating ${scale_mb} MB of ${name}..."
+    "${gen_bin}" ${name%% *} ${scale_mb} ${name#${format}} > "${scaled_fn}" || exit 1
+    records=$(count ${format} "${scaled_fn}")
+    variants=("")
+    if [ "${name}" = "sam" ] || [ "${name}" = "bam" ]; then
+        variants+=("--split")
+    fi
+    for variant in "${variants[@]}"; do
+        for mode in "${modes[@]}"; do
+            label="${name} ${variant:+${variant} }${mode%%:*}"
+            measure "${label} (candidate)" "${candidate_bin}" "${scaled_fn}" "${records}" --input=${format} ${variant} ${mode#*:}
+            if [ -n "${baseline_bin}" ]; then
+                measure "${label} (baseline)" "${baseline_bin}" "${scaled_fn}" "${records}" --input=${format} ${variant} ${mode#*:}
+            fi
+        done
+    done
+    rm -f "${scaled_fn}"
+done
+
+echo "[bench] throughput tests complete!"
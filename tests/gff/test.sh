@@ -3,6 +3,7 @@
 bin_dir="/usr/local/bin"
 gff2bed_bin="${bin_dir}/gff2bed"
 gff2starch_bin="${bin_dir}/gff2starch"
+convert2bed_bin="${bin_dir}/convert2bed"
 
 echo "[gff2bed] testing sorted output..."
 sample_gff_fn="sample.gff"
@@ -28,4 +29,28 @@ ${gff2starch_bin} --starch-gzip < ${sample_gff_fn} > ${observed_starch_fn} 2> /d
 diff -q <(unstarch ${expected_starch_fn}) <(unstarch ${observed_starch_fn})
 rm -f ${observed_starch_fn}
 
+echo "[gff2bed] testing sorted output from on-disk sort runs..."
+sample_gff_fn="sample.gff"
+scaled_gff_fn="$(mktemp /tmp/XXXXXX)"
+expected_sorted_bed_fn="$(mktemp /tmp/XXXXXX)"
+observed_sorted_bed_fn="$(mktemp /tmp/XXXXXX)"
+awk 'BEGIN { FS = OFS = "\t" } /^chr/ { features[n++] = $0 } END { for (i = 0; i < 60000; i++) for (j = 0; j < n; j++) { $0 = features[j]; $1 = "chr" (1 + (i * 7) % 22); $4 += (i * 13) % 100000; $5 += (i * 13) % 100000; print } }' ${sample_gff_fn} > ${scaled_gff_fn}
+${convert2bed_bin} --input=gff < ${scaled_gff_fn} > ${expected_sorted_bed_fn} 2> /dev/null
+${convert2bed_bin} --input=gff --max-mem=16M --sort-tmpdir=/tmp < ${scaled_gff_fn} > ${observed_sorted_bed_fn} 2> /dev/null
+diff -q ${expected_sorted_bed_fn} ${observed_sorted_bed_fn}
+rm -f ${expected_sorted_bed_fn} ${observed_sorted_bed_fn}
+
+echo "[gff2bed] testing --stats report sections, with and without on-disk sort runs..."
+for stats_case in "${sample_gff_fn}:--stats:sorted" "${scaled_gff_fn}:--max-mem=16M --sort-tmpdir=/tmp --stats:spilled" "${sample_gff_fn}:--do-not-sort --stats:unsorted"; do
+    stats_input_fn="${stats_case%%:*}"
+    stats_args="${stats_case#*:}"
+    stats_args="${stats_args%:*}"
+    expected_stats_fn="sample.expected.stats.${stats_case##*:}.txt"
+    observed_stats_fn="$(mktemp /tmp/XXXXXX)"
+    ${convert2bed_bin} --input=gff ${stats_args} < ${stats_input_fn} > /dev/null 2> ${observed_stats_fn}
+    diff -q ${expected_stats_fn} <(sed -n -e 's/^  \("sort": null\).*/\1/p' -e 's/^  \("[a-z_]*"\):.*/\1/p' -e 's/^    \("runs": \[\]\{0,1\}\).*/\1/p' -e 's/^    \("buffer_growths": [0-9]*\).*/\1/p' ${observed_stats_fn})
+    rm -f ${observed_stats_fn}
+done
+rm -f ${scaled_gff_fn}
+
 echo "[gff2bed] tests complete!"
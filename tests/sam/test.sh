@@ -3,6 +3,7 @@
 bin_dir="/usr/local/bin"
 sam2bed_bin="${bin_dir}/sam2bed"
 sam2starch_bin="${bin_dir}/sam2starch"
+convert2bed_bin="${bin_dir}/convert2bed"
 
 echo "[sam2bed] testing sorted output..."
 sample_sam_fn="sample.sam"
@@ -36,4 +37,163 @@ ${sam2starch_bin} --starch-gzip < ${sample_sam_fn} > ${observed_starch_fn} 2> /d
 diff -q <(unstarch ${expected_starch_fn}) <(unstarch ${observed_starch_fn})
 rm -f ${observed_starch_fn}
 
+echo "[sam2bed] testing multi-threaded starch output..."
+sample_sam_fn="sample.sam"
+single_threaded_starch_fn="$(mktemp /tmp/XXXXXX)"
+observed_starch_fn="$(mktemp /tmp/XXXXXX)"
+${convert2bed_bin} --input=sam --output=starch --starch-threads=1 < ${sample_sam_fn} > ${single_threaded_starch_fn} 2> /dev/null
+${convert2bed_bin} --input=sam --output=starch --starch-threads=4 < ${sample_sam_fn} > ${observed_starch_fn} 2> /dev/null
+diff -q <(unstarch ${single_threaded_starch_fn}) <(unstarch ${observed_starch_fn})
+rm -f ${single_threaded_starch_fn} ${observed_starch_fn}
+
+for compression in bzip2 gzip; do
+    echo "[sam2bed] testing multi-threaded starch (${compression}) output within a small --max-mem..."
+    sample_sam_fn="sample.sam"
+    expected_starch_fn="sample.expected.starch"
+    expected_warning_fn="sample.expected.starch.${compression}.warning.txt"
+    observed_starch_fn="$(mktemp /tmp/XXXXXX)"
+    observed_warning_fn="$(mktemp /tmp/XXXXXX)"
+    ${convert2bed_bin} --input=sam --output=starch --starch-${compression} --starch-threads=4 --max-mem=16M < ${sample_sam_fn} > ${observed_starch_fn} 2> ${observed_warning_fn}
+    diff -q <(unstarch ${expected_starch_fn}) <(unstarch ${observed_starch_fn})
+    diff -q ${expected_warning_fn} ${observed_warning_fn}
+    rm -f ${observed_starch_fn} ${observed_warning_fn}
+done
+
+echo "[sam2bed] testing multi-threaded output..."
+threaded_sam_fn="sample.sam"
+expected_threaded_bed_fn="sample.expected.bed"
+observed_threaded_bed_fn="$(mktemp /tmp/XXXXXX)"
+${convert2bed_bin} --input=sam --threads=4 < ${threaded_sam_fn} > ${observed_threaded_bed_fn} 2> /dev/null
+diff -q ${expected_threaded_bed_fn} ${observed_threaded_bed_fn}
+rm -f ${observed_threaded_bed_fn}
+
+echo "[sam2bed] testing split BED6 output..."
+split_bed6_sam_fn="reads.sam"
+expected_split_bed6_bed_fn="reads.expected.split-bed6.bed"
+observed_split_bed6_bed_fn="$(mktemp /tmp/XXXXXX)"
+${convert2bed_bin} --input=sam --split --split-bed6 < ${split_bed6_sam_fn} > ${observed_split_bed6_bed_fn} 2> /dev/null
+diff -q ${expected_split_bed6_bed_fn} ${observed_split_bed6_bed_fn}
+rm -f ${observed_split_bed6_bed_fn}
+
+echo "[sam2bed] testing column selection..."
+columns_sam_fn="reads.sam"
+expected_columns_bed_fn="reads.expected.columns.bed"
+observed_columns_bed_fn="$(mktemp /tmp/XXXXXX)"
+${convert2bed_bin} --input=sam --columns=flag,cigar,NM < ${columns_sam_fn} > ${observed_columns_bed_fn} 2> /dev/null
+diff -q ${expected_columns_bed_fn} ${observed_columns_bed_fn}
+rm -f ${observed_columns_bed_fn}
+
+echo "[sam2bed] testing reordered column selection..."
+columns_sam_fn="reads.sam"
+expected_columns_bed_fn="reads.expected.columns.reordered.bed"
+observed_columns_bed_fn="$(mktemp /tmp/XXXXXX)"
+${convert2bed_bin} --input=sam --columns=NM,tlen,flag,RG < ${columns_sam_fn} > ${observed_columns_bed_fn} 2> /dev/null
+diff -q ${expected_columns_bed_fn} ${observed_columns_bed_fn}
+rm -f ${observed_columns_bed_fn}
+
+echo "[sam2bed] testing column selection with an unknown name..."
+columns_sam_fn="reads.sam"
+expected_columns_error_fn="reads.expected.columns.error.txt"
+observed_columns_error_fn="$(mktemp /tmp/XXXXXX)"
+if ${convert2bed_bin} --input=sam --columns=flag,bogus < ${columns_sam_fn} > /dev/null 2> ${observed_columns_error_fn}; then
+    echo "[sam2bed] unknown column name was accepted"
+fi
+diff -q ${expected_columns_error_fn} <(head -n 1 ${observed_columns_error_fn})
+rm -f ${observed_columns_error_fn}
+
+echo "[sam2bed] testing FLAG and MAPQ filters..."
+filtered_sam_fn="reads.sam"
+expected_filtered_bed_fn="reads.expected.filtered.flags.bed"
+observed_filtered_bed_fn="$(mktemp /tmp/XXXXXX)"
+${convert2bed_bin} --input=sam --require-flags=2 --exclude-flags=1024 --min-mapq=10 < ${filtered_sam_fn} > ${observed_filtered_bed_fn} 2> /dev/null
+diff -q ${expected_filtered_bed_fn} ${observed_filtered_bed_fn}
+rm -f ${observed_filtered_bed_fn}
+
+echo "[sam2bed] testing string and numeric tag filters..."
+filtered_sam_fn="reads.sam"
+expected_filtered_bed_fn="reads.expected.filtered.tags.bed"
+observed_filtered_bed_fn="$(mktemp /tmp/XXXXXX)"
+${convert2bed_bin} --input=sam --tag-filter=RG=grpA --tag-filter='NM<=2' < ${filtered_sam_fn} > ${observed_filtered_bed_fn} 2> /dev/null
+diff -q ${expected_filtered_bed_fn} ${observed_filtered_bed_fn}
+rm -f ${observed_filtered_bed_fn}
+
+echo "[sam2bed] testing FLAG, MAPQ and tag filters together..."
+filtered_sam_fn="reads.sam"
+expected_filtered_bed_fn="reads.expected.filtered.bed"
+observed_filtered_bed_fn="$(mktemp /tmp/XXXXXX)"
+${convert2bed_bin} --input=sam --exclude-flags=1796 --min-mapq=20 --tag-filter=RG=grpB --tag-filter='NM>=1' < ${filtered_sam_fn} > ${observed_filtered_bed_fn} 2> /dev/null
+diff -q ${expected_filtered_bed_fn} ${observed_filtered_bed_fn}
+rm -f ${observed_filtered_bed_fn}
+
+echo "[sam2bed] testing tag filter with a non-numeric integer tag value..."
+filtered_sam_fn="reads.sam"
+expected_filtered_error_fn="reads.expected.filtered.error.txt"
+observed_filtered_error_fn="$(mktemp /tmp/XXXXXX)"
+if ${convert2bed_bin} --input=sam --tag-filter=NM=abc < ${filtered_sam_fn} > /dev/null 2> ${observed_filtered_error_fn}; then
+    echo "[sam2bed] non-numeric integer tag value was accepted"
+fi
+diff -q ${expected_filtered_error_fn} <(head -n 1 ${observed_filtered_error_fn})
+rm -f ${observed_filtered_error_fn}
+
+echo "[sam2bed] testing fragments of proper, improper and orphaned pairs..."
+fragments_sam_fn="reads.sam"
+expected_fragments_bed_fn="reads.expected.fragments.bed"
+observed_fragments_bed_fn="$(mktemp /tmp/XXXXXX)"
+${convert2bed_bin} --input=sam --fragments < ${fragments_sam_fn} > ${observed_fragments_bed_fn} 2> /dev/null
+diff -q ${expected_fragments_bed_fn} ${observed_fragments_bed_fn}
+rm -f ${observed_fragments_bed_fn}
+
+echo "[sam2bed] testing fragments spilled to partitions..."
+fragments_sam_fn="pairs.sam"
+expected_fragments_bed_fn="pairs.expected.fragments.bed"
+observed_fragments_bed_fn="$(mktemp /tmp/XXXXXX)"
+${convert2bed_bin} --input=sam --fragments --fragments-max-mem=1 < ${fragments_sam_fn} > ${observed_fragments_bed_fn} 2> /dev/null
+diff -q ${expected_fragments_bed_fn} ${observed_fragments_bed_fn}
+rm -f ${observed_fragments_bed_fn}
+
+echo "[sam2bed] testing bedGraph coverage..."
+coverage_sam_fn="reads.sam"
+expected_coverage_fn="reads.expected.coverage.bedgraph"
+observed_coverage_fn="$(mktemp /tmp/XXXXXX)"
+${convert2bed_bin} --input=sam --coverage < ${coverage_sam_fn} > ${observed_coverage_fn} 2> /dev/null
+diff -q ${expected_coverage_fn} ${observed_coverage_fn}
+rm -f ${observed_coverage_fn}
+
+echo "[sam2bed] testing BED coverage..."
+coverage_sam_fn="reads.sam"
+expected_coverage_fn="reads.expected.coverage.bed"
+observed_coverage_fn="$(mktemp /tmp/XXXXXX)"
+${convert2bed_bin} --input=sam --coverage=bed < ${coverage_sam_fn} > ${observed_coverage_fn} 2> /dev/null
+diff -q ${expected_coverage_fn} ${observed_coverage_fn}
+rm -f ${observed_coverage_fn}
+
+echo "[sam2bed] testing bedGraph coverage of split reads..."
+coverage_sam_fn="reads.sam"
+expected_coverage_fn="reads.expected.coverage.split.bedgraph"
+observed_coverage_fn="$(mktemp /tmp/XXXXXX)"
+${convert2bed_bin} --input=sam --split --coverage < ${coverage_sam_fn} > ${observed_coverage_fn} 2> /dev/null
+diff -q ${expected_coverage_fn} ${observed_coverage_fn}
+rm -f ${observed_coverage_fn}
+
+echo "[sam2bed] testing coverage of unsorted input..."
+coverage_sam_fn="sample.sam"
+expected_coverage_error_fn="sample.expected.coverage.error.txt"
+observed_coverage_error_fn="$(mktemp /tmp/XXXXXX)"
+if ${convert2bed_bin} --input=sam --coverage < ${coverage_sam_fn} > /dev/null 2> ${observed_coverage_error_fn}; then
+    echo "[sam2bed] unsorted input was accepted"
+fi
+diff -q ${expected_coverage_error_fn} <(head -n 1 ${observed_coverage_error_fn})
+rm -f ${observed_coverage_error_fn}
+
+echo "[sam2bed] testing --stats report sections, and the aliases of --stats..."
+sample_sam_fn="sample.sam"
+for stats_case in "--stats:sorted" "--sort-stats:sorted" "--line-stats:sorted" "--pipe-stats:sorted" "--output=starch --stats:sorted" "--do-not-sort --stats:unsorted"; do
+    stats_args="${stats_case%%:*}"
+    expected_stats_fn="sample.expected.stats.${stats_case##*:}.txt"
+    observed_stats_fn="$(mktemp /tmp/XXXXXX)"
+    ${convert2bed_bin} --input=sam ${stats_args} < ${sample_sam_fn} > /dev/null 2> ${observed_stats_fn}
+    diff -q ${expected_stats_fn} <(sed -n -e 's/^  \("sort": null\).*/\1/p' -e 's/^  \("[a-z_]*"\):.*/\1/p' -e 's/^    \("runs": \[\]\{0,1\}\).*/\1/p' -e 's/^    \("buffer_growths": [0-9]*\).*/\1/p' ${observed_stats_fn})
+    rm -f ${observed_stats_fn}
+done
+
 echo "[sam2bed] tests complete!"
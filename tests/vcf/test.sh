@@ -3,6 +3,7 @@
 bin_dir="/usr/local/bin"
 vcf2bed_bin="${bin_dir}/vcf2bed"
 vcf2starch_bin="${bin_dir}/vcf2starch"
+convert2bed_bin="${bin_dir}/convert2bed"
 
 echo "[vcf2bed] testing sorted and split output..."
 sample_split_vcf_fn="sample.vcf"
@@ -23,17 +24,27 @@ rm -f ${observed_nosplit_sorted_bed_fn}
 echo "[vcf2bed] testing starch split (bzip2) output..."
 sample_vcf_fn="sample.vcf"
 expected_split_starch_fn="sample.expected.split.bzip2.starch"
+expected_split_bed_fn="sample.expected.split.bed"
 observed_split_starch_fn="$(mktemp /tmp/XXXXXX)"
 ${vcf2starch_bin} < ${sample_vcf_fn} > ${observed_split_starch_fn} 2> /dev/null
-diff -q <(unstarch ${expected_split_starch_fn}) <(unstarch ${observed_split_starch_fn})
+diff -q ${expected_split_bed_fn} <(unstarch ${observed_split_starch_fn})
+diff -q <(unstarch ${expected_split_starch_fn} | LC_ALL=C sort) <(unstarch ${observed_split_starch_fn} | LC_ALL=C sort)
+for query in --list-chr --elements --bases --bases-uniq; do
+    diff -q <(unstarch ${query} ${expected_split_starch_fn}) <(unstarch ${query} ${observed_split_starch_fn})
+done
 rm -f ${observed_split_starch_fn}
 
 echo "[vcf2bed] testing starch (gzip) output..."
 sample_vcf_fn="sample.vcf"
 expected_split_starch_fn="sample.expected.split.gzip.starch"
+expected_split_bed_fn="sample.expected.split.bed"
 observed_split_starch_fn="$(mktemp /tmp/XXXXXX)"
 ${vcf2starch_bin} --starch-gzip < ${sample_vcf_fn} > ${observed_split_starch_fn} 2> /dev/null
-diff -q <(unstarch ${expected_split_starch_fn}) <(unstarch ${observed_split_starch_fn})
+diff -q ${expected_split_bed_fn} <(unstarch ${observed_split_starch_fn})
+diff -q <(unstarch ${expected_split_starch_fn} | LC_ALL=C sort) <(unstarch ${observed_split_starch_fn} | LC_ALL=C sort)
+for query in --list-chr --elements --bases --bases-uniq; do
+    diff -q <(unstarch ${query} ${expected_split_starch_fn}) <(unstarch ${query} ${observed_split_starch_fn})
+done
 rm -f ${observed_split_starch_fn}
 
 echo "[vcf2bed] testing starch no-split (bzip2) output..."
@@ -42,6 +53,9 @@ expected_split_starch_fn="sample.expected.nosplit.bzip2.starch"
 observed_split_starch_fn="$(mktemp /tmp/XXXXXX)"
 ${vcf2starch_bin} --do-not-split < ${sample_vcf_fn} > ${observed_split_starch_fn} 2> /dev/null
 diff -q <(unstarch ${expected_split_starch_fn}) <(unstarch ${observed_split_starch_fn})
+for query in --list-chr --elements --bases --bases-uniq; do
+    diff -q <(unstarch ${query} ${expected_split_starch_fn}) <(unstarch ${query} ${observed_split_starch_fn})
+done
 rm -f ${observed_split_starch_fn}
 
 echo "[vcf2bed] testing starch (gzip) output..."
@@ -50,6 +64,47 @@ expected_split_starch_fn="sample.expected.nosplit.gzip.starch"
 observed_split_starch_fn="$(mktemp /tmp/XXXXXX)"
 ${vcf2starch_bin} --do-not-split --starch-gzip < ${sample_vcf_fn} > ${observed_split_starch_fn} 2> /dev/null
 diff -q <(unstarch ${expected_split_starch_fn}) <(unstarch ${observed_split_starch_fn})
+for query in --list-chr --elements --bases --bases-uniq; do
+    diff -q <(unstarch ${query} ${expected_split_starch_fn}) <(unstarch ${query} ${observed_split_starch_fn})
+done
 rm -f ${observed_split_starch_fn}
 
+echo "[vcf2bed] testing multi-threaded output..."
+threaded_vcf_fn="sample.vcf"
+expected_threaded_bed_fn="sample.expected.split.bed"
+observed_threaded_bed_fn="$(mktemp /tmp/XXXXXX)"
+${convert2bed_bin} --input=vcf --threads=4 < ${threaded_vcf_fn} > ${observed_threaded_bed_fn} 2> /dev/null
+diff -q ${expected_threaded_bed_fn} ${observed_threaded_bed_fn}
+rm -f ${observed_threaded_bed_fn}
+
+echo "[vcf2bed] testing line longer than 128K..."
+longline_vcf_fn="longline.vcf"
+expected_longline_bed_fn="longline.expected.bed"
+observed_longline_bed_fn="$(mktemp /tmp/XXXXXX)"
+${convert2bed_bin} --input=vcf < ${longline_vcf_fn} > ${observed_longline_bed_fn} 2> /dev/null
+diff -q ${expected_longline_bed_fn} ${observed_longline_bed_fn}
+rm -f ${observed_longline_bed_fn}
+
+echo "[vcf2bed] testing line longer than --max-line-length..."
+longline_vcf_fn="longline.vcf"
+expected_longline_error_fn="longline.expected.error.txt"
+observed_longline_error_fn="$(mktemp /tmp/XXXXXX)"
+if ${convert2bed_bin} --input=vcf --max-line-length=128K < ${longline_vcf_fn} > /dev/null 2> ${observed_longline_error_fn}; then
+    echo "[vcf2bed] line longer than --max-line-length was accepted"
+fi
+diff -q ${expected_longline_error_fn} <(head -n 1 ${observed_longline_error_fn})
+rm -f ${observed_longline_error_fn}
+
+echo "[vcf2bed] testing --stats report sections, with and without line buffer growth..."
+for stats_case in "sample.vcf:--stats:sample.expected.stats.sorted.txt" "longline.vcf:--stats:longline.expected.stats.txt" "sample.vcf:--do-not-sort --stats:sample.expected.stats.unsorted.txt"; do
+    stats_input_fn="${stats_case%%:*}"
+    stats_args="${stats_case#*:}"
+    stats_args="${stats_args%:*}"
+    expected_stats_fn="${stats_case##*:}"
+    observed_stats_fn="$(mktemp /tmp/XXXXXX)"
+    ${convert2bed_bin} --input=vcf ${stats_args} < ${stats_input_fn} > /dev/null 2> ${observed_stats_fn}
+    diff -q ${expected_stats_fn} <(sed -n -e 's/^  \("sort": null\).*/\1/p' -e 's/^  \("[a-z_]*"\):.*/\1/p' -e 's/^    \("runs": \[\]\{0,1\}\).*/\1/p' -e 's/^    \("buffer_growths": [0-9]*\).*/\1/p' ${observed_stats_fn})
+    rm -f ${observed_stats_fn}
+done
+
 echo "[vcf2bed] tests complete!"
@@ -3,6 +3,7 @@
 bin_dir="/usr/local/bin"
 wig2bed_bin="${bin_dir}/wig2bed"
 wig2starch_bin="${bin_dir}/wig2starch"
+convert2bed_bin="${bin_dir}/convert2bed"
 
 for idx in $(seq 1 5)
 do
@@ -57,4 +58,12 @@ ${wig2starch_bin} --starch-gzip --keep-header --multisplit="foo" < ${sample_wig_
 diff -q <(unstarch ${expected_starch_fn}) <(unstarch ${observed_starch_fn})
 rm -f ${observed_starch_fn}
 
+echo "[wig2bed] testing multi-threaded output [$idx]..."
+sample_wig_fn="sample_$idx.wig"
+expected_sorted_bed_fn="sample_$idx.expected.bed"
+observed_sorted_bed_fn="$(mktemp /tmp/XXXXXX)"
+${convert2bed_bin} --input=wig --keep-header --multisplit="foo" --threads=4 < ${sample_wig_fn} > ${observed_sorted_bed_fn} 2> /dev/null
+diff -q ${expected_sorted_bed_fn} ${observed_sorted_bed_fn}
+rm -f ${observed_sorted_bed_fn}
+
 echo "[wig2bed] tests complete!"